@@ -24,8 +24,12 @@
 
 #include <boost/date_time/posix_time/posix_time_duration.hpp> // for seconds
 #include <boost/date_time/posix_time/ptime.hpp>               // for ptime
+#include <algorithm>                                          // for stable_sort
+#include <cstdint>                                            // for uint64_t
 #include <cstdlib>                                            // for abs
 #include <iostream>                                           // for basic_...
+#include <iterator>                                           // for distance, next
+#include <set>                                                // for set
 
 #include "goby/acomms/acomms_constants.h"               // for BROADC...
 #include "goby/time/convert.h"                          // for convert
@@ -59,11 +63,13 @@ goby::acomms::MACManager::~MACManager() = default;
 void goby::acomms::MACManager::startup(const protobuf::MACConfig& cfg)
 {
     cfg_ = cfg;
+    queue_depths_.clear();
 
     switch (cfg_.type())
     {
         case protobuf::MAC_POLLED:
         case protobuf::MAC_FIXED_DECENTRALIZED:
+        case protobuf::MAC_ADAPTIVE_DECENTRALIZED:
             std::list<protobuf::ModemTransmission>::clear();
             for (int i = 0, n = cfg_.slot_size(); i < n; ++i)
             {
@@ -80,6 +86,21 @@ void goby::acomms::MACManager::startup(const protobuf::MACConfig& cfg)
                 glog.is(DEBUG1) && glog << group(glog_mac_group_)
                                         << "Using the Decentralized MAC_FIXED_DECENTRALIZED scheme"
                                         << std::endl;
+            else if (cfg_.type() == protobuf::MAC_ADAPTIVE_DECENTRALIZED)
+            {
+                glog.is(DEBUG1) &&
+                    glog << group(glog_mac_group_)
+                         << "Using the Decentralized MAC_ADAPTIVE_DECENTRALIZED scheme"
+                         << std::endl;
+
+                if (cfg_.slot_size() > 0 &&
+                    (cfg_.slot(0).src() == BROADCAST_ID || cfg_.slot(0).always_initiate()))
+                    glog.is(WARN) && glog << group(glog_mac_group_)
+                                          << "The first slot must be owned by a single node (the "
+                                             "cycle leader) for MAC_ADAPTIVE_DECENTRALIZED to "
+                                             "reallocate slots. Using the configured owners."
+                                          << std::endl;
+            }
             break;
 
         default: return;
@@ -140,10 +161,34 @@ void goby::acomms::MACManager::begin_slot()
     protobuf::ModemTransmission s = *current_slot_;
     s.set_time_with_units(time::convert<time::MicroTime>(next_slot_t_));
 
+    if (cfg_.type() == protobuf::MAC_ADAPTIVE_DECENTRALIZED)
+    {
+        // a slot owner that stays silent has nothing left to send
+        if (current_owner_ != -1 && current_owner_ != cfg_.modem_id() &&
+            !heard_from_current_owner_ && queue_depths_[current_owner_] != 0)
+        {
+            glog.is(DEBUG1) && glog << group(glog_mac_group_) << "Nothing heard from "
+                                    << current_owner_
+                                    << " in its slot, setting its queue depth to 0" << std::endl;
+            queue_depths_[current_owner_] = 0;
+        }
+
+        if (current_slot_ == std::list<protobuf::ModemTransmission>::begin())
+            allocate_slots();
+
+        auto index = std::distance(std::list<protobuf::ModemTransmission>::begin(), current_slot_);
+        if (index < static_cast<decltype(index)>(slot_owners_.size()))
+            s.set_src(slot_owners_[index]);
+
+        current_owner_ = s.src();
+        heard_from_current_owner_ = false;
+    }
+
     bool we_are_transmitting = true;
     switch (cfg_.type())
     {
         case protobuf::MAC_FIXED_DECENTRALIZED:
+        case protobuf::MAC_ADAPTIVE_DECENTRALIZED:
             // we only transmit if the packet source is us
             we_are_transmitting = (s.src() == cfg_.modem_id()) || s.always_initiate();
             break;
@@ -161,7 +206,9 @@ void goby::acomms::MACManager::begin_slot()
     {
         glog << group(glog_mac_group_) << "Cycle order: [";
 
-        for (auto it = std::list<protobuf::ModemTransmission>::begin(), n = end(); it != n; ++it)
+        std::size_t index = 0;
+        for (auto it = std::list<protobuf::ModemTransmission>::begin(), n = end(); it != n;
+             ++it, ++index)
         {
             if (it == current_slot_)
                 glog << group(glog_mac_group_) << " " << green;
@@ -174,7 +221,11 @@ void goby::acomms::MACManager::begin_slot()
                 default: break;
             }
 
-            glog << it->src() << "/" << it->dest() << "@" << it->rate() << " " << nocolor;
+            int src = (cfg_.type() == protobuf::MAC_ADAPTIVE_DECENTRALIZED &&
+                       index < slot_owners_.size())
+                          ? slot_owners_[index]
+                          : it->src();
+            glog << src << "/" << it->dest() << "@" << it->rate() << " " << nocolor;
         }
         glog << " ]" << std::endl;
     }
@@ -197,6 +248,7 @@ void goby::acomms::MACManager::increment_slot()
     switch (cfg_.type())
     {
         case protobuf::MAC_FIXED_DECENTRALIZED:
+        case protobuf::MAC_ADAPTIVE_DECENTRALIZED:
         case protobuf::MAC_POLLED:
             next_slot_t_ += time::convert_duration<std::chrono::microseconds>(
                 current_slot_->slot_seconds_with_units());
@@ -266,6 +318,9 @@ void goby::acomms::MACManager::update()
 
     // reset the cycle to the beginning
     current_slot_ = std::list<protobuf::ModemTransmission>::begin();
+    current_owner_ = -1;
+    allocate_slots();
+
     // advance the next slot time to the beginning of the next cycle
     next_slot_t_ = next_cycle_time();
 
@@ -275,7 +330,8 @@ void goby::acomms::MACManager::update()
 
     // if we can start cycles in the middle, do it
     if (cfg_.start_cycle_in_middle() && std::list<protobuf::ModemTransmission>::size() > 1 &&
-        (cfg_.type() == protobuf::MAC_FIXED_DECENTRALIZED || cfg_.type() == protobuf::MAC_POLLED))
+        (cfg_.type() == protobuf::MAC_FIXED_DECENTRALIZED || cfg_.type() == protobuf::MAC_POLLED ||
+         cfg_.type() == protobuf::MAC_ADAPTIVE_DECENTRALIZED))
     {
         glog.is(DEBUG1) && glog << group(glog_mac_group_)
                                 << "Starting next available slot (in middle of cycle)" << std::endl;
@@ -301,6 +357,134 @@ goby::time::SystemClock::duration goby::acomms::MACManager::cycle_duration()
     return time::convert_duration<goby::time::SystemClock::duration>(length);
 }
 
+void goby::acomms::MACManager::handle_queue_depth(int modem_id, unsigned depth)
+{
+    glog.is(DEBUG2) && glog << group(glog_mac_group_) << "Queue depth for " << modem_id << ": "
+                            << depth << std::endl;
+
+    queue_depths_[modem_id] = depth;
+    if (modem_id == current_owner_)
+        heard_from_current_owner_ = true;
+}
+
+void goby::acomms::MACManager::handle_allocation(int modem_id, const std::vector<unsigned>& depths)
+{
+    if (cfg_.type() != protobuf::MAC_ADAPTIVE_DECENTRALIZED || modem_id != cycle_leader_ ||
+        modem_id == cfg_.modem_id())
+        return;
+
+    if (depths.size() != participants_.size())
+    {
+        glog.is(WARN) && glog << group(glog_mac_group_) << "Ignoring allocation from " << modem_id
+                              << " with " << depths.size() << " queue depths (expected "
+                              << participants_.size() << "): is its MAC configuration different?"
+                              << std::endl;
+        return;
+    }
+
+    allocation_depths_ = depths;
+    assign_slots();
+}
+
+void goby::acomms::MACManager::allocate_slots()
+{
+    // start from the configured owners
+    slot_owners_.clear();
+    pool_.clear();
+    std::set<int> participants;
+    for (const protobuf::ModemTransmission& slot : *this)
+    {
+        if (slot.src() != BROADCAST_ID && !slot.always_initiate())
+        {
+            participants.insert(slot.src());
+            // the cycle leader keeps the first slot, in which it sends the allocation
+            if (!slot_owners_.empty())
+                pool_.push_back(slot_owners_.size());
+        }
+        slot_owners_.push_back(slot.src());
+    }
+    participants_.assign(participants.begin(), participants.end());
+    allocation_depths_.clear();
+
+    cycle_leader_ = BROADCAST_ID;
+    if (cfg_.type() != protobuf::MAC_ADAPTIVE_DECENTRALIZED || slot_owners_.empty() ||
+        front().src() == BROADCAST_ID || front().always_initiate())
+        return;
+
+    cycle_leader_ = front().src();
+    if (cycle_leader_ == cfg_.modem_id())
+    {
+        for (int id : participants_)
+        {
+            auto it = queue_depths_.find(id);
+            allocation_depths_.push_back(it == queue_depths_.end() ? 0u : it->second);
+        }
+        assign_slots();
+    }
+    else
+    {
+        // until we hear the leader's allocation for this cycle we don't know who owns these
+        for (auto index : pool_) slot_owners_[index] = BROADCAST_ID;
+    }
+}
+
+void goby::acomms::MACManager::assign_slots()
+{
+    for (auto index : pool_) slot_owners_[index] = std::next(begin(), index)->src();
+
+    std::uint64_t total_depth = 0;
+    for (auto depth : allocation_depths_) total_depth += depth;
+
+    const std::size_t min_slots = cfg_.adaptive().min_slots_per_node();
+    if (total_depth == 0 || pool_.size() < participants_.size() * min_slots)
+    {
+        glog.is(DEBUG1) && glog << group(glog_mac_group_)
+                                << "Using configured slot owners for this cycle" << std::endl;
+        return;
+    }
+
+    // everyone gets min_slots, the rest are shared in proportion to queue depth using the largest
+    // remainder method
+    const std::size_t spare = pool_.size() - participants_.size() * min_slots;
+    std::map<int, std::size_t> allocation;
+    std::vector<std::pair<std::uint64_t, int>> remainders;
+    std::size_t allocated = 0;
+    for (std::size_t i = 0, n = participants_.size(); i < n; ++i)
+    {
+        int id = participants_[i];
+        std::uint64_t share = static_cast<std::uint64_t>(spare) * allocation_depths_[i];
+        allocation[id] = min_slots + share / total_depth;
+        allocated += share / total_depth;
+        remainders.emplace_back(share % total_depth, id);
+    }
+    // participants are in modem_id order, so ties go to the lower modem_id
+    std::stable_sort(remainders.begin(), remainders.end(),
+                     [](const std::pair<std::uint64_t, int>& a,
+                        const std::pair<std::uint64_t, int>& b) { return a.first > b.first; });
+    for (auto it = remainders.begin(); allocated < spare; ++it, ++allocated)
+        ++allocation[it->second];
+
+    // interleave the owners so that a busy node's slots are spread across the cycle
+    auto pool_it = pool_.begin();
+    for (std::size_t round = 0; pool_it != pool_.end(); ++round)
+    {
+        for (const auto& id_slots_pair : allocation)
+        {
+            if (id_slots_pair.second > round && pool_it != pool_.end())
+                slot_owners_[*pool_it++] = id_slots_pair.first;
+        }
+    }
+
+    if (glog.is(DEBUG1))
+    {
+        glog << group(glog_mac_group_) << "Adaptive slot allocation from " << cycle_leader_ << ":";
+        for (std::size_t i = 0, n = participants_.size(); i < n; ++i)
+            glog << " " << participants_[i] << " (depth " << allocation_depths_[i]
+                 << "): " << allocation[participants_[i]];
+        glog << std::endl;
+    }
+}
+
 std::ostream& goby::acomms::operator<<(std::ostream& os, const MACManager& mac)
 {
     for (const auto& it : mac) { os << it; }
@@ -30,8 +30,11 @@
 #include <chrono>                         // for seconds
 #include <iosfwd>                         // for ostream
 #include <list>                           // for list, list<>::ite...
+#include <map>                            // for map
 #include <string>                         // for operator==, string
+#include <vector>                         // for vector
 
+#include "goby/acomms/acomms_constants.h"          // for BROADCAST_ID
 #include "goby/acomms/protobuf/amac_config.pb.h"   // for MACConfig
 #include "goby/acomms/protobuf/modem_message.pb.h" // for ModemTransmission
 #include "goby/time/system_clock.h"                // for SystemClock, Syst...
@@ -103,6 +106,34 @@ class MACManager : public std::list<protobuf::ModemTransmission>
 
     const std::string& glog_mac_group() const { return glog_mac_group_; }
 
+    /// \name Adaptive TDMA (MAC_ADAPTIVE_DECENTRALIZED)
+    ///
+    /// The owner (src) of the first slot of the cycle is the cycle leader. It always keeps that slot and, at the start of each cycle, allocates the other slots from the queue depths it has heard. It must then send allocation_depths() in its transmission in the first slot (slot_index 0), and every other node passes what it hears to handle_allocation(). A node that has not heard the allocation for the current cycle does not transmit in the reassigned slots, so the nodes never act on different schedules. Clocks must agree to well within the time it takes the leader's transmission to arrive.
+    //@{
+
+    /// \brief Record the queue depth (messages waiting to be sent) advertised by a node.
+    ///
+    /// Call this for each depth piggybacked on a received transmission, and also with our own modem_id and the depth we piggyback on our own transmissions. Only the cycle leader's values determine the allocation.
+    void handle_queue_depth(int modem_id, unsigned depth);
+
+    /// \brief Record the allocation sent by modem_id (ignored unless modem_id is the cycle leader) and use it for the rest of the current cycle
+    ///
+    /// \param depths The leader's allocation_depths()
+    void handle_allocation(int modem_id, const std::vector<unsigned>& depths);
+
+    /// \brief modem_id of the cycle leader, or BROADCAST_ID if the first slot has no single owner (in which case the configured owners are always used)
+    int cycle_leader() const { return cycle_leader_; }
+
+    /// \brief Queue depths of the participating nodes (in increasing modem_id order) from which the current cycle was allocated; empty if this node has not yet heard the allocation for this cycle
+    const std::vector<unsigned>& allocation_depths() const { return allocation_depths_; }
+
+    /// \brief Most recently advertised queue depth for each node (modem_id -> depth)
+    const std::map<int, unsigned>& queue_depths() const { return queue_depths_; }
+
+    /// \brief Owner (src) of each slot in the current cycle, in list order
+    const std::vector<int>& slot_owners() const { return slot_owners_; }
+    //@}
+
   private:
     void begin_slot();
     time::SystemClock::time_point next_cycle_time();
@@ -115,6 +146,9 @@ class MACManager : public std::list<protobuf::ModemTransmission>
     unsigned cycle_sum();
     void position_blank();
 
+    void allocate_slots();
+    void assign_slots();
+
     // allowed offset from actual end of slot
 
     const time::SystemClock::duration allowed_skew_{std::chrono::seconds(2)};
@@ -136,6 +170,19 @@ class MACManager : public std::list<protobuf::ModemTransmission>
 
     bool started_up_{false};
 
+    // adaptive TDMA state
+    std::map<int, unsigned> queue_depths_;
+    std::vector<int> slot_owners_;
+    int cycle_leader_{BROADCAST_ID};
+    // nodes that share the reassignable slots, in increasing modem_id order
+    std::vector<int> participants_;
+    // indices of the slots that can be reassigned
+    std::vector<std::size_t> pool_;
+    std::vector<unsigned> allocation_depths_;
+    // owner of the slot in progress, and whether they've advertised during it
+    int current_owner_{-1};
+    bool heard_from_current_owner_{false};
+
     std::string glog_mac_group_;
     static int count_;
 };
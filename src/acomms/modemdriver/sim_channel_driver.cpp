@@ -0,0 +1,514 @@
+// Copyright 2012-2023:
+//   GobySoft, LLC (2013-)
+//   Community contributors (see AUTHORS file)
+// File authors:
+//   Toby Schneider <toby@gobysoft.org>
+//
+//
+// This file is part of the Goby Underwater Autonomy Project Libraries
+// ("The Goby Libraries").
+//
+// The Goby Libraries are free software: you can redistribute them and/or modify
+// them under the terms of the GNU Lesser General Public License as published by
+// the Free Software Foundation, either version 2.1 of the License, or
+// (at your option) any later version.
+//
+// The Goby Libraries are distributed in the hope that they will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU Lesser General Public License for more details.
+//
+// You should have received a copy of the GNU Lesser General Public License
+// along with Goby.  If not, see <http://www.gnu.org/licenses/>.
+
+
+#include "sim_channel_driver.h"
+
+#include <algorithm> // for remove_if, any_of, sort, min
+#include <chrono>    // for duration, duration_cast
+#include <cmath>     // for sqrt, pow
+#include <map>       // for map
+#include <mutex>     // for mutex, lock_guard
+#include <random>    // for seed_seq, mt19937
+#include <vector>    // for vector
+
+#include "goby/acomms/acomms_constants.h"           // for BROADCAST_ID
+#include "goby/acomms/modemdriver/driver_exception.h" // for ModemDriverException
+#include "goby/acomms/protobuf/modem_message.pb.h"  // for ModemTransmission
+#include "goby/time/convert.h"                      // for SystemClock::now
+#include "goby/time/system_clock.h"                 // for SystemClock
+#include "goby/time/types.h"                        // for MicroTime
+#include "goby/util/debug_logger.h"
+#include "goby/util/protobuf/io.h" // for operator<<
+
+using goby::glog;
+using namespace goby::util::logger;
+using goby::time::SteadyClock;
+
+namespace goby
+{
+namespace acomms
+{
+namespace sim_channel
+{
+/// \brief Shared medium for all the SimChannelDrivers using a given channel name
+class Channel
+{
+  public:
+    static std::shared_ptr<Channel> attach(const std::string& name, int modem_id,
+                                           const protobuf::Config& cfg);
+    static ChannelStatistics statistics(const std::string& name);
+
+    void detach(int modem_id);
+    void set_position(int modem_id, const protobuf::Config::Position& position);
+
+    /// \brief Put a transmission on the channel from modem_id, starting at tx_start
+    void transmit(int modem_id, const acomms::protobuf::ModemTransmission& msg,
+                  SteadyClock::time_point tx_start, SteadyClock::duration duration);
+
+    /// \brief Returns the transmissions that have completely arrived at modem_id by now, with lost frames emptied
+    std::vector<acomms::protobuf::ModemTransmission> receive(int modem_id,
+                                                             SteadyClock::time_point now);
+
+  private:
+    struct Window
+    {
+        SteadyClock::time_point start;
+        SteadyClock::time_point end;
+        bool overlaps(const Window& other) const
+        {
+            return start < other.end && other.start < end;
+        }
+    };
+
+    struct Arrival
+    {
+        acomms::protobuf::ModemTransmission msg;
+        int src_modem_id;
+        // index of this transmission among those made by src_modem_id
+        std::uint64_t tx_sequence;
+        Window window;
+        bool collided{false};
+    };
+
+    struct Node
+    {
+        protobuf::Config cfg;
+        protobuf::Config::Position position;
+        // transmissions this node has made that may still overlap with pending arrivals
+        std::vector<Window> transmitting;
+        std::vector<Arrival> arrivals;
+        std::uint64_t tx_count{0};
+    };
+
+    bool frame_lost(const Node& rx, const Arrival& arrival, int frame_index) const;
+
+  private:
+    std::mutex mutex_;
+    std::map<int, Node> nodes_;
+    ChannelStatistics stats_;
+
+    static std::mutex registry_mutex_;
+    static std::map<std::string, std::shared_ptr<Channel>> registry_;
+};
+} // namespace sim_channel
+} // namespace acomms
+} // namespace goby
+
+std::mutex goby::acomms::sim_channel::Channel::registry_mutex_;
+std::map<std::string, std::shared_ptr<goby::acomms::sim_channel::Channel>>
+    goby::acomms::sim_channel::Channel::registry_;
+
+std::shared_ptr<goby::acomms::sim_channel::Channel>
+goby::acomms::sim_channel::Channel::attach(const std::string& name, int modem_id,
+                                           const protobuf::Config& cfg)
+{
+    std::shared_ptr<Channel> channel;
+    {
+        std::lock_guard<std::mutex> lock(registry_mutex_);
+        auto& registered = registry_[name];
+        if (!registered)
+            registered = std::make_shared<Channel>();
+        channel = registered;
+    }
+
+    std::lock_guard<std::mutex> lock(channel->mutex_);
+    if (channel->nodes_.count(modem_id))
+        throw(ModemDriverException("modem_id " + std::to_string(modem_id) +
+                                       " is already attached to simulated channel \"" + name +
+                                       "\"",
+                                   acomms::protobuf::ModemDriverStatus::INVALID_CONFIGURATION));
+
+    Node& node = channel->nodes_[modem_id];
+    node.cfg = cfg;
+    node.position = cfg.position();
+    return channel;
+}
+
+goby::acomms::sim_channel::ChannelStatistics
+goby::acomms::sim_channel::Channel::statistics(const std::string& name)
+{
+    std::shared_ptr<Channel> channel;
+    {
+        std::lock_guard<std::mutex> lock(registry_mutex_);
+        auto it = registry_.find(name);
+        if (it == registry_.end())
+            return ChannelStatistics();
+        channel = it->second;
+    }
+
+    std::lock_guard<std::mutex> lock(channel->mutex_);
+    return channel->stats_;
+}
+
+void goby::acomms::sim_channel::Channel::detach(int modem_id)
+{
+    std::lock_guard<std::mutex> lock(mutex_);
+    nodes_.erase(modem_id);
+}
+
+void goby::acomms::sim_channel::Channel::set_position(int modem_id,
+                                                      const protobuf::Config::Position& position)
+{
+    std::lock_guard<std::mutex> lock(mutex_);
+    auto it = nodes_.find(modem_id);
+    if (it != nodes_.end())
+        it->second.position = position;
+}
+
+void goby::acomms::sim_channel::Channel::transmit(int modem_id,
+                                                  const acomms::protobuf::ModemTransmission& msg,
+                                                  SteadyClock::time_point tx_start,
+                                                  SteadyClock::duration duration)
+{
+    std::lock_guard<std::mutex> lock(mutex_);
+    auto tx_it = nodes_.find(modem_id);
+    if (tx_it == nodes_.end())
+        return;
+
+    Node& tx = tx_it->second;
+    tx.transmitting.push_back({tx_start, tx_start + duration});
+
+    std::uint64_t tx_sequence = tx.tx_count++;
+    ++stats_.transmissions;
+    stats_.busy_time += duration;
+    stats_.frames_sent += msg.frame_size();
+
+    for (auto& id_node_pair : nodes_)
+    {
+        if (id_node_pair.first == modem_id)
+            continue;
+
+        Node& rx = id_node_pair.second;
+        double dx = rx.position.x() - tx.position.x(), dy = rx.position.y() - tx.position.y(),
+               dz = rx.position.z() - tx.position.z();
+        double range = std::sqrt(dx * dx + dy * dy + dz * dz);
+
+        if (range > rx.cfg.max_range())
+        {
+            stats_.frames_out_of_range += msg.frame_size();
+            continue;
+        }
+
+        auto delay = std::chrono::duration_cast<SteadyClock::duration>(
+            std::chrono::duration<double>(range / rx.cfg.sound_speed()));
+
+        Arrival arrival{msg, modem_id, tx_sequence, {tx_start + delay, tx_start + delay + duration}};
+
+        if (rx.cfg.collisions())
+        {
+            for (auto& other : rx.arrivals)
+            {
+                if (other.window.overlaps(arrival.window))
+                    other.collided = arrival.collided = true;
+            }
+        }
+        rx.arrivals.push_back(arrival);
+    }
+}
+
+std::vector<goby::acomms::protobuf::ModemTransmission>
+goby::acomms::sim_channel::Channel::receive(int modem_id, SteadyClock::time_point now)
+{
+    std::vector<acomms::protobuf::ModemTransmission> received;
+
+    std::lock_guard<std::mutex> lock(mutex_);
+    auto rx_it = nodes_.find(modem_id);
+    if (rx_it == nodes_.end())
+        return received;
+
+    Node& rx = rx_it->second;
+
+    // arrivals in the order they finish
+    std::sort(rx.arrivals.begin(), rx.arrivals.end(),
+              [](const Arrival& a, const Arrival& b) { return a.window.end < b.window.end; });
+
+    auto arrived_end = rx.arrivals.begin();
+    for (; arrived_end != rx.arrivals.end() && arrived_end->window.end <= now; ++arrived_end)
+    {
+        const Arrival& arrival = *arrived_end;
+        auto num_frames = arrival.msg.frame_size();
+
+        if (arrival.collided)
+        {
+            stats_.frames_lost_collision += num_frames;
+            continue;
+        }
+
+        if (rx.cfg.half_duplex() &&
+            std::any_of(rx.transmitting.begin(), rx.transmitting.end(),
+                        [&](const Window& tx) { return tx.overlaps(arrival.window); }))
+        {
+            stats_.frames_lost_half_duplex += num_frames;
+            continue;
+        }
+
+        received.push_back(arrival.msg);
+        auto& msg = received.back();
+        for (int i = 0; i < num_frames; ++i)
+        {
+            if (frame_lost(rx, arrival, i))
+            {
+                ++stats_.frames_lost_error;
+                msg.mutable_frame(i)->clear();
+            }
+            else
+            {
+                ++stats_.frames_received;
+                stats_.bytes_received += msg.frame(i).size();
+            }
+        }
+    }
+    rx.arrivals.erase(rx.arrivals.begin(), arrived_end);
+
+    // pending (and future) arrivals all start after this, so earlier transmissions can no longer
+    // overlap them
+    auto horizon = now;
+    for (const auto& arrival : rx.arrivals) horizon = std::min(horizon, arrival.window.start);
+    rx.transmitting.erase(std::remove_if(rx.transmitting.begin(), rx.transmitting.end(),
+                                         [&](const Window& tx) { return tx.end < horizon; }),
+                          rx.transmitting.end());
+
+    return received;
+}
+
+bool goby::acomms::sim_channel::Channel::frame_lost(const Node& rx, const Arrival& arrival,
+                                                    int frame_index) const
+{
+    double p_loss = rx.cfg.packet_loss_probability();
+    if (rx.cfg.bit_error_rate() > 0)
+    {
+        double bits = 8.0 * arrival.msg.frame(frame_index).size();
+        p_loss = 1 - (1 - p_loss) * std::pow(1 - rx.cfg.bit_error_rate(), bits);
+    }
+
+    if (p_loss <= 0)
+        return false;
+
+    // seed from the sender and its own transmission count (not the channel-wide count) so the
+    // outcome doesn't depend on the polling order or on how transmissions from different modems
+    // interleave
+    std::seed_seq seq{rx.cfg.seed(),
+                      static_cast<std::uint32_t>(arrival.src_modem_id),
+                      static_cast<std::uint32_t>(arrival.msg.dest()),
+                      static_cast<std::uint32_t>(arrival.tx_sequence),
+                      static_cast<std::uint32_t>(arrival.tx_sequence >> 32),
+                      static_cast<std::uint32_t>(frame_index)};
+    std::mt19937 gen(seq);
+    return std::uniform_real_distribution<double>(0, 1)(gen) < p_loss;
+}
+
+goby::acomms::SimChannelDriver::SimChannelDriver() = default;
+goby::acomms::SimChannelDriver::~SimChannelDriver() { shutdown(); }
+
+void goby::acomms::SimChannelDriver::startup(const protobuf::DriverConfig& cfg)
+{
+    driver_cfg_ = cfg;
+
+    // transmission_duration() divides by bits_per_second
+    for (const auto& rate : sim_cfg().rate())
+    {
+        if (!(rate.bits_per_second() > 0))
+            throw(ModemDriverException(
+                "rate " + std::to_string(rate.rate()) + ": bits_per_second must be positive",
+                acomms::protobuf::ModemDriverStatus::INVALID_CONFIGURATION));
+    }
+
+    modem_start(driver_cfg_);
+
+    channel_ = sim_channel::Channel::attach(sim_cfg().channel(), driver_cfg_.modem_id(), sim_cfg());
+
+    glog.is(DEBUG1) && glog << group(glog_out_group()) << "Attached to simulated channel \""
+                            << sim_cfg().channel() << "\" at position: "
+                            << sim_cfg().position().ShortDebugString() << std::endl;
+}
+
+void goby::acomms::SimChannelDriver::shutdown()
+{
+    if (channel_)
+    {
+        channel_->detach(driver_cfg_.modem_id());
+        channel_.reset();
+    }
+}
+
+void goby::acomms::SimChannelDriver::set_position(double x, double y, double z)
+{
+    sim_channel::protobuf::Config::Position position;
+    position.set_x(x);
+    position.set_y(y);
+    position.set_z(z);
+    if (channel_)
+        channel_->set_position(driver_cfg_.modem_id(), position);
+}
+
+goby::acomms::sim_channel::ChannelStatistics
+goby::acomms::SimChannelDriver::channel_statistics(const std::string& channel)
+{
+    return sim_channel::Channel::statistics(channel);
+}
+
+const goby::acomms::sim_channel::protobuf::Config::Rate&
+goby::acomms::SimChannelDriver::rate_cfg(int rate) const
+{
+    for (const auto& rate_cfg : sim_cfg().rate())
+    {
+        if (rate_cfg.rate() == rate)
+            return rate_cfg;
+    }
+    return default_rate_;
+}
+
+goby::time::SteadyClock::duration goby::acomms::SimChannelDriver::transmission_duration(
+    const protobuf::ModemTransmission& msg)
+{
+    std::size_t bytes = 0;
+    if (msg.type() == protobuf::ModemTransmission::ACK)
+        bytes = sim_cfg().ack_bytes();
+    else
+        for (const auto& frame : msg.frame()) bytes += frame.size();
+
+    return std::chrono::duration_cast<SteadyClock::duration>(
+        std::chrono::duration<double>(8.0 * bytes / rate_cfg(msg.rate()).bits_per_second()));
+}
+
+void goby::acomms::SimChannelDriver::handle_initiate_transmission(
+    const protobuf::ModemTransmission& orig_msg)
+{
+    protobuf::ModemTransmission msg = orig_msg;
+    signal_modify_transmission(&msg);
+
+    const auto& rate = rate_cfg(msg.rate());
+
+    if (!msg.has_frame_start())
+        msg.set_frame_start(next_frame_);
+    if (!msg.has_max_frame_bytes())
+        msg.set_max_frame_bytes(rate.max_frame_bytes());
+    if (!msg.has_max_num_frames())
+        msg.set_max_num_frames(rate.max_frames());
+
+    signal_data_request(&msg);
+
+    if (msg.frame_size() > static_cast<int>(rate.max_frames()))
+    {
+        glog.is(WARN) && glog << group(glog_out_group()) << "Rate " << msg.rate() << " allows "
+                              << rate.max_frames() << " frame(s), discarding "
+                              << msg.frame_size() - rate.max_frames() << " extra" << std::endl;
+        while (msg.frame_size() > static_cast<int>(rate.max_frames()))
+            msg.mutable_frame()->RemoveLast();
+    }
+
+    // a real modem would not send these, and a truncated DCCL frame would not decode
+    for (auto& frame : *msg.mutable_frame())
+    {
+        if (frame.size() > rate.max_frame_bytes())
+        {
+            glog.is(WARN) && glog << group(glog_out_group()) << "Frame of " << frame.size()
+                                  << " bytes exceeds max_frame_bytes (" << rate.max_frame_bytes()
+                                  << ") for rate " << msg.rate() << ", discarding" << std::endl;
+            frame.clear();
+        }
+    }
+
+    glog.is(DEBUG1) && glog << group(glog_out_group())
+                            << "After modification, initiating transmission with " << msg
+                            << std::endl;
+
+    next_frame_ += msg.frame_size();
+
+    if (std::any_of(msg.frame().begin(), msg.frame().end(),
+                    [](const std::string& frame) { return !frame.empty(); }))
+        start_send(msg);
+}
+
+void goby::acomms::SimChannelDriver::do_work()
+{
+    if (!channel_)
+        return;
+
+    for (const auto& msg : channel_->receive(driver_cfg_.modem_id(), SteadyClock::now()))
+        receive_message(msg);
+}
+
+void goby::acomms::SimChannelDriver::start_send(protobuf::ModemTransmission& msg)
+{
+    msg.set_time_with_units(goby::time::SystemClock::now<goby::time::MicroTime>());
+
+    auto duration = transmission_duration(msg);
+    glog.is(DEBUG1) && glog << group(glog_out_group()) << "Transmitting for "
+                            << std::chrono::duration<double>(duration).count() << " s: " << msg
+                            << std::endl;
+
+    if (!signal_raw_outgoing.empty())
+    {
+        protobuf::ModemRaw raw_msg;
+        msg.SerializeToString(raw_msg.mutable_raw());
+        signal_raw_outgoing(raw_msg);
+    }
+
+    if (channel_)
+        channel_->transmit(driver_cfg_.modem_id(), msg, SteadyClock::now(), duration);
+
+    signal_transmit_result(msg);
+}
+
+void goby::acomms::SimChannelDriver::receive_message(const protobuf::ModemTransmission& msg)
+{
+    if (!signal_raw_incoming.empty())
+    {
+        protobuf::ModemRaw raw_msg;
+        msg.SerializeToString(raw_msg.mutable_raw());
+        signal_raw_incoming(raw_msg);
+    }
+
+    glog.is(DEBUG1) && glog << group(glog_in_group()) << "Received: " << msg << std::endl;
+
+    if (msg.type() != protobuf::ModemTransmission::ACK && msg.ack_requested() &&
+        msg.dest() == driver_cfg_.modem_id())
+    {
+        // only acknowledge the frames that made it through the channel
+        protobuf::ModemTransmission ack;
+        ack.set_type(goby::acomms::protobuf::ModemTransmission::ACK);
+        ack.set_src(msg.dest());
+        ack.set_dest(msg.src());
+        ack.set_rate(msg.rate());
+        for (int i = 0, n = msg.frame_size(); i < n; ++i)
+        {
+            if (!msg.frame(i).empty())
+                ack.add_acked_frame(msg.frame_start() + i);
+        }
+        if (ack.acked_frame_size() > 0)
+            start_send(ack);
+    }
+
+    signal_receive(msg);
+}
+
+void goby::acomms::SimChannelDriver::report(protobuf::ModemReport* report)
+{
+    ModemDriverBase::report(report);
+
+    report->set_link_state(channel_ ? protobuf::ModemReport::LINK_AVAILABLE
+                                    : protobuf::ModemReport::LINK_NOT_AVAILABLE);
+    report->set_link_quality(protobuf::ModemReport::QUALITY_UNKNOWN);
+}
@@ -0,0 +1,119 @@
+// Copyright 2023:
+//   GobySoft, LLC (2013-)
+//   Community contributors (see AUTHORS file)
+// File authors:
+//   Toby Schneider <toby@gobysoft.org>
+//
+//
+// This file is part of the Goby Underwater Autonomy Project Libraries
+// ("The Goby Libraries").
+//
+// The Goby Libraries are free software: you can redistribute them and/or modify
+// them under the terms of the GNU Lesser General Public License as published by
+// the Free Software Foundation, either version 2.1 of the License, or
+// (at your option) any later version.
+//
+// The Goby Libraries are distributed in the hope that they will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU Lesser General Public License for more details.
+//
+// You should have received a copy of the GNU Lesser General Public License
+// along with Goby.  If not, see <http://www.gnu.org/licenses/>.
+
+
+#ifndef GOBY_ACOMMS_MODEMDRIVER_SIM_CHANNEL_DRIVER_H
+#define GOBY_ACOMMS_MODEMDRIVER_SIM_CHANNEL_DRIVER_H
+
+#include <cstdint> // for uint32_t, uint64_t
+#include <memory>  // for shared_ptr
+#include <string>  // for string
+
+#include "goby/acomms/modemdriver/driver_base.h"        // for ModemDriverBase
+#include "goby/acomms/protobuf/driver_base.pb.h"        // for DriverConfig
+#include "goby/acomms/protobuf/sim_channel_driver.pb.h" // for Config
+#include "goby/time/steady_clock.h"                     // for SteadyClock
+
+namespace goby
+{
+namespace acomms
+{
+namespace protobuf
+{
+class ModemTransmission;
+} // namespace protobuf
+
+namespace sim_channel
+{
+class Channel;
+
+/// \brief Cumulative statistics for one simulated channel (summed over all receivers)
+struct ChannelStatistics
+{
+    /// number of transmissions (data and acks) put on the channel
+    std::uint64_t transmissions{0};
+    /// sum of the duration of all transmissions
+    goby::time::SteadyClock::duration busy_time{0};
+
+    /// frames transmitted (counted once per transmission)
+    std::uint64_t frames_sent{0};
+    /// frames received intact (counted once per receiver)
+    std::uint64_t frames_received{0};
+    /// bytes in the intact frames
+    std::uint64_t bytes_received{0};
+
+    /// frames lost to packet_loss_probability or bit_error_rate
+    std::uint64_t frames_lost_error{0};
+    /// frames lost due to overlapping arrivals at the receiver
+    std::uint64_t frames_lost_collision{0};
+    /// frames lost since the receiver was transmitting during the arrival
+    std::uint64_t frames_lost_half_duplex{0};
+    /// frames not heard since the receiver was beyond max_range
+    std::uint64_t frames_out_of_range{0};
+};
+} // namespace sim_channel
+
+/// \brief Driver that simulates an acoustic channel between any number of drivers in the same process, including propagation delay, bandwidth limited transmission time, frame loss, collisions and half-duplex operation.
+///
+/// Drivers configured with the same channel name share a single medium. Random frame loss (packet_loss_probability and bit_error_rate) is derived from the configured seed, the sending modem and that modem's own transmission count, so it does not depend on thread scheduling or on how different modems' transmissions interleave. Arrival times, and hence collisions and half-duplex losses, follow the real (SteadyClock) time at which each driver transmits and polls, so these are not reproducible from run to run.
+class SimChannelDriver : public ModemDriverBase
+{
+  public:
+    SimChannelDriver();
+    ~SimChannelDriver() override;
+
+    void startup(const protobuf::DriverConfig& cfg) override;
+    void shutdown() override;
+    void do_work() override;
+    void handle_initiate_transmission(const protobuf::ModemTransmission& m) override;
+
+    void report(protobuf::ModemReport* report) override;
+
+    /// \brief Move this modem (meters, in the same local frame as sim_channel::protobuf::Config::position). Takes effect for subsequent transmissions.
+    void set_position(double x, double y, double z);
+
+    /// \brief Statistics for the given channel name (all zeros if no driver has used it)
+    static sim_channel::ChannelStatistics channel_statistics(const std::string& channel);
+
+  private:
+    void start_send(protobuf::ModemTransmission& msg);
+    void receive_message(const protobuf::ModemTransmission& msg);
+
+    const sim_channel::protobuf::Config::Rate& rate_cfg(int rate) const;
+    goby::time::SteadyClock::duration transmission_duration(const protobuf::ModemTransmission& msg);
+
+    const sim_channel::protobuf::Config& sim_cfg() const
+    {
+        return driver_cfg_.GetExtension(sim_channel::protobuf::config);
+    }
+
+  private:
+    protobuf::DriverConfig driver_cfg_;
+    std::shared_ptr<sim_channel::Channel> channel_;
+    sim_channel::protobuf::Config::Rate default_rate_;
+
+    std::uint32_t next_frame_{0};
+};
+} // namespace acomms
+} // namespace goby
+#endif
@@ -25,6 +25,7 @@ protobuf_generate_cpp(ACOMMS_PROTO_SRCS ACOMMS_PROTO_HDRS
   acomms/protobuf/udp_multicast_driver.proto
   acomms/protobuf/buffer.proto
   acomms/protobuf/popoto_driver.proto
+  acomms/protobuf/sim_channel_driver.proto
   )
 
 set(ACOMMS_SRC
@@ -46,6 +47,7 @@ set(ACOMMS_SRC
   acomms/modemdriver/benthos_atm900_driver_fsm.cpp
   acomms/route/route.cpp
   acomms/modemdriver/popoto_driver.cpp
+  acomms/modemdriver/sim_channel_driver.cpp
   ${ACOMMS_PROTO_SRCS} ${ACOMMS_PROTO_HDRS}
   )
 
@@ -0,0 +1,145 @@
+// Copyright 2023:
+//   GobySoft, LLC (2013-)
+//   Community contributors (see AUTHORS file)
+// File authors:
+//   Toby Schneider <toby@gobysoft.org>
+//
+//
+// This file is part of the Goby Underwater Autonomy Project Binaries
+// ("The Goby Binaries").
+//
+// The Goby Binaries are free software: you can redistribute them and/or modify
+// them under the terms of the GNU General Public License as published by
+// the Free Software Foundation, either version 2 of the License, or
+// (at your option) any later version.
+//
+// The Goby Binaries are distributed in the hope that they will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with Goby.  If not, see <http://www.gnu.org/licenses/>.
+
+#include <algorithm> // for max, min
+#include <chrono>    // for duration
+#include <ostream>   // for endl
+
+#include "goby/util/debug_logger/flex_ostream.h" // for glog
+
+#include "arbiter.h"
+
+bool goby::apps::middleware::SerialMuxArbiter::enqueue(int index, const Data& data)
+{
+    if (index < 0 || index >= static_cast<int>(clients_.size()))
+        return false;
+
+    Client& client = clients_[index];
+    client.queue.push_back(data);
+    client.queue_bytes += data->data().size();
+
+    bool dropped = false;
+    while (client.queue_bytes > client.cfg.max_queue_bytes && client.queue.size() > 1)
+    {
+        auto bytes = client.queue.front()->data().size();
+        client.queue_bytes -= bytes;
+        client.bytes_dropped += bytes;
+        dropped = true;
+        client.queue.pop_front();
+    }
+
+    // warn once each time the queue overflows (until it has been emptied)
+    if (dropped && !client.queue_full)
+    {
+        client.queue_full = true;
+        goby::glog.is_warn() && goby::glog << "Queue for " << client.cfg.name
+                                           << " is full, discarding its oldest data" << std::endl;
+    }
+    return true;
+}
+
+void goby::apps::middleware::SerialMuxArbiter::update(Clock::time_point now)
+{
+    double elapsed = std::chrono::duration<double>(now - last_update_).count();
+    last_update_ = now;
+
+    bytes_in_flight_ = std::max(0.0, bytes_in_flight_ - elapsed * link_.link_rate);
+
+    for (auto& client : clients_)
+    {
+        if (client.cfg.rate_limit > 0)
+            client.tokens = std::min<double>(client.cfg.burst,
+                                             client.tokens + elapsed * client.cfg.rate_limit);
+    }
+}
+
+goby::apps::middleware::SerialMuxArbiter::Client*
+goby::apps::middleware::SerialMuxArbiter::next_client()
+{
+    Client* next = nullptr;
+    for (std::size_t i = 0, n = clients_.size(); i < n; ++i)
+    {
+        Client& client = clients_[(next_index_ + i) % n];
+        if (client.queue.empty() || (client.cfg.rate_limit > 0 && client.tokens <= 0))
+            continue;
+
+        // strictly greater, so the first in turn wins among equal priorities
+        if (!next || client.cfg.priority > next->cfg.priority)
+            next = &client;
+    }
+    return next;
+}
+
+std::shared_ptr<goby::middleware::protobuf::IOData>
+goby::apps::middleware::SerialMuxArbiter::next_write(Clock::time_point now)
+{
+    update(now);
+
+    if (bytes_in_flight_ >= link_.max_bytes_in_flight)
+        return nullptr;
+
+    const auto max_batch = static_cast<std::size_t>(
+        std::min<double>(link_.max_write_batch,
+                         std::max(1.0, link_.max_bytes_in_flight - bytes_in_flight_)));
+
+    auto write = std::make_shared<goby::middleware::protobuf::IOData>();
+    std::string& batch = *write->mutable_data();
+
+    while (Client* client = next_client())
+    {
+        const auto& data = client->queue.front()->data();
+        // messages (lines) are never split, so data from different clients are not interleaved
+        if (!batch.empty() && batch.size() + data.size() > max_batch)
+            break;
+
+        batch += data;
+        client->tokens -= data.size();
+        client->bytes_sent += data.size();
+        client->queue_bytes -= data.size();
+        client->queue.pop_front();
+        if (client->queue.empty())
+            client->queue_full = false;
+
+        next_index_ = (client->index + 1) % clients_.size();
+    }
+
+    if (batch.empty())
+        return nullptr;
+
+    bytes_in_flight_ += batch.size();
+    return write;
+}
+
+void goby::apps::middleware::SerialMuxArbiter::log_stats() const
+{
+    for (const auto& client : clients_)
+    {
+        goby::glog.is_debug1() && goby::glog << client.cfg.name << " (priority "
+                                             << client.cfg.priority
+                                             << "): " << client.bytes_sent << " bytes sent, "
+                                             << client.queue_bytes << " queued, "
+                                             << client.bytes_dropped << " discarded" << std::endl;
+    }
+    goby::glog.is_debug1() && goby::glog << "Bytes in flight: " << bytes_in_flight_ << " (max "
+                                         << link_.max_bytes_in_flight << ")" << std::endl;
+}
@@ -0,0 +1,150 @@
+// Copyright 2023:
+//   GobySoft, LLC (2013-)
+//   Community contributors (see AUTHORS file)
+// File authors:
+//   Toby Schneider <toby@gobysoft.org>
+//
+//
+// This file is part of the Goby Underwater Autonomy Project Binaries
+// ("The Goby Binaries").
+//
+// The Goby Binaries are free software: you can redistribute them and/or modify
+// them under the terms of the GNU General Public License as published by
+// the Free Software Foundation, either version 2 of the License, or
+// (at your option) any later version.
+//
+// The Goby Binaries are distributed in the hope that they will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with Goby.  If not, see <http://www.gnu.org/licenses/>.
+
+#ifndef GOBY_APPS_MIDDLEWARE_SERIAL_MUX_ARBITER_H
+#define GOBY_APPS_MIDDLEWARE_SERIAL_MUX_ARBITER_H
+
+#include <cstdint> // for uint64_t, uint32_t
+#include <deque>   // for deque
+#include <memory>  // for shared_ptr
+#include <string>  // for string
+#include <utility> // for move
+#include <vector>  // for vector
+
+#include "goby/middleware/protobuf/io.pb.h" // for IOData
+#include "goby/time/steady_clock.h"         // for SteadyClock
+
+namespace goby
+{
+namespace apps
+{
+namespace middleware
+{
+/// \brief Decides which of the data written by several clients (the secondary PTYs of goby_serial_mux) are written next to a shared link (the primary serial port)
+///
+/// Clients with the highest priority go first and clients of equal priority are served in turn. Each client may be limited by a token bucket, and its queue is bounded (discarding the oldest data). Queued messages are combined into writes of up to max_write_batch bytes, but are never split. Writes stop while the bytes estimated (from the link rate) to be written but not yet transmitted reach max_bytes_in_flight.
+///
+/// All methods take the current time, so the arbiter can be run in simulated time.
+class SerialMuxArbiter
+{
+  public:
+    using Clock = goby::time::SteadyClock;
+    using Data = std::shared_ptr<const goby::middleware::protobuf::IOData>;
+
+    /// defaults are for a 9600 baud link arbitrated at 50 Hz
+    struct LinkConfig
+    {
+        /// bytes/s transmitted by the link
+        double link_rate{960};
+        /// maximum bytes written but not yet transmitted
+        double max_bytes_in_flight{38.4};
+        /// maximum bytes combined into a single write
+        std::uint32_t max_write_batch{256};
+    };
+
+    struct ClientConfig
+    {
+        /// used in debug output
+        std::string name;
+        int priority{0};
+        /// maximum long-term rate (bytes/s), or 0 for no limit
+        double rate_limit{0};
+        /// token bucket depth (bytes)
+        std::uint32_t burst{256};
+        std::uint32_t max_queue_bytes{16384};
+    };
+
+    struct Client
+    {
+        Client(int i, ClientConfig c) : index(i), cfg(std::move(c)), tokens(cfg.burst) {}
+
+        int index;
+        ClientConfig cfg;
+
+        // token bucket: may go negative, as messages are never split
+        double tokens;
+
+        std::deque<Data> queue;
+        std::size_t queue_bytes{0};
+        bool queue_full{false};
+
+        std::uint64_t bytes_sent{0};
+        std::uint64_t bytes_dropped{0};
+    };
+
+    explicit SerialMuxArbiter(const LinkConfig& link, Clock::time_point now = Clock::now())
+        : link_(link), last_update_(now)
+    {
+    }
+
+    /// \brief Add a client
+    ///
+    /// \return the client's index, used by enqueue()
+    int add_client(const ClientConfig& cfg)
+    {
+        clients_.emplace_back(clients_.size(), cfg);
+        return clients_.back().index;
+    }
+
+    /// \brief Queue data written by a client, discarding its oldest data if its queue is full
+    ///
+    /// \return false if the index is not a client
+    bool enqueue(int index, const Data& data);
+
+    /// \brief Combine queued data (in priority order) into the next write to the link
+    ///
+    /// \return the data to write, or nullptr if there are none or the link is busy
+    std::shared_ptr<goby::middleware::protobuf::IOData> next_write(Clock::time_point now);
+
+    const std::vector<Client>& clients() const { return clients_; }
+
+    /// \brief Estimate of the bytes written to the link but not yet transmitted (as of the last call to next_write())
+    double bytes_in_flight() const { return bytes_in_flight_; }
+
+    /// \brief Log the bytes sent, queued and discarded for each client at debug1
+    void log_stats() const;
+
+  private:
+    // refills the token buckets and drains the bytes in flight up to now
+    void update(Clock::time_point now);
+
+    // highest priority client with data that its rate limit allows to be sent (or nullptr)
+    Client* next_client();
+
+  private:
+    const LinkConfig link_;
+    std::vector<Client> clients_;
+
+    double bytes_in_flight_{0};
+
+    // clients of equal priority are served in turn, starting from this index
+    std::size_t next_index_{0};
+
+    Clock::time_point last_update_;
+};
+
+} // namespace middleware
+} // namespace apps
+} // namespace goby
+
+#endif
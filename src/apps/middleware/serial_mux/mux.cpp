@@ -21,11 +21,12 @@
 // You should have received a copy of the GNU General Public License
 // along with Goby.  If not, see <http://www.gnu.org/licenses/>.
 
+#include <algorithm>                // for max, min
 #include <boost/units/quantity.hpp> // for operator/
+#include <chrono>                   // for seconds, duration
 #include <memory>                   // for shared...
 #include <ostream>                  // for basic_...
 #include <regex>                    // for match_...
-#include <set>                      // for set
 #include <string>                   // for operat...
 #include <unordered_map>            // for unorde...
 #include <vector>                   // for vector
@@ -44,9 +45,12 @@
 #include "goby/middleware/protobuf/pty_config.pb.h"           // for PTYConfig
 #include "goby/middleware/protobuf/serial_config.pb.h"        // for Serial...
 #include "goby/middleware/transport/interthread.h"            // for InterT...
+#include "goby/time/steady_clock.h"                           // for Steady...
 #include "goby/util/debug_logger/flex_ostream.h"              // for operat...
 #include "goby/util/debug_logger/logger_manipulators.h"       // for operat...
 
+#include "arbiter.h"
+
 namespace goby
 {
 namespace apps
@@ -78,9 +82,22 @@ class SerialMux
             goby::middleware::io::PubSubLayer::INTERTHREAD,
             goby::middleware::io::PubSubLayer::INTERTHREAD>;
 
+        // without an arbitration block, writes pass straight through to the primary serial port
+        if (cfg().has_arbitration())
+            configure_arbiter();
+
         interthread().subscribe<groups::pty_secondary_in>(
             [this](const std::shared_ptr<const goby::middleware::protobuf::IOData>& from_pty) {
-                if (allow_write_.count(from_pty->index()))
+                if (from_pty->index() < 0 || from_pty->index() >= cfg().secondary_size() ||
+                    !cfg().secondary(from_pty->index()).allow_write())
+                    return;
+
+                if (arbiter_)
+                {
+                    arbiter_->enqueue(from_pty->index(), from_pty);
+                    send();
+                }
+                else
                 {
                     auto to_serial =
                         std::make_shared<goby::middleware::protobuf::IOData>(*from_pty);
@@ -94,14 +111,66 @@ class SerialMux
         int pty_index = 0;
         for (const auto& secondary_cfg : cfg().secondary())
         {
-            if (secondary_cfg.allow_write())
-                allow_write_.insert(pty_index);
+            if (arbiter_)
+            {
+                SerialMuxArbiter::ClientConfig client_cfg;
+                client_cfg.name = "PTY " + secondary_cfg.pty().port();
+                client_cfg.priority = secondary_cfg.priority();
+                client_cfg.rate_limit = secondary_cfg.rate_limit();
+                client_cfg.burst = secondary_cfg.burst();
+                client_cfg.max_queue_bytes = secondary_cfg.max_queue_bytes();
+                arbiter_->add_client(client_cfg);
+            }
             launch_thread<PTYThread>(pty_index++, secondary_cfg.pty());
         }
+
+        if (arbiter_)
+        {
+            launch_timer<0>(cfg().arbitration().frequency() * boost::units::si::hertz, [this]() {
+                send();
+
+                auto now = goby::time::SteadyClock::now();
+                if (now >= next_stats_time_)
+                {
+                    arbiter_->log_stats();
+                    next_stats_time_ = now + std::chrono::seconds(10);
+                }
+            });
+        }
+    }
+
+  private:
+    void configure_arbiter()
+    {
+        const auto& arbitration_cfg = cfg().arbitration();
+        // the default max_bytes_in_flight divides by this, and nothing would be sent by the timer
+        if (!(arbitration_cfg.frequency() > 0))
+            goby::glog.is_die() && goby::glog << "arbitration.frequency must be positive, not "
+                                              << arbitration_cfg.frequency() << std::endl;
+
+        SerialMuxArbiter::LinkConfig link;
+        link.link_rate = arbitration_cfg.link_rate() > 0 ? arbitration_cfg.link_rate()
+                                                         : cfg().primary_serial().baud() / 10.0;
+        link.max_bytes_in_flight =
+            arbitration_cfg.max_bytes_in_flight() > 0
+                ? arbitration_cfg.max_bytes_in_flight()
+                : std::max(1.0, 2 * link.link_rate / arbitration_cfg.frequency());
+        link.max_write_batch = arbitration_cfg.max_write_batch();
+        arbiter_ = std::make_unique<SerialMuxArbiter>(link);
+    }
+
+    // write the data chosen by the arbiter to the primary serial port
+    void send()
+    {
+        if (auto to_serial = arbiter_->next_write(goby::time::SteadyClock::now()))
+            interthread().publish<groups::serial_primary_out>(to_serial);
     }
 
   private:
-    std::set<int> allow_write_;
+    // only set when the arbitration block is configured
+    std::unique_ptr<SerialMuxArbiter> arbiter_;
+
+    goby::time::SteadyClock::time_point next_stats_time_{goby::time::SteadyClock::now()};
 };
 
 } // namespace middleware
@@ -64,6 +64,7 @@
 #include "goby/acomms/modemdriver/iridium_shore_driver.h"     // for Iridiu...
 #include "goby/acomms/modemdriver/mm_driver.h"                // for MMDriver
 #include "goby/acomms/modemdriver/popoto_driver.h"            // for Popoto...
+#include "goby/acomms/modemdriver/sim_channel_driver.h"       // for SimCha...
 #include "goby/acomms/modemdriver/udp_driver.h"               // for UDPDriver
 #include "goby/acomms/modemdriver/udp_multicast_driver.h"     // for UDPMul...
 #include "goby/acomms/protobuf/amac.pb.h"                     // for MACUpdate
@@ -488,6 +489,12 @@ void goby::apps::moos::CpAcommsHandler::process_configuration()
                  << " is reserved for broadcast messages. You must specify a modem_id != "
                  << goby::acomms::BROADCAST_ID << " for this vehicle." << std::endl;
 
+    // the QueueManager has no way to carry the queue depths and slot allocation
+    if (cfg_.mac_cfg().type() == goby::acomms::protobuf::MAC_ADAPTIVE_DECENTRALIZED)
+        glog.is(DIE) && glog << "mac_cfg.type = MAC_ADAPTIVE_DECENTRALIZED is not supported by "
+                                "pAcommsHandler. Use MAC_FIXED_DECENTRALIZED or MAC_POLLED."
+                             << std::endl;
+
     publish("MODEM_ID", cfg_.modem_id());
     publish("VEHICLE_ID", cfg_.modem_id());
 
@@ -676,6 +683,9 @@ void goby::apps::moos::CpAcommsHandler::create_driver(
             case goby::acomms::protobuf::DRIVER_UDP_MULTICAST:
                 driver.reset(new goby::acomms::UDPMulticastDriver);
                 break;
+            case goby::acomms::protobuf::DRIVER_SIM_CHANNEL:
+                driver.reset(new goby::acomms::SimChannelDriver);
+                break;
 
             case goby::acomms::protobuf::DRIVER_BLUEFIN_MOOS:
                 driver.reset(new goby::moos::BluefinCommsDriver(mac));
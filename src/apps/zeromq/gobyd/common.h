@@ -44,6 +44,12 @@ template <typename Config> void process_intervehicle_config(Config& cfg)
             if (!p.has_name())
                 p.set_name(cfg.interprocess().platform());
         }
+
+        for (auto& link : *intervehicle.mutable_link())
+        {
+            if (link.has_buffer_journal() && !link.buffer_journal().has_name())
+                link.mutable_buffer_journal()->set_name(cfg.interprocess().platform());
+        }
     }
 }
 
@@ -0,0 +1,186 @@
+// Copyright 2023:
+//   GobySoft, LLC (2013-)
+//   Community contributors (see AUTHORS file)
+// File authors:
+//   Toby Schneider <toby@gobysoft.org>
+//
+//
+// This file is part of the Goby Underwater Autonomy Project Libraries
+// ("The Goby Libraries").
+//
+// The Goby Libraries are free software: you can redistribute them and/or modify
+// them under the terms of the GNU Lesser General Public License as published by
+// the Free Software Foundation, either version 2.1 of the License, or
+// (at your option) any later version.
+//
+// The Goby Libraries are distributed in the hope that they will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU Lesser General Public License for more details.
+//
+// You should have received a copy of the GNU Lesser General Public License
+// along with Goby.  If not, see <http://www.gnu.org/licenses/>.
+
+
+#include <algorithm> // for find_if
+#include <cerrno>    // for errno
+#include <climits>   // for CHAR_BIT
+#include <cstring>   // for strerror
+#include <pthread.h> // for pthread_setaffinity_np
+#include <regex>     // for regex_match
+#include <sched.h>   // for sched_param
+#include <vector>    // for vector
+
+#ifdef __linux__
+#include <sys/syscall.h> // for SYS_set_mempolicy
+#include <unistd.h>      // for syscall
+#endif
+
+#include "goby/util/debug_logger.h" // for glog
+
+#include "thread_placement.h"
+
+using goby::glog;
+using goby::middleware::protobuf::AppConfig;
+
+namespace
+{
+void warn_failed(const std::string& what, const std::string& thread_name, int err)
+{
+    glog.is_warn() && glog << "Failed to set " << what << " for thread " << thread_name << ": "
+                           << std::strerror(err) << std::endl;
+}
+
+void warn_invalid(const std::string& what, int value, const std::string& thread_name)
+{
+    glog.is_warn() && glog << "Invalid " << what << " " << value << " in thread_placement for thread "
+                           << thread_name << " (ignoring)" << std::endl;
+}
+
+// largest number of NUMA nodes supported by the Linux kernel (MAX_NUMNODES with NODES_SHIFT = 10)
+constexpr int max_numa_nodes{1024};
+} // namespace
+
+bool goby::middleware::detail::apply_thread_placement(
+    const google::protobuf::RepeatedPtrField<AppConfig::ThreadPlacement>& placements,
+    const std::string& thread_name)
+{
+    for (const auto& placement : placements)
+    {
+        try
+        {
+            if (std::regex_match(thread_name, std::regex(placement.name())))
+            {
+                apply_thread_placement(placement, thread_name);
+                return true;
+            }
+        }
+        catch (const std::regex_error& e)
+        {
+            glog.is_warn() && glog << "Invalid thread_placement name regex \"" << placement.name()
+                                   << "\": " << e.what() << std::endl;
+        }
+    }
+    return false;
+}
+
+bool goby::middleware::detail::apply_thread_placement(
+    const AppConfig::ThreadPlacement& placement, const std::string& thread_name)
+{
+#ifdef __linux__
+    bool ok = true;
+    if (placement.cpu_size() > 0)
+    {
+        // CPU_SET is undefined for values outside of the cpu_set_t
+        auto invalid_cpu = std::find_if(placement.cpu().begin(), placement.cpu().end(),
+                                        [](int cpu) { return cpu < 0 || cpu >= CPU_SETSIZE; });
+        if (invalid_cpu != placement.cpu().end())
+        {
+            warn_invalid("CPU", *invalid_cpu, thread_name);
+            ok = false;
+        }
+        else
+        {
+            cpu_set_t cpus;
+            CPU_ZERO(&cpus);
+            for (auto cpu : placement.cpu()) CPU_SET(cpu, &cpus);
+            if (int err = pthread_setaffinity_np(pthread_self(), sizeof(cpus), &cpus))
+            {
+                warn_failed("CPU affinity", thread_name, err);
+                ok = false;
+            }
+        }
+    }
+
+    if (placement.has_policy())
+    {
+        int policy = SCHED_OTHER;
+        switch (placement.policy())
+        {
+            case AppConfig::ThreadPlacement::SCHED__OTHER: policy = SCHED_OTHER; break;
+            case AppConfig::ThreadPlacement::SCHED__FIFO: policy = SCHED_FIFO; break;
+            case AppConfig::ThreadPlacement::SCHED__RR: policy = SCHED_RR; break;
+        }
+        sched_param param{};
+        param.sched_priority = (policy == SCHED_OTHER) ? 0 : placement.priority();
+        if (int err = pthread_setschedparam(pthread_self(), policy, &param))
+        {
+            warn_failed("scheduling policy", thread_name, err);
+            ok = false;
+        }
+    }
+
+    auto invalid_node =
+        std::find_if(placement.numa_node().begin(), placement.numa_node().end(),
+                     [](int node) { return node < 0 || node >= max_numa_nodes; });
+    if (invalid_node != placement.numa_node().end())
+    {
+        warn_invalid("NUMA node", *invalid_node, thread_name);
+        ok = false;
+    }
+    else if (placement.numa_node_size() > 0)
+    {
+        // values from <numaif.h>, using the system call directly avoids a dependency on libnuma
+        enum
+        {
+            MPOL_PREFERRED = 1,
+            MPOL_BIND = 2,
+            MPOL_INTERLEAVE = 3
+        };
+
+        int mode = MPOL_BIND;
+        switch (placement.memory_policy())
+        {
+            case AppConfig::ThreadPlacement::MEMORY__BIND: mode = MPOL_BIND; break;
+            case AppConfig::ThreadPlacement::MEMORY__PREFERRED: mode = MPOL_PREFERRED; break;
+            case AppConfig::ThreadPlacement::MEMORY__INTERLEAVE: mode = MPOL_INTERLEAVE; break;
+        }
+
+        const int bits_per_word = sizeof(unsigned long) * CHAR_BIT;
+        std::vector<unsigned long> nodemask;
+        for (int i = 0, n = placement.numa_node_size(); i < n; ++i)
+        {
+            // MPOL_PREFERRED takes a single node
+            if (mode == MPOL_PREFERRED && i > 0)
+                break;
+
+            int node = placement.numa_node(i);
+            if (static_cast<int>(nodemask.size()) <= node / bits_per_word)
+                nodemask.resize(node / bits_per_word + 1, 0);
+            nodemask[node / bits_per_word] |= 1ul << (node % bits_per_word);
+        }
+
+        if (syscall(SYS_set_mempolicy, mode, nodemask.data(),
+                    nodemask.size() * bits_per_word + 1) != 0)
+        {
+            warn_failed("memory policy", thread_name, errno);
+            ok = false;
+        }
+    }
+    return ok;
+#else
+    glog.is_warn() && glog << "Thread placement is only supported on Linux (ignoring for thread "
+                           << thread_name << ")" << std::endl;
+    return false;
+#endif
+}
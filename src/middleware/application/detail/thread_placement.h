@@ -0,0 +1,57 @@
+// Copyright 2023:
+//   GobySoft, LLC (2013-)
+//   Community contributors (see AUTHORS file)
+// File authors:
+//   Toby Schneider <toby@gobysoft.org>
+//
+//
+// This file is part of the Goby Underwater Autonomy Project Libraries
+// ("The Goby Libraries").
+//
+// The Goby Libraries are free software: you can redistribute them and/or modify
+// them under the terms of the GNU Lesser General Public License as published by
+// the Free Software Foundation, either version 2.1 of the License, or
+// (at your option) any later version.
+//
+// The Goby Libraries are distributed in the hope that they will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU Lesser General Public License for more details.
+//
+// You should have received a copy of the GNU Lesser General Public License
+// along with Goby.  If not, see <http://www.gnu.org/licenses/>.
+
+
+#ifndef GOBY_MIDDLEWARE_APPLICATION_DETAIL_THREAD_PLACEMENT_H
+#define GOBY_MIDDLEWARE_APPLICATION_DETAIL_THREAD_PLACEMENT_H
+
+#include <string> // for string
+
+#include "goby/middleware/protobuf/app_config.pb.h"
+
+namespace goby
+{
+namespace middleware
+{
+namespace detail
+{
+/// \brief Applies the first entry of \c placements whose name matches \c thread_name to the calling OS thread
+///
+/// Failures (e.g. insufficient privileges for real-time scheduling) are logged as warnings, not thrown.
+/// \return true if an entry matched
+bool apply_thread_placement(
+    const google::protobuf::RepeatedPtrField<protobuf::AppConfig::ThreadPlacement>& placements,
+    const std::string& thread_name);
+
+/// \brief Applies the CPU affinity, scheduling policy and memory policy in \c placement to the calling OS thread
+///
+/// Out of range CPU or NUMA node values cause that part of the placement to be skipped (with a warning), rather than passed to the operating system.
+/// \return true if every setting in \c placement was applied
+bool apply_thread_placement(const protobuf::AppConfig::ThreadPlacement& placement,
+                            const std::string& thread_name);
+
+} // namespace detail
+} // namespace middleware
+} // namespace goby
+
+#endif
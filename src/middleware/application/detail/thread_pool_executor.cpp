@@ -0,0 +1,281 @@
+// Copyright 2023:
+//   GobySoft, LLC (2013-)
+//   Community contributors (see AUTHORS file)
+// File authors:
+//   Toby Schneider <toby@gobysoft.org>
+//
+//
+// This file is part of the Goby Underwater Autonomy Project Libraries
+// ("The Goby Libraries").
+//
+// The Goby Libraries are free software: you can redistribute them and/or modify
+// them under the terms of the GNU Lesser General Public License as published by
+// the Free Software Foundation, either version 2.1 of the License, or
+// (at your option) any later version.
+//
+// The Goby Libraries are distributed in the hope that they will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU Lesser General Public License for more details.
+//
+// You should have received a copy of the GNU Lesser General Public License
+// along with Goby.  If not, see <http://www.gnu.org/licenses/>.
+
+
+#include <algorithm> // for max
+#include <pthread.h> // for pthread_setname_np
+#include <string>    // for to_string
+#include <thread>    // for yield
+
+#include "thread_pool_executor.h"
+
+using goby::middleware::detail::ThreadPoolExecutor;
+
+namespace
+{
+// index into workers_ of the worker running on this OS thread (-1 for non-workers)
+thread_local int current_worker{-1};
+// task currently running on this OS thread
+thread_local ThreadPoolExecutor::Task* current_task{nullptr};
+
+// substitutes the task's ThreadId for the worker's while the task runs
+struct ThreadIdScope
+{
+    ThreadIdScope(goby::middleware::ThreadId id)
+    {
+        goby::middleware::detail::thread_id_override() = id;
+    }
+    ~ThreadIdScope()
+    {
+        goby::middleware::detail::thread_id_override() = goby::middleware::ThreadId();
+    }
+};
+} // namespace
+
+void ThreadPoolExecutor::Task::wake()
+{
+    int state = state_.load();
+    while (true)
+    {
+        switch (state)
+        {
+            case IDLE:
+                if (state_.compare_exchange_weak(state, QUEUED))
+                {
+                    executor_.enqueue(shared_from_this());
+                    return;
+                }
+                break;
+            case RUNNING:
+                // the worker running this task will requeue it when the current step completes
+                if (state_.compare_exchange_weak(state, RUNNING_WOKEN))
+                    return;
+                break;
+            default: return;
+        }
+    }
+}
+
+void ThreadPoolExecutor::Task::wait()
+{
+    std::unique_lock<std::mutex> lock(complete_mutex_);
+    complete_cv_.wait(lock, [this]() { return state_ == COMPLETE; });
+}
+
+ThreadPoolExecutor::ThreadPoolExecutor(int num_workers,
+                                       std::function<void(int worker_index)> on_worker_start)
+    : on_worker_start_(std::move(on_worker_start))
+{
+    if (num_workers <= 0)
+        num_workers = std::max(1u, std::thread::hardware_concurrency());
+
+    for (int i = 0; i < num_workers; ++i) workers_.emplace_back(new Worker);
+
+    for (int i = 0; i < num_workers; ++i)
+    {
+        workers_[i]->thread = std::thread([this, i]() { run_worker(i); });
+#ifndef __APPLE__
+        // set thread name for debugging purposes
+        std::string name = "goby::pool/" + std::to_string(i);
+        pthread_setname_np(workers_[i]->thread.native_handle(), name.c_str());
+#endif
+    }
+}
+
+ThreadPoolExecutor::~ThreadPoolExecutor()
+{
+    {
+        std::lock_guard<std::mutex> lock(mutex_);
+        running_ = false;
+    }
+    cv_.notify_all();
+    for (auto& worker : workers_) worker->thread.join();
+}
+
+std::shared_ptr<ThreadPoolExecutor::Task> ThreadPoolExecutor::launch(StepFunction step)
+{
+    std::shared_ptr<Task> task(new Task(*this, std::move(step)));
+    task->wake();
+    return task;
+}
+
+std::shared_ptr<ThreadPoolExecutor::Task> ThreadPoolExecutor::this_task()
+{
+    return current_task ? current_task->shared_from_this() : std::shared_ptr<Task>();
+}
+
+void ThreadPoolExecutor::enqueue(std::shared_ptr<Task> task)
+{
+    // keep tasks woken by a worker on that worker (likely to have the data in cache)
+    int index = current_worker >= 0 ? current_worker : next_worker_++ % workers_.size();
+    {
+        std::lock_guard<std::mutex> lock(workers_[index]->queue_mutex);
+        workers_[index]->queue.push_back(std::move(task));
+    }
+
+    ++queued_;
+    {
+        // ensure an idle worker isn't between checking queued_ and waiting on cv_
+        std::lock_guard<std::mutex> lock(mutex_);
+    }
+    cv_.notify_one();
+}
+
+std::shared_ptr<ThreadPoolExecutor::Task> ThreadPoolExecutor::dequeue(int worker_index)
+{
+    const int n = workers_.size();
+    for (int k = 0; k < n; ++k)
+    {
+        auto& worker = *workers_[(worker_index + k) % n];
+        std::lock_guard<std::mutex> lock(worker.queue_mutex);
+        if (worker.queue.empty())
+            continue;
+
+        std::shared_ptr<Task> task;
+        if (k == 0)
+        {
+            // own queue: oldest first
+            task = std::move(worker.queue.front());
+            worker.queue.pop_front();
+        }
+        else
+        {
+            // steal from the other end to limit contention with the owner
+            task = std::move(worker.queue.back());
+            worker.queue.pop_back();
+        }
+        --queued_;
+        return task;
+    }
+    return nullptr;
+}
+
+void ThreadPoolExecutor::run_worker(int worker_index)
+{
+    current_worker = worker_index;
+    if (on_worker_start_)
+        on_worker_start_(worker_index);
+    while (true)
+    {
+        if (auto task = dequeue(worker_index))
+        {
+            run_step(task);
+            // a worker kept busy (e.g. by a loop() with infinite frequency) must still fire the
+            // timers once they are due
+            if (Clock::now().time_since_epoch().count() < next_timer_)
+                continue;
+        }
+
+        std::vector<std::shared_ptr<Task>> expired;
+        {
+            std::unique_lock<std::mutex> lock(mutex_);
+            if (!running_)
+                return;
+
+            auto now = Clock::now();
+            while (!timers_.empty() && timers_.begin()->first <= now)
+            {
+                // stale entries (task complete or its deadline has since changed) are discarded
+                auto task = timers_.begin()->second.lock();
+                if (task && task->timer_ == timers_.begin()->first)
+                {
+                    task->timer_ = Clock::time_point::max();
+                    expired.push_back(task);
+                }
+                timers_.erase(timers_.begin());
+            }
+            next_timer_ = timers_.empty() ? Clock::time_point::max().time_since_epoch().count()
+                                          : timers_.begin()->first.time_since_epoch().count();
+
+            if (expired.empty() && queued_ == 0)
+            {
+                if (timers_.empty())
+                    cv_.wait(lock);
+                else
+                    cv_.wait_until(lock, timers_.begin()->first);
+            }
+        }
+
+        for (auto& task : expired) task->wake();
+    }
+}
+
+void ThreadPoolExecutor::run_step(const std::shared_ptr<Task>& task)
+{
+    task->state_ = Task::RUNNING;
+
+    Clock::time_point next_run = Clock::time_point::max();
+    bool more = false;
+    {
+        ThreadIdScope id_scope(task->id_);
+        current_task = task.get();
+        more = task->step_(next_run);
+        // release anything held by the step function while the task's ThreadId is still in effect
+        if (!more)
+            task->step_ = nullptr;
+        current_task = nullptr;
+    }
+
+    if (!more)
+    {
+        {
+            std::lock_guard<std::mutex> lock(task->complete_mutex_);
+            task->state_ = Task::COMPLETE;
+        }
+        task->complete_cv_.notify_all();
+        return;
+    }
+
+    bool due = next_run <= Clock::now();
+    if (!due && next_run != Clock::time_point::max())
+    {
+        bool earliest = false;
+        {
+            std::lock_guard<std::mutex> lock(mutex_);
+            if (task->timer_ != next_run)
+            {
+                task->timer_ = next_run;
+                earliest = timers_.empty() || next_run < timers_.begin()->first;
+                timers_.emplace(next_run, task);
+                if (earliest)
+                    next_timer_ = next_run.time_since_epoch().count();
+            }
+        }
+        // an idle worker may be waiting on a later timer
+        if (earliest)
+            cv_.notify_one();
+    }
+
+    int expected = Task::RUNNING;
+    if (due || !task->state_.compare_exchange_strong(expected, Task::IDLE))
+    {
+        // woken while running (or loop() is already due)
+        task->state_ = Task::QUEUED;
+        enqueue(task);
+
+        // a task that is always due (loop() at infinite frequency) would otherwise keep this
+        // worker from ever giving up its core to other OS threads
+        if (due)
+            std::this_thread::yield();
+    }
+}
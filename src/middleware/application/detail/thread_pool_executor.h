@@ -0,0 +1,152 @@
+// Copyright 2023:
+//   GobySoft, LLC (2013-)
+//   Community contributors (see AUTHORS file)
+// File authors:
+//   Toby Schneider <toby@gobysoft.org>
+//
+//
+// This file is part of the Goby Underwater Autonomy Project Libraries
+// ("The Goby Libraries").
+//
+// The Goby Libraries are free software: you can redistribute them and/or modify
+// them under the terms of the GNU Lesser General Public License as published by
+// the Free Software Foundation, either version 2.1 of the License, or
+// (at your option) any later version.
+//
+// The Goby Libraries are distributed in the hope that they will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU Lesser General Public License for more details.
+//
+// You should have received a copy of the GNU Lesser General Public License
+// along with Goby.  If not, see <http://www.gnu.org/licenses/>.
+
+
+#ifndef GOBY_MIDDLEWARE_APPLICATION_DETAIL_THREAD_POOL_EXECUTOR_H
+#define GOBY_MIDDLEWARE_APPLICATION_DETAIL_THREAD_POOL_EXECUTOR_H
+
+#include <atomic>             // for atomic
+#include <chrono>             // for steady_clock
+#include <condition_variable> // for condition_variable
+#include <deque>              // for deque
+#include <functional>         // for function
+#include <map>                // for multimap
+#include <memory>             // for shared_ptr
+#include <mutex>              // for mutex
+#include <thread>             // for thread
+#include <vector>             // for vector
+
+#include "goby/middleware/common.h"
+
+namespace goby
+{
+namespace middleware
+{
+namespace detail
+{
+/// \brief Runs many goby Threads as tasks on a fixed pool of OS threads (used by MultiThreadApplication when AppConfig::thread_pool_cfg::enable is set)
+///
+/// Each task is a non-blocking step function that is called whenever the task is woken (by data published to it, via PollerWakeHook) or when the time it returned from its previous step is reached (for loop()). A task never runs on two workers at once, but may move between workers from step to step. While a task runs, its ThreadId is substituted for the worker's (see this_thread_id()) so that the interthread layer treats each task as a separate thread.
+///
+/// Each worker has its own queue; idle workers steal from the others.
+class ThreadPoolExecutor
+{
+  public:
+    using Clock = std::chrono::steady_clock;
+
+    /// \brief Runs one (non-blocking) step of a task
+    ///
+    /// \param next_run Set to the time at which the task must be run again even if not woken, or Clock::time_point::max()
+    /// \return false if the task is complete
+    using StepFunction = std::function<bool(Clock::time_point& next_run)>;
+
+    class Task : public std::enable_shared_from_this<Task>
+    {
+      public:
+        /// \brief Schedule this task to run (as soon as a worker is available). Safe to call from any thread
+        void wake();
+
+        /// \brief Block until this task is complete
+        void wait();
+
+        ThreadId id() const { return id_; }
+
+      private:
+        friend class ThreadPoolExecutor;
+        Task(ThreadPoolExecutor& executor, StepFunction step)
+            : executor_(executor), step_(std::move(step)), id_(ThreadId::create())
+        {
+        }
+
+        enum State
+        {
+            IDLE,
+            QUEUED,
+            RUNNING,
+            RUNNING_WOKEN,
+            COMPLETE
+        };
+
+        ThreadPoolExecutor& executor_;
+        StepFunction step_;
+        const ThreadId id_;
+        std::atomic<int> state_{IDLE};
+
+        // protected by executor_.mutex_
+        Clock::time_point timer_{Clock::time_point::max()};
+
+        std::mutex complete_mutex_;
+        std::condition_variable complete_cv_;
+    };
+
+    /// \param num_workers Number of OS threads to create (zero uses the number of cores)
+    /// \param on_worker_start If set, called by each worker thread (with its index) before it runs any tasks
+    explicit ThreadPoolExecutor(int num_workers = 0,
+                                std::function<void(int worker_index)> on_worker_start = nullptr);
+
+    /// \brief Stops the workers. All tasks must be complete
+    ~ThreadPoolExecutor();
+
+    /// \brief Create a task and schedule its first step
+    std::shared_ptr<Task> launch(StepFunction step);
+
+    /// \brief The task currently running on this OS thread, or nullptr if not called from a step
+    static std::shared_ptr<Task> this_task();
+
+    int num_workers() const { return workers_.size(); }
+
+  private:
+    struct Worker
+    {
+        std::mutex queue_mutex;
+        std::deque<std::shared_ptr<Task>> queue;
+        std::thread thread;
+    };
+
+    void enqueue(std::shared_ptr<Task> task);
+    std::shared_ptr<Task> dequeue(int worker_index);
+    void run_worker(int worker_index);
+    void run_step(const std::shared_ptr<Task>& task);
+
+  private:
+    std::function<void(int worker_index)> on_worker_start_;
+    std::vector<std::unique_ptr<Worker>> workers_;
+    std::atomic<unsigned> next_worker_{0};
+    // number of tasks in all the worker queues
+    std::atomic<int> queued_{0};
+
+    // protects timers_, Task::timer_ and running_; idle workers wait on cv_
+    std::mutex mutex_;
+    std::condition_variable cv_;
+    std::multimap<Clock::time_point, std::weak_ptr<Task>> timers_;
+    bool running_{true};
+    // earliest deadline in timers_, so that busy workers can check for expired timers without
+    // locking mutex_
+    std::atomic<Clock::rep> next_timer_{Clock::time_point::max().time_since_epoch().count()};
+};
+
+} // namespace detail
+} // namespace middleware
+} // namespace goby
+
+#endif
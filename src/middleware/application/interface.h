@@ -38,6 +38,7 @@
 #include "goby/middleware/application/configurator.h"
 #include "goby/middleware/marshalling/detail/dccl_serializer_parser.h"
 #include "goby/middleware/protobuf/app_config.pb.h"
+#include "goby/middleware/transport/metrics.h"
 #include "goby/time.h"
 #include "goby/util/debug_logger.h"
 #include "goby/util/geodesy.h"
@@ -128,6 +129,9 @@ template <typename Config> class Application
 
     std::string app_name() { return app3_base_configuration_->name(); }
 
+    /// \brief Accesses the base application configuration (the "app" block of the configuration)
+    const protobuf::AppConfig& app3_base_cfg() { return *app3_base_configuration_; }
+
   protected:
     void configure_geodesy(goby::util::UTMGeodesy::LatLonPoint datum);
 
@@ -178,6 +182,8 @@ template <typename Config> goby::middleware::Application<Config>::Application()
     if (!app3_base_configuration_->IsInitialized())
         throw(middleware::ConfigException("Invalid base configuration"));
 
+    metrics::Registry::configure(app3_base_configuration_->metrics_cfg());
+
     glog.is_debug2() && glog << "Application: constructed with PID: " << getpid() << std::endl;
     glog.is_debug1() && glog << "App name is " << app3_base_configuration_->name() << std::endl;
     glog.is_debug2() && glog << "Configuration is: " << app_cfg_->DebugString() << std::endl;
@@ -249,6 +255,9 @@ template <typename Config> void goby::middleware::Application<Config>::configure
 
     if (app3_base_configuration_->glog_config().show_dccl_log())
         goby::middleware::detail::DCCLSerializerParserHelperBase::setup_dlog();
+
+    if (app3_base_configuration_->glog_config().async())
+        glog.enable_async(app3_base_configuration_->glog_config().async_queue_size());
 }
 
 template <typename Config>
@@ -315,8 +324,13 @@ int goby::run(const goby::middleware::ConfiguratorInterface<typename App::Config
                 goby::time::SimulatorSettings::reference_time =
                     std::chrono::system_clock::time_point(std::chrono::microseconds(
                         App::app3_base_configuration_->simulation().time().reference_microtime()));
+            if (App::app3_base_configuration_->simulation().time().discrete_event())
+                goby::time::DiscreteEventScheduler::enable();
         }
 
+        // the main thread takes part in the discrete event simulation (if enabled)
+        goby::time::DiscreteEventScheduler::Participant main_thread_participant;
+
         // instantiate the application (with the configuration already set)
         App app;
         return_value = app.__run();
@@ -325,11 +339,14 @@ int goby::run(const goby::middleware::ConfiguratorInterface<typename App::Config
     {
         // some other exception
         std::cerr << "Application:: uncaught exception: " << e.what() << std::endl;
+        goby::glog.disable_async();
         throw;
     }
 
     goby::glog.is_debug2() && goby::glog << "goby::run: exiting cleanly with code: " << return_value
                                          << std::endl;
+    // the file log stream (Application::fout_) may be destroyed before glog
+    goby::glog.disable_async();
     return return_value;
 }
 
@@ -34,6 +34,8 @@
 
 #include "goby/exception.h"
 #include "goby/middleware/application/detail/interprocess_common.h"
+#include "goby/middleware/application/detail/thread_placement.h"
+#include "goby/middleware/application/detail/thread_pool_executor.h"
 #include "goby/middleware/application/detail/thread_type_selector.h"
 #include "goby/middleware/application/groups.h"
 #include "goby/middleware/application/interface.h"
@@ -103,16 +105,30 @@ class MultiThreadApplicationBase : public goby::middleware::Application<Config>,
                 alive = false;
                 thread->join();
             }
+            else if (task)
+            {
+                goby::glog.is(goby::util::logger::DEBUG1) &&
+                    goby::glog << "Joining pooled thread: " << name << std::endl;
+                alive = false;
+                task->wake();
+                task->wait();
+            }
         }
 
+        bool joinable() const { return thread || task; }
+
         std::atomic<bool> alive{true};
         std::string name;
         int uid;
         std::unique_ptr<std::thread> thread;
+        // set instead of thread when run on the thread pool
+        std::shared_ptr<detail::ThreadPoolExecutor::Task> task;
     };
 
     static std::exception_ptr thread_exception_;
 
+    // must outlive threads_
+    std::unique_ptr<detail::ThreadPoolExecutor> thread_pool_;
     std::map<std::type_index, std::map<int, ThreadManagement>> threads_;
     int thread_uid_{0};
     int running_thread_count_{0};
@@ -179,6 +195,33 @@ class MultiThreadApplicationBase : public goby::middleware::Application<Config>,
     {
         goby::glog.set_lock_action(goby::util::logger_lock::lock);
 
+        const auto& placements = this->app3_base_cfg().thread_placement();
+        detail::apply_thread_placement(placements, this->app_name());
+
+        const auto& thread_pool_cfg = this->app3_base_cfg().thread_pool_cfg();
+        if (thread_pool_cfg.enable() && time::DiscreteEventScheduler::enabled())
+        {
+            goby::glog.is(goby::util::logger::WARN) &&
+                goby::glog << "thread_pool_cfg.enable is ignored when running a discrete event "
+                              "simulation (each thread must wait on the simulated clock)"
+                           << std::endl;
+        }
+        else if (thread_pool_cfg.enable())
+        {
+            std::function<void(int)> on_worker_start;
+            if (placements.size() > 0)
+                on_worker_start = [this](int worker_index) {
+                    detail::apply_thread_placement(this->app3_base_cfg().thread_placement(),
+                                                   "goby::pool/" + std::to_string(worker_index));
+                };
+
+            thread_pool_.reset(
+                new detail::ThreadPoolExecutor(thread_pool_cfg.num_workers(), on_worker_start));
+            goby::glog.is(goby::util::logger::DEBUG1) &&
+                goby::glog << "Running threads on a pool of " << thread_pool_->num_workers()
+                           << " workers" << std::endl;
+        }
+
         interthread_.template subscribe<MainThreadBase::joinable_group_>(
             [this](const ThreadIdentifier& joinable) {
                 _join_thread(joinable.type_i, joinable.index);
@@ -238,6 +281,10 @@ class MultiThreadApplicationBase : public goby::middleware::Application<Config>,
     template <typename ThreadType, typename ThreadConfig, bool has_index, bool has_config>
     void _launch_thread(int index, const ThreadConfig& cfg);
 
+    template <typename ThreadType, typename ThreadConfig, bool has_index, bool has_config>
+    void _launch_pooled_thread(int index, const ThreadConfig& cfg,
+                               ThreadManagement& thread_manager);
+
     void _join_thread(const std::type_index& type_i, int index);
 };
 
@@ -312,6 +359,10 @@ class MultiThreadApplication
                 }
 
                 this->thread_health(*health_response->mutable_main());
+                if (metrics::Registry::enabled() &&
+                    this->app_cfg().app().metrics_cfg().include_in_health())
+                    *health_response->mutable_transporter_metrics() =
+                        metrics::Registry::snapshot();
                 this->interthread().template publish<groups::health_response>(health_response);
             });
 
@@ -428,12 +479,34 @@ void goby::middleware::MultiThreadApplicationBase<Config, Transporter>::_launch_
         thread_manager.name += "/" + std::to_string(index);
     thread_manager.uid = thread_uid_++;
 
+    if (thread_pool_ && ThreadType::run_in_thread_pool)
+    {
+        _launch_pooled_thread<ThreadType, ThreadConfig, has_index, has_config>(index, cfg,
+                                                                              thread_manager);
+        ++running_thread_count_;
+        return;
+    }
+
+    // counted before the thread starts so that simulated time cannot advance until it first waits
+    bool sim_participant =
+        ThreadType::run_in_thread_pool && time::DiscreteEventScheduler::enabled();
+    if (sim_participant)
+        time::DiscreteEventScheduler::reserve_participant();
+
     // copy configuration
-    auto thread_lambda = [this, type_i, index, cfg, &thread_manager]() {
+    auto thread_lambda = [this, type_i, index, cfg, &thread_manager, sim_participant]() {
+        // threads that block outside of poll() (e.g. IOThread) cannot take part in the simulation
+        std::unique_ptr<time::DiscreteEventScheduler::Participant> participant;
+        if (sim_participant)
+            participant.reset(new time::DiscreteEventScheduler::Participant(true));
+
 #ifdef __APPLE__
         // set thread name for debugging purposes
         pthread_setname_np(thread_manager.name.c_str());
 #endif
+        // before constructing the thread so that its allocations follow any memory policy
+        detail::apply_thread_placement(this->app3_base_cfg().thread_placement(),
+                                       thread_manager.name);
         try
         {
             std::shared_ptr<ThreadType> goby_thread(
@@ -463,6 +536,58 @@ void goby::middleware::MultiThreadApplicationBase<Config, Transporter>::_launch_
     ++running_thread_count_;
 }
 
+template <class Config, class Transporter>
+template <typename ThreadType, typename ThreadConfig, bool has_index, bool has_config>
+void goby::middleware::MultiThreadApplicationBase<Config, Transporter>::_launch_pooled_thread(
+    int index, const ThreadConfig& cfg, ThreadManagement& thread_manager)
+{
+    std::type_index type_i = std::type_index(typeid(ThreadType));
+
+    // the same steps as the thread_lambda in _launch_thread, split so that each call returns without blocking
+    std::shared_ptr<ThreadType> goby_thread;
+    auto step = [this, type_i, index, cfg, &thread_manager,
+                 goby_thread](detail::ThreadPoolExecutor::Clock::time_point& next_run) mutable {
+        try
+        {
+            if (!goby_thread)
+            {
+                goby_thread =
+                    detail::ThreadTypeSelector<ThreadType, ThreadConfig, has_index,
+                                               has_config>::thread(cfg, index);
+
+                goby_thread->set_name(thread_manager.name);
+                goby_thread->set_type_index(type_i);
+                goby_thread->set_uid(thread_manager.uid);
+
+                std::weak_ptr<detail::ThreadPoolExecutor::Task> task =
+                    detail::ThreadPoolExecutor::this_task();
+                goby_thread->pooled_start(thread_manager.alive, [task]() {
+                    if (auto t = task.lock())
+                        t->wake();
+                });
+            }
+
+            if (thread_manager.alive)
+            {
+                next_run = goby_thread->pooled_run_once();
+                if (thread_manager.alive)
+                    return true;
+            }
+            goby_thread->pooled_finish();
+        }
+        catch (...)
+        {
+            thread_exception_ = std::current_exception();
+        }
+
+        goby_thread.reset();
+        interthread_.publish<MainThreadBase::joinable_group_>(ThreadIdentifier{type_i, index});
+        return false;
+    };
+
+    thread_manager.task = thread_pool_->launch(step);
+}
+
 template <class Config, class Transporter>
 void goby::middleware::MultiThreadApplicationBase<Config, Transporter>::_join_thread(
     const std::type_index& type_i, int index)
@@ -471,14 +596,24 @@ void goby::middleware::MultiThreadApplicationBase<Config, Transporter>::_join_th
         throw(Exception(std::string("No thread of type: ") + type_i.name() + " and index " +
                         std::to_string(index) + " to join."));
 
-    if (threads_[type_i][index].thread)
+    auto& thread_manager = threads_[type_i][index];
+    if (thread_manager.joinable())
     {
         goby::glog.is(goby::util::logger::DEBUG1) &&
             goby::glog << "Joining thread: " << type_i.name() << " index " << index << std::endl;
 
-        threads_[type_i][index].alive = false;
-        threads_[type_i][index].thread->join();
-        threads_[type_i][index].thread.reset();
+        thread_manager.alive = false;
+        if (thread_manager.thread)
+        {
+            thread_manager.thread->join();
+            thread_manager.thread.reset();
+        }
+        else
+        {
+            thread_manager.task->wake();
+            thread_manager.task->wait();
+            thread_manager.task.reset();
+        }
         --running_thread_count_;
 
         goby::glog.is(goby::util::logger::DEBUG1) &&
@@ -98,6 +98,9 @@ class SingleThreadApplication : public goby::middleware::Application<Config>,
                 resp.set_name(this->app_name());
                 resp.set_pid(getpid());
                 this->thread_health(*resp.mutable_main());
+                if (metrics::Registry::enabled() &&
+                    this->app_cfg().app().metrics_cfg().include_in_health())
+                    *resp.mutable_transporter_metrics() = metrics::Registry::snapshot();
                 this->interprocess().template publish<groups::health_response>(resp);
             });
 
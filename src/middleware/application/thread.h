@@ -25,8 +25,11 @@
 #ifndef GOBY_MIDDLEWARE_APPLICATION_THREAD_H
 #define GOBY_MIDDLEWARE_APPLICATION_THREAD_H
 
+#include <algorithm>
 #include <atomic>
 #include <chrono>
+#include <cmath>
+#include <functional>
 #include <memory>
 #include <mutex>
 #include <typeindex>
@@ -36,9 +39,11 @@
 #include "goby/exception.h"
 #include "goby/middleware/marshalling/interface.h"
 #include "goby/middleware/protobuf/coroner.pb.h"
+#include "goby/middleware/transport/metrics.h"
 
 #include "goby/middleware/common.h"
 #include "goby/middleware/group.h"
+#include "goby/time/discrete_event.h"
 #include "goby/time/simulation.h"
 
 namespace goby
@@ -65,6 +70,7 @@ template <typename Config, typename TransporterType> class Thread
     boost::units::quantity<boost::units::si::frequency> loop_frequency_;
     std::chrono::steady_clock::time_point loop_time_;
     unsigned long long loop_count_{0};
+
     const Config cfg_;
     int index_;
     std::atomic<bool>* alive_{nullptr};
@@ -125,20 +131,96 @@ template <typename Config, typename TransporterType> class Thread
 
     virtual ~Thread() {}
 
+    /// \brief Timing of loop() and of the subscription callbacks run by this thread (also reported in ThreadHealth::loop_period and ThreadHealth::loop_timing)
+    struct LoopTiming
+    {
+        /// \brief Record the start of a call to loop() that was scheduled for the given time. The period and lateness are both derived from this one measurement.
+        ///
+        /// \param expected_period seconds between calls to loop() at the configured frequency
+        void record_loop_start(std::chrono::steady_clock::time_point start,
+                               std::chrono::steady_clock::time_point scheduled,
+                               double expected_period)
+        {
+            if (last_loop_start_ != std::chrono::steady_clock::time_point())
+            {
+                double seconds = std::chrono::duration<double>(start - last_loop_start_).count();
+                ++period.count;
+                double delta = seconds - period.mean;
+                period.mean += delta / period.count;
+                period.m2 += delta * (seconds - period.mean);
+                period.max_error = std::max(period.max_error, std::abs(seconds - expected_period));
+            }
+            last_loop_start_ = start;
+            lateness.add(std::max(start - scheduled, decltype(start - scheduled)(0)));
+        }
+
+        /// period between successive calls to loop() in seconds (fixed frequency threads only)
+        struct Period
+        {
+            unsigned long long count{0};
+            /// running mean and sum of squared differences from the mean (Welford's method)
+            double mean{0};
+            double m2{0};
+            /// largest difference from the configured period
+            double max_error{0};
+        };
+        Period period;
+
+        /// how late each call to loop() started relative to its scheduled time (fixed frequency threads only)
+        metrics::DurationHistogram lateness;
+        /// execution time of loop() (fixed frequency threads only)
+        metrics::DurationHistogram loop_time;
+        /// execution time of the subscription callbacks run by each poll that handled data
+        metrics::DurationHistogram callback_time;
+        /// number of calls to loop() that finished after the next call was due
+        std::atomic<std::uint64_t> overruns{0};
+
+      private:
+        std::chrono::steady_clock::time_point last_loop_start_;
+    };
+
+    const LoopTiming& loop_timing() const { return loop_timing_; }
+
     /// \brief Run the thread until the boolean reference passed is set false. This call blocks, and should be run in a std::thread by the caller.
     ///
     /// \param alive Reference to an atomic boolean. While alive is true, the thread will run; when alive is set false, the thread will complete (and become joinable), assuming nothing is blocking loop() or any transporter callback.
     void run(std::atomic<bool>& alive)
+    {
+        pooled_start(alive);
+        while (alive) { run_once(); }
+        pooled_finish();
+    }
+
+    /// \brief Set to false in subclasses whose loop() or callbacks block (e.g. io::IOThread) so that they are always given their own OS thread, even when MultiThreadApplication is configured to use a thread pool. Such threads also do not take part in a discrete event simulation (time::DiscreteEventScheduler)
+    static constexpr bool run_in_thread_pool{true};
+
+    /// \brief Used by ThreadPoolExecutor in place of run(): performs everything run() does before the first call to run_once()
+    ///
+    /// \param alive See run()
+    /// \param wake If set, called whenever data are published to this thread (in addition to the usual condition variable notification)
+    void pooled_start(std::atomic<bool>& alive, std::function<void()> wake = std::function<void()>())
     {
         alive_ = &alive;
         do_subscribe();
+        if (wake)
+            transporter_->wake_hook()->set(wake);
         initialize();
-        while (alive) { run_once(); }
+    }
+
+    /// \brief Used by ThreadPoolExecutor in place of run(): a non-blocking run_once()
+    ///
+    /// \return the time at which this method must be called again (if not woken earlier by incoming data), or time_point::max() if only incoming data will require it to be called
+    std::chrono::steady_clock::time_point pooled_run_once();
+
+    /// \brief Used by ThreadPoolExecutor in place of run(): performs everything run() does after alive is false
+    void pooled_finish()
+    {
         if (!finalize_run_)
         {
             finalize();
             finalize_run_ = true;
         }
+        transporter_->wake_hook()->clear();
     }
 
     /// \return the Thread index (for multiple instantiations)
@@ -160,7 +242,7 @@ template <typename Config, typename TransporterType> class Thread
     Thread(const Config& cfg, boost::units::quantity<boost::units::si::frequency> loop_freq,
            int index = -1)
         : loop_frequency_(loop_freq),
-          loop_time_(std::chrono::steady_clock::now()),
+          loop_time_(loop_clock_now()),
           cfg_(cfg),
           index_(index),
           thread_id_(goby::middleware::gettid()),
@@ -171,7 +253,7 @@ template <typename Config, typename TransporterType> class Thread
             loop_frequency_hertz() != std::numeric_limits<double>::infinity())
         {
             unsigned long long microsec_interval =
-                1000000.0 / (loop_frequency_hertz() * time::SimulatorSettings::warp_factor);
+                1000000.0 / (loop_frequency_hertz() * loop_warp_factor());
 
             unsigned long long ticks_since_epoch =
                 std::chrono::duration_cast<std::chrono::microseconds>(loop_time_.time_since_epoch())
@@ -216,6 +298,31 @@ template <typename Config, typename TransporterType> class Thread
 #endif
         if (uid_ >= 0)
             health.set_uid(uid_);
+
+        const auto& period = loop_timing_.period;
+        if (period.count > 0)
+        {
+            auto& loop_period = *health.mutable_loop_period();
+            loop_period.set_count(period.count);
+            loop_period.set_expected(expected_loop_period());
+            loop_period.set_mean(period.mean);
+            loop_period.set_jitter(period.count > 1 ? std::sqrt(period.m2 / (period.count - 1))
+                                                    : 0);
+            loop_period.set_max_error(period.max_error);
+        }
+
+        if (loop_timing_.loop_time.count() > 0 || loop_timing_.callback_time.count() > 0)
+        {
+            auto& loop_timing = *health.mutable_loop_timing();
+            if (loop_timing_.lateness.count() > 0)
+                loop_timing_.lateness.to_proto(loop_timing.mutable_lateness());
+            if (loop_timing_.loop_time.count() > 0)
+                loop_timing_.loop_time.to_proto(loop_timing.mutable_loop_time());
+            if (loop_timing_.callback_time.count() > 0)
+                loop_timing_.callback_time.to_proto(loop_timing.mutable_callback_time());
+            loop_timing.set_overruns(loop_timing_.overruns);
+        }
+
         this->health(health);
     }
 
@@ -240,6 +347,79 @@ template <typename Config, typename TransporterType> class Thread
     bool alive() { return alive_ && *alive_; }
 
   private:
+    LoopTiming loop_timing_;
+
+    // seconds between calls to loop() at the configured frequency
+    double expected_loop_period() const
+    {
+        return 1.0 / (loop_frequency_hertz() * loop_warp_factor());
+    }
+
+    // warp factor applied to the loop period (discrete event simulation time is already simulated)
+    static int loop_warp_factor()
+    {
+        return time::DiscreteEventScheduler::enabled() ? 1 : time::SimulatorSettings::warp_factor;
+    }
+
+    // now() on the clock that loop_time_ is kept on: real time, or the simulated SteadyClock time
+    // when running a discrete event simulation
+    static std::chrono::steady_clock::time_point loop_clock_now()
+    {
+        if (time::DiscreteEventScheduler::enabled())
+            return std::chrono::steady_clock::time_point(
+                time::SteadyClock::now().time_since_epoch());
+        else
+            return std::chrono::steady_clock::now();
+    }
+
+    // (real) time at which the earliest of the transporter's timers() is due
+    std::chrono::steady_clock::time_point next_timer_time()
+    {
+        auto next_deadline = transporter_->timers()->next_deadline();
+        if (next_deadline == time::SteadyClock::time_point::max())
+            return std::chrono::steady_clock::time_point::max();
+
+        // SteadyClock may be warped
+        auto remaining = next_deadline - time::SteadyClock::now();
+        return std::chrono::steady_clock::now() + remaining / time::SimulatorSettings::warp_factor;
+    }
+
+    // poll() until loop_time_ (converted to a SteadyClock deadline in a discrete event simulation)
+    int poll_until_loop_time()
+    {
+        using time::SteadyClock;
+        if (time::DiscreteEventScheduler::enabled())
+            return transporter_->poll(SteadyClock::time_point(
+                std::chrono::duration_cast<SteadyClock::duration>(loop_time_.time_since_epoch())));
+        else
+            return transporter_->poll(loop_time_);
+    }
+
+    // calls loop() and schedules the next call, recording the loop period and timing statistics
+    void fixed_frequency_loop()
+    {
+        // loop() execution time is always measured in real time
+        auto real_start = std::chrono::steady_clock::now();
+        loop_timing_.record_loop_start(loop_clock_now(), loop_time_, expected_loop_period());
+
+        loop();
+        ++loop_count_;
+        loop_time_ += std::chrono::nanoseconds(
+            (unsigned long long)(1000000000ull /
+                                 (loop_frequency_hertz() * loop_warp_factor())));
+
+        loop_timing_.loop_time.add(std::chrono::steady_clock::now() - real_start);
+        // the next call to loop() is already due
+        if (loop_clock_now() > loop_time_)
+            ++loop_timing_.overruns;
+    }
+
+    // records the time spent in the subscription callbacks by the last poll()
+    void record_poll()
+    {
+        loop_timing_.callback_time.add(transporter_->last_poll_callback_time());
+    }
+
     void do_subscribe()
     {
         if (!transporter_)
@@ -271,6 +451,41 @@ template <typename Config, typename TransporterType>
 constexpr goby::middleware::Group
     goby::middleware::Thread<Config, TransporterType>::joinable_group_;
 
+template <typename Config, typename TransporterType>
+constexpr bool goby::middleware::Thread<Config, TransporterType>::run_in_thread_pool;
+
+template <typename Config, typename TransporterType>
+std::chrono::steady_clock::time_point
+goby::middleware::Thread<Config, TransporterType>::pooled_run_once()
+{
+    if (!transporter_)
+        throw(goby::Exception("Null transporter"));
+
+    if (loop_frequency_hertz() == std::numeric_limits<double>::infinity())
+    {
+        if (transporter_->poll(std::chrono::seconds(0)) > 0)
+            record_poll();
+        loop();
+        return loop_clock_now();
+    }
+    else if (loop_frequency_hertz() > 0)
+    {
+        // as in run_once(), loop() is only called once there are no more data to handle
+        int events = transporter_->poll(std::chrono::seconds(0));
+        if (events > 0)
+            record_poll();
+        else if (loop_clock_now() >= loop_time_)
+            fixed_frequency_loop();
+        return std::min(loop_time_, next_timer_time());
+    }
+    else
+    {
+        if (transporter_->poll(std::chrono::seconds(0)) > 0)
+            record_poll();
+        return next_timer_time();
+    }
+}
+
 template <typename Config, typename TransporterType>
 void goby::middleware::Thread<Config, TransporterType>::run_once()
 {
@@ -280,27 +495,25 @@ void goby::middleware::Thread<Config, TransporterType>::run_once()
     if (loop_frequency_hertz() == std::numeric_limits<double>::infinity())
     {
         // call loop as fast as possible
-        transporter_->poll(std::chrono::seconds(0));
+        if (transporter_->poll(std::chrono::seconds(0)) > 0)
+            record_poll();
         loop();
     }
     else if (loop_frequency_hertz() > 0)
     {
-        int events = transporter_->poll(loop_time_);
+        int events = poll_until_loop_time();
 
         // timeout
         if (events == 0)
-        {
-            loop();
-            ++loop_count_;
-            loop_time_ += std::chrono::nanoseconds(
-                (unsigned long long)(1000000000ull / (loop_frequency_hertz() *
-                                                      time::SimulatorSettings::warp_factor)));
-        }
+            fixed_frequency_loop();
+        else
+            record_poll();
     }
     else
     {
         // don't call loop()
-        transporter_->poll();
+        if (transporter_->poll() > 0)
+            record_poll();
     }
 }
 } // namespace goby
@@ -26,7 +26,10 @@
 #ifndef GOBY_MIDDLEWARE_COMMON_H
 #define GOBY_MIDDLEWARE_COMMON_H
 
+#include <atomic>
+#include <cstdint>
 #include <fstream>
+#include <functional>
 #include <sstream>
 #include <sys/syscall.h>
 #include <thread>
@@ -49,14 +52,90 @@ inline std::string to_string(goby::middleware::protobuf::Layer layer)
     return name;
 }
 
+/// \brief Identifies a thread of execution to the transporters (interthread inboxes, forwarded subscriptions, etc.)
+///
+/// Each OS thread has its own ThreadId, except while a ThreadPoolExecutor is running a pooled Thread, when the pooled Thread's ThreadId is substituted (see this_thread_id()). This allows several goby Threads to share one OS thread.
+class ThreadId
+{
+  public:
+    ThreadId() = default;
+
+    /// \brief Create a new, process-unique, ThreadId for a pooled Thread
+    static ThreadId create() { return ThreadId(next_value(), std::thread::id()); }
+
+    /// \brief Create a new, process-unique, ThreadId for an OS thread
+    static ThreadId create(std::thread::id os_thread_id)
+    {
+        return ThreadId(next_value(), os_thread_id);
+    }
+
+    /// \return integer value of this id, or 0 if this ThreadId does not represent a thread
+    std::uint64_t value() const { return value_; }
+
+    /// \return the OS thread this id was created for, or std::thread::id() for a pooled Thread
+    std::thread::id os_thread_id() const { return os_thread_id_; }
+
+  private:
+    ThreadId(std::uint64_t value, std::thread::id os_thread_id)
+        : value_(value), os_thread_id_(os_thread_id)
+    {
+    }
+
+    static std::uint64_t next_value()
+    {
+        static std::atomic<std::uint64_t> next_id{1};
+        return next_id++;
+    }
+
+  private:
+    std::uint64_t value_{0};
+    std::thread::id os_thread_id_;
+};
+
+inline bool operator==(const ThreadId& a, const ThreadId& b) { return a.value() == b.value(); }
+inline bool operator!=(const ThreadId& a, const ThreadId& b) { return !(a == b); }
+inline bool operator<(const ThreadId& a, const ThreadId& b) { return a.value() < b.value(); }
+
+namespace detail
+{
+// set by ThreadPoolExecutor while running a pooled Thread
+inline ThreadId& thread_id_override()
+{
+    thread_local ThreadId id;
+    return id;
+}
+} // namespace detail
+
+/// \brief ThreadId of the currently running thread of execution (the analog of std::this_thread::get_id())
+inline ThreadId this_thread_id()
+{
+    const ThreadId& override_id = detail::thread_id_override();
+    if (override_id.value())
+        return override_id;
+
+    thread_local const ThreadId os_thread_id(ThreadId::create(std::this_thread::get_id()));
+    return os_thread_id;
+}
+
 // unique portable thread id string from hashing std::thread::id
-inline std::string thread_id(std::thread::id i = std::this_thread::get_id())
+inline std::string thread_id(std::thread::id i)
 {
     std::stringstream ss;
     ss << std::hex << std::hash<std::thread::id>{}(i);
     return ss.str();
 }
 
+// unique portable thread id string (the same as for std::thread::id, except for pooled Threads)
+inline std::string thread_id(ThreadId i = this_thread_id())
+{
+    if (i.os_thread_id() != std::thread::id())
+        return thread_id(i.os_thread_id());
+
+    std::stringstream ss;
+    ss << std::hex << i.value();
+    return ss.str();
+}
+
 // Linux/Apple thread ID, useful because you can access it outside the system
 #if defined __APPLE__
 inline uint64_t gettid()
@@ -101,11 +180,28 @@ inline std::string full_process_id()
 }
 
 // full_process_id + thread_id
-inline std::string full_process_and_thread_id(std::thread::id i = std::this_thread::get_id())
+inline std::string full_process_and_thread_id(std::thread::id i)
+{
+    return full_process_id() + "-t" + thread_id(i);
+}
+
+// full_process_id + thread_id
+inline std::string full_process_and_thread_id(ThreadId i = this_thread_id())
 {
     return full_process_id() + "-t" + thread_id(i);
 }
 } // namespace middleware
 } // namespace goby
 
+namespace std
+{
+template <> struct hash<goby::middleware::ThreadId>
+{
+    size_t operator()(const goby::middleware::ThreadId& id) const
+    {
+        return std::hash<std::uint64_t>{}(id.value());
+    }
+};
+} // namespace std
+
 #endif
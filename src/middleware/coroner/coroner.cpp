@@ -22,6 +22,8 @@
 // along with Goby.  If not, see <http://www.gnu.org/licenses/>.
 
 #include "goby/middleware/coroner/coroner.h"
+#include "goby/middleware/transport/metrics.h"
+#include "goby/time/convert.h"
 
 goby::middleware::HealthMonitorThread::HealthMonitorThread()
     : SimpleThread<NullConfig>(NullConfig(), 1.0 * boost::units::si::hertz)
@@ -53,6 +55,19 @@ goby::middleware::HealthMonitorThread::HealthMonitorThread()
 
 void goby::middleware::HealthMonitorThread::loop()
 {
+    if (metrics::Registry::enabled() && goby::time::SteadyClock::now() >= next_metrics_time_)
+    {
+        auto metrics_cfg = metrics::Registry::cfg();
+        if (metrics_cfg.publish_interval() > 0)
+        {
+            this->interprocess().template publish<groups::transporter_metrics>(
+                metrics::Registry::snapshot());
+            next_metrics_time_ = goby::time::SteadyClock::now() +
+                                 goby::time::convert_duration<goby::time::SteadyClock::duration>(
+                                     metrics_cfg.publish_interval_with_units());
+        }
+    }
+
     if (waiting_for_responses_ &&
         goby::time::SteadyClock::now() > last_health_request_time_ + health_request_timeout_)
     {
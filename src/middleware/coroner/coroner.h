@@ -54,6 +54,8 @@ class HealthMonitorThread : public SimpleThread<NullConfig>
     goby::time::SteadyClock::time_point last_health_request_time_;
     const goby::time::SteadyClock::duration health_request_timeout_{std::chrono::seconds(1)};
     bool waiting_for_responses_{false};
+
+    goby::time::SteadyClock::time_point next_metrics_time_;
 };
 } // namespace middleware
 } // namespace goby
@@ -36,6 +36,7 @@ namespace groups
 constexpr goby::middleware::Group health_request{"goby::health::request"};
 constexpr goby::middleware::Group health_response{"goby::health::response"};
 constexpr goby::middleware::Group health_report{"goby::health::report"};
+constexpr goby::middleware::Group transporter_metrics{"goby::transporter::metrics"};
 
 } // namespace groups
 } // namespace middleware
@@ -25,6 +25,8 @@
 #ifndef GOBY_MIDDLEWARE_IO_CAN_H
 #define GOBY_MIDDLEWARE_IO_CAN_H
 
+#include <algorithm>       // for max
+#include <cstring>         // for strerror
 #include <errno.h>         // for errno
 #include <linux/can.h>     // for can_frame, socka...
 #include <linux/can/raw.h> // for CAN_RAW_FILTER
@@ -34,20 +36,20 @@
 #include <string.h>        // for strcpy, strerror
 #include <string>          // for string, operator+
 #include <sys/ioctl.h>     // for ioctl, SIOCGIFINDEX
-#include <sys/socket.h>    // for bind, setsockopt
+#include <sys/socket.h>    // for bind, setsockopt, recvmmsg
+#include <time.h>          // for timespec
 #include <tuple>           // for make_tuple, tuple
 #include <vector>          // for vector
 
-#include <boost/asio/buffer.hpp>                  // for buffer
+#include <boost/asio/error.hpp>                   // for get_system_category
 #include <boost/asio/posix/stream_descriptor.hpp> // for stream_descriptor
-#include <boost/asio/read.hpp>                    // for async_read
-#include <boost/bind.hpp>                         // for bind
-#include <boost/core/ref.hpp>                     // for ref
 
 #include "goby/exception.h"                         // for Exception
 #include "goby/middleware/io/detail/io_interface.h" // for PubSubLayer, IOT...
+#include "goby/middleware/io/detail/receive_time.h" // for ReceiveTime
 #include "goby/middleware/protobuf/can_config.pb.h" // for CanConfig, CanCo...
 #include "goby/middleware/protobuf/io.pb.h"         // for IOData
+#include "goby/time/system_clock.h"                 // for SystemClock
 namespace goby
 {
 namespace middleware
@@ -82,6 +84,24 @@ parse_extended_format_can_id(std::uint32_t can_id)
     return std::make_tuple((can_id >> 8) & 0x1FFFF, (can_id >> 26) & 0x7, can_id & 0xFF);
 }
 
+/// \brief The frames read by CanThread from one system call
+///
+/// When CanConfig::batch_size > 1, the frames are also published on line_in_group as a CanFrameBatch (after the individual frames), so that subscribers that handle many frames at once can subscribe to this instead. The can_frame (or canfd_frame) and IOData for each frame are published as usual.
+struct CanFrameBatch
+{
+    struct Frame
+    {
+        /// \brief The frame (a can_frame if !is_fd, which has the same layout as the start of a canfd_frame)
+        canfd_frame frame;
+        /// \brief Is this a CAN FD frame (only if CanConfig::enable_fd is set)?
+        bool is_fd{false};
+        /// \brief Time the frame was received (by the kernel if CanConfig::kernel_timestamp is set, otherwise when the read completed)
+        goby::time::SystemClock::time_point time;
+    };
+
+    std::vector<Frame> frames;
+};
+
 template <const goby::middleware::Group& line_in_group,
           const goby::middleware::Group& line_out_group,
           // by default publish all incoming traffic to interprocess for logging
@@ -119,10 +139,23 @@ class CanThread : public detail::IOThread<line_in_group, line_out_group, publish
 
     void open_socket() override;
 
-    void data_rec(struct can_frame& receive_frame_, boost::asio::posix::stream_descriptor& stream);
+    /// \brief Reads all the available frames (up to CanConfig::batch_size) with one recvmmsg call and publishes them
+    void data_rec();
+
+    void write_frame(const void* frame, std::size_t size)
+    {
+        auto io_msg = this->make_io_data();
+        io_msg->mutable_data()->assign(static_cast<const char*>(frame), size);
+        this->write(io_msg);
+    }
 
   private:
-    struct can_frame receive_frame_;
+    // recvmmsg buffers (sized to CanConfig::batch_size when the socket is opened)
+    std::vector<canfd_frame> rx_frames_;
+    std::vector<iovec> rx_iov_;
+    std::vector<mmsghdr> rx_msgs_;
+    static constexpr std::size_t rx_control_size{CMSG_SPACE(sizeof(timespec))};
+    std::vector<char> rx_control_;
 };
 } // namespace io
 } // namespace middleware
@@ -140,7 +173,6 @@ void goby::middleware::io::CanThread<line_in_group, line_out_group, publish_laye
     struct sockaddr_can addr_
     {
     };
-    struct can_frame receive_frame_;
     struct ifreq ifr_;
     can_socket = socket(PF_CAN, SOCK_RAW, CAN_RAW);
 
@@ -167,6 +199,23 @@ void goby::middleware::io::CanThread<line_in_group, line_out_group, publish_laye
         setsockopt(can_socket, SOL_CAN_RAW, CAN_RAW_FILTER, filters.data(),
                    sizeof(can_filter) * filters.size());
     }
+
+    if (this->cfg().enable_fd())
+    {
+        int enable = 1;
+        if (setsockopt(can_socket, SOL_CAN_RAW, CAN_RAW_FD_FRAMES, &enable, sizeof(enable)) < 0)
+            throw(goby::Exception(std::string("Failed to enable CAN FD frames on interface ") +
+                                  this->cfg().interface() + ": " + std::strerror(errno)));
+    }
+
+    if (this->cfg().kernel_timestamp())
+    {
+        int enable = 1;
+        if (setsockopt(can_socket, SOL_SOCKET, SO_TIMESTAMPNS, &enable, sizeof(enable)) < 0)
+            throw(goby::Exception(std::string("Failed to enable timestamps on interface ") +
+                                  this->cfg().interface() + ": " + std::strerror(errno)));
+    }
+
     std::strcpy(ifr_.ifr_name, this->cfg().interface().c_str());
 
     ioctl(can_socket, SIOCGIFINDEX, &ifr_);
@@ -179,16 +228,20 @@ void goby::middleware::io::CanThread<line_in_group, line_out_group, publish_laye
 
     this->mutable_socket().assign(can_socket);
 
-    this->interthread().template subscribe<line_out_group, can_frame>(
-        [this](const can_frame& frame) {
-            auto io_msg = std::make_shared<goby::middleware::protobuf::IOData>();
-            std::string& bytes = *io_msg->mutable_data();
+    const auto batch_size = std::max<std::uint32_t>(1, this->cfg().batch_size());
+    rx_frames_.resize(batch_size);
+    rx_iov_.resize(batch_size);
+    rx_msgs_.resize(batch_size);
+    rx_control_.resize(batch_size * rx_control_size);
 
-            const int frame_size = sizeof(can_frame);
+    this->interthread().template subscribe<line_out_group, can_frame>(
+        [this](const can_frame& frame) { write_frame(&frame, CAN_MTU); });
 
-            for (int i = 0; i < frame_size; ++i)
-            { bytes += *(reinterpret_cast<const char*>(&frame) + i); } this->write(io_msg);
-        });
+    if (this->cfg().enable_fd())
+    {
+        this->interthread().template subscribe<line_out_group, canfd_frame>(
+            [this](const canfd_frame& frame) { write_frame(&frame, CANFD_MTU); });
+    }
 }
 
 template <const goby::middleware::Group& line_in_group,
@@ -198,10 +251,14 @@ template <const goby::middleware::Group& line_in_group,
 void goby::middleware::io::CanThread<line_in_group, line_out_group, publish_layer, subscribe_layer,
                                      ThreadType>::async_read()
 {
-    boost::asio::async_read(this->mutable_socket(),
-                            boost::asio::buffer(&receive_frame_, sizeof(receive_frame_)),
-                            boost::bind(&CanThread::data_rec, this, boost::ref(receive_frame_),
-                                        boost::ref(this->mutable_socket())));
+    this->mutable_socket().async_wait(
+        boost::asio::posix::stream_descriptor::wait_read,
+        [this](const boost::system::error_code& ec) {
+            if (ec)
+                this->handle_read_error(ec);
+            else
+                data_rec();
+        });
 }
 
 template <const goby::middleware::Group& line_in_group,
@@ -209,24 +266,88 @@ template <const goby::middleware::Group& line_in_group,
           goby::middleware::io::PubSubLayer publish_layer,
           goby::middleware::io::PubSubLayer subscribe_layer, template <class> class ThreadType>
 void goby::middleware::io::CanThread<line_in_group, line_out_group, publish_layer, subscribe_layer,
-                                     ThreadType>::data_rec(struct can_frame& receive_frame_,
-                                                           boost::asio::posix::stream_descriptor&
-                                                               stream)
+                                     ThreadType>::data_rec()
 {
-    //  Within a process raw can frames are probably what we are looking for.
-    this->interthread().template publish<line_in_group>(receive_frame_);
+    for (decltype(rx_msgs_.size()) i = 0, n = rx_msgs_.size(); i < n; ++i)
+    {
+        rx_iov_[i].iov_base = &rx_frames_[i];
+        rx_iov_[i].iov_len = sizeof(canfd_frame);
+        rx_msgs_[i] = mmsghdr();
+        rx_msgs_[i].msg_hdr.msg_iov = &rx_iov_[i];
+        rx_msgs_[i].msg_hdr.msg_iovlen = 1;
+        if (this->cfg().kernel_timestamp())
+        {
+            rx_msgs_[i].msg_hdr.msg_control = &rx_control_[i * rx_control_size];
+            rx_msgs_[i].msg_hdr.msg_controllen = rx_control_size;
+        }
+    }
 
-    std::string bytes;
-    const int frame_size = sizeof(can_frame);
+    int num_frames = recvmmsg(this->mutable_socket().native_handle(), rx_msgs_.data(),
+                              rx_msgs_.size(), MSG_DONTWAIT, nullptr);
+    if (num_frames < 0)
+    {
+        int err = errno;
+        if (err == EAGAIN || err == EWOULDBLOCK || err == EINTR)
+            async_read();
+        else
+            this->handle_read_error(
+                boost::system::error_code(err, boost::asio::error::get_system_category()));
+        return;
+    }
 
-    for (int i = 0; i < frame_size; ++i)
-    { bytes += *(reinterpret_cast<char*>(&receive_frame_) + i); }
+    const auto read_time = detail::ReceiveTime::now();
+    const bool kernel_timestamp = this->cfg().kernel_timestamp();
+    std::shared_ptr<CanFrameBatch> batch;
+    if (rx_msgs_.size() > 1)
+    {
+        batch = std::make_shared<CanFrameBatch>();
+        batch->frames.reserve(num_frames);
+    }
+
+    for (int i = 0; i < num_frames; ++i)
+    {
+        const auto& frame = rx_frames_[i];
+        const auto size = rx_msgs_[i].msg_len;
+        const bool is_fd = (size == CANFD_MTU);
+        if (size != CAN_MTU && !is_fd)
+            continue;
+
+        auto receive_time = read_time;
+        goby::time::SystemClock::time_point kernel_time;
+        if (kernel_timestamp && detail::kernel_receive_time(rx_msgs_[i].msg_hdr, kernel_time))
+            receive_time = detail::ReceiveTime::from_system_time(kernel_time, read_time);
+
+        if (batch)
+        {
+            CanFrameBatch::Frame batch_frame;
+            batch_frame.frame = frame;
+            batch_frame.is_fd = is_fd;
+            batch_frame.time = receive_time.system_time;
+            batch->frames.push_back(batch_frame);
+        }
+
+        //  Within a process raw can frames are probably what we are looking for.
+        if (is_fd)
+        {
+            this->interthread().template publish<line_in_group>(frame);
+        }
+        else
+        {
+            this->interthread().template publish<line_in_group>(
+                *reinterpret_cast<const can_frame*>(&frame));
+        }
+
+        auto io_msg = this->make_io_data();
+        io_msg->mutable_data()->assign(reinterpret_cast<const char*>(&frame), size);
+        detail::set_receive_time(*io_msg, receive_time);
+        this->handle_read_success(size, io_msg);
+    }
 
-    this->handle_read_success(bytes.size(), bytes);
+    if (batch && !batch->frames.empty())
+        this->interthread().template publish<line_in_group>(
+            std::shared_ptr<const CanFrameBatch>(batch));
 
-    boost::asio::async_read(
-        stream, boost::asio::buffer(&receive_frame_, sizeof(receive_frame_)),
-        boost::bind(&CanThread::data_rec, this, boost::ref(receive_frame_), boost::ref(stream)));
+    async_read();
 }
 
 #endif
@@ -24,15 +24,19 @@
 #ifndef GOBY_MIDDLEWARE_IO_COBS_COMMON_H
 #define GOBY_MIDDLEWARE_IO_COBS_COMMON_H
 
-#include <memory>
+#include <algorithm> // for min
+#include <array>     // for array
+#include <cstdint>   // for uint8_t
+#include <cstring>   // for memchr, memcpy, memmove
+#include <memory>    // for shared_ptr
+#include <string>    // for string
 
-#include <boost/asio/read.hpp>  // for async_read
-#include <boost/asio/write.hpp> // for async_write
+#include <boost/asio/buffer.hpp> // for buffer
+#include <boost/asio/write.hpp>  // for async_write
 
 #include "goby/middleware/protobuf/io.pb.h"
 #include "goby/util/binary.h"
 #include "goby/util/debug_logger.h" // for glog
-#include "goby/util/thirdparty/cobs/cobs.h"
 
 namespace goby
 {
@@ -40,33 +44,156 @@ namespace middleware
 {
 namespace io
 {
-template <class Thread>
-void cobs_async_write(Thread* this_thread,
-                      std::shared_ptr<const goby::middleware::protobuf::IOData> io_msg)
+/// \brief Maximum size of the COBS encoding of \c size bytes, including the final zero delimiter
+constexpr std::size_t cobs_encoded_size_max(std::size_t size) { return size + size / 254 + 2; }
+
+/// \brief COBS encodes \c length bytes from \c input into \c output, followed by the zero delimiter
+///
+/// Produces the same encoding as cobs_encode() (goby/util/thirdparty/cobs/cobs.h), but finds each zero byte with memchr and copies the run before it with memcpy (both of which are vectorized by the C library) rather than handling the data a byte at a time.
+///
+/// \param output Must have room for cobs_encoded_size_max(length) bytes
+/// \return Number of bytes written to output (including the delimiter)
+inline std::size_t cobs_encode_block(const char* input, std::size_t length, char* output)
 {
-    constexpr static char cobs_eol{0};
+    constexpr std::size_t max_run = 254;
+    const char* end = input + length;
+    char* out = output;
+    while (true)
+    {
+        std::size_t run = std::min<std::size_t>(end - input, max_run);
+        const char* zero = static_cast<const char*>(std::memchr(input, 0, run));
+        if (zero)
+            run = zero - input;
 
-    // COBS worst case is 1 byte for every 254 bytes of input
-    auto input_size = io_msg->data().size();
-    auto output_size_max = input_size + (input_size / 254) + 1;
-    std::string cobs_encoded(output_size_max, '\0');
+        *out++ = static_cast<char>(run + 1);
+        std::memcpy(out, input, run);
+        out += run;
+        input += run;
 
-    auto cobs_size = cobs_encode(reinterpret_cast<const uint8_t*>(io_msg->data().data()),
-                                 input_size, reinterpret_cast<uint8_t*>(&cobs_encoded[0]));
+        if (zero)
+            ++input; // the zero is implied by the code of this block
+        else if (run != max_run)
+            break;
+        // a full block without a zero (or a zero at the very end) is followed by another block
+    }
+    *out++ = 0;
+    return out - output;
+}
 
-    if (cobs_size)
+/// \brief Decodes a COBS frame (without the zero delimiter) in place, resizing it to the decoded size
+///
+/// The decoded data is never longer than the encoded data, so each block is moved down within the same buffer.
+/// \return false if the frame is not valid COBS (in which case its contents are undefined)
+inline bool cobs_decode_in_place(std::string& frame)
+{
+    const std::size_t length = frame.size();
+    char* data = &frame[0];
+    std::size_t read_index = 0;
+    std::size_t write_index = 0;
+    while (read_index < length)
     {
-        cobs_encoded.resize(cobs_size);
-        cobs_encoded += cobs_eol;
+        std::size_t code = static_cast<std::uint8_t>(data[read_index]);
+        if (code == 0 || read_index + code > length)
+            return false;
+        ++read_index;
 
+        std::size_t run = code - 1;
+        std::memmove(data + write_index, data + read_index, run);
+        write_index += run;
+        read_index += run;
+
+        if (code != 0xFF && read_index != length)
+            data[write_index++] = 0;
+    }
+    frame.resize(write_index);
+    return true;
+}
+
+/// \brief COBS encodes the data into cobs_encoded (including the final zero delimiter)
+///
+/// cobs_encoded is only resized (not reallocated) if it already has the capacity, such as the data of an IOData from make_io_data()
+/// \return false if the encoding failed
+inline bool cobs_encode_frame(const std::string& data, std::string& cobs_encoded)
+{
+    cobs_encoded.resize(cobs_encoded_size_max(data.size()));
+    auto cobs_size = cobs_encode_block(data.data(), data.size(), &cobs_encoded[0]);
+    if (!cobs_size)
+        return false;
+
+    cobs_encoded.resize(cobs_size);
+    return true;
+}
+
+namespace detail
+{
+/// \brief Read buffer for the COBS IO threads: splits the bytes read into frames and decodes each in place in a (pooled) IOData
+class COBSReadBuffer
+{
+  public:
+    /// \brief Buffer to read into (with async_read_some)
+    boost::asio::mutable_buffer read_buffer()
+    {
+        return boost::asio::buffer(read_buffer_.data(), read_buffer_.size());
+    }
+
+    /// \brief Splits the first \c bytes_read bytes of the read buffer into frames
+    ///
+    /// A frame that is not complete is kept (in an IOData from make_io_data) until the remainder is read. Empty frames (consecutive delimiters) are skipped.
+    /// \param make_io_data Returns an empty IOData to decode a frame into
+    /// \param handle_frame Called as bool(std::size_t encoded_size, std::shared_ptr<IOData> encoded) for each complete frame (not including the delimiter). Should decode the frame and return false to stop reading (the rest of the data read is discarded).
+    /// \return false if handle_frame returned false
+    template <typename MakeIOData, typename FrameHandler>
+    bool parse(std::size_t bytes_read, MakeIOData make_io_data, FrameHandler handle_frame)
+    {
+        const char* begin = read_buffer_.data();
+        const char* end = begin + bytes_read;
+        while (begin != end)
+        {
+            const char* zero = static_cast<const char*>(std::memchr(begin, 0, end - begin));
+            if (!partial_)
+                partial_ = make_io_data();
+            partial_->mutable_data()->append(begin, (zero ? zero : end) - begin);
+
+            if (!zero)
+                break;
+            begin = zero + 1;
+
+            if (partial_->data().empty())
+                continue;
+
+            auto frame = std::move(partial_);
+            if (!handle_frame(frame->data().size(), frame))
+                return false;
+        }
+        return true;
+    }
+
+    /// \brief Discards any incomplete frame
+    void clear() { partial_.reset(); }
+
+  private:
+    std::array<char, 4096> read_buffer_;
+    std::shared_ptr<goby::middleware::protobuf::IOData> partial_;
+};
+} // namespace detail
+
+template <class Thread>
+void cobs_async_write(Thread* this_thread,
+                      std::shared_ptr<const goby::middleware::protobuf::IOData> io_msg)
+{
+    // encode into a pooled message that is kept alive until the write completes
+    auto encoded_msg = this_thread->make_io_data();
+    auto& cobs_encoded = *encoded_msg->mutable_data();
+    if (cobs_encode_frame(io_msg->data(), cobs_encoded))
+    {
         goby::glog.is_debug2() && goby::glog << group(this_thread->glog_group()) << "COBS ("
                                              << cobs_encoded.size() << "B) <"
                                              << " " << goby::util::hex_encode(cobs_encoded)
                                              << std::endl;
 
         boost::asio::async_write(this_thread->mutable_socket(), boost::asio::buffer(cobs_encoded),
-                                 [this_thread, cobs_encoded](const boost::system::error_code& ec,
-                                                             std::size_t bytes_transferred) {
+                                 [this_thread, encoded_msg](const boost::system::error_code& ec,
+                                                            std::size_t bytes_transferred) {
                                      if (!ec && bytes_transferred > 0)
                                      {
                                          this_thread->handle_write_success(bytes_transferred);
@@ -90,47 +217,50 @@ template <class Thread, class ThreadBase = Thread>
 void cobs_async_read(Thread* this_thread,
                      std::shared_ptr<ThreadBase> self = std::shared_ptr<ThreadBase>())
 {
-    constexpr static char cobs_eol{0};
-
-    boost::asio::async_read_until(
-        this_thread->mutable_socket(), this_thread->buffer_, cobs_eol,
+    this_thread->mutable_socket().async_read_some(
+        this_thread->buffer_.read_buffer(),
         [this_thread, self](const boost::system::error_code& ec, std::size_t bytes_transferred) {
             if (!ec && bytes_transferred > 0)
             {
-                std::string bytes(bytes_transferred, '\0');
-                std::istream is(&this_thread->buffer_);
-                is.read(&bytes[0], bytes_transferred);
-
-                goby::glog.is_debug2() && goby::glog << group(this_thread->glog_group()) << "COBS ("
-                                                     << bytes.size() << "B) >"
-                                                     << " " << goby::util::hex_encode(bytes)
-                                                     << std::endl;
-
-                auto io_msg = std::make_shared<goby::middleware::protobuf::IOData>();
-                auto& cobs_decoded = *io_msg->mutable_data();
-                cobs_decoded = std::string(bytes_transferred, '\0');
-
-                int decoded_size =
-                    cobs_decode(reinterpret_cast<const uint8_t*>(bytes.data()), bytes_transferred,
-                                reinterpret_cast<uint8_t*>(&cobs_decoded[0]));
-                if (decoded_size)
+                auto make_io_data = [this_thread]() { return this_thread->make_io_data(); };
+                auto handle_frame =
+                    [this_thread](std::size_t encoded_size,
+                                  std::shared_ptr<goby::middleware::protobuf::IOData> io_msg) {
+                        auto& frame = *io_msg->mutable_data();
+                        goby::glog.is_debug2() && goby::glog << group(this_thread->glog_group())
+                                                             << "COBS (" << encoded_size << "B) >"
+                                                             << " " << goby::util::hex_encode(frame)
+                                                             << std::endl;
+
+                        if (cobs_decode_in_place(frame))
+                        {
+                            // include the delimiter
+                            this_thread->handle_read_success(encoded_size + 1, io_msg);
+                            return true;
+                        }
+                        else
+                        {
+                            goby::glog.is_warn() &&
+                                goby::glog << group(this_thread->glog_group())
+                                           << "Failed to decode COBS message of " << encoded_size
+                                           << "B" << std::endl;
+                            return false;
+                        }
+                    };
+
+                if (this_thread->buffer_.parse(bytes_transferred, make_io_data, handle_frame))
                 {
-                    // decoded size includes final 0 so remove last byte?
-                    cobs_decoded.resize(decoded_size - 1);
-                    this_thread->handle_read_success(bytes_transferred, io_msg);
                     this_thread->async_read();
                 }
                 else
                 {
-                    goby::glog.is_warn() && goby::glog << group(this_thread->glog_group())
-                                                       << "Failed to decode COBS message: "
-                                                       << goby::util::hex_encode(bytes)
-                                                       << std::endl;
+                    this_thread->buffer_.clear();
                     this_thread->handle_read_error(ec);
                 }
             }
             else
             {
+                this_thread->buffer_.clear();
                 this_thread->handle_read_error(ec);
             }
         });
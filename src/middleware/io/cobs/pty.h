@@ -24,11 +24,8 @@
 #ifndef GOBY_MIDDLEWARE_IO_COBS_PTY_H
 #define GOBY_MIDDLEWARE_IO_COBS_PTY_H
 
-#include <istream> // for istream, basic_...
-#include <string>  // for string
+#include <string> // for string
 
-#include <boost/asio/read_until.hpp>   // for async_read_until
-#include <boost/asio/streambuf.hpp>    // for streambuf
 #include <boost/system/error_code.hpp> // for error_code
 
 #include "goby/middleware/io/cobs/common.h"
@@ -100,7 +97,7 @@ class PTYThreadCOBS : public detail::PTYThread<line_in_group, line_out_group, pu
     }
 
   private:
-    boost::asio::streambuf buffer_;
+    detail::COBSReadBuffer buffer_;
 };
 } // namespace io
 } // namespace middleware
@@ -24,11 +24,8 @@
 #ifndef GOBY_MIDDLEWARE_IO_COBS_SERIAL_H
 #define GOBY_MIDDLEWARE_IO_COBS_SERIAL_H
 
-#include <istream> // for istream, bas...
-#include <string>  // for string
+#include <string> // for string
 
-#include <boost/asio/read_until.hpp>   // for async_read_u...
-#include <boost/asio/streambuf.hpp>    // for streambuf
 #include <boost/system/error_code.hpp> // for error_code
 
 #include "goby/middleware/io/cobs/common.h"
@@ -102,7 +99,7 @@ class SerialThreadCOBS
     }
 
   private:
-    boost::asio::streambuf buffer_;
+    detail::COBSReadBuffer buffer_;
 };
 } // namespace io
 } // namespace middleware
@@ -24,12 +24,9 @@
 #ifndef GOBY_MIDDLEWARE_IO_COBS_TCP_CLIENT_H
 #define GOBY_MIDDLEWARE_IO_COBS_TCP_CLIENT_H
 
-#include <istream> // for istream
-#include <memory>  // for make_shared
-#include <string>  // for basic_st...
+#include <memory> // for make_shared
+#include <string> // for basic_st...
 
-#include <boost/asio/read_until.hpp>   // for async_re...
-#include <boost/asio/streambuf.hpp>    // for streambuf
 #include <boost/system/error_code.hpp> // for error_code
 
 #include "goby/middleware/io/cobs/common.h"
@@ -105,7 +102,7 @@ class TCPClientThreadCOBS
     }
 
   private:
-    boost::asio::streambuf buffer_;
+    detail::COBSReadBuffer buffer_;
 };
 } // namespace io
 } // namespace middleware
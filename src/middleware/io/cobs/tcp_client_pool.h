@@ -0,0 +1,129 @@
+// Copyright 2023:
+//   GobySoft, LLC (2013-)
+//   Community contributors (see AUTHORS file)
+// File authors:
+//   Toby Schneider <toby@gobysoft.org>
+//
+//
+// This file is part of the Goby Underwater Autonomy Project Libraries
+// ("The Goby Libraries").
+//
+// The Goby Libraries are free software: you can redistribute them and/or modify
+// them under the terms of the GNU Lesser General Public License as published by
+// the Free Software Foundation, either version 2.1 of the License, or
+// (at your option) any later version.
+//
+// The Goby Libraries are distributed in the hope that they will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU Lesser General Public License for more details.
+//
+// You should have received a copy of the GNU Lesser General Public License
+// along with Goby.  If not, see <http://www.gnu.org/licenses/>.
+
+
+#ifndef GOBY_MIDDLEWARE_IO_COBS_TCP_CLIENT_POOL_H
+#define GOBY_MIDDLEWARE_IO_COBS_TCP_CLIENT_POOL_H
+
+#include <memory> // for unique_ptr
+#include <string> // for basic_st...
+
+#include <boost/system/error_code.hpp> // for error_code
+
+#include "goby/middleware/io/cobs/common.h"
+#include "goby/middleware/io/detail/io_interface.h"              // for PubSubLayer
+#include "goby/middleware/io/detail/tcp_client_pool_interface.h" // for TCPClien...
+#include "goby/middleware/protobuf/io.pb.h"                      // for IOData
+#include "goby/middleware/protobuf/tcp_config.pb.h"              // for TCPClien...
+
+namespace goby
+{
+namespace middleware
+{
+class Group;
+}
+} // namespace goby
+
+namespace goby
+{
+namespace middleware
+{
+namespace io
+{
+template <typename TCPClientPoolThreadType>
+class TCPClientPoolConnectionCOBS : public detail::TCPClientPoolConnection<TCPClientPoolThreadType>
+{
+    using Base = detail::TCPClientPoolConnection<TCPClientPoolThreadType>;
+
+  public:
+    TCPClientPoolConnectionCOBS(TCPClientPoolThreadType& pool,
+                                const typename Base::ConnectionConfig& cfg, int index)
+        : Base(pool, cfg, index)
+    {
+    }
+
+    template <class Thread, class ThreadBase>
+    friend void cobs_async_read(Thread* this_thread, std::shared_ptr<ThreadBase> self);
+
+  private:
+    void async_read() override { cobs_async_read(this); }
+
+    void async_write(std::shared_ptr<const goby::middleware::protobuf::IOData> io_msg) override
+    {
+        // encode into a new message that is written using the connection's write queue
+        auto encoded_msg = this->make_io_data();
+        if (cobs_encode_frame(io_msg->data(), *encoded_msg->mutable_data()))
+        {
+            this->queue_write(encoded_msg);
+        }
+        else
+        {
+            goby::glog.is_warn() && goby::glog << group(this->glog_group())
+                                               << "Failed to encode COBS message: "
+                                               << goby::util::hex_encode(io_msg->data())
+                                               << std::endl;
+        }
+    }
+
+    void clear_read_buffer() override { buffer_.clear(); }
+
+  private:
+    detail::COBSReadBuffer buffer_;
+};
+
+/// \brief Reads/Writes COBS-framed data from/to many TCP connections (each reconnected independently)
+/// \tparam line_in_group goby::middleware::Group to publish to after receiving data from a connection (with IOData::index set to the connection's index)
+/// \tparam line_out_group goby::middleware::Group to subcribe to for data to send to the connection given by IOData::index (or IOData::tcp_dest)
+template <const goby::middleware::Group& line_in_group,
+          const goby::middleware::Group& line_out_group,
+          PubSubLayer publish_layer = PubSubLayer::INTERPROCESS,
+          PubSubLayer subscribe_layer = PubSubLayer::INTERTHREAD,
+          typename Config = goby::middleware::protobuf::TCPClientPoolConfig,
+          template <class> class ThreadType = goby::middleware::SimpleThread,
+          bool use_indexed_groups = false>
+class TCPClientPoolThreadCOBS
+    : public detail::TCPClientPoolThread<line_in_group, line_out_group, publish_layer,
+                                         subscribe_layer, Config, ThreadType, use_indexed_groups>
+{
+    using Base = detail::TCPClientPoolThread<line_in_group, line_out_group, publish_layer,
+                                             subscribe_layer, Config, ThreadType,
+                                             use_indexed_groups>;
+
+  public:
+    /// \brief Constructs the thread.
+    /// \param config A reference to the Protocol Buffers config read by the main application at launch
+    TCPClientPoolThreadCOBS(const Config& config) : Base(config) {}
+
+  private:
+    std::unique_ptr<detail::TCPClientPoolConnection<Base>>
+    create_connection(const typename Config::Connection& connection_cfg, int index) override
+    {
+        return std::unique_ptr<detail::TCPClientPoolConnection<Base>>(
+            new TCPClientPoolConnectionCOBS<Base>(*this, connection_cfg, index));
+    }
+};
+} // namespace io
+} // namespace middleware
+} // namespace goby
+
+#endif
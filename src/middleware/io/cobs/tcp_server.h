@@ -24,14 +24,11 @@
 #ifndef GOBY_MIDDLEWARE_IO_COBS_TCP_SERVER_H
 #define GOBY_MIDDLEWARE_IO_COBS_TCP_SERVER_H
 
-#include <istream> // for istream
 #include <memory>  // for make_shared
 #include <string>  // for basic_st...
 #include <utility> // for move
 
 #include <boost/asio/ip/tcp.hpp>       // for tcp, tcp...
-#include <boost/asio/read_until.hpp>   // for async_re...
-#include <boost/asio/streambuf.hpp>    // for streambuf
 #include <boost/system/error_code.hpp> // for error_code
 
 #include "goby/middleware/io/cobs/common.h"
@@ -63,10 +60,6 @@ class TCPSessionCOBS : public detail::TCPSession<TCPServerThreadType>
     {
     }
 
-    template <class Thread>
-    friend void cobs_async_write(Thread* this_thread,
-                                 std::shared_ptr<const goby::middleware::protobuf::IOData> io_msg);
-
     template <class Thread, class ThreadBase>
     friend void cobs_async_read(Thread* this_thread, std::shared_ptr<ThreadBase> self);
 
@@ -79,11 +72,24 @@ class TCPSessionCOBS : public detail::TCPSession<TCPServerThreadType>
 
     void async_write(std::shared_ptr<const goby::middleware::protobuf::IOData> io_msg) override
     {
-        cobs_async_write(this, io_msg);
+        // encode into a new message that is written using the session's write queue
+        auto encoded_msg = this->make_io_data();
+        if (cobs_encode_frame(io_msg->data(), *encoded_msg->mutable_data()))
+        {
+            this->queue_write(encoded_msg);
+        }
+        else
+        {
+            goby::glog.is_warn() && goby::glog << group(this->glog_group())
+                                               << "Failed to encode COBS message: "
+                                               << goby::util::hex_encode(io_msg->data())
+                                               << std::endl;
+            this->handle_write_error(boost::system::error_code());
+        }
     }
 
   private:
-    boost::asio::streambuf buffer_;
+    detail::COBSReadBuffer buffer_;
 };
 
 template <const goby::middleware::Group& packet_in_group,
@@ -0,0 +1,111 @@
+// Copyright 2023:
+//   GobySoft, LLC (2013-)
+//   Community contributors (see AUTHORS file)
+// File authors:
+//   Toby Schneider <toby@gobysoft.org>
+//
+//
+// This file is part of the Goby Underwater Autonomy Project Libraries
+// ("The Goby Libraries").
+//
+// The Goby Libraries are free software: you can redistribute them and/or modify
+// them under the terms of the GNU Lesser General Public License as published by
+// the Free Software Foundation, either version 2.1 of the License, or
+// (at your option) any later version.
+//
+// The Goby Libraries are distributed in the hope that they will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU Lesser General Public License for more details.
+//
+// You should have received a copy of the GNU Lesser General Public License
+// along with Goby.  If not, see <http://www.gnu.org/licenses/>.
+
+
+#ifndef GOBY_MIDDLEWARE_IO_DETAIL_IO_DATA_POOL_H
+#define GOBY_MIDDLEWARE_IO_DETAIL_IO_DATA_POOL_H
+
+#include <algorithm> // for min
+#include <atomic>    // for atomic_thread_fence
+#include <cstdint>   // for uint64_t
+#include <memory>    // for shared_ptr
+#include <vector>    // for vector
+
+#include "goby/middleware/protobuf/io.pb.h" // for IOData
+
+namespace goby
+{
+namespace middleware
+{
+namespace io
+{
+namespace detail
+{
+/// \brief Recycles IOData messages (and the capacity of their data strings) once every subscriber has released them, so that reading from (or writing to) a socket does not allocate for each chunk of data
+///
+/// acquire() must only be called from one thread (the IOThread); the messages may be released from any thread.
+class IODataPool
+{
+  public:
+    /// \param max_size Maximum number of messages kept for reuse
+    explicit IODataPool(std::size_t max_size = 64) : max_size_(max_size)
+    {
+        pool_.reserve(max_size);
+    }
+
+    /// \brief Returns a cleared IOData, reusing one from the pool if one is no longer in use
+    std::shared_ptr<protobuf::IOData> acquire()
+    {
+        // messages are handed out in turn, so the oldest (checked first) is the most likely
+        // to have been released
+        // number of pool entries checked before allocating
+        const std::size_t max_scan = 4;
+        for (std::size_t i = 0, n = std::min(pool_.size(), max_scan); i < n; ++i)
+        {
+            auto& msg = pool_[next_];
+            next_ = (next_ + 1) % pool_.size();
+            // only the pool refers to it, so no other thread can obtain a new reference
+            if (msg.use_count() == 1)
+            {
+                // synchronize with the release of the last reference by another thread
+                std::atomic_thread_fence(std::memory_order_acquire);
+                // Clear() keeps the capacity of the data string
+                msg->Clear();
+                ++reused_;
+                return msg;
+            }
+        }
+
+        ++allocated_;
+        auto msg = std::make_shared<protobuf::IOData>();
+        if (pool_.size() < max_size_)
+        {
+            pool_.push_back(msg);
+        }
+        else
+        {
+            // replace a message that is still in use (and will be freed by its last user)
+            pool_[next_] = msg;
+            next_ = (next_ + 1) % pool_.size();
+        }
+        return msg;
+    }
+
+    /// \brief Number of IOData messages that were allocated by acquire()
+    std::uint64_t allocated() const { return allocated_; }
+    /// \brief Number of IOData messages that were reused by acquire()
+    std::uint64_t reused() const { return reused_; }
+
+  private:
+    std::size_t max_size_;
+    std::vector<std::shared_ptr<protobuf::IOData>> pool_;
+    std::size_t next_{0};
+    std::uint64_t allocated_{0};
+    std::uint64_t reused_{0};
+};
+} // namespace detail
+} // namespace io
+} // namespace middleware
+} // namespace goby
+
+#endif
@@ -24,6 +24,7 @@
 #ifndef GOBY_MIDDLEWARE_IO_DETAIL_IO_INTERFACE_H
 #define GOBY_MIDDLEWARE_IO_DETAIL_IO_INTERFACE_H
 
+#include <atomic>    // for atomic
 #include <chrono>    // for seconds
 #include <exception> // for exception
 #include <memory>    // for shared_ptr
@@ -45,7 +46,9 @@
 #include "goby/util/asio_compat.h"
 #include "goby/util/debug_logger.h" // for glog
 
+#include "io_data_pool.h"
 #include "io_transporters.h"
+#include "receive_time.h"
 
 namespace goby
 {
@@ -87,6 +90,9 @@ class IOThread : public ThreadType<IOConfig>,
                      line_out_group, subscribe_layer, use_indexed_groups>
 {
   public:
+    /// \brief loop() blocks in boost::asio, so IOThreads always get their own OS thread
+    static constexpr bool run_in_thread_pool{false};
+
     /// \brief Constructs the thread.
     /// \param config A reference to the configuration read by the main application at launch
     /// \param index Thread index for multiple instances in a given application (-1 indicates a single instance)
@@ -106,7 +112,7 @@ class IOThread : public ThreadType<IOConfig>,
     {
         auto data_out_callback =
             [this](std::shared_ptr<const goby::middleware::protobuf::IOData> io_msg) {
-                if (!io_msg->has_index() || io_msg->index() == this->index())
+                if (this->is_write_destination(*io_msg))
                 {
                     write(io_msg);
                 }
@@ -123,44 +129,32 @@ class IOThread : public ThreadType<IOConfig>,
 
     void initialize() override
     {
-        // thread to handle synchonization between boost::asio and goby condition_variable signaling
-        incoming_mail_notify_thread_.reset(new std::thread([this]() {
-            while (this->alive())
-            {
-                std::unique_lock<std::mutex> lock(incoming_mail_notify_mutex_);
-                this->interthread().cv()->wait(lock);
-                // post empty handler to cause loop() to return and allow incoming mail to be handled
-                io_.post([]() {});
-            }
-        }));
+        // synchronize boost::asio with goby mail: data published to this thread post an empty handler, which causes loop() to return and allow incoming mail to be handled. The io_context wakes its reactor for posted handlers (via an eventfd on Linux), so socket and mailbox events are both handled in this thread.
+        this->interthread().wake_hook()->set([this]() {
+            // only one wakeup handler needs to be pending at a time
+            if (!incoming_mail_pending_.exchange(true))
+                io_.post([this]() { incoming_mail_pending_ = false; });
+        });
 
         this->set_name(thread_name_);
     }
 
-    void finalize() override
-    {
-        // join incoming mail thread
-        {
-            std::lock_guard<std::mutex> l(incoming_mail_notify_mutex_);
-            this->interthread().cv()->notify_all();
-        }
-        incoming_mail_notify_thread_->join();
-        incoming_mail_notify_thread_.reset();
-    }
+    void finalize() override { this->interthread().wake_hook()->clear(); }
 
     virtual ~IOThread()
     {
+        this->interthread().wake_hook()->clear();
         socket_.reset();
 
-        // for non clean shutdown, avoid abort
-        if (incoming_mail_notify_thread_)
-            incoming_mail_notify_thread_->detach();
-
         auto status = std::make_shared<protobuf::IOStatus>();
         status->set_state(protobuf::IO__LINK_CLOSED);
 
         this->publish_in(status);
         this->template unsubscribe_out<goby::middleware::protobuf::IOData>();
+
+        goby::glog.is_debug1() && goby::glog << group(glog_group_) << "IOData pool: "
+                                             << io_data_pool_.allocated() << " allocated, "
+                                             << io_data_pool_.reused() << " reused" << std::endl;
     }
 
     template <class IOThreadImplementation>
@@ -182,10 +176,32 @@ class IOThread : public ThreadType<IOConfig>,
         this->async_write(io_msg);
     }
 
+    /// \brief Returns true if data published to line_out_group are to be written by this thread: by default, if the data's index is unset or matches this thread's index
+    virtual bool is_write_destination(const goby::middleware::protobuf::IOData& io_msg)
+    {
+        return !io_msg.has_index() || io_msg.index() == this->index();
+    }
+
+    /// \brief Returns an empty IOData for publishing, recycled (along with the capacity of its data string) from a previous message once all of its subscribers have released it
+    ///
+    /// Must only be called from this thread
+    std::shared_ptr<goby::middleware::protobuf::IOData> make_io_data()
+    {
+        return io_data_pool_.acquire();
+    }
+
+    /// \brief Number of IOData messages allocated and reused by make_io_data()
+    const IODataPool& io_data_pool() const { return io_data_pool_; }
+
     void handle_read_success(std::size_t bytes_transferred, const std::string& bytes)
     {
-        auto io_msg = std::make_shared<goby::middleware::protobuf::IOData>();
-        *io_msg->mutable_data() = bytes;
+        handle_read_success(bytes_transferred, bytes.data(), bytes.size());
+    }
+
+    void handle_read_success(std::size_t bytes_transferred, const char* bytes, std::size_t size)
+    {
+        auto io_msg = make_io_data();
+        io_msg->mutable_data()->assign(bytes, size);
 
         handle_read_success(bytes_transferred, io_msg);
     }
@@ -196,6 +212,10 @@ class IOThread : public ThreadType<IOConfig>,
         if (this->index() != -1)
             io_msg->set_index(this->index());
 
+        // unless already set by the derived class (e.g. from a kernel time stamp)
+        if (!io_msg->has_receive_time())
+            set_receive_time(*io_msg, ReceiveTime::now());
+
         goby::glog.is_debug2() &&
             goby::glog << group(glog_group_) << "(" << bytes_transferred << "B) >"
                        << ((this->index() == -1) ? std::string() : std::to_string(this->index()))
@@ -249,8 +269,9 @@ class IOThread : public ThreadType<IOConfig>,
     goby::time::SteadyClock::duration backoff_interval_{min_backoff_interval_};
     goby::time::SteadyClock::time_point next_open_attempt_{goby::time::SteadyClock::now()};
 
-    std::mutex incoming_mail_notify_mutex_;
-    std::unique_ptr<std::thread> incoming_mail_notify_thread_;
+    std::atomic<bool> incoming_mail_pending_{false};
+
+    IODataPool io_data_pool_;
 
     std::string glog_group_;
     std::string thread_name_;
@@ -356,11 +377,15 @@ void goby::middleware::io::detail::IOThread<line_in_group, line_out_group, publi
                                             subscribe_layer, IOConfig, SocketType, ThreadType,
                                             use_indexed_groups>::loop()
 {
+    // loop() is called once more after the shutdown request is handled, and the wake hook (cleared in finalize()) will no longer cause run_one() to return
+    if (!this->alive())
+        return;
+
     if (socket_ && socket_->is_open())
     {
         // run the io service (blocks until either we read something
         // from the socket or a subscription is available
-        // as signaled from an empty handler in the incoming_mail_notify_thread)
+        // as signaled from the empty handler posted by the interthread wake hook)
         io_.run_one();
     }
     else
@@ -0,0 +1,105 @@
+// Copyright 2023:
+//   GobySoft, LLC (2013-)
+//   Community contributors (see AUTHORS file)
+// File authors:
+//   Toby Schneider <toby@gobysoft.org>
+//
+//
+// This file is part of the Goby Underwater Autonomy Project Libraries
+// ("The Goby Libraries").
+//
+// The Goby Libraries are free software: you can redistribute them and/or modify
+// them under the terms of the GNU Lesser General Public License as published by
+// the Free Software Foundation, either version 2.1 of the License, or
+// (at your option) any later version.
+//
+// The Goby Libraries are distributed in the hope that they will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU Lesser General Public License for more details.
+//
+// You should have received a copy of the GNU Lesser General Public License
+// along with Goby.  If not, see <http://www.gnu.org/licenses/>.
+
+
+#ifndef GOBY_MIDDLEWARE_IO_DETAIL_RECEIVE_TIME_H
+#define GOBY_MIDDLEWARE_IO_DETAIL_RECEIVE_TIME_H
+
+#include <chrono>  // for seconds, nanoseconds
+#include <cstring> // for memcpy
+
+#ifdef __linux__
+#include <sys/socket.h> // for msghdr, CMSG_FIRSTHDR, SCM_TIMESTAMPNS
+#include <time.h>       // for timespec
+#endif
+
+#include "goby/middleware/protobuf/io.pb.h" // for IOData
+#include "goby/time/steady_clock.h"         // for SteadyClock
+#include "goby/time/system_clock.h"         // for SystemClock
+
+namespace goby
+{
+namespace middleware
+{
+namespace io
+{
+namespace detail
+{
+/// \brief Time that data were received, on both the system clock (for comparison with other hosts) and the steady clock (for intervals unaffected by changes to the system time)
+struct ReceiveTime
+{
+    goby::time::SystemClock::time_point system_time;
+    goby::time::SteadyClock::time_point steady_time;
+
+    static ReceiveTime now()
+    {
+        return {goby::time::SystemClock::now(), goby::time::SteadyClock::now()};
+    }
+
+    /// \brief Receive time from a system clock time stamp (e.g. from the kernel); the steady time is inferred from the age of the time stamp at \c current
+    static ReceiveTime from_system_time(goby::time::SystemClock::time_point system_time,
+                                        const ReceiveTime& current = now())
+    {
+        auto age = current.system_time - system_time;
+        if (age < decltype(age)::zero())
+            age = decltype(age)::zero();
+        return {system_time, current.steady_time - age};
+    }
+};
+
+/// \brief Sets the receive time fields of an IOData message
+inline void set_receive_time(protobuf::IOData& io_msg, const ReceiveTime& receive_time)
+{
+    // both clocks have microsecond durations, matching the field units
+    io_msg.set_receive_time(receive_time.system_time.time_since_epoch().count());
+    io_msg.set_receive_steady_time(receive_time.steady_time.time_since_epoch().count());
+}
+
+#ifdef __linux__
+/// \brief Finds the kernel receive time (SCM_TIMESTAMPNS, enabled by the SO_TIMESTAMPNS socket option) in the control messages of a received message
+///
+/// \return true if the time stamp was found (and written to \c system_time)
+inline bool kernel_receive_time(msghdr& hdr, goby::time::SystemClock::time_point& system_time)
+{
+    for (cmsghdr* cmsg = CMSG_FIRSTHDR(&hdr); cmsg; cmsg = CMSG_NXTHDR(&hdr, cmsg))
+    {
+        if (cmsg->cmsg_level == SOL_SOCKET && cmsg->cmsg_type == SCM_TIMESTAMPNS)
+        {
+            timespec ts;
+            std::memcpy(&ts, CMSG_DATA(cmsg), sizeof(ts));
+            system_time = goby::time::SystemClock::time_point(
+                std::chrono::duration_cast<goby::time::SystemClock::duration>(
+                    std::chrono::seconds(ts.tv_sec) + std::chrono::nanoseconds(ts.tv_nsec)));
+            return true;
+        }
+    }
+    return false;
+}
+#endif
+
+} // namespace detail
+} // namespace io
+} // namespace middleware
+} // namespace goby
+
+#endif
@@ -0,0 +1,728 @@
+// Copyright 2023:
+//   GobySoft, LLC (2013-)
+//   Community contributors (see AUTHORS file)
+// File authors:
+//   Toby Schneider <toby@gobysoft.org>
+//
+//
+// This file is part of the Goby Underwater Autonomy Project Libraries
+// ("The Goby Libraries").
+//
+// The Goby Libraries are free software: you can redistribute them and/or modify
+// them under the terms of the GNU Lesser General Public License as published by
+// the Free Software Foundation, either version 2.1 of the License, or
+// (at your option) any later version.
+//
+// The Goby Libraries are distributed in the hope that they will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU Lesser General Public License for more details.
+//
+// You should have received a copy of the GNU Lesser General Public License
+// along with Goby.  If not, see <http://www.gnu.org/licenses/>.
+
+
+#ifndef GOBY_MIDDLEWARE_IO_DETAIL_TCP_CLIENT_POOL_INTERFACE_H
+#define GOBY_MIDDLEWARE_IO_DETAIL_TCP_CLIENT_POOL_INTERFACE_H
+
+#include <algorithm>   // for min
+#include <chrono>      // for duration
+#include <deque>       // for deque
+#include <map>         // for map
+#include <memory>      // for shared_ptr, unique_ptr
+#include <set>         // for set
+#include <string>      // for string, to_string
+#include <type_traits> // for integral_constant
+
+#include <boost/asio/basic_waitable_timer.hpp> // for basic_waitable_timer
+#include <boost/asio/buffer.hpp>               // for buffer
+#include <boost/asio/ip/tcp.hpp>               // for tcp, tcp::endpoint
+#include <boost/asio/write.hpp>                // for async_write
+#include <boost/system/error_code.hpp>         // for error_code
+
+#include "goby/exception.h"                         // for Exception
+#include "goby/middleware/group.h"                  // for DynamicGroup
+#include "goby/middleware/io/detail/io_interface.h" // for IOThread, PubSubLayer
+#include "goby/middleware/protobuf/io.pb.h"         // for IOData, TCPClientEvent
+#include "goby/middleware/protobuf/tcp_config.pb.h" // for TCPClientPoolConfig
+#include "goby/time/steady_clock.h"                 // for SteadyClock
+
+namespace goby
+{
+namespace middleware
+{
+namespace io
+{
+namespace detail
+{
+/// \brief Stands in for the socket of the IOThread base of TCPClientPoolThread (each connection has its own socket): it is open once the connections have been started
+class TCPClientPoolSocket
+{
+  public:
+    explicit TCPClientPoolSocket(boost::asio::io_context& io) {}
+
+    void open() { open_ = true; }
+    bool is_open() const { return open_; }
+
+  private:
+    bool open_{false};
+};
+
+/// \brief One of the connections of a TCPClientPoolThread, which connects (and reconnects) to its remote endpoint without blocking the other connections
+template <typename TCPClientPoolThreadType> class TCPClientPoolConnection
+{
+  public:
+    using ConnectionConfig = typename TCPClientPoolThreadType::ConfigType::Connection;
+
+    TCPClientPoolConnection(TCPClientPoolThreadType& pool, const ConnectionConfig& cfg, int index)
+        : pool_(pool),
+          cfg_(cfg),
+          index_(index),
+          socket_(pool.mutable_io()),
+          resolver_(pool.mutable_io()),
+          timer_(pool.mutable_io()),
+          backoff_interval_(seconds_to_duration(pool.cfg().reconnect().min_backoff_interval()))
+    {
+    }
+
+    virtual ~TCPClientPoolConnection()
+    {
+        if (state_ == State::CONNECTED)
+            publish_event(goby::middleware::protobuf::TCPClientEvent::EVENT_DISCONNECT);
+    }
+
+    /// \brief Makes the first connection attempt
+    void start() { connect(); }
+
+    /// \brief Queues data to be written, or discards them if not connected
+    void write(std::shared_ptr<const goby::middleware::protobuf::IOData> io_msg)
+    {
+        if (state_ != State::CONNECTED)
+        {
+            goby::glog.is_debug2() && goby::glog << group(glog_group()) << "Not connected to "
+                                                 << cfg_.remote_address() << ":"
+                                                 << cfg_.remote_port() << " (" << index_
+                                                 << "), discarding data" << std::endl;
+            return;
+        }
+        async_write(io_msg);
+    }
+
+    int index() const { return index_; }
+    bool is_connected() const { return state_ == State::CONNECTED; }
+    const boost::asio::ip::tcp::endpoint& remote_endpoint() { return remote_endpoint_; }
+    const std::string& glog_group() { return pool_.glog_group(); }
+
+  protected:
+    virtual void async_write(std::shared_ptr<const goby::middleware::protobuf::IOData> io_msg)
+    {
+        queue_write(io_msg);
+    }
+
+    /// \brief Queues data to be written (one message at a time, in order) to the socket
+    void queue_write(std::shared_ptr<const goby::middleware::protobuf::IOData> io_msg);
+
+    std::shared_ptr<goby::middleware::protobuf::IOData> make_io_data()
+    {
+        return pool_.make_io_data();
+    }
+
+    void handle_read_success(std::size_t bytes_transferred,
+                             std::shared_ptr<goby::middleware::protobuf::IOData> io_msg)
+    {
+        *io_msg->mutable_tcp_src() = endpoint_convert<protobuf::TCPEndPoint>(remote_endpoint_);
+        *io_msg->mutable_tcp_dest() = endpoint_convert<protobuf::TCPEndPoint>(local_endpoint_);
+        pool_.handle_connection_read(index_, bytes_transferred, io_msg);
+    }
+
+    void handle_read_error(const boost::system::error_code& ec)
+    {
+        disconnect(goby::middleware::protobuf::IOError::IO__READ_FAILURE, ec);
+    }
+
+    void handle_write_success(std::size_t bytes_transferred) {}
+    void handle_write_error(const boost::system::error_code& ec)
+    {
+        disconnect(goby::middleware::protobuf::IOError::IO__WRITE_FAILURE, ec);
+    }
+
+    const ConnectionConfig& cfg() { return cfg_; }
+
+    /// \brief End of line for this connection (line-based protocols)
+    const std::string& end_of_line()
+    {
+        return cfg_.has_end_of_line() ? cfg_.end_of_line() : pool_.cfg().end_of_line();
+    }
+
+    boost::asio::ip::tcp::socket& mutable_socket() { return socket_; }
+
+  private:
+    /// \brief Starts an asynchronous read on the socket
+    virtual void async_read() = 0;
+
+    /// \brief Discards any partial data read on a previous connection
+    virtual void clear_read_buffer() = 0;
+
+    void connect();
+    void handle_connect();
+    void handle_connect_error(const std::string& text);
+    void disconnect(goby::middleware::protobuf::IOError::ErrorCode code,
+                    const boost::system::error_code& ec);
+    void schedule_reconnect();
+    void write_queued();
+
+    void publish_event(goby::middleware::protobuf::TCPClientEvent::Event event_type);
+    void publish_status(goby::middleware::protobuf::IOState state,
+                        goby::middleware::protobuf::IOError::ErrorCode code =
+                            goby::middleware::protobuf::IOError::IO__INIT_FAILURE,
+                        const std::string& text = std::string());
+
+    static goby::time::SteadyClock::duration seconds_to_duration(double seconds)
+    {
+        return std::chrono::duration_cast<goby::time::SteadyClock::duration>(
+            std::chrono::duration<double>(seconds));
+    }
+
+  private:
+    enum class State
+    {
+        WAITING,
+        CONNECTING,
+        CONNECTED
+    };
+
+    TCPClientPoolThreadType& pool_;
+    const ConnectionConfig& cfg_;
+    const int index_;
+
+    boost::asio::ip::tcp::socket socket_;
+    boost::asio::ip::tcp::resolver resolver_;
+    boost::asio::ip::tcp::endpoint remote_endpoint_;
+    boost::asio::ip::tcp::endpoint local_endpoint_;
+
+    State state_{State::WAITING};
+    // used both for the connection timeout and the wait before reconnecting
+    boost::asio::basic_waitable_timer<goby::time::SteadyClock> timer_;
+    bool connect_timed_out_{false};
+    goby::time::SteadyClock::duration backoff_interval_;
+    goby::time::SteadyClock::time_point connect_time_;
+
+    std::deque<std::shared_ptr<const goby::middleware::protobuf::IOData>> write_queue_;
+    bool write_in_flight_{false};
+    // set when the queue overflows, cleared when it empties
+    bool write_queue_full_{false};
+};
+
+/// \brief Manages many TCP client connections (TCPClientPoolConfig::connection) from one thread
+///
+/// Each connection connects and reconnects (with exponential backoff) independently using asynchronous operations on this thread's io_context, and all of them share this thread's IOData pool. The data, status (IOStatus) and events (TCPClientEvent) of each connection are published with its index (and, if use_indexed_groups is true, to the groups with its index). Data published to line_out_group are written to the connection given by IOData::index, or else to all the connections matching IOData::tcp_dest.
+template <const goby::middleware::Group& line_in_group,
+          const goby::middleware::Group& line_out_group, PubSubLayer publish_layer,
+          PubSubLayer subscribe_layer, typename Config, template <class> class ThreadType,
+          bool use_indexed_groups = false>
+class TCPClientPoolThread
+    : public IOThread<line_in_group, line_out_group, publish_layer, subscribe_layer, Config,
+                      TCPClientPoolSocket, ThreadType, use_indexed_groups>
+{
+    using Base = IOThread<line_in_group, line_out_group, publish_layer, subscribe_layer, Config,
+                          TCPClientPoolSocket, ThreadType, use_indexed_groups>;
+
+    using ConfigType = Config;
+
+    using Connection = TCPClientPoolConnection<
+        TCPClientPoolThread<line_in_group, line_out_group, publish_layer, subscribe_layer, Config,
+                            ThreadType, use_indexed_groups>>;
+
+    using PublishTransporter = IOTransporterByLayer<Base, Direction::PUBLISH, publish_layer>;
+    using SubscribeTransporter = IOTransporterByLayer<Base, Direction::SUBSCRIBE, subscribe_layer>;
+
+  public:
+    /// \brief Constructs the thread.
+    /// \param config A reference to the Protocol Buffers config read by the main application at launch
+    TCPClientPoolThread(const Config& config)
+        : Base(config, -1,
+               std::string("tcp-pool: ") + std::to_string(config.connection_size()) +
+                   " connections")
+    {
+        if (config.connection_size() == 0)
+            throw(goby::Exception("TCPClientPoolThread requires at least one 'connection'"));
+
+        std::set<int> indices;
+        for (int i = 0, n = config.connection_size(); i < n; ++i)
+        {
+            if (!indices.insert(connection_index(i)).second)
+                throw(goby::Exception("Duplicate TCPClientPoolThread connection index: " +
+                                      std::to_string(connection_index(i))));
+        }
+
+        subscribe_connections(std::integral_constant<bool, use_indexed_groups>());
+
+        auto ready = ThreadState::SUBSCRIPTIONS_COMPLETE;
+        this->interthread().template publish<line_in_group>(ready);
+    }
+
+    ~TCPClientPoolThread() override
+    {
+        // connections publish their disconnection
+        connections_.clear();
+        unsubscribe_connections(std::integral_constant<bool, use_indexed_groups>());
+    }
+
+    template <typename TCPClientPoolThreadType> friend class TCPClientPoolConnection;
+
+  private:
+    /// \brief Creates the connection (of the derived class's protocol) for the given configuration
+    virtual std::unique_ptr<Connection>
+    create_connection(const typename Config::Connection& connection_cfg, int index) = 0;
+
+    /// \brief Starts all the connections
+    void open_socket() override;
+
+    /// \brief Each connection reads from its own socket once connected
+    void async_read() override {}
+
+    /// \brief Writes to the connection given by IOData::index, or else to those matching IOData::tcp_dest
+    void async_write(std::shared_ptr<const goby::middleware::protobuf::IOData> io_msg) override;
+
+    /// \brief Data are routed to the connections by async_write()
+    bool is_write_destination(const goby::middleware::protobuf::IOData& io_msg) override
+    {
+        return true;
+    }
+
+    int connection_index(int i)
+    {
+        const auto& connection_cfg = this->cfg().connection(i);
+        return connection_cfg.has_index() ? connection_cfg.index() : i;
+    }
+
+    void handle_connection_read(int index, std::size_t bytes_transferred,
+                                std::shared_ptr<goby::middleware::protobuf::IOData> io_msg);
+
+    /// \brief Writes data published to the indexed group of one connection
+    void write_connection(int index,
+                          std::shared_ptr<const goby::middleware::protobuf::IOData> io_msg);
+
+    template <typename Data> void publish_connection(int index, std::shared_ptr<Data> data)
+    {
+        publish_connection(index, data, std::integral_constant<bool, use_indexed_groups>());
+    }
+
+    template <typename Data>
+    void publish_connection(int index, std::shared_ptr<Data> data, std::false_type)
+    {
+        this->publish_in(data);
+    }
+
+    template <typename Data>
+    void publish_connection(int index, std::shared_ptr<Data> data, std::true_type)
+    {
+        using Transporter = typename PublishTransporter::Transporter;
+        this->PublishTransporter::io_transporter()
+            .template publish_dynamic<Data, transporter_scheme<Data, Transporter>()>(
+                data, *in_groups_.at(index));
+    }
+
+    void subscribe_connections(std::false_type) {}
+    void subscribe_connections(std::true_type);
+    void unsubscribe_connections(std::false_type) {}
+    void unsubscribe_connections(std::true_type);
+
+  private:
+    std::map<int, std::unique_ptr<Connection>> connections_;
+
+    // per-connection groups (only if use_indexed_groups)
+    std::map<int, std::unique_ptr<DynamicGroup>> in_groups_;
+    std::map<int, std::unique_ptr<DynamicGroup>> out_groups_;
+};
+} // namespace detail
+} // namespace io
+} // namespace middleware
+} // namespace goby
+
+template <typename TCPClientPoolThreadType>
+void goby::middleware::io::detail::TCPClientPoolConnection<TCPClientPoolThreadType>::connect()
+{
+    state_ = State::CONNECTING;
+    connect_timed_out_ = false;
+
+    // the timeout covers both resolving the remote address and connecting
+    timer_.expires_at(goby::time::SteadyClock::now() +
+                      seconds_to_duration(pool_.cfg().reconnect().connect_timeout()));
+    timer_.async_wait([this](const boost::system::error_code& ec) {
+        // cancelling the resolver or closing the socket completes the pending operation with an error
+        if (!ec && state_ == State::CONNECTING)
+        {
+            connect_timed_out_ = true;
+            resolver_.cancel();
+            boost::system::error_code close_ec;
+            socket_.close(close_ec);
+        }
+    });
+
+    auto connect_error = [this](const boost::system::error_code& ec) {
+        timer_.cancel();
+        handle_connect_error(connect_timed_out_ ? std::string("Connection timed out")
+                                                : ec.message());
+    };
+
+    // resolve asynchronously so that a slow name lookup does not block the other connections
+    resolver_.async_resolve(
+        {boost::asio::ip::tcp::v4(), cfg_.remote_address(), std::to_string(cfg_.remote_port()),
+         boost::asio::ip::resolver_query_base::numeric_service},
+        [this, connect_error](const boost::system::error_code& ec,
+                              boost::asio::ip::tcp::resolver::iterator endpoints) {
+            if (ec || connect_timed_out_)
+            {
+                connect_error(ec);
+                return;
+            }
+
+            remote_endpoint_ = *endpoints;
+            socket_.async_connect(remote_endpoint_,
+                                  [this, connect_error](const boost::system::error_code& ec) {
+                                      if (!ec)
+                                      {
+                                          timer_.cancel();
+                                          handle_connect();
+                                      }
+                                      else
+                                      {
+                                          connect_error(ec);
+                                      }
+                                  });
+        });
+}
+
+template <typename TCPClientPoolThreadType>
+void goby::middleware::io::detail::TCPClientPoolConnection<
+    TCPClientPoolThreadType>::handle_connect()
+{
+    state_ = State::CONNECTED;
+    connect_time_ = goby::time::SteadyClock::now();
+
+    boost::system::error_code ec;
+    local_endpoint_ = socket_.local_endpoint(ec);
+
+    clear_read_buffer();
+    publish_event(goby::middleware::protobuf::TCPClientEvent::EVENT_CONNECT);
+    publish_status(goby::middleware::protobuf::IO__LINK_OPEN);
+
+    goby::glog.is_debug1() && goby::glog << group(glog_group()) << "Connected to "
+                                         << remote_endpoint_ << " (" << index_ << ")"
+                                         << std::endl;
+
+    async_read();
+}
+
+template <typename TCPClientPoolThreadType>
+void goby::middleware::io::detail::TCPClientPoolConnection<
+    TCPClientPoolThreadType>::handle_connect_error(const std::string& text)
+{
+    state_ = State::WAITING;
+    boost::system::error_code ec;
+    socket_.close(ec);
+
+    publish_status(goby::middleware::protobuf::IO__CRITICAL_FAILURE,
+                   goby::middleware::protobuf::IOError::IO__INIT_FAILURE,
+                   text + ": config (" + cfg_.ShortDebugString() + ")");
+
+    goby::glog.is_warn() && goby::glog << group(glog_group()) << "Failed to connect to "
+                                       << cfg_.remote_address() << ":" << cfg_.remote_port()
+                                       << " (" << index_ << "): " << text << std::endl;
+
+    schedule_reconnect();
+}
+
+template <typename TCPClientPoolThreadType>
+void goby::middleware::io::detail::TCPClientPoolConnection<TCPClientPoolThreadType>::disconnect(
+    goby::middleware::protobuf::IOError::ErrorCode code, const boost::system::error_code& ec)
+{
+    // both the read and the write may fail for the same disconnection
+    if (state_ != State::CONNECTED)
+        return;
+
+    state_ = State::WAITING;
+    boost::system::error_code close_ec;
+    socket_.close(close_ec);
+
+    write_queue_.clear();
+    write_in_flight_ = false;
+    write_queue_full_ = false;
+
+    publish_status(goby::middleware::protobuf::IO__CRITICAL_FAILURE, code, ec.message());
+    publish_event(goby::middleware::protobuf::TCPClientEvent::EVENT_DISCONNECT);
+
+    goby::glog.is_warn() && goby::glog << group(glog_group()) << "Lost connection to "
+                                       << remote_endpoint_ << " (" << index_
+                                       << "): " << ec.message() << std::endl;
+
+    // only a connection that stayed up for at least the next wait resets the backoff, so that
+    // a remote that accepts and then immediately drops connections is not retried continuously
+    if (goby::time::SteadyClock::now() - connect_time_ >= backoff_interval_)
+        backoff_interval_ = seconds_to_duration(pool_.cfg().reconnect().min_backoff_interval());
+
+    schedule_reconnect();
+}
+
+template <typename TCPClientPoolThreadType>
+void goby::middleware::io::detail::TCPClientPoolConnection<
+    TCPClientPoolThreadType>::schedule_reconnect()
+{
+    auto wait = backoff_interval_;
+    backoff_interval_ =
+        std::min(backoff_interval_ * 2,
+                 seconds_to_duration(pool_.cfg().reconnect().max_backoff_interval()));
+
+    goby::glog.is_debug1() && goby::glog << group(glog_group()) << "Will retry connecting to "
+                                         << cfg_.remote_address() << ":" << cfg_.remote_port()
+                                         << " (" << index_ << ") in "
+                                         << std::chrono::duration<double>(wait).count()
+                                         << " seconds" << std::endl;
+
+    timer_.expires_at(goby::time::SteadyClock::now() + wait);
+    timer_.async_wait([this](const boost::system::error_code& ec) {
+        if (!ec && state_ == State::WAITING)
+            connect();
+    });
+}
+
+template <typename TCPClientPoolThreadType>
+void goby::middleware::io::detail::TCPClientPoolConnection<TCPClientPoolThreadType>::queue_write(
+    std::shared_ptr<const goby::middleware::protobuf::IOData> io_msg)
+{
+    const auto max_write_queue = pool_.cfg().max_write_queue();
+    if (max_write_queue > 0 && write_queue_.size() >= max_write_queue)
+    {
+        if (!write_queue_full_)
+        {
+            write_queue_full_ = true;
+            goby::glog.is_warn() && goby::glog << group(glog_group())
+                                               << "Write queue full for connection to "
+                                               << remote_endpoint_ << " (" << index_
+                                               << "), discarding data" << std::endl;
+        }
+        return;
+    }
+
+    write_queue_.push_back(io_msg);
+    if (!write_in_flight_)
+        write_queued();
+}
+
+template <typename TCPClientPoolThreadType>
+void goby::middleware::io::detail::TCPClientPoolConnection<
+    TCPClientPoolThreadType>::write_queued()
+{
+    write_in_flight_ = true;
+    boost::asio::async_write(
+        socket_, boost::asio::buffer(write_queue_.front()->data()),
+        [this](const boost::system::error_code& ec, std::size_t bytes_transferred) {
+            // the queue was cleared on disconnection
+            if (state_ != State::CONNECTED)
+                return;
+
+            if (ec)
+            {
+                handle_write_error(ec);
+                return;
+            }
+
+            handle_write_success(bytes_transferred);
+            write_in_flight_ = false;
+            write_queue_.pop_front();
+            if (!write_queue_.empty())
+                write_queued();
+            else
+                write_queue_full_ = false;
+        });
+}
+
+template <typename TCPClientPoolThreadType>
+void goby::middleware::io::detail::TCPClientPoolConnection<TCPClientPoolThreadType>::publish_event(
+    goby::middleware::protobuf::TCPClientEvent::Event event_type)
+{
+    auto event = std::make_shared<goby::middleware::protobuf::TCPClientEvent>();
+    event->set_index(index_);
+    event->set_event(event_type);
+    *event->mutable_local_endpoint() = endpoint_convert<protobuf::TCPEndPoint>(local_endpoint_);
+    *event->mutable_remote_endpoint() = endpoint_convert<protobuf::TCPEndPoint>(remote_endpoint_);
+    goby::glog.is_debug2() && goby::glog << group(glog_group())
+                                         << "Event: " << event->ShortDebugString() << std::endl;
+    pool_.publish_connection(index_, event);
+}
+
+template <typename TCPClientPoolThreadType>
+void goby::middleware::io::detail::TCPClientPoolConnection<TCPClientPoolThreadType>::publish_status(
+    goby::middleware::protobuf::IOState state, goby::middleware::protobuf::IOError::ErrorCode code,
+    const std::string& text)
+{
+    auto status = std::make_shared<goby::middleware::protobuf::IOStatus>();
+    status->set_index(index_);
+    status->set_state(state);
+    if (state == goby::middleware::protobuf::IO__CRITICAL_FAILURE)
+    {
+        goby::middleware::protobuf::IOError& error = *status->mutable_error();
+        error.set_code(code);
+        error.set_text(text);
+    }
+    pool_.publish_connection(index_, status);
+}
+
+template <const goby::middleware::Group& line_in_group,
+          const goby::middleware::Group& line_out_group,
+          goby::middleware::io::PubSubLayer publish_layer,
+          goby::middleware::io::PubSubLayer subscribe_layer, typename Config,
+          template <class> class ThreadType, bool use_indexed_groups>
+void goby::middleware::io::detail::TCPClientPoolThread<
+    line_in_group, line_out_group, publish_layer, subscribe_layer, Config, ThreadType,
+    use_indexed_groups>::open_socket()
+{
+    this->mutable_socket().open();
+
+    connections_.clear();
+    for (int i = 0, n = this->cfg().connection_size(); i < n; ++i)
+    {
+        int index = connection_index(i);
+        auto& connection = connections_[index];
+        connection = create_connection(this->cfg().connection(i), index);
+        connection->start();
+    }
+}
+
+template <const goby::middleware::Group& line_in_group,
+          const goby::middleware::Group& line_out_group,
+          goby::middleware::io::PubSubLayer publish_layer,
+          goby::middleware::io::PubSubLayer subscribe_layer, typename Config,
+          template <class> class ThreadType, bool use_indexed_groups>
+void goby::middleware::io::detail::TCPClientPoolThread<
+    line_in_group, line_out_group, publish_layer, subscribe_layer, Config, ThreadType,
+    use_indexed_groups>::async_write(std::shared_ptr<const goby::middleware::protobuf::IOData>
+                                         io_msg)
+{
+    if (io_msg->has_index())
+    {
+        auto it = connections_.find(io_msg->index());
+        if (it != connections_.end())
+            it->second->write(io_msg);
+        else
+            goby::glog.is_warn() && goby::glog << group(this->glog_group())
+                                               << "No connection with index: " << io_msg->index()
+                                               << std::endl;
+    }
+    else if (io_msg->has_tcp_dest())
+    {
+        for (auto& index_connection : connections_)
+        {
+            auto& connection = index_connection.second;
+            if (io_msg->tcp_dest().all_clients() ||
+                (io_msg->tcp_dest().addr() == connection->remote_endpoint().address().to_string() &&
+                 io_msg->tcp_dest().port() == connection->remote_endpoint().port()))
+            {
+                connection->write(io_msg);
+            }
+        }
+    }
+    else
+    {
+        throw(goby::Exception(
+            "TCPClientPoolThread requires 'index' or 'tcp_dest' field to be set in IOData"));
+    }
+}
+
+template <const goby::middleware::Group& line_in_group,
+          const goby::middleware::Group& line_out_group,
+          goby::middleware::io::PubSubLayer publish_layer,
+          goby::middleware::io::PubSubLayer subscribe_layer, typename Config,
+          template <class> class ThreadType, bool use_indexed_groups>
+void goby::middleware::io::detail::TCPClientPoolThread<
+    line_in_group, line_out_group, publish_layer, subscribe_layer, Config, ThreadType,
+    use_indexed_groups>::handle_connection_read(int index, std::size_t bytes_transferred,
+                                                std::shared_ptr<goby::middleware::protobuf::IOData>
+                                                    io_msg)
+{
+    io_msg->set_index(index);
+    if (!io_msg->has_receive_time())
+        set_receive_time(*io_msg, ReceiveTime::now());
+
+    goby::glog.is_debug2() && goby::glog << group(this->glog_group()) << "(" << bytes_transferred
+                                         << "B) >" << index << " " << io_msg->ShortDebugString()
+                                         << std::endl;
+
+    publish_connection(index, io_msg);
+}
+
+template <const goby::middleware::Group& line_in_group,
+          const goby::middleware::Group& line_out_group,
+          goby::middleware::io::PubSubLayer publish_layer,
+          goby::middleware::io::PubSubLayer subscribe_layer, typename Config,
+          template <class> class ThreadType, bool use_indexed_groups>
+void goby::middleware::io::detail::TCPClientPoolThread<
+    line_in_group, line_out_group, publish_layer, subscribe_layer, Config, ThreadType,
+    use_indexed_groups>::write_connection(int index,
+                                          std::shared_ptr<const goby::middleware::protobuf::IOData>
+                                              io_msg)
+{
+    goby::glog.is_debug2() && goby::glog << group(this->glog_group()) << "("
+                                         << io_msg->data().size() << "B) <" << index << " "
+                                         << io_msg->ShortDebugString() << std::endl;
+    if (io_msg->data().empty())
+        return;
+
+    auto it = connections_.find(index);
+    if (it != connections_.end())
+        it->second->write(io_msg);
+}
+
+template <const goby::middleware::Group& line_in_group,
+          const goby::middleware::Group& line_out_group,
+          goby::middleware::io::PubSubLayer publish_layer,
+          goby::middleware::io::PubSubLayer subscribe_layer, typename Config,
+          template <class> class ThreadType, bool use_indexed_groups>
+void goby::middleware::io::detail::TCPClientPoolThread<
+    line_in_group, line_out_group, publish_layer, subscribe_layer, Config, ThreadType,
+    use_indexed_groups>::subscribe_connections(std::true_type)
+{
+    using Transporter = typename SubscribeTransporter::Transporter;
+    for (int i = 0, n = this->cfg().connection_size(); i < n; ++i)
+    {
+        int index = connection_index(i);
+        if (index < 0 || index > Group::maximum_valid_group)
+            throw(goby::Exception("Connection index must be between 0 and " +
+                                  std::to_string(Group::maximum_valid_group)));
+
+        in_groups_[index].reset(new DynamicGroup(std::string(line_in_group), index));
+        out_groups_[index].reset(new DynamicGroup(std::string(line_out_group), index));
+
+        this->SubscribeTransporter::io_transporter()
+            .template subscribe_dynamic<goby::middleware::protobuf::IOData,
+                                        transporter_scheme<goby::middleware::protobuf::IOData,
+                                                           Transporter>()>(
+                [this, index](std::shared_ptr<const goby::middleware::protobuf::IOData> io_msg) {
+                    write_connection(index, io_msg);
+                },
+                *out_groups_[index]);
+    }
+}
+
+template <const goby::middleware::Group& line_in_group,
+          const goby::middleware::Group& line_out_group,
+          goby::middleware::io::PubSubLayer publish_layer,
+          goby::middleware::io::PubSubLayer subscribe_layer, typename Config,
+          template <class> class ThreadType, bool use_indexed_groups>
+void goby::middleware::io::detail::TCPClientPoolThread<
+    line_in_group, line_out_group, publish_layer, subscribe_layer, Config, ThreadType,
+    use_indexed_groups>::unsubscribe_connections(std::true_type)
+{
+    using Transporter = typename SubscribeTransporter::Transporter;
+    for (auto& index_group : out_groups_)
+    {
+        this->SubscribeTransporter::io_transporter()
+            .template unsubscribe_dynamic<goby::middleware::protobuf::IOData,
+                                          transporter_scheme<goby::middleware::protobuf::IOData,
+                                                             Transporter>()>(
+                *index_group.second);
+    }
+}
+
+#endif
@@ -24,11 +24,15 @@
 #ifndef GOBY_MIDDLEWARE_IO_DETAIL_TCP_SERVER_INTERFACE_H
 #define GOBY_MIDDLEWARE_IO_DETAIL_TCP_SERVER_INTERFACE_H
 
-#include <memory>  // for shared_ptr
-#include <ostream> // for endl, basic_...
-#include <set>     // for set
-#include <string>  // for operator<<
-#include <utility> // for move
+#include <algorithm> // for min, max
+#include <cstdint>   // for uint64_t
+#include <deque>     // for deque
+#include <memory>    // for shared_ptr
+#include <ostream>   // for endl, basic_...
+#include <set>       // for set
+#include <string>    // for operator<<
+#include <utility>   // for move
+#include <vector>    // for vector
 
 #include <boost/asio/buffer.hpp>       // for buffer
 #include <boost/asio/error.hpp>        // for eof, make_er...
@@ -85,34 +89,13 @@ class TCPSession : public std::enable_shared_from_this<TCPSession<TCPServerThrea
 
     virtual ~TCPSession()
     {
-        auto event = std::make_shared<goby::middleware::protobuf::TCPServerEvent>();
-        if (server_.index() != -1)
-            event->set_index(server_.index());
-        event->set_event(goby::middleware::protobuf::TCPServerEvent::EVENT_DISCONNECT);
-        *event->mutable_local_endpoint() = endpoint_convert<protobuf::TCPEndPoint>(local_endpoint_);
-        *event->mutable_remote_endpoint() =
-            endpoint_convert<protobuf::TCPEndPoint>(remote_endpoint_);
-        event->set_number_of_clients(server_.clients_.size());
-        goby::glog.is_debug2() && goby::glog << group(server_.glog_group())
-                                             << "Event: " << event->ShortDebugString() << std::endl;
-        server_.publish_in(event);
+        publish_event(goby::middleware::protobuf::TCPServerEvent::EVENT_DISCONNECT);
     }
 
     void start()
     {
         server_.clients_.insert(this->shared_from_this());
-
-        auto event = std::make_shared<goby::middleware::protobuf::TCPServerEvent>();
-        if (server_.index() != -1)
-            event->set_index(server_.index());
-        event->set_event(goby::middleware::protobuf::TCPServerEvent::EVENT_CONNECT);
-        *event->mutable_local_endpoint() = endpoint_convert<protobuf::TCPEndPoint>(local_endpoint_);
-        *event->mutable_remote_endpoint() =
-            endpoint_convert<protobuf::TCPEndPoint>(remote_endpoint_);
-        event->set_number_of_clients(server_.clients_.size());
-        goby::glog.is_debug2() && goby::glog << group(server_.glog_group())
-                                             << "Event: " << event->ShortDebugString() << std::endl;
-        server_.publish_in(event);
+        publish_event(goby::middleware::protobuf::TCPServerEvent::EVENT_CONNECT);
         async_read();
     }
 
@@ -124,32 +107,32 @@ class TCPSession : public std::enable_shared_from_this<TCPSession<TCPServerThrea
     // public so TCPServer can call this
     virtual void async_write(std::shared_ptr<const goby::middleware::protobuf::IOData> io_msg)
     {
-        auto self(this->shared_from_this());
-        boost::asio::async_write(
-            socket_, boost::asio::buffer(io_msg->data()),
-            [this, self, io_msg](boost::system::error_code ec, std::size_t bytes_transferred) {
-                if (!ec)
-                {
-                    this->handle_write_success(bytes_transferred);
-                }
-                else
-                {
-                    this->handle_write_error(ec);
-                }
-            });
+        queue_write(io_msg);
     }
 
   protected:
+    /// \brief Queues data to be written to this client, applying TCPServerConfig::write_queue's limits and slow client policy.
+    ///
+    /// The data are not copied: up to max_write_batch queued messages are written with one gather write directly from the (shared) IOData buffers.
+    void queue_write(std::shared_ptr<const goby::middleware::protobuf::IOData> io_msg);
+
     void handle_write_success(std::size_t bytes_transferred)
     {
         server_.handle_write_success(bytes_transferred);
     }
     void handle_write_error(const boost::system::error_code& ec)
     {
-        goby::glog.is_warn() && goby::glog << "Write error: " << ec.message() << std::endl;
+        // operation_aborted: we closed the socket (e.g. slow client policy DISCONNECT)
+        if (ec != boost::asio::error::operation_aborted)
+            goby::glog.is_warn() && goby::glog << "Write error: " << ec.message() << std::endl;
         server_.clients_.erase(this->shared_from_this());
     }
 
+    std::shared_ptr<goby::middleware::protobuf::IOData> make_io_data()
+    {
+        return server_.make_io_data();
+    }
+
     void handle_read_success(std::size_t bytes_transferred,
                              std::shared_ptr<goby::middleware::protobuf::IOData> io_msg)
     {
@@ -161,7 +144,7 @@ class TCPSession : public std::enable_shared_from_this<TCPSession<TCPServerThrea
 
     void handle_read_error(const boost::system::error_code& ec)
     {
-        if (ec != boost::asio::error::eof)
+        if (ec != boost::asio::error::eof && ec != boost::asio::error::operation_aborted)
             goby::glog.is_warn() && goby::glog << "Read error: " << ec.message() << std::endl;
         // erase ourselves from the client list to ensure destruction
         server_.clients_.erase(this->shared_from_this());
@@ -174,11 +157,51 @@ class TCPSession : public std::enable_shared_from_this<TCPSession<TCPServerThrea
   private:
     virtual void async_read() = 0;
 
+    /// \brief Writes the messages at the front of the queue
+    void write_queued();
+
+    bool write_queue_full(std::size_t bytes) const
+    {
+        const auto& queue_cfg = server_.cfg().write_queue();
+        return (queue_cfg.max_messages() > 0 && write_queue_.size() >= queue_cfg.max_messages()) ||
+               (queue_cfg.max_bytes() > 0 && write_queue_bytes_ + bytes > queue_cfg.max_bytes());
+    }
+
+    void publish_event(goby::middleware::protobuf::TCPServerEvent::Event event_type)
+    {
+        auto event = std::make_shared<goby::middleware::protobuf::TCPServerEvent>();
+        if (server_.index() != -1)
+            event->set_index(server_.index());
+        event->set_event(event_type);
+        *event->mutable_local_endpoint() = endpoint_convert<protobuf::TCPEndPoint>(local_endpoint_);
+        *event->mutable_remote_endpoint() =
+            endpoint_convert<protobuf::TCPEndPoint>(remote_endpoint_);
+        event->set_number_of_clients(server_.clients_.size());
+        if (event_type != goby::middleware::protobuf::TCPServerEvent::EVENT_CONNECT)
+        {
+            write_queue_stats_.set_depth(write_queue_.size());
+            write_queue_stats_.set_depth_bytes(write_queue_bytes_);
+            *event->mutable_write_queue() = write_queue_stats_;
+        }
+        goby::glog.is_debug2() && goby::glog << group(server_.glog_group())
+                                             << "Event: " << event->ShortDebugString() << std::endl;
+        server_.publish_in(event);
+    }
+
   private:
     boost::asio::ip::tcp::socket socket_;
     TCPServerThreadType& server_;
     boost::asio::ip::tcp::endpoint remote_endpoint_;
     boost::asio::ip::tcp::endpoint local_endpoint_;
+
+    std::deque<std::shared_ptr<const goby::middleware::protobuf::IOData>> write_queue_;
+    std::uint64_t write_queue_bytes_{0};
+    // number of messages at the front of write_queue_ that are being written
+    std::size_t write_in_flight_{0};
+    std::vector<boost::asio::const_buffer> write_buffers_;
+    // set when the queue overflows, cleared when it empties
+    bool write_queue_full_{false};
+    goby::middleware::protobuf::TCPServerEvent::WriteQueueStats write_queue_stats_;
 };
 
 template <const goby::middleware::Group& line_in_group,
@@ -324,8 +347,10 @@ void goby::middleware::io::detail::TCPServerThread<
         throw(goby::Exception("TCPServerThread requires 'tcp_dest' field to have 'addr'/'port' set "
                               "or all_clients=true in IOData"));
 
-    for (auto& client : clients_)
+    // a client may be removed from clients_ by async_write (slow client policy DISCONNECT)
+    for (auto it = clients_.begin(); it != clients_.end();)
     {
+        auto client = *it++;
         if (io_msg->tcp_dest().all_clients() ||
             (io_msg->tcp_dest() ==
              endpoint_convert<protobuf::TCPEndPoint>(client->remote_endpoint())))
@@ -335,4 +360,109 @@ void goby::middleware::io::detail::TCPServerThread<
     }
 }
 
+template <typename TCPServerThreadType>
+void goby::middleware::io::detail::TCPSession<TCPServerThreadType>::queue_write(
+    std::shared_ptr<const goby::middleware::protobuf::IOData> io_msg)
+{
+    using protobuf::TCPServerConfig;
+    const auto bytes = io_msg->data().size();
+
+    if (write_queue_full(bytes))
+    {
+        if (!write_queue_full_)
+        {
+            write_queue_full_ = true;
+            goby::glog.is_warn() && goby::glog << group(server_.glog_group())
+                                               << "Write queue full for client: "
+                                               << remote_endpoint_ << std::endl;
+            publish_event(goby::middleware::protobuf::TCPServerEvent::EVENT_WRITE_QUEUE_FULL);
+        }
+
+        switch (server_.cfg().write_queue().slow_client_policy())
+        {
+            case TCPServerConfig::WriteQueue::DISCONNECT:
+            {
+                write_queue_stats_.set_messages_dropped(write_queue_stats_.messages_dropped() +
+                                                        write_queue_.size() + 1);
+                boost::system::error_code ec;
+                socket_.close(ec);
+                server_.clients_.erase(this->shared_from_this());
+                return;
+            }
+
+            case TCPServerConfig::WriteQueue::DROP_NEWEST:
+                write_queue_stats_.set_messages_dropped(write_queue_stats_.messages_dropped() + 1);
+                return;
+
+            case TCPServerConfig::WriteQueue::DROP_OLDEST:
+                // messages that are being written cannot be removed
+                while (write_queue_full(bytes) && write_queue_.size() > write_in_flight_)
+                {
+                    auto oldest = write_queue_.begin() + write_in_flight_;
+                    write_queue_bytes_ -= (*oldest)->data().size();
+                    write_queue_.erase(oldest);
+                    write_queue_stats_.set_messages_dropped(write_queue_stats_.messages_dropped() +
+                                                            1);
+                }
+                if (write_queue_full(bytes))
+                {
+                    write_queue_stats_.set_messages_dropped(
+                        write_queue_stats_.messages_dropped() + 1);
+                    return;
+                }
+                break;
+        }
+    }
+
+    write_queue_.push_back(io_msg);
+    write_queue_bytes_ += bytes;
+    if (write_queue_.size() > write_queue_stats_.max_depth())
+        write_queue_stats_.set_max_depth(write_queue_.size());
+
+    if (write_in_flight_ == 0)
+        write_queued();
+}
+
+template <typename TCPServerThreadType>
+void goby::middleware::io::detail::TCPSession<TCPServerThreadType>::write_queued()
+{
+    const auto max_write_batch =
+        std::max<std::size_t>(1, server_.cfg().write_queue().max_write_batch());
+    write_in_flight_ = std::min(write_queue_.size(), max_write_batch);
+
+    write_buffers_.clear();
+    for (std::size_t i = 0; i < write_in_flight_; ++i)
+        write_buffers_.push_back(boost::asio::buffer(write_queue_[i]->data()));
+
+    auto self(this->shared_from_this());
+    boost::asio::async_write(
+        socket_, write_buffers_,
+        [this, self](boost::system::error_code ec, std::size_t bytes_transferred) {
+            if (!ec)
+            {
+                for (std::size_t i = 0; i < write_in_flight_; ++i)
+                {
+                    write_queue_bytes_ -= write_queue_.front()->data().size();
+                    write_queue_.pop_front();
+                }
+                write_queue_stats_.set_messages_written(write_queue_stats_.messages_written() +
+                                                        write_in_flight_);
+                write_queue_stats_.set_bytes_written(write_queue_stats_.bytes_written() +
+                                                     bytes_transferred);
+                write_in_flight_ = 0;
+
+                this->handle_write_success(bytes_transferred);
+
+                if (!write_queue_.empty())
+                    write_queued();
+                else
+                    write_queue_full_ = false;
+            }
+            else
+            {
+                this->handle_write_error(ec);
+            }
+        });
+}
+
 #endif
@@ -24,15 +24,25 @@
 #ifndef GOBY_MIDDLEWARE_IO_LINE_BASED_COMMON_H
 #define GOBY_MIDDLEWARE_IO_LINE_BASED_COMMON_H
 
-#include <atomic>   // for atomic
-#include <locale>   // for ctype, use_facet, locale
-#include <map>      // for map
-#include <regex>    // for _NFA, match_results, regex, regex_search
-#include <sstream>  // for basic_stringbuf<>::int_type, basic_stringbuf<>::...
-#include <stddef.h> // for size_t
-#include <string>   // for string
-#include <utility>  // for make_pair, pair
-#include <vector>   // for vector
+#include <algorithm>   // for equal, max, min
+#include <array>       // for array
+#include <atomic>      // for atomic
+#include <cctype>      // for isalnum
+#include <cstring>     // for memchr, memmem, memcmp
+#include <locale>      // for ctype, use_facet, locale
+#include <map>         // for map
+#include <memory>      // for shared_ptr
+#include <regex>       // for _NFA, match_results, regex, regex_search
+#include <sstream>     // for basic_stringbuf<>::int_type, basic_stringbuf<>::...
+#include <stddef.h>    // for size_t
+#include <string>      // for string
+#include <type_traits> // for true_type, is_pointer
+#include <utility>     // for make_pair, pair
+#include <vector>      // for vector
+
+#include <boost/asio/buffers_iterator.hpp>          // for buffers_iterator
+#include <boost/asio/streambuf.hpp>                 // for streambuf
+#include <boost/type_traits/integral_constant.hpp> // for true_type
 
 namespace boost
 {
@@ -86,6 +96,191 @@ class match_regex
     std::regex eol_regex_;
 };
 
+namespace detail
+{
+/// \brief Is the range [begin, end) a single block of memory?
+template <typename Iterator> struct is_contiguous_iterator : std::is_pointer<Iterator>
+{
+};
+
+// boost::asio::streambuf data is a single buffer
+template <>
+struct is_contiguous_iterator<
+    boost::asio::buffers_iterator<boost::asio::streambuf::const_buffers_type>> : std::true_type
+{
+};
+
+/// \brief Parses an end-of-line regex that is one or more literal strings separated by '|' (e.g. "\r\n" or "\r\n|\n")
+///
+/// \return false if the regex uses any other regex features
+inline bool parse_literal_eol(const std::string& eol, std::vector<std::string>& literals)
+{
+    literals.assign(1, std::string());
+    for (auto it = eol.begin(), end = eol.end(); it != end; ++it)
+    {
+        char c = *it;
+        switch (c)
+        {
+            case '|': literals.emplace_back(); continue;
+
+            case '.':
+            case '^':
+            case '$':
+            case '(':
+            case ')':
+            case '[':
+            case ']':
+            case '{':
+            case '}':
+            case '*':
+            case '+':
+            case '?': return false;
+
+            case '\\':
+                if (++it == end)
+                    return false;
+                switch (*it)
+                {
+                    case 'n': c = '\n'; break;
+                    case 'r': c = '\r'; break;
+                    case 't': c = '\t'; break;
+                    case 'f': c = '\f'; break;
+                    case 'v': c = '\v'; break;
+                    case '0': c = '\0'; break;
+                    default:
+                        // other escaped letters and digits are character classes, back references, etc.
+                        if (std::isalnum(static_cast<unsigned char>(*it)))
+                            return false;
+                        c = *it;
+                        break;
+                }
+                break;
+
+            default: break;
+        }
+        literals.back().push_back(c);
+    }
+
+    for (const auto& literal : literals)
+    {
+        if (literal.empty())
+            return false;
+    }
+    return true;
+}
+} // namespace detail
+
+/// \brief Provides a matching function object for the boost::asio::async_read_until that finds the end-of-line string (a std::regex) with the same results as match_regex, but much faster for the common case where the end-of-line is a literal string (e.g. "\n" or "\r\n") or a choice of literal strings (e.g. "\r\n|\n").
+///
+/// Literal end-of-lines are found using memchr/memmem, and the search resumes where the previous one left off (rather than rescanning the whole buffer when more data arrive). Other regexes use std::regex.
+class match_eol
+{
+  public:
+    explicit match_eol(const std::string& eol) : impl_(std::make_shared<Impl>())
+    {
+        if (detail::parse_literal_eol(eol, impl_->literals))
+        {
+            impl_->first_bytes.fill(false);
+            for (const auto& literal : impl_->literals)
+            {
+                impl_->first_bytes[static_cast<unsigned char>(literal[0])] = true;
+                impl_->max_literal_size = std::max(impl_->max_literal_size, literal.size());
+            }
+        }
+        else
+        {
+            impl_->literals.clear();
+            impl_->regex.reset(new match_regex(eol));
+        }
+    }
+
+    /// \brief Is the end-of-line matched without using std::regex?
+    bool is_literal() const { return !impl_->regex; }
+
+    template <typename Iterator>
+    std::pair<Iterator, bool> operator()(Iterator begin, Iterator end) const
+    {
+        if (impl_->regex)
+            return (*impl_->regex)(begin, end);
+
+        auto match = find(begin, end, detail::is_contiguous_iterator<Iterator>());
+        if (match.second)
+            return match;
+
+        // a partial end-of-line at the end of the data could be completed by the next read, so resume the search from there
+        auto resume_size = std::min<std::size_t>(impl_->max_literal_size - 1, end - begin);
+        return std::make_pair(end - resume_size, false);
+    }
+
+  private:
+    // contiguous memory: memchr/memmem
+    template <typename Iterator>
+    std::pair<Iterator, bool> find(Iterator begin, Iterator end, std::true_type) const
+    {
+        if (begin == end)
+            return std::make_pair(end, false);
+
+        const char* data = &*begin;
+        std::size_t size = end - begin;
+        const auto& literals = impl_->literals;
+
+        if (literals.size() == 1)
+        {
+            const std::string& eol = literals[0];
+            const void* pos = (eol.size() == 1) ? std::memchr(data, eol[0], size)
+                                                : memmem(data, size, eol.data(), eol.size());
+            if (pos)
+                return std::make_pair(
+                    begin + (static_cast<const char*>(pos) - data) + eol.size(), true);
+            return std::make_pair(end, false);
+        }
+
+        for (std::size_t i = 0; i < size; ++i)
+        {
+            if (!impl_->first_bytes[static_cast<unsigned char>(data[i])])
+                continue;
+
+            // the first alternative that matches wins, as for std::regex (ECMAScript)
+            for (const auto& eol : literals)
+            {
+                if (eol.size() <= size - i && std::memcmp(data + i, eol.data(), eol.size()) == 0)
+                    return std::make_pair(begin + i + eol.size(), true);
+            }
+        }
+        return std::make_pair(end, false);
+    }
+
+    // generic iterators
+    template <typename Iterator>
+    std::pair<Iterator, bool> find(Iterator begin, Iterator end, std::false_type) const
+    {
+        for (auto it = begin; it != end; ++it)
+        {
+            if (!impl_->first_bytes[static_cast<unsigned char>(*it)])
+                continue;
+
+            for (const auto& eol : impl_->literals)
+            {
+                if (static_cast<std::size_t>(end - it) >= eol.size() &&
+                    std::equal(eol.begin(), eol.end(), it))
+                    return std::make_pair(it + eol.size(), true);
+            }
+        }
+        return std::make_pair(end, false);
+    }
+
+  private:
+    // shared as boost::asio copies the match condition for each read
+    struct Impl
+    {
+        std::vector<std::string> literals;
+        std::size_t max_literal_size{0};
+        std::array<bool, 256> first_bytes;
+        std::unique_ptr<match_regex> regex;
+    };
+    std::shared_ptr<Impl> impl_;
+};
+
 } // namespace io
 } // namespace middleware
 } // namespace goby
@@ -97,6 +292,9 @@ namespace asio
 template <> struct is_match_condition<goby::middleware::io::match_regex> : public boost::true_type
 {
 };
+template <> struct is_match_condition<goby::middleware::io::match_eol> : public boost::true_type
+{
+};
 } // namespace asio
 } // namespace boost
 
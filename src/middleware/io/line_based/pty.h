@@ -33,7 +33,7 @@
 
 #include "goby/middleware/io/detail/io_interface.h"  // for PubSubLayer
 #include "goby/middleware/io/detail/pty_interface.h" // for PTYThread
-#include "goby/middleware/io/line_based/common.h"    // for match_regex
+#include "goby/middleware/io/line_based/common.h"    // for match_eol
 
 namespace goby
 {
@@ -89,7 +89,7 @@ class PTYThreadLineBased : public detail::PTYThread<line_in_group, line_out_grou
     void async_read() override;
 
   private:
-    match_regex eol_matcher_;
+    match_eol eol_matcher_;
     boost::asio::streambuf buffer_;
 };
 } // namespace io
@@ -108,10 +108,12 @@ void goby::middleware::io::PTYThreadLineBased<line_in_group, line_out_group, pub
         [this](const boost::system::error_code& ec, std::size_t bytes_transferred) {
             if (!ec && bytes_transferred > 0)
             {
-                std::string bytes(bytes_transferred, 0);
+                auto io_msg = this->make_io_data();
+                auto& bytes = *io_msg->mutable_data();
+                bytes.resize(bytes_transferred);
                 std::istream is(&buffer_);
                 is.read(&bytes[0], bytes_transferred);
-                this->handle_read_success(bytes_transferred, bytes);
+                this->handle_read_success(bytes_transferred, io_msg);
                 this->async_read();
             }
             else
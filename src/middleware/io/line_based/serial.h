@@ -33,7 +33,7 @@
 
 #include "goby/middleware/io/detail/io_interface.h"     // for PubSubLayer
 #include "goby/middleware/io/detail/serial_interface.h" // for SerialThread
-#include "goby/middleware/io/line_based/common.h"       // for match_regex
+#include "goby/middleware/io/line_based/common.h"       // for match_eol
 
 namespace goby
 {
@@ -91,7 +91,7 @@ class SerialThreadLineBased
     void async_read() override;
 
   private:
-    match_regex eol_matcher_;
+    match_eol eol_matcher_;
     boost::asio::streambuf buffer_;
 };
 } // namespace io
@@ -112,10 +112,12 @@ void goby::middleware::io::SerialThreadLineBased<line_in_group, line_out_group,
         [this](const boost::system::error_code& ec, std::size_t bytes_transferred) {
             if (!ec && bytes_transferred > 0)
             {
-                std::string bytes(bytes_transferred, 0);
+                auto io_msg = this->make_io_data();
+                auto& bytes = *io_msg->mutable_data();
+                bytes.resize(bytes_transferred);
                 std::istream is(&buffer_);
                 is.read(&bytes[0], bytes_transferred);
-                this->handle_read_success(bytes_transferred, bytes);
+                this->handle_read_success(bytes_transferred, io_msg);
                 this->async_read();
             }
             else
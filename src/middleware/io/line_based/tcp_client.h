@@ -34,7 +34,7 @@
 
 #include "goby/middleware/io/detail/io_interface.h"         // for PubSubLayer
 #include "goby/middleware/io/detail/tcp_client_interface.h" // for TCPClien...
-#include "goby/middleware/io/line_based/common.h"           // for match_regex
+#include "goby/middleware/io/line_based/common.h"           // for match_eol
 #include "goby/middleware/protobuf/io.pb.h"                 // for IOData
 
 namespace goby
@@ -95,7 +95,7 @@ class TCPClientThreadLineBased
     void async_read() override;
 
   private:
-    match_regex eol_matcher_;
+    match_eol eol_matcher_;
     boost::asio::streambuf buffer_;
 };
 } // namespace io
@@ -116,9 +116,9 @@ void goby::middleware::io::TCPClientThreadLineBased<line_in_group, line_out_grou
         [this](const boost::system::error_code& ec, std::size_t bytes_transferred) {
             if (!ec && bytes_transferred > 0)
             {
-                auto io_msg = std::make_shared<goby::middleware::protobuf::IOData>();
+                auto io_msg = this->make_io_data();
                 auto& bytes = *io_msg->mutable_data();
-                bytes = std::string(bytes_transferred, 0);
+                bytes.resize(bytes_transferred);
                 std::istream is(&buffer_);
                 is.read(&bytes[0], bytes_transferred);
                 this->insert_endpoints(io_msg);
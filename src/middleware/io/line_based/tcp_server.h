@@ -36,7 +36,7 @@
 
 #include "goby/middleware/io/detail/io_interface.h"         // for PubSubLayer
 #include "goby/middleware/io/detail/tcp_server_interface.h" // for TCPServe...
-#include "goby/middleware/io/line_based/common.h"           // for match_regex
+#include "goby/middleware/io/line_based/common.h"           // for match_eol
 #include "goby/middleware/protobuf/io.pb.h"                 // for IOData
 #include "goby/middleware/protobuf/tcp_config.pb.h"         // for TCPServe...
 namespace goby
@@ -72,9 +72,9 @@ class TCPSessionLineBased : public detail::TCPSession<TCPServerThreadType>
             [this, self](const boost::system::error_code& ec, std::size_t bytes_transferred) {
                 if (!ec && bytes_transferred > 0)
                 {
-                    auto io_msg = std::make_shared<goby::middleware::protobuf::IOData>();
+                    auto io_msg = this->make_io_data();
                     auto& bytes = *io_msg->mutable_data();
-                    bytes = std::string(bytes_transferred, 0);
+                    bytes.resize(bytes_transferred);
                     std::istream is(&buffer_);
                     is.read(&bytes[0], bytes_transferred);
 
@@ -89,7 +89,7 @@ class TCPSessionLineBased : public detail::TCPSession<TCPServerThreadType>
     }
 
   private:
-    match_regex eol_matcher_;
+    match_eol eol_matcher_;
     boost::asio::streambuf buffer_;
 };
 
@@ -24,7 +24,9 @@
 #ifndef GOBY_MIDDLEWARE_IO_MAVLINK_COMMON_H
 #define GOBY_MIDDLEWARE_IO_MAVLINK_COMMON_H
 
+#include <array>   // for array
 #include <cstdint> // for uint8_t
+#include <map>     // for map
 #include <memory>  // for shared_ptr, __sh...
 #include <sstream> // for basic_ostream<>:...
 #include <string>  // for string
@@ -32,12 +34,12 @@
 
 #include <mavlink/v2.0/common/common.hpp>
 
-#include "goby/exception.h"                         // for Exception
-#include "goby/middleware/io/detail/io_interface.h" // for PubSubLayer, Pub...
-#include "goby/middleware/marshalling/interface.h"  // for MarshallingScheme
-#include "goby/middleware/marshalling/mavlink.h"    // for SerializerParser...
-#include "goby/middleware/protobuf/io.pb.h"         // for IOData
-#include "goby/util/debug_logger/flex_ostream.h"    // for operator<<, Flex...
+#include "goby/middleware/io/detail/io_interface.h"  // for PubSubLayer, Pub...
+#include "goby/middleware/io/mavlink/frame_parser.h" // for MAVLinkFrameParser
+#include "goby/middleware/marshalling/interface.h"   // for MarshallingScheme
+#include "goby/middleware/marshalling/mavlink.h"     // for SerializerParser...
+#include "goby/middleware/protobuf/io.pb.h"          // for IOData
+#include "goby/util/debug_logger/flex_ostream.h"     // for operator<<, Flex...
 
 namespace goby
 {
@@ -70,10 +72,10 @@ class IOThreadMAVLink : public IOThreadBase
                     goby::glog << "writing msg [sysid: " << static_cast<int>(msg->sysid)
                                << ", compid: " << static_cast<int>(msg->compid)
                                << "] of msgid: " << static_cast<int>(msg->msgid) << std::endl;
-                auto io_msg = std::make_shared<goby::middleware::protobuf::IOData>();
+                auto io_msg = this->make_io_data();
                 auto data = SerializerParserHelper<mavlink::mavlink_message_t,
                                                    MarshallingScheme::MAVLINK>::serialize(*msg);
-                io_msg->set_data(&data[0], data.size());
+                io_msg->mutable_data()->assign(data.begin(), data.end());
                 this->write(io_msg);
             };
 
@@ -83,27 +85,27 @@ class IOThreadMAVLink : public IOThreadBase
         }
     }
 
-    ~IOThreadMAVLink() {}
+    ~IOThreadMAVLink() { log_stats(); }
 
   protected:
     void try_parse(std::size_t bytes_transferred);
-    std::array<char, MAVLINK_MAX_PACKET_LEN>& buffer() { return buffer_; }
+    std::array<char, 4096>& buffer() { return buffer_; }
+
+    /// \brief Frame statistics (totals and per msgid) for the data read so far
+    const detail::MAVLinkFrameParser& frame_parser() const { return parser_; }
 
   private:
-    void clear_buffers()
-    {
-        msg_ = std::make_shared<mavlink::mavlink_message_t>();
-        status_ = {};
-        msg_buffer_ = {};
-        status_buffer_ = {};
-    }
+    void handle_frame(const char* frame, std::size_t frame_size,
+                      detail::MAVLinkFrameParser::FrameStatus status);
+    void log_stats();
 
   private:
-    std::array<char, MAVLINK_MAX_PACKET_LEN> buffer_;
-    std::shared_ptr<mavlink::mavlink_message_t> msg_ =
-        std::make_shared<mavlink::mavlink_message_t>();
-    mavlink::mavlink_message_t msg_buffer_{};
-    mavlink::mavlink_status_t status_{}, status_buffer_{};
+    // several frames may be read at once (or arrive in one datagram)
+    std::array<char, 4096> buffer_;
+    detail::MAVLinkFrameParser parser_;
+
+    goby::time::SteadyClock::time_point next_stats_log_time_{goby::time::SteadyClock::now() +
+                                                             std::chrono::seconds(10)};
 };
 } // namespace io
 } // namespace middleware
@@ -117,69 +119,81 @@ void goby::middleware::io::IOThreadMAVLink<line_in_group, line_out_group, publis
                                            subscribe_layer, IOThreadBase,
                                            IOConfig>::try_parse(std::size_t bytes_transferred)
 {
-    auto bytes_begin = buffer_.begin(), bytes_end = buffer_.begin() + bytes_transferred;
-    for (auto c = bytes_begin; c != bytes_end; ++c)
+    parser_.parse(buffer_.data(), buffer_.data() + bytes_transferred,
+                  [this](const char* frame, std::size_t frame_size,
+                         detail::MAVLinkFrameParser::FrameStatus status) {
+                      handle_frame(frame, frame_size, status);
+                  });
+
+    auto now = goby::time::SteadyClock::now();
+    if (now >= next_stats_log_time_)
     {
-        try
-        {
-            auto res = mavlink::mavlink_frame_char_buffer(&msg_buffer_, &status_buffer_, *c,
-                                                          msg_.get(), &status_);
-            switch (res)
-            {
-                case mavlink::MAVLINK_FRAMING_BAD_CRC:
-                    if (status_.parse_state != mavlink::MAVLINK_PARSE_STATE_IDLE)
-                    {
-                        break; // keep parsing
-                    }
-                    else if (mavlink::mavlink_get_msg_entry(msg_->msgid) == nullptr)
-                    {
-                        goby::glog.is_debug3() &&
-                            goby::glog << "BAD CRC decoding MAVLink msg, but "
-                                          "forwarding because we don't know this msgid"
-                                       << std::endl;
-                        // forward anyway as it might be a msgid we don't know
-                        // so flow through here (no break) is intentional!!
-                    }
-                    else
-                    {
-                        goby::glog.is_warn() && goby::glog << "BAD CRC decoding MAVLink msg"
-                                                           << std::endl;
-                        break;
-                    }
-
-                case mavlink::MAVLINK_FRAMING_OK:
-                {
-                    goby::glog.is_debug3() && goby::glog << "Parsed message of id: " << msg_->msgid
-                                                         << std::endl;
-
-                    this->publish_in(msg_);
-
-                    std::array<uint8_t, MAVLINK_MAX_PACKET_LEN> buffer;
-                    auto length = mavlink::mavlink_msg_to_send_buffer(&buffer[0], msg_.get());
-                    std::string bytes(buffer.begin(), buffer.begin() + length);
-                    this->handle_read_success(length, bytes);
-                    break;
-                }
-
-                case mavlink::MAVLINK_FRAMING_INCOMPLETE: break;
-
-                case mavlink::MAVLINK_FRAMING_BAD_SIGNATURE:
-                    goby::glog.is_warn() && goby::glog << "BAD SIGNATURE decoding MAVLink msg"
-                                                       << std::endl;
-                    break;
-                default:
-                    goby::glog.is_warn() && goby::glog << "Unknown value " << res
-                                                       << " returned while decoding MAVLink msg"
-                                                       << std::endl;
-                    break;
-            }
-        }
-        catch (goby::Exception& e)
-        {
-            goby::glog.is_warn() && goby::glog << "Exception decoding MAVLink msg: " << e.what()
-                                               << std::endl;
-            clear_buffers();
-        }
+        log_stats();
+        next_stats_log_time_ = now + std::chrono::seconds(10);
+    }
+}
+
+template <
+    const goby::middleware::Group& line_in_group, const goby::middleware::Group& line_out_group,
+    goby::middleware::io::PubSubLayer publish_layer,
+    goby::middleware::io::PubSubLayer subscribe_layer, typename IOThreadBase, typename IOConfig>
+void goby::middleware::io::IOThreadMAVLink<
+    line_in_group, line_out_group, publish_layer, subscribe_layer, IOThreadBase,
+    IOConfig>::handle_frame(const char* frame, std::size_t frame_size,
+                            detail::MAVLinkFrameParser::FrameStatus status)
+{
+    using FrameStatus = detail::MAVLinkFrameParser::FrameStatus;
+    switch (status)
+    {
+        case FrameStatus::BAD_CRC:
+            goby::glog.is_warn() && goby::glog << "BAD CRC decoding MAVLink msg" << std::endl;
+            return;
+
+        case FrameStatus::UNKNOWN_MSGID:
+            // forward anyway as it might be a msgid we don't know
+            goby::glog.is_debug3() && goby::glog << "Unable to check CRC of MAVLink msg, but "
+                                                    "forwarding because we don't know this msgid"
+                                                 << std::endl;
+            break;
+
+        case FrameStatus::OK: break;
+    }
+
+    // a new message each time, as subscribers may still hold the previous one
+    auto msg = std::make_shared<mavlink::mavlink_message_t>();
+    detail::MAVLinkFrameParser::to_message(frame, *msg);
+
+    goby::glog.is_debug3() && goby::glog << "Parsed message of id: " << msg->msgid << std::endl;
+
+    this->publish_in(msg);
+
+    // publish the frame as received rather than re-serializing msg
+    this->handle_read_success(frame_size, frame, frame_size);
+}
+
+template <
+    const goby::middleware::Group& line_in_group, const goby::middleware::Group& line_out_group,
+    goby::middleware::io::PubSubLayer publish_layer,
+    goby::middleware::io::PubSubLayer subscribe_layer, typename IOThreadBase, typename IOConfig>
+void goby::middleware::io::IOThreadMAVLink<line_in_group, line_out_group, publish_layer,
+                                           subscribe_layer, IOThreadBase, IOConfig>::log_stats()
+{
+    const auto& stats = parser_.stats();
+    goby::glog.is_debug1() && goby::glog << "MAVLink frames: " << stats.frames << " ("
+                                         << stats.unknown_msgid
+                                         << " with unknown msgid), bad CRC: " << stats.bad_crc
+                                         << ", bytes skipped: " << stats.bytes_skipped
+                                         << std::endl;
+
+    // sorted by msgid
+    std::map<std::uint32_t, detail::MAVLinkFrameParser::MsgStats> msg_stats(
+        parser_.msg_stats().begin(), parser_.msg_stats().end());
+    for (const auto& id_stats_pair : msg_stats)
+    {
+        goby::glog.is_debug1() && goby::glog << "\tmsgid " << id_stats_pair.first << ": "
+                                             << id_stats_pair.second.frames << " frames, "
+                                             << id_stats_pair.second.bytes << " bytes, "
+                                             << id_stats_pair.second.rate() << " Hz" << std::endl;
     }
 }
 
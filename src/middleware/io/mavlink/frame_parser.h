@@ -0,0 +1,297 @@
+// Copyright 2023:
+//   GobySoft, LLC (2013-)
+//   Community contributors (see AUTHORS file)
+// File authors:
+//   Toby Schneider <toby@gobysoft.org>
+//
+//
+// This file is part of the Goby Underwater Autonomy Project Libraries
+// ("The Goby Libraries").
+//
+// The Goby Libraries are free software: you can redistribute them and/or modify
+// them under the terms of the GNU Lesser General Public License as published by
+// the Free Software Foundation, either version 2.1 of the License, or
+// (at your option) any later version.
+//
+// The Goby Libraries are distributed in the hope that they will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU Lesser General Public License for more details.
+//
+// You should have received a copy of the GNU Lesser General Public License
+// along with Goby.  If not, see <http://www.gnu.org/licenses/>.
+
+#ifndef GOBY_MIDDLEWARE_IO_MAVLINK_FRAME_PARSER_H
+#define GOBY_MIDDLEWARE_IO_MAVLINK_FRAME_PARSER_H
+
+#include <chrono>        // for duration
+#include <cstdint>       // for uint8_t, uint16_t, uint32_t, uint64_t
+#include <cstring>       // for memchr, memcpy
+#include <unordered_map> // for unordered_map
+#include <vector>        // for vector
+
+#include <mavlink/v2.0/common/common.hpp>
+
+#include "goby/middleware/marshalling/mavlink.h" // for MAVLinkRegistry
+#include "goby/time/steady_clock.h"              // for SteadyClock
+
+namespace goby
+{
+namespace middleware
+{
+namespace io
+{
+namespace detail
+{
+/// \brief Splits a stream of bytes into MAVLink (v1 and v2) frames
+///
+/// Rather than feeding the stream through mavlink_frame_char_buffer one byte at a time, the parser scans for the start-of-frame bytes, reads the length from the header, and checks the CRC over the whole frame at once. Frames are passed to the handler in place (pointing into the data given to parse()); only the bytes of an incomplete frame at the end of the data are copied and kept until the next call.
+class MAVLinkFrameParser
+{
+  public:
+    enum class FrameStatus
+    {
+        /// CRC is correct
+        OK,
+        /// msgid is not in the MAVLinkRegistry, so the CRC could not be checked
+        UNKNOWN_MSGID,
+        /// CRC is incorrect (the frame is not consumed: scanning resumes at the next byte)
+        BAD_CRC
+    };
+
+    /// \brief Frame counts for one msgid
+    struct MsgStats
+    {
+        std::uint64_t frames{0};
+        std::uint64_t bytes{0};
+        goby::time::SteadyClock::time_point first_frame_time;
+        goby::time::SteadyClock::time_point last_frame_time;
+
+        /// \brief Mean frame rate (Hz) between the first and last frame received
+        double rate() const
+        {
+            if (frames < 2)
+                return 0;
+            std::chrono::duration<double> elapsed = last_frame_time - first_frame_time;
+            return elapsed.count() > 0 ? (frames - 1) / elapsed.count() : 0;
+        }
+    };
+
+    /// \brief Totals across all msgids
+    struct Stats
+    {
+        std::uint64_t frames{0};
+        std::uint64_t bad_crc{0};
+        std::uint64_t unknown_msgid{0};
+        /// bytes discarded while searching for the start of a frame
+        std::uint64_t bytes_skipped{0};
+    };
+
+    /// \brief Parse the next chunk of the stream
+    ///
+    /// \param begin Start of the new data
+    /// \param end End of the new data
+    /// \param handler Called as handler(const char* frame, std::size_t frame_size, FrameStatus status) for each frame found. The frame is only valid during the call.
+    template <typename FrameHandler>
+    void parse(const char* begin, const char* end, FrameHandler handler);
+
+    /// \brief Unpack a frame (as passed to the handler of parse()) into a mavlink_message_t
+    static void to_message(const char* frame, mavlink::mavlink_message_t& msg);
+
+    /// \brief MAVLink (CRC-16/MCRF4XX) checksum, identical to the MAVLink library crc_accumulate()
+    static std::uint16_t crc_accumulate(const std::uint8_t* begin, const std::uint8_t* end,
+                                        std::uint16_t crc = 0xFFFF)
+    {
+        for (auto c = begin; c != end; ++c)
+        {
+            std::uint8_t tmp = *c ^ static_cast<std::uint8_t>(crc & 0xFF);
+            tmp ^= (tmp << 4);
+            crc = (crc >> 8) ^ (tmp << 8) ^ (tmp << 3) ^ (tmp >> 4);
+        }
+        return crc;
+    }
+
+    const std::unordered_map<std::uint32_t, MsgStats>& msg_stats() const { return msg_stats_; }
+    const Stats& stats() const { return stats_; }
+
+    /// \brief Bytes of an incomplete frame held until the next call to parse()
+    std::size_t pending() const { return partial_.size(); }
+
+  private:
+    static bool is_stx(char c)
+    {
+        auto u = static_cast<std::uint8_t>(c);
+        return u == MAVLINK_STX || u == MAVLINK_STX_MAVLINK1;
+    }
+
+    static const char* find_stx(const char* begin, const char* end)
+    {
+        // in a clean stream, frames are back to back
+        if (begin == end || is_stx(*begin))
+            return begin;
+
+        auto v2 = static_cast<const char*>(std::memchr(begin, MAVLINK_STX, end - begin));
+        const char* v1_end = v2 ? v2 : end;
+        auto v1 =
+            static_cast<const char*>(std::memchr(begin, MAVLINK_STX_MAVLINK1, v1_end - begin));
+        return v1 ? v1 : v1_end;
+    }
+
+    static std::size_t header_size(std::uint8_t magic)
+    {
+        return 1 + (magic == MAVLINK_STX ? MAVLINK_CORE_HEADER_LEN
+                                         : MAVLINK_CORE_HEADER_MAVLINK1_LEN);
+    }
+
+    // returns the start of the unconsumed (incomplete) data
+    template <typename FrameHandler>
+    const char* scan(const char* begin, const char* end, FrameHandler& handler,
+                     goby::time::SteadyClock::time_point now);
+
+  private:
+    std::vector<char> partial_;
+    Stats stats_;
+    std::unordered_map<std::uint32_t, MsgStats> msg_stats_;
+};
+
+} // namespace detail
+} // namespace io
+} // namespace middleware
+} // namespace goby
+
+template <typename FrameHandler>
+void goby::middleware::io::detail::MAVLinkFrameParser::parse(const char* begin, const char* end,
+                                                             FrameHandler handler)
+{
+    auto now = goby::time::SteadyClock::now();
+    if (partial_.empty())
+    {
+        // common case: frames are handed out directly from the caller's buffer
+        const char* rest = scan(begin, end, handler, now);
+        partial_.assign(rest, end);
+    }
+    else
+    {
+        partial_.insert(partial_.end(), begin, end);
+        const char* rest = scan(partial_.data(), partial_.data() + partial_.size(), handler, now);
+        partial_.erase(partial_.begin(), partial_.begin() + (rest - partial_.data()));
+    }
+}
+
+template <typename FrameHandler>
+const char* goby::middleware::io::detail::MAVLinkFrameParser::scan(
+    const char* begin, const char* end, FrameHandler& handler,
+    goby::time::SteadyClock::time_point now)
+{
+    const char* p = begin;
+    while (p != end)
+    {
+        const char* stx = find_stx(p, end);
+        stats_.bytes_skipped += stx - p;
+        p = stx;
+        if (p == end)
+            break;
+
+        auto frame = reinterpret_cast<const std::uint8_t*>(p);
+        const std::size_t available = end - p;
+        const bool v2 = frame[0] == MAVLINK_STX;
+        const std::size_t header = header_size(frame[0]);
+        if (available < header)
+            break;
+
+        const std::uint8_t payload_size = frame[1];
+        const std::uint8_t incompat_flags = v2 ? frame[2] : 0;
+        if (incompat_flags & ~MAVLINK_IFLAG_MASK)
+        {
+            // not a frame we can parse: treat the start byte as noise
+            ++stats_.bytes_skipped;
+            ++p;
+            continue;
+        }
+
+        const std::size_t frame_size =
+            header + payload_size + MAVLINK_NUM_CHECKSUM_BYTES +
+            ((incompat_flags & MAVLINK_IFLAG_SIGNED) ? MAVLINK_SIGNATURE_BLOCK_LEN : 0);
+        if (available < frame_size)
+            break;
+
+        const std::uint32_t msgid =
+            v2 ? (frame[7] | (frame[8] << 8) | (frame[9] << 16)) : frame[5];
+
+        const std::uint8_t* checksum = frame + header + payload_size;
+        FrameStatus status = FrameStatus::UNKNOWN_MSGID;
+        if (const auto* entry = goby::middleware::MAVLinkRegistry::get_msg_entry(msgid))
+        {
+            std::uint16_t crc = crc_accumulate(frame + 1, checksum);
+            crc = crc_accumulate(&entry->crc_extra, &entry->crc_extra + 1, crc);
+            status = (crc == (checksum[0] | (checksum[1] << 8))) ? FrameStatus::OK
+                                                                : FrameStatus::BAD_CRC;
+        }
+
+        handler(p, frame_size, status);
+
+        if (status == FrameStatus::BAD_CRC)
+        {
+            ++stats_.bad_crc;
+            ++stats_.bytes_skipped;
+            ++p;
+            continue;
+        }
+
+        if (status == FrameStatus::UNKNOWN_MSGID)
+            ++stats_.unknown_msgid;
+        ++stats_.frames;
+
+        auto& msg_stats = msg_stats_[msgid];
+        if (msg_stats.frames == 0)
+            msg_stats.first_frame_time = now;
+        msg_stats.last_frame_time = now;
+        ++msg_stats.frames;
+        msg_stats.bytes += frame_size;
+
+        p += frame_size;
+    }
+    return p;
+}
+
+inline void
+goby::middleware::io::detail::MAVLinkFrameParser::to_message(const char* frame,
+                                                             mavlink::mavlink_message_t& msg)
+{
+    auto bytes = reinterpret_cast<const std::uint8_t*>(frame);
+    const std::size_t header = header_size(bytes[0]);
+
+    msg = mavlink::mavlink_message_t{};
+    msg.magic = bytes[0];
+    msg.len = bytes[1];
+    if (msg.magic == MAVLINK_STX)
+    {
+        msg.incompat_flags = bytes[2];
+        msg.compat_flags = bytes[3];
+        msg.seq = bytes[4];
+        msg.sysid = bytes[5];
+        msg.compid = bytes[6];
+        msg.msgid = bytes[7] | (bytes[8] << 8) | (bytes[9] << 16);
+    }
+    else
+    {
+        msg.seq = bytes[2];
+        msg.sysid = bytes[3];
+        msg.compid = bytes[4];
+        msg.msgid = bytes[5];
+    }
+
+    // payload bytes beyond len (truncated zeros in v2) stay zero
+    std::memcpy(&msg.payload64[0], bytes + header, msg.len);
+
+    const std::uint8_t* checksum = bytes + header + msg.len;
+    msg.ck[0] = checksum[0];
+    msg.ck[1] = checksum[1];
+    msg.checksum = checksum[0] | (checksum[1] << 8);
+
+    if (msg.incompat_flags & MAVLINK_IFLAG_SIGNED)
+        std::memcpy(msg.signature, checksum + MAVLINK_NUM_CHECKSUM_BYTES,
+                    MAVLINK_SIGNATURE_BLOCK_LEN);
+}
+
+#endif
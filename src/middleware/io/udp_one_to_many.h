@@ -24,18 +24,31 @@
 #ifndef GOBY_MIDDLEWARE_IO_UDP_ONE_TO_MANY_H
 #define GOBY_MIDDLEWARE_IO_UDP_ONE_TO_MANY_H
 
+#include <algorithm>             // for max
 #include <array>                 // for array
 #include <boost/asio/buffer.hpp> // for buffer
+#include <boost/asio/error.hpp>  // for get_system_category
 #include <boost/asio/ip/udp.hpp>
 #include <boost/asio/ip/udp.hpp>       // for udp, udp::endpoint
 #include <boost/asio/socket_base.hpp>  // for socket_base
 #include <boost/system/error_code.hpp> // for error_code
+#include <cerrno>                      // for errno
 #include <cstddef>                     // for size_t
+#include <cstdint>                     // for uint32_t
+#include <cstring>                     // for memcpy, strerror
+#include <deque>                       // for deque
 #include <memory>                      // for shared_ptr, __s...
 #include <string>                      // for string, to_string
+#include <utility>                     // for pair
+#include <vector>                      // for vector
+
+#ifdef __linux__
+#include <sys/socket.h> // for recvmmsg, sendmmsg
+#endif
 
 #include "goby/exception.h"                         // for Exception
 #include "goby/middleware/io/detail/io_interface.h" // for PubSubLayer
+#include "goby/middleware/io/detail/receive_time.h" // for ReceiveTime
 #include "goby/middleware/protobuf/io.pb.h"         // for IOData, UDPEndP...
 #include "goby/middleware/protobuf/udp_config.pb.h" // for UDPOneToManyConfig
 
@@ -91,15 +104,71 @@ class UDPOneToManyThread
     virtual void
     async_write(std::shared_ptr<const goby::middleware::protobuf::IOData> io_msg) override;
 
+    /// \brief Sends the data to the given endpoint, either directly or (if cfg().batch_size() > 1) queued to be sent with other writes in the same sendmmsg call
+    void send_to(std::shared_ptr<const goby::middleware::protobuf::IOData> io_msg,
+                 const boost::asio::ip::udp::endpoint& remote_endpoint);
+
   private:
     /// \brief Tries to open the udp socket, and if fails publishes an error
     void open_socket() override;
 
+    /// \brief Publishes a datagram read from the socket
+    void handle_datagram(const char* data, std::size_t size,
+                         const boost::asio::ip::udp::endpoint& sender_endpoint,
+                         const detail::ReceiveTime& receive_time);
+
+    bool use_batch() const
+    {
+#ifdef __linux__
+        return this->cfg().batch_size() > 1;
+#else
+        return false;
+#endif
+    }
+
+    // kernel time stamps are read from the control messages, so also use recvmmsg
+    bool use_recvmmsg() const
+    {
+#ifdef __linux__
+        return use_batch() || this->cfg().kernel_timestamp();
+#else
+        return false;
+#endif
+    }
+
+#ifdef __linux__
+    /// \brief Waits for the socket to become readable, then reads all available datagrams (up to cfg().batch_size()) with one recvmmsg call
+    void async_read_batch();
+
+    static constexpr std::size_t rx_control_size{CMSG_SPACE(sizeof(timespec))};
+
+    /// \brief Sends the queued writes using sendmmsg, waiting for the socket to become writable if necessary
+    void flush_tx_queue();
+#endif
+
   private:
     static constexpr int max_udp_size{65507};
     std::array<char, max_udp_size> rx_message_;
     boost::asio::ip::udp::endpoint sender_endpoint_;
     boost::asio::ip::udp::endpoint local_endpoint_;
+
+#ifdef __linux__
+    // recvmmsg buffers (sized to cfg().batch_size() when the socket is opened)
+    std::vector<char> rx_batch_data_;
+    std::vector<mmsghdr> rx_batch_msgs_;
+    std::vector<iovec> rx_batch_iov_;
+    std::vector<sockaddr_storage> rx_batch_addr_;
+    std::vector<char> rx_batch_control_;
+
+    // writes waiting for the next sendmmsg call
+    std::deque<std::pair<std::shared_ptr<const goby::middleware::protobuf::IOData>,
+                         boost::asio::ip::udp::endpoint>>
+        tx_queue_;
+    bool tx_flush_pending_{false};
+    // set when the queue overflows (cfg().tx_queue()), cleared when it empties
+    bool tx_queue_full_{false};
+    std::uint64_t tx_dropped_{0};
+#endif
 };
 } // namespace io
 } // namespace middleware
@@ -131,6 +200,61 @@ void goby::middleware::io::UDPOneToManyThread<line_in_group, line_out_group, pub
     this->mutable_socket().bind(
         boost::asio::ip::udp::endpoint(boost::asio::ip::udp::v4(), this->cfg().bind_port()));
     local_endpoint_ = this->mutable_socket().local_endpoint();
+
+#ifdef __linux__
+    tx_queue_.clear();
+    tx_flush_pending_ = false;
+    tx_queue_full_ = false;
+
+    if (this->cfg().kernel_timestamp())
+    {
+        int enable = 1;
+        if (setsockopt(this->mutable_socket().native_handle(), SOL_SOCKET, SO_TIMESTAMPNS, &enable,
+                       sizeof(enable)) < 0)
+            throw(goby::Exception(std::string("Failed to enable timestamps on UDP socket: ") +
+                                  std::strerror(errno)));
+    }
+
+    if (use_recvmmsg())
+    {
+        const auto batch_size = std::max<std::uint32_t>(1, this->cfg().batch_size());
+        rx_batch_data_.resize(batch_size * max_udp_size);
+        rx_batch_msgs_.resize(batch_size);
+        rx_batch_iov_.resize(batch_size);
+        rx_batch_addr_.resize(batch_size);
+        rx_batch_control_.resize(batch_size * rx_control_size);
+        for (decltype(rx_batch_msgs_.size()) i = 0; i < batch_size; ++i)
+        {
+            rx_batch_iov_[i].iov_base = &rx_batch_data_[i * max_udp_size];
+            rx_batch_iov_[i].iov_len = max_udp_size;
+            rx_batch_msgs_[i] = mmsghdr();
+            rx_batch_msgs_[i].msg_hdr.msg_iov = &rx_batch_iov_[i];
+            rx_batch_msgs_[i].msg_hdr.msg_iovlen = 1;
+            rx_batch_msgs_[i].msg_hdr.msg_name = &rx_batch_addr_[i];
+        }
+    }
+#endif
+}
+
+template <const goby::middleware::Group& line_in_group,
+          const goby::middleware::Group& line_out_group,
+          goby::middleware::io::PubSubLayer publish_layer,
+          goby::middleware::io::PubSubLayer subscribe_layer, typename Config,
+          template <class> class ThreadType>
+void goby::middleware::io::UDPOneToManyThread<
+    line_in_group, line_out_group, publish_layer, subscribe_layer, Config,
+    ThreadType>::handle_datagram(const char* data, std::size_t size,
+                                 const boost::asio::ip::udp::endpoint& sender_endpoint,
+                                 const detail::ReceiveTime& receive_time)
+{
+    auto io_msg = this->make_io_data();
+    io_msg->mutable_data()->assign(data, size);
+    detail::set_receive_time(*io_msg, receive_time);
+
+    *io_msg->mutable_udp_src() = detail::endpoint_convert<protobuf::UDPEndPoint>(sender_endpoint);
+    *io_msg->mutable_udp_dest() = detail::endpoint_convert<protobuf::UDPEndPoint>(local_endpoint_);
+
+    this->handle_read_success(size, io_msg);
 }
 
 template <const goby::middleware::Group& line_in_group,
@@ -141,21 +265,21 @@ template <const goby::middleware::Group& line_in_group,
 void goby::middleware::io::UDPOneToManyThread<line_in_group, line_out_group, publish_layer,
                                               subscribe_layer, Config, ThreadType>::async_read()
 {
+#ifdef __linux__
+    if (use_recvmmsg())
+    {
+        async_read_batch();
+        return;
+    }
+#endif
+
     this->mutable_socket().async_receive_from(
         boost::asio::buffer(rx_message_), sender_endpoint_,
         [this](const boost::system::error_code& ec, size_t bytes_transferred) {
             if (!ec && bytes_transferred > 0)
             {
-                auto io_msg = std::make_shared<goby::middleware::protobuf::IOData>();
-                *io_msg->mutable_data() =
-                    std::string(rx_message_.begin(), rx_message_.begin() + bytes_transferred);
-
-                *io_msg->mutable_udp_src() =
-                    detail::endpoint_convert<protobuf::UDPEndPoint>(sender_endpoint_);
-                *io_msg->mutable_udp_dest() =
-                    detail::endpoint_convert<protobuf::UDPEndPoint>(local_endpoint_);
-
-                this->handle_read_success(bytes_transferred, io_msg);
+                handle_datagram(rx_message_.data(), bytes_transferred, sender_endpoint_,
+                                detail::ReceiveTime::now());
                 this->async_read();
             }
             else
@@ -183,6 +307,54 @@ void goby::middleware::io::UDPOneToManyThread<
                            std::to_string(io_msg->udp_dest().port()),
                            boost::asio::ip::resolver_query_base::numeric_service});
 
+    send_to(io_msg, remote_endpoint);
+}
+
+template <const goby::middleware::Group& line_in_group,
+          const goby::middleware::Group& line_out_group,
+          goby::middleware::io::PubSubLayer publish_layer,
+          goby::middleware::io::PubSubLayer subscribe_layer, typename Config,
+          template <class> class ThreadType>
+void goby::middleware::io::UDPOneToManyThread<line_in_group, line_out_group, publish_layer,
+                                              subscribe_layer, Config, ThreadType>::
+    send_to(std::shared_ptr<const goby::middleware::protobuf::IOData> io_msg,
+            const boost::asio::ip::udp::endpoint& remote_endpoint)
+{
+#ifdef __linux__
+    if (use_batch())
+    {
+        const auto& queue_cfg = this->cfg().tx_queue();
+        if (queue_cfg.max_messages() > 0 && tx_queue_.size() >= queue_cfg.max_messages())
+        {
+            const bool drop_newest =
+                queue_cfg.overflow() == goby::middleware::protobuf::UDPTxQueueConfig::DROP_NEWEST;
+            ++tx_dropped_;
+            if (!tx_queue_full_)
+            {
+                tx_queue_full_ = true;
+                goby::glog.is_warn() &&
+                    goby::glog << group(this->glog_group()) << "Send queue full ("
+                               << tx_queue_.size() << " datagrams), dropping the "
+                               << (drop_newest ? "newest" : "oldest") << " datagrams ("
+                               << tx_dropped_ << " dropped in total)" << std::endl;
+            }
+
+            if (drop_newest)
+                return;
+            tx_queue_.pop_front();
+        }
+
+        tx_queue_.emplace_back(io_msg, remote_endpoint);
+        // writes published to this thread are handled together before the io_context is run again, so the posted flush sends all of them
+        if (!tx_flush_pending_)
+        {
+            tx_flush_pending_ = true;
+            this->mutable_io().post([this]() { flush_tx_queue(); });
+        }
+        return;
+    }
+#endif
+
     this->mutable_socket().async_send_to(
         boost::asio::buffer(io_msg->data()), remote_endpoint,
         [this, io_msg](const boost::system::error_code& ec, std::size_t bytes_transferred) {
@@ -197,4 +369,152 @@ void goby::middleware::io::UDPOneToManyThread<
         });
 }
 
+#ifdef __linux__
+template <const goby::middleware::Group& line_in_group,
+          const goby::middleware::Group& line_out_group,
+          goby::middleware::io::PubSubLayer publish_layer,
+          goby::middleware::io::PubSubLayer subscribe_layer, typename Config,
+          template <class> class ThreadType>
+void goby::middleware::io::UDPOneToManyThread<line_in_group, line_out_group, publish_layer,
+                                              subscribe_layer, Config,
+                                              ThreadType>::async_read_batch()
+{
+    this->mutable_socket().async_wait(
+        boost::asio::ip::udp::socket::wait_read, [this](const boost::system::error_code& ec) {
+            if (ec)
+            {
+                this->handle_read_error(ec);
+                return;
+            }
+
+            const bool kernel_timestamp = this->cfg().kernel_timestamp();
+            for (decltype(rx_batch_msgs_.size()) i = 0, n = rx_batch_msgs_.size(); i < n; ++i)
+            {
+                auto& hdr = rx_batch_msgs_[i].msg_hdr;
+                hdr.msg_namelen = sizeof(sockaddr_storage);
+                if (kernel_timestamp)
+                {
+                    hdr.msg_control = &rx_batch_control_[i * rx_control_size];
+                    hdr.msg_controllen = rx_control_size;
+                }
+            }
+
+            int num_msgs = recvmmsg(this->mutable_socket().native_handle(), rx_batch_msgs_.data(),
+                                    rx_batch_msgs_.size(), MSG_DONTWAIT, nullptr);
+            if (num_msgs < 0)
+            {
+                int err = errno;
+                if (err == EAGAIN || err == EWOULDBLOCK || err == EINTR)
+                    this->async_read();
+                else
+                    this->handle_read_error(
+                        boost::system::error_code(err, boost::asio::error::get_system_category()));
+                return;
+            }
+
+            const auto read_time = detail::ReceiveTime::now();
+            for (int i = 0; i < num_msgs; ++i)
+            {
+                auto& msg = rx_batch_msgs_[i];
+                if (msg.msg_len == 0)
+                    continue;
+
+                auto receive_time = read_time;
+                goby::time::SystemClock::time_point kernel_time;
+                if (kernel_timestamp && detail::kernel_receive_time(msg.msg_hdr, kernel_time))
+                    receive_time = detail::ReceiveTime::from_system_time(kernel_time, read_time);
+
+                boost::asio::ip::udp::endpoint sender_endpoint;
+                std::memcpy(sender_endpoint.data(), msg.msg_hdr.msg_name,
+                            msg.msg_hdr.msg_namelen);
+                sender_endpoint.resize(msg.msg_hdr.msg_namelen);
+
+                handle_datagram(static_cast<const char*>(rx_batch_iov_[i].iov_base), msg.msg_len,
+                                sender_endpoint, receive_time);
+            }
+            this->async_read();
+        });
+}
+
+template <const goby::middleware::Group& line_in_group,
+          const goby::middleware::Group& line_out_group,
+          goby::middleware::io::PubSubLayer publish_layer,
+          goby::middleware::io::PubSubLayer subscribe_layer, typename Config,
+          template <class> class ThreadType>
+void goby::middleware::io::UDPOneToManyThread<line_in_group, line_out_group, publish_layer,
+                                              subscribe_layer, Config,
+                                              ThreadType>::flush_tx_queue()
+{
+    if (!this->socket_is_open())
+    {
+        tx_queue_.clear();
+        tx_flush_pending_ = false;
+        return;
+    }
+
+    const auto batch_size = this->cfg().batch_size();
+    std::vector<mmsghdr> msgs(batch_size);
+    std::vector<iovec> iov(batch_size);
+
+    while (!tx_queue_.empty())
+    {
+        unsigned num_msgs = 0;
+        for (auto it = tx_queue_.begin(); it != tx_queue_.end() && num_msgs < batch_size;
+             ++it, ++num_msgs)
+        {
+            const std::string& data = it->first->data();
+            iov[num_msgs].iov_base = const_cast<char*>(data.data());
+            iov[num_msgs].iov_len = data.size();
+            msgs[num_msgs] = mmsghdr();
+            msgs[num_msgs].msg_hdr.msg_iov = &iov[num_msgs];
+            msgs[num_msgs].msg_hdr.msg_iovlen = 1;
+            msgs[num_msgs].msg_hdr.msg_name = it->second.data();
+            msgs[num_msgs].msg_hdr.msg_namelen = it->second.size();
+        }
+
+        int num_sent =
+            sendmmsg(this->mutable_socket().native_handle(), msgs.data(), num_msgs, MSG_DONTWAIT);
+        if (num_sent < 0)
+        {
+            int err = errno;
+            if (err == EAGAIN || err == EWOULDBLOCK || err == EINTR)
+            {
+                // send buffer is full: try again once there is space
+                this->mutable_socket().async_wait(
+                    boost::asio::ip::udp::socket::wait_write,
+                    [this](const boost::system::error_code& ec) {
+                        if (ec)
+                        {
+                            tx_queue_.clear();
+                            tx_flush_pending_ = false;
+                            this->handle_write_error(ec);
+                        }
+                        else
+                        {
+                            flush_tx_queue();
+                        }
+                    });
+            }
+            else
+            {
+                tx_queue_.clear();
+                tx_flush_pending_ = false;
+                this->handle_write_error(
+                    boost::system::error_code(err, boost::asio::error::get_system_category()));
+            }
+            return;
+        }
+
+        for (int i = 0; i < num_sent; ++i)
+        {
+            this->handle_write_success(msgs[i].msg_len);
+            tx_queue_.pop_front();
+        }
+    }
+    tx_flush_pending_ = false;
+    // warn again the next time the queue overflows
+    tx_queue_full_ = false;
+}
+#endif
+
 #endif
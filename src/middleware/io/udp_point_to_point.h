@@ -112,18 +112,7 @@ void goby::middleware::io::UDPPointToPointThread<
     line_in_group, line_out_group, publish_layer, subscribe_layer,
     ThreadType>::async_write(std::shared_ptr<const goby::middleware::protobuf::IOData> io_msg)
 {
-    this->mutable_socket().async_send_to(
-        boost::asio::buffer(io_msg->data()), remote_endpoint_,
-        [this, io_msg](const boost::system::error_code& ec, std::size_t bytes_transferred) {
-            if (!ec && bytes_transferred > 0)
-            {
-                this->handle_write_success(bytes_transferred);
-            }
-            else
-            {
-                this->handle_write_error(ec);
-            }
-        });
+    this->send_to(io_msg, remote_endpoint_);
 }
 
 #endif
@@ -21,8 +21,9 @@
 // You should have received a copy of the GNU Lesser General Public License
 // along with Goby.  If not, see <http://www.gnu.org/licenses/>.
 
-#include <list> // for oper...
-#include <map>  // for map
+#include <algorithm> // for min
+#include <list>      // for oper...
+#include <map>       // for map
 
 #include <dccl/logger.h>                   // for Logger
 #include <google/protobuf/descriptor.pb.h> // for File...
@@ -44,6 +45,12 @@ class Descriptor;
 } // namespace protobuf
 } // namespace google
 
+namespace
+{
+// from intervehicle.proto AggregateHeader definition
+constexpr std::size_t max_aggregate_count{255};
+} // namespace
+
 std::unique_ptr<dccl::Codec>
     goby::middleware::detail::DCCLSerializerParserHelperBase::codec_(nullptr);
 std::unordered_map<
@@ -88,6 +95,10 @@ goby::middleware::detail::DCCLSerializerParserHelperBase::unpack(const std::stri
 {
     std::lock_guard<std::mutex> lock(dccl_mutex_);
 
+    check_load<goby::middleware::intervehicle::protobuf::AggregateHeader>();
+    const auto aggregate_id =
+        codec().id<goby::middleware::intervehicle::protobuf::AggregateHeader>();
+
     goby::middleware::intervehicle::protobuf::DCCLForwardedData packets;
 
     std::string::const_iterator frame_it = frame.begin(), frame_end = frame.end();
@@ -95,17 +106,22 @@ goby::middleware::detail::DCCLSerializerParserHelperBase::unpack(const std::stri
     {
         auto dccl_id = codec().id(frame_it, frame_end);
 
-        goby::middleware::intervehicle::protobuf::DCCLPacket& packet = *packets.add_frame();
-        packet.set_dccl_id(dccl_id);
-
-        std::string::const_iterator next_frame_it;
+        unsigned count = 1;
+        if (dccl_id == aggregate_id)
+        {
+            goby::middleware::intervehicle::protobuf::AggregateHeader header;
+            frame_it = codec().decode(frame_it, frame_end, &header);
+            count = header.count();
+            if (frame_it >= frame_end)
+                break;
+            dccl_id = codec().id(frame_it, frame_end);
+        }
 
         if (codec().loaded().count(dccl_id) == INVALID_DCCL_ID)
         {
             goby::glog.is_debug1() &&
                 goby::glog << "DCCL ID " << dccl_id
                            << " is not loaded. Discarding remainder of the message." << std::endl;
-            packets.mutable_frame()->RemoveLast();
             return packets;
         }
 
@@ -113,15 +129,125 @@ goby::middleware::detail::DCCLSerializerParserHelperBase::unpack(const std::stri
         auto msg = dccl::DynamicProtobufManager::new_protobuf_message<
             std::unique_ptr<google::protobuf::Message>>(desc);
 
-        next_frame_it = codec().decode(frame_it, frame_end, msg.get());
-        packet.set_data(std::string(frame_it, next_frame_it));
+        // the first message is always complete
+        const std::string::const_iterator id_prefix_begin = frame_it;
+        std::string::const_iterator next_frame_it = codec().decode(frame_it, frame_end, msg.get());
 
+        goby::middleware::intervehicle::protobuf::DCCLPacket& packet = *packets.add_frame();
+        packet.set_dccl_id(dccl_id);
+        packet.set_data(std::string(frame_it, next_frame_it));
         frame_it = next_frame_it;
+
+        if (count == 1)
+            continue;
+
+        // the rest of an aggregate omit the DCCL ID prefix, so restore it from the first, copying
+        // at most one message worth of the frame after it
+        const auto prefix_size = id_size(dccl_id);
+        const std::size_t max_body_size = codec().max_size(desc) - prefix_size;
+        std::string bytes;
+        for (unsigned i = 1; i < count && frame_it < frame_end; ++i)
+        {
+            auto body_size = std::min<std::size_t>(frame_end - frame_it, max_body_size);
+            bytes.assign(id_prefix_begin, id_prefix_begin + prefix_size);
+            bytes.append(frame_it, frame_it + body_size);
+            std::string::const_iterator bytes_end =
+                codec().decode(bytes.cbegin(), bytes.cend(), msg.get());
+            const std::size_t message_size = bytes_end - bytes.cbegin();
+
+            goby::middleware::intervehicle::protobuf::DCCLPacket& aggregate_packet =
+                *packets.add_frame();
+            aggregate_packet.set_dccl_id(dccl_id);
+            aggregate_packet.set_data(bytes.data(), message_size);
+            frame_it += message_size - prefix_size;
+        }
     }
 
     return packets;
 }
 
+std::string goby::middleware::detail::DCCLSerializerParserHelperBase::pack(
+    const std::vector<std::string>& messages)
+{
+    std::lock_guard<std::mutex> lock(dccl_mutex_);
+
+    check_load<goby::middleware::intervehicle::protobuf::AggregateHeader>();
+
+    // group messages by DCCL ID, keeping the order in which each ID first appears
+    std::vector<unsigned> id_order;
+    std::map<unsigned, std::vector<const std::string*>> id_messages;
+    for (const auto& message : messages)
+    {
+        auto dccl_id = codec().id(message.begin(), message.end());
+        auto& same_id = id_messages[dccl_id];
+        if (same_id.empty())
+            id_order.push_back(dccl_id);
+        same_id.push_back(&message);
+    }
+
+    goby::middleware::intervehicle::protobuf::AggregateHeader header;
+
+    std::string frame;
+    for (auto dccl_id : id_order)
+    {
+        const auto& same_id = id_messages[dccl_id];
+        const auto prefix_size = id_size(dccl_id);
+
+        for (std::size_t begin = 0, n = same_id.size(); begin < n;)
+        {
+            std::size_t count = std::min(n - begin, max_aggregate_count);
+
+            std::string header_bytes;
+            if (count > 1)
+            {
+                header.set_count(count);
+                codec().encode(&header_bytes, header);
+            }
+
+            // only aggregate when we actually save space
+            if (count > 1 && (count - 1) * prefix_size > header_bytes.size())
+            {
+                frame += header_bytes;
+                frame += *same_id[begin];
+                for (std::size_t i = begin + 1; i < begin + count; ++i)
+                    frame.append(same_id[i]->begin() + prefix_size, same_id[i]->end());
+            }
+            else
+            {
+                for (std::size_t i = begin; i < begin + count; ++i) frame += *same_id[i];
+            }
+            begin += count;
+        }
+    }
+    return frame;
+}
+
+std::size_t goby::middleware::detail::DCCLSerializerParserHelperBase::packed_size(
+    unsigned dccl_id, std::size_t count, std::size_t bytes)
+{
+    std::lock_guard<std::mutex> lock(dccl_mutex_);
+
+    check_load<goby::middleware::intervehicle::protobuf::AggregateHeader>();
+
+    // same runs (and choice of whether to aggregate each one) as pack()
+    const auto prefix_size = id_size(dccl_id);
+    goby::middleware::intervehicle::protobuf::AggregateHeader header;
+    std::size_t size = bytes;
+    for (std::size_t begin = 0; begin < count;)
+    {
+        std::size_t run = std::min(count - begin, max_aggregate_count);
+        if (run > 1)
+        {
+            header.set_count(run);
+            const std::size_t header_size = codec().size(header);
+            if ((run - 1) * prefix_size > header_size)
+                size -= (run - 1) * prefix_size - header_size;
+        }
+        begin += run;
+    }
+    return size;
+}
+
 void goby::middleware::detail::DCCLSerializerParserHelperBase::setup_dlog()
 {
     static bool setup_complete = false;
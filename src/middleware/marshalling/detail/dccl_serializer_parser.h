@@ -31,6 +31,7 @@
 #include <string>        // for string, operat...
 #include <unordered_map> // for unordered_map
 #include <utility>       // for pair, make_pair
+#include <vector>        // for vector
 
 #include <dccl/codec.h>                    // for Codec
 #include <dccl/dynamic_protobuf_manager.h> // for DynamicProtobu...
@@ -118,6 +119,9 @@ struct DCCLSerializerParserHelperBase
         return *codec_;
     }
 
+    // size of the DCCL ID prefix written by dccl::DefaultIdentifierCodec
+    static std::size_t id_size(unsigned dccl_id) { return dccl_id < 128 ? 1 : 2; }
+
     static dccl::Codec& set_codec(dccl::Codec* new_codec)
     {
         codec_.reset(new_codec);
@@ -154,9 +158,25 @@ struct DCCLSerializerParserHelperBase
     }
 
     static void load_metadata(const goby::middleware::protobuf::SerializerProtobufMetadata& meta);
+
+    /// \brief Split a frame of concatenated DCCL messages (packed or not) into separate packets
     static goby::middleware::intervehicle::protobuf::DCCLForwardedData
     unpack(const std::string& bytes);
 
+    /// \brief Concatenate DCCL messages into a packed frame, where runs of messages with the same DCCL ID share a single intervehicle::protobuf::AggregateHeader
+    ///
+    /// \param messages DCCL encoded messages, which may be reordered to group identical DCCL IDs
+    /// \return packed frame, which is never larger than the messages simply concatenated
+    static std::string pack(const std::vector<std::string>& messages);
+
+    /// \brief Size that pack() produces for the messages with a given DCCL ID, without having to pack them
+    ///
+    /// \param dccl_id DCCL ID shared by the messages
+    /// \param count Number of messages with this DCCL ID
+    /// \param bytes Total size of these messages (unpacked)
+    /// \return size of these messages within a packed frame (the size of the frame is the sum over each DCCL ID)
+    static std::size_t packed_size(unsigned dccl_id, std::size_t count, std::size_t bytes);
+
     static void load_library(const std::string& library)
     {
         std::lock_guard<std::mutex> lock(dccl_mutex_);
@@ -28,13 +28,17 @@
 #include <mavlink/v2.0/common/common.hpp> // for MESSAGE_ENTRIES
 #include <mavlink/v2.0/message.hpp>       // for mavlink_get_msg_entry
 
-std::unordered_map<uint32_t, mavlink::mavlink_msg_entry_t>
-    goby::middleware::MAVLinkRegistry::entries_;
+std::atomic<const goby::middleware::MAVLinkRegistry::Table*>
+    goby::middleware::MAVLinkRegistry::table_{nullptr};
+std::vector<std::unique_ptr<const goby::middleware::MAVLinkRegistry::Table>>
+    goby::middleware::MAVLinkRegistry::tables_;
 std::mutex goby::middleware::MAVLinkRegistry::mavlink_registry_mutex_;
 
 void goby::middleware::MAVLinkRegistry::register_default_dialects()
 {
-    register_dialect_entries(mavlink::common::MESSAGE_ENTRIES);
+    std::lock_guard<std::mutex> lock(mavlink_registry_mutex_);
+    if (!table_.load(std::memory_order_relaxed))
+        insert_entries(mavlink::common::MESSAGE_ENTRIES);
 }
 
 namespace mavlink
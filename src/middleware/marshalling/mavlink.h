@@ -25,6 +25,7 @@
 #define GOBY_MIDDLEWARE_MARSHALLING_MAVLINK_H
 
 #include <array>         // for array<>::iterator
+#include <atomic>        // for atomic
 #include <cstdint>       // for uint8_t, uint32_t
 #include <memory>        // for shared_ptr, make_sh...
 #include <mutex>         // for mutex, lock_guard
@@ -49,6 +50,8 @@ namespace middleware
 /// \brief A registry of mavlink types used for decoding
 ///
 /// You should register the MESSAGE_ENTRIES for the dialect(s) you're using with this registry, if other than common and minimal. Parsing and serialization will still work if you don't, but you will get CRC errors for the unknown types.
+///
+/// Lookups do not lock: each registration publishes a new immutable table, and superseded tables are kept (registration is rare and normally only happens at startup) so that pointers returned by get_msg_entry() remain valid.
 struct MAVLinkRegistry
 {
     /// \brief Register a new Mavlink dialect
@@ -58,7 +61,9 @@ struct MAVLinkRegistry
     static void register_dialect_entries(std::array<mavlink::mavlink_msg_entry_t, Size> entries)
     {
         std::lock_guard<std::mutex> lock(mavlink_registry_mutex_);
-        for (const auto& entry : entries) entries_.insert(std::make_pair(entry.msgid, entry));
+        if (!table_.load(std::memory_order_relaxed))
+            insert_entries(mavlink::common::MESSAGE_ENTRIES);
+        insert_entries(entries);
     }
 
     /// \brief Retrieve a entry given a message id
@@ -67,12 +72,15 @@ struct MAVLinkRegistry
     /// \return The mavlink_msg_entry_t for the given msgid or nullptr if the msgid isn't loaded.
     static const mavlink::mavlink_msg_entry_t* get_msg_entry(uint32_t msgid)
     {
-        if (entries_.empty())
+        const Table* table = table_.load(std::memory_order_acquire);
+        if (!table)
+        {
             register_default_dialects();
+            table = table_.load(std::memory_order_acquire);
+        }
 
-        std::lock_guard<std::mutex> lock(mavlink_registry_mutex_);
-        auto it = entries_.find(msgid);
-        if (it != entries_.end())
+        auto it = table->find(msgid);
+        if (it != table->end())
             return &it->second;
         else
             return nullptr;
@@ -81,7 +89,23 @@ struct MAVLinkRegistry
     static void register_default_dialects();
 
   private:
-    static std::unordered_map<uint32_t, mavlink::mavlink_msg_entry_t> entries_;
+    using Table = std::unordered_map<uint32_t, mavlink::mavlink_msg_entry_t>;
+
+    // must be called with mavlink_registry_mutex_ locked
+    template <std::size_t Size>
+    static void insert_entries(const std::array<mavlink::mavlink_msg_entry_t, Size>& entries)
+    {
+        const Table* current = table_.load(std::memory_order_relaxed);
+        std::unique_ptr<Table> table(current ? new Table(*current) : new Table);
+        for (const auto& entry : entries) table->insert(std::make_pair(entry.msgid, entry));
+        table_.store(table.get(), std::memory_order_release);
+        tables_.push_back(std::move(table));
+    }
+
+  private:
+    static std::atomic<const Table*> table_;
+    // owns every table ever published (the last is current)
+    static std::vector<std::unique_ptr<const Table>> tables_;
     static std::mutex mavlink_registry_mutex_;
 };
 
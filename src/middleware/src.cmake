@@ -13,6 +13,7 @@ protobuf_generate_cpp(MIDDLEWARE_PROTO_SRCS MIDDLEWARE_PROTO_HDRS
   middleware/protobuf/can_config.proto
   middleware/protobuf/udp_config.proto
   middleware/protobuf/coroner.proto
+  middleware/protobuf/transporter_metrics.proto
   middleware/protobuf/layer.proto
   middleware/protobuf/geographic.proto
   middleware/protobuf/frontseat.proto
@@ -29,8 +30,13 @@ set(MIDDLEWARE_SRC
   middleware/marshalling/interface.cpp
   middleware/marshalling/detail/dccl_serializer_parser.cpp 
   middleware/transport/interthread.cpp
+  middleware/transport/metrics.cpp
+  middleware/transport/intervehicle/buffer_journal.cpp
   middleware/transport/intervehicle/driver_thread.cpp
+  middleware/transport/intervehicle/fragmentation.cpp
   middleware/application/configuration_reader.cpp
+  middleware/application/detail/thread_placement.cpp
+  middleware/application/detail/thread_pool_executor.cpp
   middleware/log/log_entry.cpp
   middleware/frontseat/interface.cpp
   middleware/coroner/coroner.cpp
@@ -0,0 +1,254 @@
+// Copyright 2023:
+//   GobySoft, LLC (2013-)
+//   Community contributors (see AUTHORS file)
+// File authors:
+//   Toby Schneider <toby@gobysoft.org>
+//
+//
+// This file is part of the Goby Underwater Autonomy Project Libraries
+// ("The Goby Libraries").
+//
+// The Goby Libraries are free software: you can redistribute them and/or modify
+// them under the terms of the GNU Lesser General Public License as published by
+// the Free Software Foundation, either version 2.1 of the License, or
+// (at your option) any later version.
+//
+// The Goby Libraries are distributed in the hope that they will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU Lesser General Public License for more details.
+//
+// You should have received a copy of the GNU Lesser General Public License
+// along with Goby.  If not, see <http://www.gnu.org/licenses/>.
+
+
+#ifndef GOBY_MIDDLEWARE_TRANSPORT_COROUTINE_H
+#define GOBY_MIDDLEWARE_TRANSPORT_COROUTINE_H
+
+// The Goby libraries are built as C++14, but this header can be used by code that is compiled with
+// C++20 coroutine support
+#if defined(__cpp_impl_coroutine) && __has_include(<coroutine>)
+
+#define GOBY_MIDDLEWARE_HAS_COROUTINES 1
+
+#include <algorithm>  // for remove
+#include <chrono>     // for duration
+#include <coroutine>  // for coroutine_handle, suspend_never
+#include <functional> // for function
+#include <map>        // for map
+#include <memory>     // for shared_ptr, weak_ptr
+#include <mutex>      // for mutex, lock_guard
+#include <vector>     // for vector
+
+#include "goby/middleware/group.h"               // for Group
+#include "goby/middleware/transport/interface.h" // for PollerInterface, PollerTimers
+#include "goby/time/steady_clock.h"              // for SteadyClock
+
+namespace goby
+{
+namespace middleware
+{
+/// \brief Support for writing request/response and other sequential flows as C++20 coroutines that run on an existing goby Thread
+///
+/// A coroutine is resumed from within poll() (by a subscription callback or a timer), so it runs on the thread that owns the transporter and never blocks that thread's other subscriptions while suspended. For example:
+/// \code
+/// coro::Task send_command(const Command& command)
+/// {
+///     interprocess().publish<groups::command>(command);
+///     auto ack = co_await coro::next<groups::ack, CommandAck>(interprocess(), std::chrono::seconds(5));
+///     if (!ack)
+///         glog.is_warn() && glog << "No ack received" << std::endl;
+///     co_await coro::sleep_for(interprocess(), std::chrono::seconds(1));
+///     // ...
+/// }
+/// \endcode
+namespace coro
+{
+/// \brief Return type for a coroutine that starts running immediately and is not awaited by its caller (it destroys itself when complete)
+struct Task
+{
+    struct promise_type
+    {
+        Task get_return_object() { return {}; }
+        std::suspend_never initial_suspend() noexcept { return {}; }
+        std::suspend_never final_suspend() noexcept { return {}; }
+        void return_void() {}
+        // propagate to whoever resumed the coroutine (i.e. out of poll()), as for callbacks
+        void unhandled_exception() { throw; }
+    };
+};
+
+/// \brief Awaitable that resumes the coroutine from poll() once a (SteadyClock) deadline is reached
+class SleepAwaiter
+{
+  public:
+    SleepAwaiter(PollerInterface& poller, goby::time::SteadyClock::time_point deadline)
+        : timers_(poller.timers()), deadline_(deadline)
+    {
+    }
+
+    bool await_ready() const { return deadline_ <= goby::time::SteadyClock::now(); }
+    void await_suspend(std::coroutine_handle<> handle)
+    {
+        timers_->add(deadline_, [handle]() { handle.resume(); });
+    }
+    void await_resume() const {}
+
+  private:
+    std::shared_ptr<detail::PollerTimers> timers_;
+    goby::time::SteadyClock::time_point deadline_;
+};
+
+/// \brief co_await sleep_until(poller, t): suspend until SteadyClock time t
+inline SleepAwaiter sleep_until(PollerInterface& poller, goby::time::SteadyClock::time_point t)
+{
+    return SleepAwaiter(poller, t);
+}
+
+/// \brief co_await sleep_for(poller, d): suspend for (SteadyClock) duration d
+template <typename Rep, typename Period>
+SleepAwaiter sleep_for(PollerInterface& poller, std::chrono::duration<Rep, Period> d)
+{
+    return SleepAwaiter(
+        poller, goby::time::SteadyClock::now() +
+                    std::chrono::duration_cast<goby::time::SteadyClock::duration>(d));
+}
+
+namespace detail
+{
+template <typename Data> struct NextWaiter
+{
+    std::coroutine_handle<> handle;
+    std::shared_ptr<const Data> data;
+    middleware::detail::PollerTimers::Id timer_id{0};
+};
+
+// Hands the next message received on one subscription to all the coroutines waiting for it
+template <typename Data> class NextDispatcher
+{
+  public:
+    explicit NextDispatcher(std::shared_ptr<middleware::detail::PollerTimers> timers)
+        : timers_(timers)
+    {
+    }
+
+    void add(NextWaiter<Data>* waiter) { waiting_.push_back(waiter); }
+    void remove(NextWaiter<Data>* waiter)
+    {
+        waiting_.erase(std::remove(waiting_.begin(), waiting_.end(), waiter), waiting_.end());
+    }
+
+    void dispatch(std::shared_ptr<const Data> data)
+    {
+        // coroutines that co_await next() again while being resumed wait for the following message
+        std::vector<NextWaiter<Data>*> waiting;
+        waiting.swap(waiting_);
+
+        auto timers = timers_.lock();
+        for (auto* waiter : waiting)
+        {
+            if (waiter->timer_id && timers)
+                timers->cancel(waiter->timer_id);
+            waiter->data = data;
+            waiter->handle.resume();
+        }
+    }
+
+    bool expired() const { return timers_.expired(); }
+
+  private:
+    std::weak_ptr<middleware::detail::PollerTimers> timers_;
+    std::vector<NextWaiter<Data>*> waiting_;
+};
+
+// One (permanent) subscription per transporter, group and type is shared by all calls to next()
+template <const Group& group, typename Data, int scheme, typename Transporter>
+std::shared_ptr<NextDispatcher<Data>> next_dispatcher(Transporter& transporter)
+{
+    static std::mutex registry_mutex;
+    static std::map<const Transporter*, std::shared_ptr<NextDispatcher<Data>>> registry;
+
+    std::lock_guard<std::mutex> lock(registry_mutex);
+    auto it = registry.find(&transporter);
+    // a dispatcher for a destroyed transporter that had the same address
+    if (it != registry.end() && it->second->expired())
+        it = registry.erase(it);
+
+    if (it == registry.end())
+    {
+        auto dispatcher = std::make_shared<NextDispatcher<Data>>(transporter.timers());
+        transporter.template subscribe<group, Data, scheme>(
+            std::function<void(std::shared_ptr<const Data>)>(
+                [dispatcher](std::shared_ptr<const Data> data) { dispatcher->dispatch(data); }));
+        it = registry.insert(std::make_pair(&transporter, dispatcher)).first;
+    }
+    return it->second;
+}
+} // namespace detail
+
+/// \brief Awaitable that resumes the coroutine with the next message published to a group (or nullptr on timeout)
+template <const Group& group, typename Data, int scheme, typename Transporter> class NextAwaiter
+{
+  public:
+    NextAwaiter(Transporter& transporter, goby::time::SteadyClock::duration timeout)
+        : transporter_(transporter), timeout_(timeout)
+    {
+    }
+
+    bool await_ready() const { return false; }
+    void await_suspend(std::coroutine_handle<> handle)
+    {
+        waiter_.handle = handle;
+        auto dispatcher = detail::next_dispatcher<group, Data, scheme>(transporter_);
+        dispatcher->add(&waiter_);
+
+        if (timeout_ != goby::time::SteadyClock::duration::max())
+        {
+            auto* waiter = &waiter_;
+            waiter_.timer_id = transporter_.timers()->add(goby::time::SteadyClock::now() + timeout_,
+                                                          [dispatcher, waiter]() {
+                                                              dispatcher->remove(waiter);
+                                                              waiter->handle.resume();
+                                                          });
+        }
+    }
+    std::shared_ptr<const Data> await_resume() { return std::move(waiter_.data); }
+
+  private:
+    Transporter& transporter_;
+    goby::time::SteadyClock::duration timeout_;
+    detail::NextWaiter<Data> waiter_;
+};
+
+/// \brief co_await next<group, Data>(transporter, timeout): suspend until the next message of type Data is published to group
+///
+/// \param transporter Transporter to subscribe on (must be a Poller, e.g. InterThreadTransporter or InterProcessPortal)
+/// \param timeout How long to wait for the message
+/// \return (from co_await) the message, or nullptr if the timeout was reached
+///
+/// The first call for a given transporter, group and type adds a subscription that is kept for the lifetime of the transporter (messages received when no coroutine is waiting are ignored by it). This does not affect other subscriptions to the same group.
+template <const Group& group, typename Data, typename Transporter,
+          int scheme = transporter_scheme<Data, Transporter>(), typename Rep, typename Period>
+NextAwaiter<group, Data, scheme, Transporter> next(Transporter& transporter,
+                                                   std::chrono::duration<Rep, Period> timeout)
+{
+    return NextAwaiter<group, Data, scheme, Transporter>(
+        transporter, std::chrono::duration_cast<goby::time::SteadyClock::duration>(timeout));
+}
+
+/// \brief co_await next<group, Data>(transporter): suspend (without a timeout) until the next message of type Data is published to group
+template <const Group& group, typename Data, typename Transporter,
+          int scheme = transporter_scheme<Data, Transporter>()>
+NextAwaiter<group, Data, scheme, Transporter> next(Transporter& transporter)
+{
+    return NextAwaiter<group, Data, scheme, Transporter>(
+        transporter, goby::time::SteadyClock::duration::max());
+}
+
+} // namespace coro
+} // namespace middleware
+} // namespace goby
+
+#endif
+
+#endif
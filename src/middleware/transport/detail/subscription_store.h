@@ -24,7 +24,9 @@
 #ifndef GOBY_MIDDLEWARE_TRANSPORT_DETAIL_SUBSCRIPTION_STORE_H
 #define GOBY_MIDDLEWARE_TRANSPORT_DETAIL_SUBSCRIPTION_STORE_H
 
+#include <algorithm>
 #include <condition_variable>
+#include <deque>
 #include <functional>
 #include <memory>
 #include <mutex>
@@ -35,6 +37,9 @@
 #include <unordered_map>
 #include <vector>
 
+#include "goby/middleware/common.h"
+#include "goby/middleware/transport/interface.h"
+#include "goby/middleware/transport/metrics.h"
 #include "goby/middleware/transport/publisher.h"
 
 namespace goby
@@ -49,7 +54,7 @@ class SubscriptionStoreBase
   private:
     // for each thread, stores a map of Datas to SubscriptionStores so that can call poll() on all the stores
     using StoresMap = std::unordered_map<std::type_index, std::shared_ptr<SubscriptionStoreBase>>;
-    static std::unordered_map<std::thread::id, StoresMap> stores_;
+    static std::unordered_map<ThreadId, StoresMap> stores_;
     static std::shared_timed_mutex stores_mutex_;
 
   public:
@@ -57,7 +62,7 @@ class SubscriptionStoreBase
     virtual ~SubscriptionStoreBase() = default;
 
     // returns number of data items posted to callbacks
-    static int poll_all(std::thread::id thread_id,
+    static int poll_all(ThreadId thread_id,
                         std::unique_ptr<std::unique_lock<std::timed_mutex>>& lock)
     {
         // make a copy so that other threads can subscribe if
@@ -74,7 +79,7 @@ class SubscriptionStoreBase
         return poll_items;
     }
 
-    static void unsubscribe_all(std::thread::id thread_id)
+    static void unsubscribe_all(ThreadId thread_id)
     {
         std::shared_lock<std::shared_timed_mutex> stores_lock(stores_mutex_);
         if (stores_.count(thread_id))
@@ -83,14 +88,14 @@ class SubscriptionStoreBase
         }
     }
 
-    static void remove(std::thread::id thread_id)
+    static void remove(ThreadId thread_id)
     {
         std::lock_guard<decltype(stores_mutex_)> lock(stores_mutex_);
         stores_.erase(thread_id);
     }
 
   protected:
-    template <typename StoreType> static void insert(std::thread::id thread_id)
+    template <typename StoreType> static void insert(ThreadId thread_id)
     {
         // check the store, and if there isn't one for this type, create one
         std::lock_guard<decltype(stores_mutex_)> lock(stores_mutex_);
@@ -105,62 +110,57 @@ class SubscriptionStoreBase
     }
 
   protected:
-    virtual int poll(std::thread::id thread_id,
+    virtual int poll(ThreadId thread_id,
                      std::unique_ptr<std::unique_lock<std::timed_mutex>>& lock) = 0;
-    virtual void unsubscribe_all_groups(std::thread::id thread_id) = 0;
+    virtual void unsubscribe_all_groups(ThreadId thread_id) = 0;
 };
 
 struct DataProtection
 {
     DataProtection(std::shared_ptr<std::mutex> dm, std::shared_ptr<std::condition_variable_any> pcv,
-                   std::shared_ptr<std::timed_mutex> pm)
-        : data_mutex(dm), poller_cv(pcv), poller_mutex(pm)
+                   std::shared_ptr<std::timed_mutex> pm, std::shared_ptr<PollerWakeHook> pwh)
+        : data_mutex(dm), poller_cv(pcv), poller_mutex(pm), poller_wake_hook(pwh)
     {
     }
 
     std::shared_ptr<std::mutex> data_mutex;
     std::shared_ptr<std::condition_variable_any> poller_cv;
     std::shared_ptr<std::timed_mutex> poller_mutex;
+    std::shared_ptr<PollerWakeHook> poller_wake_hook;
 };
 
 /// \brief Storage class for a specific interthread subscription (and related data). Used by InterThreadTransporter
 template <typename Data> class SubscriptionStore : public SubscriptionStoreBase
 {
   public:
+    using BatchCallbackType = std::function<void(const std::vector<std::shared_ptr<const Data>>&)>;
+
     static void subscribe(std::function<void(std::shared_ptr<const Data>)> func, const Group& group,
-                          std::thread::id thread_id, std::shared_ptr<std::mutex> data_mutex,
+                          ThreadId thread_id, std::shared_ptr<std::mutex> data_mutex,
                           std::shared_ptr<std::condition_variable_any> cv,
-                          std::shared_ptr<std::timed_mutex> poller_mutex)
+                          std::shared_ptr<std::timed_mutex> poller_mutex,
+                          std::shared_ptr<PollerWakeHook> wake_hook,
+                          const protobuf::TransporterConfig::Queue& queue_cfg =
+                              protobuf::TransporterConfig::Queue())
     {
-        {
-            std::lock_guard<std::shared_timed_mutex> lock(subscription_mutex_);
-
-            // insert callback
-            auto it =
-                subscription_callbacks_.insert(std::make_pair(thread_id, Callback(group, func)));
-            // insert group with iterator to callback
-            subscription_groups_.insert(std::make_pair(group, it));
-
-            // if necessary, create a DataQueue for this thread
-            auto queue_it = data_.find(thread_id);
-            if (queue_it == data_.end())
-            {
-                auto bool_it_pair = data_.insert(std::make_pair(thread_id, DataQueue()));
-                queue_it = bool_it_pair.first;
-            }
-            queue_it->second.create(group);
-
-            // if we don't have a condition variable already for this thread, store it
-            if (!data_protection_.count(thread_id))
-                data_protection_.insert(std::make_pair(
-                    thread_id, detail::DataProtection(data_mutex, cv, poller_mutex)));
-        }
+        insert_subscription(Callback(group, func), thread_id, data_mutex, cv, poller_mutex,
+                            wake_hook, queue_cfg);
+    }
 
-        // try inserting a copy of this templated class via the base class for SubscriptionStoreBase::poll_all to use
-        SubscriptionStoreBase::insert<SubscriptionStore<Data>>(thread_id);
+    /// \brief As subscribe(), but the callback is called once per poll with all the data queued for this group since the last poll (in order of publication)
+    static void subscribe_batch(BatchCallbackType func, const Group& group, ThreadId thread_id,
+                                std::shared_ptr<std::mutex> data_mutex,
+                                std::shared_ptr<std::condition_variable_any> cv,
+                                std::shared_ptr<std::timed_mutex> poller_mutex,
+                                std::shared_ptr<PollerWakeHook> wake_hook,
+                                const protobuf::TransporterConfig::Queue& queue_cfg =
+                                    protobuf::TransporterConfig::Queue())
+    {
+        insert_subscription(Callback(group, func), thread_id, data_mutex, cv, poller_mutex,
+                            wake_hook, queue_cfg);
     }
 
-    static void unsubscribe(const Group& group, std::thread::id thread_id)
+    static void unsubscribe(const Group& group, ThreadId thread_id)
     {
         {
             std::lock_guard<std::shared_timed_mutex> lock(subscription_mutex_);
@@ -188,6 +188,46 @@ template <typename Data> class SubscriptionStore : public SubscriptionStoreBase
         }
     }
 
+  private:
+    struct Callback;
+
+    static void insert_subscription(Callback callback, ThreadId thread_id,
+                                    std::shared_ptr<std::mutex> data_mutex,
+                                    std::shared_ptr<std::condition_variable_any> cv,
+                                    std::shared_ptr<std::timed_mutex> poller_mutex,
+                                    std::shared_ptr<PollerWakeHook> wake_hook,
+                                    const protobuf::TransporterConfig::Queue& queue_cfg)
+    {
+        const Group group = callback.group;
+        {
+            std::lock_guard<std::shared_timed_mutex> lock(subscription_mutex_);
+
+            // insert callback
+            auto it =
+                subscription_callbacks_.insert(std::make_pair(thread_id, std::move(callback)));
+            // insert group with iterator to callback
+            subscription_groups_.insert(std::make_pair(group, it));
+
+            // if necessary, create a DataQueue for this thread
+            auto queue_it = data_.find(thread_id);
+            if (queue_it == data_.end())
+            {
+                auto bool_it_pair = data_.insert(std::make_pair(thread_id, DataQueue()));
+                queue_it = bool_it_pair.first;
+            }
+            queue_it->second.create(group, queue_cfg);
+
+            // if we don't have a condition variable already for this thread, store it
+            if (!data_protection_.count(thread_id))
+                data_protection_.insert(std::make_pair(
+                    thread_id, detail::DataProtection(data_mutex, cv, poller_mutex, wake_hook)));
+        }
+
+        // try inserting a copy of this templated class via the base class for SubscriptionStoreBase::poll_all to use
+        SubscriptionStoreBase::insert<SubscriptionStore<Data>>(thread_id);
+    }
+
+  public:
     static void publish(std::shared_ptr<const Data> data, const Group& group,
                         const Publisher<Data>& publisher)
     {
@@ -198,18 +238,45 @@ template <typename Data> class SubscriptionStore : public SubscriptionStoreBase
             std::shared_lock<std::shared_timed_mutex> lock(subscription_mutex_);
 
             auto range = subscription_groups_.equal_range(group);
+
+            // all subscriptions to this group share the same counters
+            metrics::Counters* counters = nullptr;
+            auto publish_time = metrics::start_time();
+            if (metrics::Registry::enabled())
+            {
+                counters = (range.first != range.second)
+                               ? range.first->second->second.counters
+                               : &metrics::publish_counters<protobuf::LAYER_INTERTHREAD, Data>(
+                                     std::string(group), metrics::type_name<Data>());
+                counters->record_publish(0);
+            }
+
+            // queue the data once per thread: poll() passes each queued datum to all of the thread's
+            // subscriptions to this group
+            std::vector<ThreadId> queued_threads;
             for (auto it = range.first; it != range.second; ++it)
             {
-                std::thread::id thread_id = it->second->first;
+                ThreadId thread_id = it->second->first;
+                if (std::find(queued_threads.begin(), queued_threads.end(), thread_id) !=
+                    queued_threads.end())
+                    continue;
+                queued_threads.push_back(thread_id);
 
                 // don't store a copy if publisher == subscriber, and echo is false
-                if (thread_id != std::this_thread::get_id() || publisher.cfg().echo())
+                if (thread_id != this_thread_id() || publisher.cfg().echo())
                 {
                     // protect the DataQueue we are writing to
                     std::unique_lock<std::mutex> lock(*(data_protection_.at(thread_id).data_mutex));
                     auto queue_it = data_.find(thread_id);
-                    queue_it->second.insert(group, data);
-                    cv_to_notify.push_back(data_protection_.at(thread_id));
+                    auto result = queue_it->second.insert(group, data, publish_time);
+                    if (counters)
+                    {
+                        counters->record_inbox_depth(result.depth);
+                        if (result.dropped)
+                            counters->record_drop();
+                    }
+                    if (result.inserted)
+                        cv_to_notify.push_back(data_protection_.at(thread_id));
                 }
             }
         }
@@ -224,17 +291,32 @@ template <typename Data> class SubscriptionStore : public SubscriptionStoreBase
 
                 std::lock_guard<std::timed_mutex>(*data_protection.poller_mutex);
             }
+            time::DiscreteEventScheduler::notify(*data_protection.poller_cv);
             data_protection.poller_cv->notify_all();
+            (*data_protection.poller_wake_hook)();
         }
     }
 
   private:
-    int poll(std::thread::id thread_id,
+    int poll(ThreadId thread_id,
              std::unique_ptr<std::unique_lock<std::timed_mutex>>& lock) override
     {
-        std::vector<std::pair<std::shared_ptr<typename Callback::CallbackType>,
-                              std::shared_ptr<const Data>>>
-            data_callbacks;
+        struct PendingCallback
+        {
+            std::shared_ptr<typename Callback::CallbackType> callback;
+            std::shared_ptr<const Data> datum;
+            metrics::Clock::time_point publish_time;
+            metrics::Counters* counters;
+        };
+        struct PendingBatchCallback
+        {
+            std::shared_ptr<BatchCallbackType> callback;
+            std::vector<std::shared_ptr<const Data>> data;
+            std::vector<metrics::Clock::time_point> publish_times;
+            metrics::Counters* counters;
+        };
+        std::vector<PendingCallback> data_callbacks;
+        std::vector<PendingBatchCallback> batch_callbacks;
         int poll_items_count = 0;
 
         {
@@ -259,15 +341,38 @@ template <typename Data> class SubscriptionStore : public SubscriptionStoreBase
                     if (group_it->second->first != thread_id)
                         continue;
 
+                    const Callback& subscription = group_it->second->second;
+                    if (subscription.batch_callback)
+                    {
+                        if (data_it->second.data.empty())
+                            continue;
+
+                        if (lock)
+                            lock.reset();
+
+                        batch_callbacks.push_back(
+                            {subscription.batch_callback, {}, {}, subscription.counters});
+                        auto& pending = batch_callbacks.back();
+                        pending.data.reserve(data_it->second.data.size());
+                        for (auto& queued : data_it->second.data)
+                        {
+                            ++poll_items_count;
+                            pending.data.push_back(queued.datum);
+                            if (queued.publish_time != metrics::Clock::time_point())
+                                pending.publish_times.push_back(queued.publish_time);
+                        }
+                        continue;
+                    }
+
                     // store the callback function and datum for all the elements queued
-                    for (auto& datum : data_it->second)
+                    for (auto& queued : data_it->second.data)
                     {
                         ++poll_items_count;
                         // we have data, no need to keep this lock any longer
                         if (lock)
                             lock.reset();
-                        data_callbacks.push_back(
-                            std::make_pair(group_it->second->second.callback, datum));
+                        data_callbacks.push_back({subscription.callback, queued.datum,
+                                                  queued.publish_time, subscription.counters});
                     }
                 }
                 queue_it->second.clear(group);
@@ -275,13 +380,33 @@ template <typename Data> class SubscriptionStore : public SubscriptionStoreBase
         }
 
         // now that we're no longer blocking the subscription or data mutex, actually run the callbacks
-        for (const auto& callback_datum_pair : data_callbacks)
-            (*callback_datum_pair.first)(std::move(callback_datum_pair.second));
+        for (auto& pending : data_callbacks)
+        {
+            // publish_time is only set if metrics were enabled at the time of publication
+            if (pending.publish_time != metrics::Clock::time_point())
+            {
+                pending.counters->latency.add(metrics::Clock::now() - pending.publish_time);
+                pending.counters->record_receive(0);
+            }
+            (*pending.callback)(std::move(pending.datum));
+        }
+
+        for (auto& pending : batch_callbacks)
+        {
+            // publish_times are only stored for data published while metrics were enabled
+            auto now = metrics::Clock::now();
+            for (const auto& publish_time : pending.publish_times)
+            {
+                pending.counters->latency.add(now - publish_time);
+                pending.counters->record_receive(0);
+            }
+            (*pending.callback)(pending.data);
+        }
 
         return poll_items_count;
     }
 
-    void unsubscribe_all_groups(std::thread::id thread_id) override
+    void unsubscribe_all_groups(ThreadId thread_id) override
     {
         {
             std::lock_guard<std::shared_timed_mutex> lock(subscription_mutex_);
@@ -311,58 +436,115 @@ template <typename Data> class SubscriptionStore : public SubscriptionStoreBase
     {
         using CallbackType = std::function<void(std::shared_ptr<const Data>)>;
         Callback(const Group& g, const std::function<void(std::shared_ptr<const Data>)>& c)
-            : group(g), callback(new CallbackType(c))
+            : group(g),
+              callback(new CallbackType(c)),
+              counters(&metrics::Registry::counters(protobuf::LAYER_INTERTHREAD, std::string(g),
+                                                    metrics::type_name<Data>()))
+        {
+        }
+        Callback(const Group& g, const BatchCallbackType& c)
+            : group(g),
+              batch_callback(new BatchCallbackType(c)),
+              counters(&metrics::Registry::counters(protobuf::LAYER_INTERTHREAD, std::string(g),
+                                                    metrics::type_name<Data>()))
         {
         }
         Group group;
+        // exactly one of callback or batch_callback is set
         std::shared_ptr<CallbackType> callback;
+        std::shared_ptr<BatchCallbackType> batch_callback;
+        metrics::Counters* counters;
+    };
+
+    struct QueuedData
+    {
+        std::shared_ptr<const Data> datum;
+        metrics::Clock::time_point publish_time;
+    };
+
+    struct GroupQueue
+    {
+        std::deque<QueuedData> data;
+        protobuf::TransporterConfig::Queue cfg;
     };
 
     class DataQueue
     {
       private:
-        std::unordered_map<Group, std::vector<std::shared_ptr<const Data>>> data_;
+        std::unordered_map<Group, GroupQueue> data_;
 
       public:
-        void create(const Group& g)
+        struct InsertResult
+        {
+            // number of data now queued for this group
+            std::size_t depth;
+            // a datum was discarded due to the queue's overflow policy
+            bool dropped;
+            // the new datum was queued (false for DROP_NEWEST overflow)
+            bool inserted;
+        };
+
+        void create(const Group& g, const protobuf::TransporterConfig::Queue& cfg)
         {
             auto it = data_.find(g);
             if (it == data_.end())
-                data_.insert(std::make_pair(g, std::vector<std::shared_ptr<const Data>>()));
+            {
+                data_.insert(std::make_pair(g, GroupQueue{std::deque<QueuedData>(), cfg}));
+            }
+            else if (it->second.cfg.max_size() != 0 &&
+                     (cfg.max_size() == 0 || cfg.max_size() > it->second.cfg.max_size()))
+            {
+                // all subscriptions to this group from a given thread share a queue, so use the least restrictive limit
+                it->second.cfg = cfg;
+            }
         }
         void remove(const Group& g) { data_.erase(g); }
 
-        void insert(const Group& g, std::shared_ptr<const Data> datum)
+        InsertResult insert(const Group& g, std::shared_ptr<const Data> datum,
+                            metrics::Clock::time_point publish_time)
         {
-            data_.find(g)->second.push_back(datum);
+            auto& queue = data_.find(g)->second;
+            const auto max_size = queue.cfg.max_size();
+            if (max_size > 0 && queue.data.size() >= max_size)
+            {
+                if (queue.cfg.overflow() == protobuf::TransporterConfig::Queue::DROP_NEWEST)
+                    return {queue.data.size(), true, false};
+
+                queue.data.pop_front();
+                queue.data.push_back({datum, publish_time});
+                return {queue.data.size(), true, true};
+            }
+
+            queue.data.push_back({datum, publish_time});
+            return {queue.data.size(), false, true};
         }
-        void clear(const Group& g) { data_.find(g)->second.clear(); }
+        void clear(const Group& g) { data_.find(g)->second.data.clear(); }
         bool empty() { return data_.empty(); }
         typename decltype(data_)::const_iterator cbegin() { return data_.begin(); }
         typename decltype(data_)::const_iterator cend() { return data_.end(); }
     };
 
     // subscriptions for a given thread
-    static std::unordered_multimap<std::thread::id, Callback> subscription_callbacks_;
+    static std::unordered_multimap<ThreadId, Callback> subscription_callbacks_;
     // threads that are subscribed to a given group
     static std::unordered_multimap<Group,
                                    typename decltype(subscription_callbacks_)::const_iterator>
         subscription_groups_;
     // condition variable to use for data
-    static std::unordered_map<std::thread::id, detail::DataProtection> data_protection_;
+    static std::unordered_map<ThreadId, detail::DataProtection> data_protection_;
 
     static std::shared_timed_mutex
         subscription_mutex_; // protects subscription_callbacks, subscription_groups, data_protection, and the overarching data_ map (but not the DataQueues within it, which are protected by the mutexes stored in data_protection_))
 
     // data for a given thread
-    static std::unordered_map<std::thread::id, DataQueue> data_;
+    static std::unordered_map<ThreadId, DataQueue> data_;
 };
 
 template <typename Data>
-std::unordered_multimap<std::thread::id, typename SubscriptionStore<Data>::Callback>
+std::unordered_multimap<ThreadId, typename SubscriptionStore<Data>::Callback>
     SubscriptionStore<Data>::subscription_callbacks_;
 template <typename Data>
-std::unordered_map<std::thread::id, typename SubscriptionStore<Data>::DataQueue>
+std::unordered_map<ThreadId, typename SubscriptionStore<Data>::DataQueue>
     SubscriptionStore<Data>::data_;
 template <typename Data>
 std::unordered_multimap<goby::middleware::Group,
@@ -370,7 +552,7 @@ std::unordered_multimap<goby::middleware::Group,
                             SubscriptionStore<Data>::subscription_callbacks_)::const_iterator>
     SubscriptionStore<Data>::subscription_groups_;
 template <typename Data>
-std::unordered_map<std::thread::id, detail::DataProtection>
+std::unordered_map<ThreadId, detail::DataProtection>
     SubscriptionStore<Data>::data_protection_;
 
 template <typename Data> std::shared_timed_mutex SubscriptionStore<Data>::subscription_mutex_;
@@ -24,10 +24,17 @@
 #ifndef GOBY_MIDDLEWARE_TRANSPORT_DETAIL_INTERFACE_H
 #define GOBY_MIDDLEWARE_TRANSPORT_DETAIL_INTERFACE_H
 
+#include <algorithm>
+#include <atomic>
 #include <chrono>
 #include <condition_variable>
+#include <cstdint>
+#include <functional>
+#include <map>
 #include <memory>
 #include <mutex>
+#include <shared_mutex>
+#include <vector>
 
 #include "goby/middleware/group.h"
 #include "goby/middleware/marshalling/interface.h"
@@ -39,6 +46,7 @@
 #include "goby/middleware/transport/detail/type_helpers.h"
 #include "goby/middleware/transport/publisher.h"
 #include "goby/middleware/transport/subscriber.h"
+#include "goby/time/discrete_event.h"
 #include "goby/util/debug_logger.h"
 
 namespace goby
@@ -135,6 +143,158 @@ class InnerTransporterInterface<
 {
 };
 
+namespace detail
+{
+/// \brief Optional callback that is run whenever a publisher notifies PollerInterface::cv(). This is used by pollers that do not block on the condition variable (see ThreadPoolExecutor and io::IOThread)
+///
+/// The hook is run by the publishing thread. clear() blocks until any invocations in progress on other threads have returned, so once it returns the hook (and anything it captured) may safely be destroyed.
+///
+/// The hook runs with a shared lock held and set()/clear() take the exclusive lock, so calling set() or clear() on the same PollerWakeHook from within the hook (including from anything the hook publishes to or calls) would deadlock. This is detected and throws goby::Exception instead. The hook runs on the publishing thread, so this cannot be detected if the hook waits on another thread that is itself calling set() or clear(): do not call these while holding a lock that the hook (or a publisher, while publishing) may take.
+class PollerWakeHook
+{
+  public:
+    void set(std::function<void()> hook)
+    {
+        check_not_running("set");
+        std::unique_lock<std::shared_timed_mutex> lock(mutex_);
+        hook_ = std::move(hook);
+        is_set_ = static_cast<bool>(hook_);
+    }
+
+    void clear()
+    {
+        check_not_running("clear");
+        std::unique_lock<std::shared_timed_mutex> lock(mutex_);
+        is_set_ = false;
+        hook_ = std::function<void()>();
+    }
+
+    void operator()() const
+    {
+        // avoid locking for the common case of no hook
+        if (!is_set_)
+            return;
+
+        // hooks may publish, and so run other hooks (or this one again) on this thread
+        auto& running_hooks = running();
+        bool nested = std::find(running_hooks.begin(), running_hooks.end(), this) !=
+                      running_hooks.end();
+
+        // if nested, this thread already holds the shared lock (which is not recursive)
+        std::shared_lock<std::shared_timed_mutex> lock(mutex_, std::defer_lock);
+        if (!nested)
+            lock.lock();
+
+        if (hook_)
+        {
+            running_hooks.push_back(this);
+            struct Pop
+            {
+                ~Pop() { hooks.pop_back(); }
+                std::vector<const PollerWakeHook*>& hooks;
+            } pop{running_hooks};
+            hook_();
+        }
+    }
+
+  private:
+    // hooks currently being run by this thread
+    static std::vector<const PollerWakeHook*>& running()
+    {
+        thread_local std::vector<const PollerWakeHook*> hooks;
+        return hooks;
+    }
+
+    void check_not_running(const char* function) const
+    {
+        const auto& running_hooks = running();
+        if (std::find(running_hooks.begin(), running_hooks.end(), this) != running_hooks.end())
+            throw(goby::Exception(std::string("PollerWakeHook::") + function +
+                                  "() called from within the hook, which would deadlock"));
+    }
+
+    std::atomic<bool> is_set_{false};
+    mutable std::shared_timed_mutex mutex_;
+    std::function<void()> hook_;
+};
+
+/// \brief Timers that are run by PollerInterface::poll() (on the polling thread, without the poll mutex held) once their deadline is reached. These are the basis for the awaitable timers in goby/middleware/coroutine.h
+class PollerTimers
+{
+  public:
+    using Clock = goby::time::SteadyClock;
+    using Id = std::uint64_t;
+
+    /// \brief Schedule func to be run by poll() once deadline is reached
+    /// \return id to pass to cancel()
+    Id add(Clock::time_point deadline, std::function<void()> func)
+    {
+        std::lock_guard<std::mutex> lock(mutex_);
+        Id id = ++last_id_;
+        timers_.emplace(deadline, Timer{id, std::move(func)});
+        size_ = timers_.size();
+        return id;
+    }
+
+    /// \brief Remove a timer that has not yet run
+    /// \return true if the timer was found
+    bool cancel(Id id)
+    {
+        std::lock_guard<std::mutex> lock(mutex_);
+        for (auto it = timers_.begin(), end = timers_.end(); it != end; ++it)
+        {
+            if (it->second.id == id)
+            {
+                timers_.erase(it);
+                size_ = timers_.size();
+                return true;
+            }
+        }
+        return false;
+    }
+
+    bool empty() const { return size_ == 0; }
+
+    /// \brief Deadline of the earliest timer, or Clock::time_point::max() if there are none
+    Clock::time_point next_deadline() const
+    {
+        std::lock_guard<std::mutex> lock(mutex_);
+        return timers_.empty() ? Clock::time_point::max() : timers_.begin()->first;
+    }
+
+    /// \brief Run (and remove) all the timers whose deadline has been reached
+    /// \return number of timers run
+    int run_expired()
+    {
+        std::vector<std::function<void()>> expired;
+        {
+            std::lock_guard<std::mutex> lock(mutex_);
+            auto now = Clock::now();
+            while (!timers_.empty() && timers_.begin()->first <= now)
+            {
+                expired.push_back(std::move(timers_.begin()->second.func));
+                timers_.erase(timers_.begin());
+            }
+            size_ = timers_.size();
+        }
+        for (auto& func : expired) func();
+        return expired.size();
+    }
+
+  private:
+    struct Timer
+    {
+        Id id;
+        std::function<void()> func;
+    };
+
+    mutable std::mutex mutex_;
+    std::multimap<Clock::time_point, Timer> timers_;
+    Id last_id_{0};
+    std::atomic<std::size_t> size_{0};
+};
+} // namespace detail
+
 /// \brief Defines the common interface for polling for data on Goby transporters
 class PollerInterface
 {
@@ -161,14 +321,28 @@ class PollerInterface
 
     /// \brief access the condition variable used for poll synchronization
     ///
-    /// Notifications on this condition variable will cause the poll() loop to assume there is incoming data available (typically this is notified by the publishing thread in InterThreadTransporter, but can be used to synchronize the Goby poller infrastructure with other synchronous events, such as boost::asio, file descriptors, etc. For an example, see io::IOThread)
+    /// Notifications on this condition variable will cause the poll() loop to assume there is incoming data available (typically this is notified by the publishing thread in InterThreadTransporter, but can be used to synchronize the Goby poller infrastructure with other synchronous events, such as boost::asio, file descriptors, etc.). To be notified of incoming data without blocking a thread on this condition variable, use wake_hook() instead (for an example, see io::IOThread)
     /// \return pointer to the condition variable used for polling
     std::shared_ptr<std::condition_variable_any> cv() { return cv_; }
 
+    /// \brief access the hook that is called (in addition to notifying cv()) when data are published to this poller
+    std::shared_ptr<detail::PollerWakeHook> wake_hook() { return wake_hook_; }
+
+    /// \brief access the timers that are run by poll() when they expire (each counts as a poll event)
+    std::shared_ptr<detail::PollerTimers> timers() { return timers_; }
+
+    /// \brief Time spent handling data (i.e. running subscription callbacks) in the most recent call to poll() that returned poll events (excludes time spent waiting for data)
+    std::chrono::steady_clock::duration last_poll_callback_time() const
+    {
+        return last_poll_callback_time_;
+    }
+
   protected:
     PollerInterface(std::shared_ptr<std::timed_mutex> poll_mutex,
-                    std::shared_ptr<std::condition_variable_any> cv)
-        : poll_mutex_(poll_mutex), cv_(cv)
+                    std::shared_ptr<std::condition_variable_any> cv,
+                    std::shared_ptr<detail::PollerWakeHook> wake_hook,
+                    std::shared_ptr<detail::PollerTimers> timers)
+        : poll_mutex_(poll_mutex), cv_(cv), wake_hook_(wake_hook), timers_(timers)
     {
     }
 
@@ -182,9 +356,36 @@ class PollerInterface
     template <class Clock = std::chrono::system_clock, class Duration = typename Clock::duration>
     int _poll_all(const std::chrono::time_point<Clock, Duration>& timeout);
 
+    // wait on cv_ until a timer deadline (or until notified)
+    std::cv_status _wait_for_timer(std::unique_lock<std::timed_mutex>& lock,
+                                   detail::PollerTimers::Clock::time_point deadline)
+    {
+        if (time::DiscreteEventScheduler::enabled())
+            return time::DiscreteEventScheduler::wait_until(*cv_, lock, deadline);
+
+        // SteadyClock may be warped, so convert to a real time to wait on
+        auto real_deadline =
+            std::chrono::steady_clock::now() +
+            (deadline - detail::PollerTimers::Clock::now()) / time::SimulatorSettings::warp_factor;
+        return cv_->wait_until(lock, real_deadline);
+    }
+
+    // _transporter_poll(), recording last_poll_callback_time_ if any items were polled
+    int _timed_transporter_poll(std::unique_ptr<std::unique_lock<std::timed_mutex>>& lock)
+    {
+        auto start = std::chrono::steady_clock::now();
+        int poll_items = _transporter_poll(lock);
+        if (poll_items > 0)
+            last_poll_callback_time_ = std::chrono::steady_clock::now() - start;
+        return poll_items;
+    }
+
     std::shared_ptr<std::timed_mutex> poll_mutex_;
     // signaled when there's no data for this thread to read during _poll()
     std::shared_ptr<std::condition_variable_any> cv_;
+    std::shared_ptr<detail::PollerWakeHook> wake_hook_;
+    std::shared_ptr<detail::PollerTimers> timers_;
+    std::chrono::steady_clock::duration last_poll_callback_time_{0};
 };
 
 /// \brief Used to tag subscriptions based on their necessity (e.g. required for correct functioning, or optional)
@@ -313,6 +514,24 @@ class StaticTransporterInterface : public InnerTransporterInterface<Transporter,
         subscribe<group, Data, transporter_scheme<Data, Transporter>(), necessity>(f);
     }
 
+    /// \brief Subscribe to a specific group and data type, receiving all the data queued since the last poll in a single call
+    ///
+    /// Only available on transporters that queue data between polls (InterThreadTransporter and InterProcessForwarder/InterProcessPortal).
+    /// \tparam group group to subscribe to (reference to constexpr Group)
+    /// \tparam Data data type to subscribe to.
+    /// \tparam scheme Marshalling scheme id (typically MarshallingScheme::MarshallingSchemeEnum). Can usually be inferred from the Data type.
+    /// \param f Callback function or lambda that is called with the data received (in order of receipt) for each poll that returns data for this group
+    /// \param subscriber Optional metadata that controls the subscription or sets callbacks to monitor the subscription result. Typically unnecessary for interprocess and inner layers.
+    template <const Group& group, typename Data,
+              int scheme = transporter_scheme<Data, Transporter>()>
+    void subscribe_batch(std::function<void(const std::vector<std::shared_ptr<const Data>>&)> f,
+                         const Subscriber<Data>& subscriber = Subscriber<Data>())
+    {
+        static_cast<Transporter*>(this)->template check_validity<group>();
+        static_cast<Transporter*>(this)->template subscribe_batch_dynamic<Data, scheme>(
+            f, group, subscriber);
+    }
+
     /// \brief Unsubscribe to a specific group and data type
     ///
     /// \tparam group group to unsubscribe from (reference to constexpr Group)
@@ -365,17 +584,53 @@ int goby::middleware::PollerInterface::_poll_all(
         new std::unique_lock<std::timed_mutex>(*poll_mutex_));
     //    std::cout << std::this_thread::get_id() <<  " _poll_all locking: " << poll_mutex_.get() << std::endl;
 
-    int poll_items = _transporter_poll(lock);
+    int poll_items = _timed_transporter_poll(lock);
     while (poll_items == 0)
     {
         if (!lock)
             throw(goby::Exception(
                 "Poller lock was released by poll() but no poll items were returned"));
 
-        if (timeout == Clock::time_point::max())
+        // a timer is due before the timeout
+        if (!timers_->empty())
+        {
+            auto next_timer = timers_->next_deadline();
+            if (next_timer < time::DiscreteEventScheduler::to_steady_time(timeout))
+            {
+                if (next_timer <= detail::PollerTimers::Clock::now())
+                {
+                    // as with subscription callbacks, run the timers without the poll lock
+                    lock.reset();
+                    poll_items = timers_->run_expired();
+                    if (poll_items == 0)
+                    {
+                        // cancelled from another thread in the meantime
+                        lock.reset(new std::unique_lock<std::timed_mutex>(*poll_mutex_));
+                        poll_items = _timed_transporter_poll(lock);
+                    }
+                }
+                else if (_wait_for_timer(*lock, next_timer) == std::cv_status::no_timeout)
+                {
+                    poll_items = _timed_transporter_poll(lock);
+                }
+                continue;
+            }
+        }
+
+        if (time::DiscreteEventScheduler::enabled())
+        {
+            // simulated time only advances once every participating thread is waiting
+            if (time::DiscreteEventScheduler::wait_until(
+                    *cv_, *lock, time::DiscreteEventScheduler::to_steady_time(timeout)) ==
+                std::cv_status::no_timeout)
+                poll_items = _timed_transporter_poll(lock);
+            else
+                return poll_items;
+        }
+        else if (timeout == Clock::time_point::max())
         {
             cv_->wait(*lock); // wait_until doesn't work well with time_point::max()
-            poll_items = _transporter_poll(lock);
+            poll_items = _timed_transporter_poll(lock);
 
             // TODO: fix this message now that zeromq::InterProcessPortal can have
             // a condition_variable trigger for REQUEST_HOLD_STATE
@@ -387,7 +642,7 @@ int goby::middleware::PollerInterface::_poll_all(
         else
         {
             if (cv_->wait_until(*lock, timeout) == std::cv_status::no_timeout)
-                poll_items = _transporter_poll(lock);
+                poll_items = _timed_transporter_poll(lock);
             else
                 return poll_items;
         }
@@ -35,6 +35,7 @@
 #include "goby/middleware/group.h"
 
 #include "goby/middleware/marshalling/interface.h"
+#include "goby/middleware/transport/metrics.h"
 #include "goby/middleware/transport/null.h"
 #include "goby/middleware/transport/poller.h"
 #include "goby/middleware/transport/serialization_handlers.h"
@@ -156,6 +157,22 @@ class InterProcessTransporterBase
         static_cast<Derived*>(this)->template _subscribe<Data, scheme>(f, group, subscriber);
     }
 
+    /// \brief Subscribe to a specific run-time defined group and data type, receiving all the data received since the last poll in a single call. Where possible, prefer the static variant in StaticTransporterInterface::subscribe_batch()
+    ///
+    /// \tparam Data data type to subscribe to.
+    /// \tparam scheme Marshalling scheme id (typically MarshallingScheme::MarshallingSchemeEnum). Can usually be inferred from the Data type.
+    /// \param f Callback function or lambda that is called with the data received (in order of receipt) for each poll that returns data for this group
+    /// \param group group to subscribe to (typically a DynamicGroup)
+    /// \param subscriber Optional metadata that controls the subscription or sets callbacks to monitor the subscription result. Typically unnecessary for interprocess and inner layers.
+    template <typename Data, int scheme = scheme<Data>()>
+    void subscribe_batch_dynamic(
+        std::function<void(const std::vector<std::shared_ptr<const Data>>&)> f,
+        const Group& group, const Subscriber<Data>& subscriber = Subscriber<Data>())
+    {
+        check_validity_runtime(group);
+        static_cast<Derived*>(this)->template _subscribe_batch<Data, scheme>(f, group, subscriber);
+    }
+
     /// \brief Unsubscribe to a specific run-time defined group and data type. Where possible, prefer the static variant in StaticTransporterInterface::unsubscribe()
     ///
     /// \tparam Data data type to unsubscribe from.
@@ -327,6 +344,7 @@ class InterProcessForwarder
     void _publish(const Data& d, const Group& group, const Publisher<Data>& publisher)
     {
         // create and forward publication to edge
+        auto serialize_start = metrics::start_time();
         std::vector<char> bytes(SerializerParserHelper<Data, scheme>::serialize(d));
         std::string* sbytes = new std::string(bytes.begin(), bytes.end());
         auto msg = std::make_shared<goby::middleware::protobuf::SerializerTransporterMessage>();
@@ -337,6 +355,10 @@ class InterProcessForwarder
         key->set_group(std::string(group));
         msg->set_allocated_data(sbytes);
 
+        if (metrics::Registry::enabled())
+            metrics::publish_counters<protobuf::LAYER_INTERPROCESS, Data>(key->group(), key->type())
+                .record_publish(bytes.size(), serialize_start);
+
         *key->mutable_cfg() = publisher.cfg();
 
         this->inner().template publish<Base::to_portal_group_>(msg);
@@ -353,6 +375,11 @@ class InterProcessForwarder
         key->set_group(std::string(group));
         msg->set_data(std::string(bytes.begin(), bytes.end()));
 
+        if (metrics::Registry::enabled())
+            metrics::publish_counters<protobuf::LAYER_INTERPROCESS, std::vector<char>>(
+                key->group(), type_name)
+                .record_publish(bytes.size());
+
         this->inner().template publish<Base::to_portal_group_>(msg);
     }
 
@@ -360,8 +387,22 @@ class InterProcessForwarder
     void _subscribe(std::function<void(std::shared_ptr<const Data> d)> f, const Group& group,
                     const Subscriber<Data>& subscriber)
     {
-        this->inner().template subscribe_dynamic<Data, scheme>(f, group);
+        // the interthread layer applies any subscriber.cfg().queue() limits to the data forwarded from the portal
+        this->inner().template subscribe_dynamic<Data, scheme>(f, group, subscriber);
+        _forward_subscription<Data, scheme>(group);
+    }
 
+    template <typename Data, int scheme>
+    void _subscribe_batch(std::function<void(const std::vector<std::shared_ptr<const Data>>&)> f,
+                          const Group& group, const Subscriber<Data>& subscriber)
+    {
+        // data from the portal are published to our inner transporter one at a time, so they are batched by the interthread layer when we poll
+        this->inner().template subscribe_batch_dynamic<Data, scheme>(f, group, subscriber);
+        _forward_subscription<Data, scheme>(group);
+    }
+
+    template <typename Data, int scheme> void _forward_subscription(const Group& group)
+    {
         // forward subscription to edge
         auto inner_publication_lambda = [=](std::shared_ptr<const Data> d) {
             this->inner().template publish_dynamic<Data, scheme>(d, group);
@@ -27,9 +27,9 @@
 #include <functional> // for fun...
 #include <memory>     // for sha...
 #include <mutex>      // for mutex
-#include <thread>     // for get_id
 
 #include "goby/exception.h"                                      // for Exc...
+#include "goby/middleware/common.h"                               // for thi...
 #include "goby/middleware/group.h"                               // for Group
 #include "goby/middleware/marshalling/interface.h"               // for Mar...
 #include "goby/middleware/transport/detail/subscription_store.h" // for Sub...
@@ -67,8 +67,8 @@ class InterThreadTransporter
 
     virtual ~InterThreadTransporter()
     {
-        detail::SubscriptionStoreBase::unsubscribe_all(std::this_thread::get_id());
-        detail::SubscriptionStoreBase::remove(std::this_thread::get_id());
+        detail::SubscriptionStoreBase::unsubscribe_all(this_thread_id());
+        detail::SubscriptionStoreBase::remove(this_thread_id());
     }
 
     /// \brief Scheme for interthread is always MarshallingScheme::CXX_OBJECT as the data are not serialized, but rather passed around using shared pointers
@@ -147,15 +147,13 @@ class InterThreadTransporter
     /// \tparam scheme Marshalling scheme id (typically MarshallingScheme::MarshallingSchemeEnum). Can usually be inferred from the Data type.
     /// \param f Callback function or lambda that is called upon receipt of the subscribed data
     /// \param group group to subscribe to (typically a DynamicGroup)
+    /// \param subscriber Optional metadata; only cfg().queue() is used by this layer, to bound the data held for this thread between polls
     template <typename Data, int scheme = scheme<Data>()>
     void subscribe_dynamic(std::function<void(const Data&)> f, const Group& group,
-                           const Subscriber<Data>& /*subscriber*/ = Subscriber<Data>())
+                           const Subscriber<Data>& subscriber = Subscriber<Data>())
     {
-        check_validity_runtime(group);
-        detail::SubscriptionStore<Data>::subscribe([=](std::shared_ptr<const Data> pd) { f(*pd); },
-                                                   group, std::this_thread::get_id(), data_mutex_,
-                                                   Poller<InterThreadTransporter>::cv(),
-                                                   Poller<InterThreadTransporter>::poll_mutex());
+        subscribe_dynamic<Data, scheme>([=](std::shared_ptr<const Data> pd) { f(*pd); }, group,
+                                        subscriber);
     }
 
     /// \brief Subscribe to a specific run-time defined group and data type (shared pointer variant). Where possible, prefer the static variant in StaticTransporterInterface::subscribe()
@@ -164,14 +162,35 @@ class InterThreadTransporter
     /// \tparam scheme Marshalling scheme id (typically MarshallingScheme::MarshallingSchemeEnum). Can usually be inferred from the Data type.
     /// \param f Callback function or lambda that is called upon receipt of the subscribed data
     /// \param group group to subscribe to (typically a DynamicGroup)
+    /// \param subscriber Optional metadata; only cfg().queue() is used by this layer, to bound the data held for this thread between polls
     template <typename Data, int scheme = scheme<Data>()>
     void subscribe_dynamic(std::function<void(std::shared_ptr<const Data>)> f, const Group& group,
-                           const Subscriber<Data>& /*subscriber*/ = Subscriber<Data>())
+                           const Subscriber<Data>& subscriber = Subscriber<Data>())
     {
         check_validity_runtime(group);
         detail::SubscriptionStore<Data>::subscribe(
-            f, group, std::this_thread::get_id(), data_mutex_, Poller<InterThreadTransporter>::cv(),
-            Poller<InterThreadTransporter>::poll_mutex());
+            f, group, this_thread_id(), data_mutex_, Poller<InterThreadTransporter>::cv(),
+            Poller<InterThreadTransporter>::poll_mutex(),
+            Poller<InterThreadTransporter>::wake_hook(), subscriber.cfg().queue());
+    }
+
+    /// \brief Subscribe to a specific run-time defined group and data type, receiving all the data queued since the last poll in a single call. Where possible, prefer the static variant in StaticTransporterInterface::subscribe_batch()
+    ///
+    /// \tparam Data data type to subscribe to.
+    /// \tparam scheme Marshalling scheme id (typically MarshallingScheme::MarshallingSchemeEnum). Can usually be inferred from the Data type.
+    /// \param f Callback function or lambda that is called with the data received (in order of publication) for each poll that returns data for this group. The vector holds the same shared pointers as were published (no copies are made)
+    /// \param group group to subscribe to (typically a DynamicGroup)
+    /// \param subscriber Optional metadata; only cfg().queue() is used by this layer, to bound the data held for this thread between polls
+    template <typename Data, int scheme = scheme<Data>()>
+    void subscribe_batch_dynamic(
+        std::function<void(const std::vector<std::shared_ptr<const Data>>&)> f,
+        const Group& group, const Subscriber<Data>& subscriber = Subscriber<Data>())
+    {
+        check_validity_runtime(group);
+        detail::SubscriptionStore<Data>::subscribe_batch(
+            f, group, this_thread_id(), data_mutex_, Poller<InterThreadTransporter>::cv(),
+            Poller<InterThreadTransporter>::poll_mutex(),
+            Poller<InterThreadTransporter>::wake_hook(), subscriber.cfg().queue());
     }
 
     /// \brief Subscribe with no data (used to receive a signal from another thread)
@@ -191,20 +210,20 @@ class InterThreadTransporter
                              const Subscriber<Data>& /*subscriber*/ = Subscriber<Data>())
     {
         check_validity_runtime(group);
-        detail::SubscriptionStore<Data>::unsubscribe(group, std::this_thread::get_id());
+        detail::SubscriptionStore<Data>::unsubscribe(group, this_thread_id());
     }
 
     /// \brief Unsubscribe from all current subscriptions
     void unsubscribe_all()
     {
-        detail::SubscriptionStoreBase::unsubscribe_all(std::this_thread::get_id());
+        detail::SubscriptionStoreBase::unsubscribe_all(this_thread_id());
     }
 
   private:
     friend Poller<InterThreadTransporter>;
     int _poll(std::unique_ptr<std::unique_lock<std::timed_mutex>>& lock)
     {
-        return detail::SubscriptionStoreBase::poll_all(std::this_thread::get_id(), lock);
+        return detail::SubscriptionStoreBase::poll_all(this_thread_id(), lock);
     }
 
   private:
@@ -270,7 +270,12 @@ class InterVehicleTransporterBase
             throw(InvalidPublication(ss.str()));
         }
 
+        auto serialize_start = metrics::start_time();
         auto data = intervehicle::serialize_publication(d, group, publisher);
+        if (metrics::Registry::enabled())
+            metrics::publish_counters<protobuf::LAYER_INTERVEHICLE, Data>(std::string(group),
+                                                                          data->key().type())
+                .record_publish(data->data().size(), serialize_start);
 
         if (publisher.cfg().intervehicle().buffer().ack_required())
         {
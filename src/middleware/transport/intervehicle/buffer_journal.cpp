@@ -0,0 +1,323 @@
+// Copyright 2023:
+//   GobySoft, LLC (2013-)
+//   Community contributors (see AUTHORS file)
+// File authors:
+//   Toby Schneider <toby@gobysoft.org>
+//
+//
+// This file is part of the Goby Underwater Autonomy Project Libraries
+// ("The Goby Libraries").
+//
+// The Goby Libraries are free software: you can redistribute them and/or modify
+// them under the terms of the GNU Lesser General Public License as published by
+// the Free Software Foundation, either version 2.1 of the License, or
+// (at your option) any later version.
+//
+// The Goby Libraries are distributed in the hope that they will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU Lesser General Public License for more details.
+//
+// You should have received a copy of the GNU Lesser General Public License
+// along with Goby.  If not, see <http://www.gnu.org/licenses/>.
+
+
+#include <algorithm> // for max
+#include <cerrno>    // for errno
+#include <cstring>   // for memcpy, strerror
+
+#include <boost/crc.hpp> // for crc_32_type
+
+#include <fcntl.h>    // for open, O_RDWR
+#include <sys/mman.h> // for mmap, munmap, msync
+#include <sys/stat.h> // for fstat
+#include <unistd.h>   // for ftruncate, close, write, fsync
+
+#include "goby/exception.h"
+#include "goby/util/debug_logger.h"
+
+#include "buffer_journal.h"
+
+using goby::glog;
+
+namespace
+{
+// [size: 4][crc32: 4]
+constexpr std::size_t header_bytes{8};
+
+std::uint32_t crc32(const char* data, std::size_t size)
+{
+    boost::crc_32_type crc;
+    crc.process_bytes(data, size);
+    return crc.checksum();
+}
+
+void throw_errno(const std::string& what, const std::string& path)
+{
+    throw(goby::Exception(what + " " + path + ": " + std::strerror(errno)));
+}
+
+// make a rename within the directory containing path durable
+void sync_directory(const std::string& path)
+{
+    auto slash = path.find_last_of('/');
+    const std::string dir =
+        slash == std::string::npos ? "." : (slash == 0 ? "/" : path.substr(0, slash));
+
+    int fd = ::open(dir.c_str(), O_RDONLY | O_DIRECTORY);
+    if (fd < 0)
+        throw_errno("Failed to open directory", dir);
+    if (fsync(fd) != 0)
+    {
+        ::close(fd);
+        throw_errno("Failed to sync directory", dir);
+    }
+    ::close(fd);
+}
+} // namespace
+
+goby::middleware::intervehicle::BufferJournal::BufferJournal(const std::string& path,
+                                                             const Config& cfg)
+    : path_(path), cfg_(cfg)
+{
+    open_and_map(path_);
+
+    bool torn = false;
+    while (end_ + header_bytes <= mapped_size_)
+    {
+        std::uint32_t size, crc;
+        std::memcpy(&size, data_ + end_, sizeof(size));
+        std::memcpy(&crc, data_ + end_ + sizeof(size), sizeof(crc));
+
+        // zero size is the unwritten remainder of the file
+        if (size == 0)
+            break;
+
+        const char* payload = data_ + end_ + header_bytes;
+        protobuf::BufferJournalRecord record;
+        if (end_ + header_bytes + size > mapped_size_ || crc32(payload, size) != crc ||
+            !record.ParseFromArray(payload, size))
+        {
+            torn = true;
+            break;
+        }
+
+        switch (record.type())
+        {
+            case protobuf::BufferJournalRecord::PUSH:
+                live_[record.id()] = std::string(payload, size);
+                live_bytes_ += header_bytes + size;
+                break;
+
+            case protobuf::BufferJournalRecord::ERASE:
+            case protobuf::BufferJournalRecord::ACK:
+            {
+                auto it = live_.find(record.id());
+                if (it != live_.end())
+                {
+                    live_bytes_ -= header_bytes + it->second.size();
+                    live_.erase(it);
+                }
+                break;
+            }
+        }
+
+        next_id_ = std::max(next_id_, record.id() + 1);
+        end_ += header_bytes + size;
+    }
+
+    glog.is_debug1() && glog << "Opened buffer journal " << path_ << " with " << live_.size()
+                             << " queued values (" << end_ << " bytes)" << std::endl;
+
+    if (torn)
+        glog.is_warn() && glog << "Ignoring incomplete record at offset " << end_
+                               << " of buffer journal " << path_ << std::endl;
+
+    // start from a clean file (this also clears any incomplete record)
+    if (torn || end_ != live_bytes_)
+        compact();
+}
+
+goby::middleware::intervehicle::BufferJournal::~BufferJournal() { close(); }
+
+std::vector<goby::middleware::intervehicle::protobuf::BufferJournalRecord>
+goby::middleware::intervehicle::BufferJournal::replay() const
+{
+    std::vector<protobuf::BufferJournalRecord> records(live_.size());
+    auto record_it = records.begin();
+    for (const auto& id_record_pair : live_)
+        (record_it++)->ParseFromString(id_record_pair.second);
+    return records;
+}
+
+std::uint64_t
+goby::middleware::intervehicle::BufferJournal::push(protobuf::BufferJournalRecord record)
+{
+    auto id = next_id_++;
+    record.set_type(protobuf::BufferJournalRecord::PUSH);
+    record.set_id(id);
+
+    std::string bytes = record.SerializeAsString();
+    append(bytes);
+    live_bytes_ += header_bytes + bytes.size();
+    live_.insert(live_.end(), std::make_pair(id, std::move(bytes)));
+    return id;
+}
+
+void goby::middleware::intervehicle::BufferJournal::erase(
+    std::uint64_t id, protobuf::BufferJournalRecord::RecordType type)
+{
+    auto it = live_.find(id);
+    if (it == live_.end())
+        return;
+
+    protobuf::BufferJournalRecord record;
+    record.set_type(type);
+    record.set_id(id);
+    append(record.SerializeAsString());
+
+    live_bytes_ -= header_bytes + it->second.size();
+    live_.erase(it);
+}
+
+bool goby::middleware::intervehicle::BufferJournal::compact_if_needed()
+{
+    auto dead_bytes = end_ - live_bytes_;
+    if (dead_bytes < cfg_.compaction_min_bytes() || dead_bytes <= live_bytes_)
+        return false;
+
+    compact();
+    return true;
+}
+
+void goby::middleware::intervehicle::BufferJournal::append(const std::string& record)
+{
+    const std::size_t total = header_bytes + record.size();
+    // leave room for a zero size after this record to mark the end
+    if (end_ + total + sizeof(std::uint32_t) > mapped_size_)
+        grow(end_ + total + sizeof(std::uint32_t));
+
+    // write the size last so that a partial record is never taken as valid
+    std::uint32_t size = record.size(), crc = crc32(record.data(), record.size());
+    std::memcpy(data_ + end_ + header_bytes, record.data(), record.size());
+    std::memcpy(data_ + end_ + sizeof(size), &crc, sizeof(crc));
+    std::memcpy(data_ + end_, &size, sizeof(size));
+
+    if (cfg_.sync())
+    {
+        const std::size_t page_size = sysconf(_SC_PAGESIZE);
+        std::size_t page_start = end_ - end_ % page_size;
+        if (msync(data_ + page_start, end_ + total - page_start, MS_SYNC) != 0)
+            glog.is_warn() && glog << "Failed to sync buffer journal " << path_ << ": "
+                                   << std::strerror(errno) << std::endl;
+    }
+
+    end_ += total;
+}
+
+void goby::middleware::intervehicle::BufferJournal::open_and_map(const std::string& path)
+{
+    fd_ = ::open(path.c_str(), O_RDWR | O_CREAT, 0644);
+    if (fd_ < 0)
+        throw_errno("Failed to open buffer journal", path);
+
+    struct stat st;
+    if (fstat(fd_, &st) != 0)
+        throw_errno("Failed to stat buffer journal", path);
+
+    mapped_size_ = std::max<std::size_t>(st.st_size, cfg_.initial_size());
+    if (static_cast<std::size_t>(st.st_size) < mapped_size_ && ftruncate(fd_, mapped_size_) != 0)
+        throw_errno("Failed to size buffer journal", path);
+
+    void* data = mmap(nullptr, mapped_size_, PROT_READ | PROT_WRITE, MAP_SHARED, fd_, 0);
+    if (data == MAP_FAILED)
+        throw_errno("Failed to map buffer journal", path);
+    data_ = static_cast<char*>(data);
+}
+
+void goby::middleware::intervehicle::BufferJournal::grow(std::size_t min_size)
+{
+    std::size_t new_size = std::max<std::size_t>(mapped_size_, 1);
+    while (new_size < min_size) new_size *= 2;
+
+    munmap(data_, mapped_size_);
+    data_ = nullptr;
+    if (ftruncate(fd_, new_size) != 0)
+        throw_errno("Failed to grow buffer journal", path_);
+
+    void* data = mmap(nullptr, new_size, PROT_READ | PROT_WRITE, MAP_SHARED, fd_, 0);
+    if (data == MAP_FAILED)
+        throw_errno("Failed to map buffer journal", path_);
+    data_ = static_cast<char*>(data);
+    mapped_size_ = new_size;
+
+    glog.is_debug1() && glog << "Grew buffer journal " << path_ << " to " << mapped_size_
+                             << " bytes" << std::endl;
+}
+
+void goby::middleware::intervehicle::BufferJournal::close()
+{
+    if (data_)
+        munmap(data_, mapped_size_);
+    data_ = nullptr;
+    mapped_size_ = 0;
+
+    if (fd_ >= 0)
+        ::close(fd_);
+    fd_ = -1;
+}
+
+void goby::middleware::intervehicle::BufferJournal::compact()
+{
+    const std::string tmp_path = path_ + ".tmp";
+    int fd = ::open(tmp_path.c_str(), O_WRONLY | O_CREAT | O_TRUNC, 0644);
+    if (fd < 0)
+        throw_errno("Failed to open", tmp_path);
+
+    std::string contents;
+    contents.reserve(live_bytes_);
+    for (const auto& id_record_pair : live_)
+    {
+        const std::string& record = id_record_pair.second;
+        std::uint32_t size = record.size(), crc = crc32(record.data(), record.size());
+        contents.append(reinterpret_cast<const char*>(&size), sizeof(size));
+        contents.append(reinterpret_cast<const char*>(&crc), sizeof(crc));
+        contents.append(record);
+    }
+
+    for (std::size_t written = 0; written < contents.size();)
+    {
+        auto n = ::write(fd, contents.data() + written, contents.size() - written);
+        if (n < 0)
+        {
+            if (errno == EINTR)
+                continue;
+            ::close(fd);
+            throw_errno("Failed to write", tmp_path);
+        }
+        written += n;
+    }
+
+    // a new file is zero-filled past the records, which marks the end
+    std::size_t size = std::max<std::size_t>(cfg_.initial_size(), 2 * contents.size());
+    if (ftruncate(fd, size) != 0 || fsync(fd) != 0)
+    {
+        ::close(fd);
+        throw_errno("Failed to sync", tmp_path);
+    }
+    ::close(fd);
+
+    auto old_bytes = end_;
+    close();
+    if (rename(tmp_path.c_str(), path_.c_str()) != 0)
+        throw_errno("Failed to replace buffer journal with", tmp_path);
+    // otherwise after a crash the directory may still name the old file, losing every record
+    // appended to the new one
+    sync_directory(path_);
+    open_and_map(path_);
+    end_ = contents.size();
+
+    glog.is_debug1() && glog << "Compacted buffer journal " << path_ << " from " << old_bytes
+                             << " to " << end_ << " bytes (" << live_.size() << " values)"
+                             << std::endl;
+}
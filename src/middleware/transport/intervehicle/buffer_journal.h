@@ -0,0 +1,111 @@
+// Copyright 2023:
+//   GobySoft, LLC (2013-)
+//   Community contributors (see AUTHORS file)
+// File authors:
+//   Toby Schneider <toby@gobysoft.org>
+//
+//
+// This file is part of the Goby Underwater Autonomy Project Libraries
+// ("The Goby Libraries").
+//
+// The Goby Libraries are free software: you can redistribute them and/or modify
+// them under the terms of the GNU Lesser General Public License as published by
+// the Free Software Foundation, either version 2.1 of the License, or
+// (at your option) any later version.
+//
+// The Goby Libraries are distributed in the hope that they will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU Lesser General Public License for more details.
+//
+// You should have received a copy of the GNU Lesser General Public License
+// along with Goby.  If not, see <http://www.gnu.org/licenses/>.
+
+
+#ifndef GOBY_MIDDLEWARE_TRANSPORT_INTERVEHICLE_BUFFER_JOURNAL_H
+#define GOBY_MIDDLEWARE_TRANSPORT_INTERVEHICLE_BUFFER_JOURNAL_H
+
+#include <cstddef> // for size_t
+#include <cstdint> // for uint64_t
+#include <map>     // for map
+#include <string>  // for string
+#include <vector>  // for vector
+
+#include "goby/middleware/protobuf/intervehicle.pb.h"
+
+namespace goby
+{
+namespace middleware
+{
+namespace intervehicle
+{
+/// \brief Append-only, memory-mapped journal of the values in the ModemDriverThread transmit buffer so that they survive a crash or restart.
+///
+/// Each push, erase or ack is a single record ([size: 4][crc32: 4][BufferJournalRecord]) copied into the mapped file, so the cost of a write is bounded by the size of the message. A torn record at the end of the file (from a crash mid-write) fails its CRC and is ignored on replay. The file is rewritten with only the live values (and atomically renamed into place) when enough of it is dead.
+class BufferJournal
+{
+  public:
+    using Config = protobuf::PortalConfig::LinkConfig::BufferJournalConfig;
+
+    /// \brief Open the journal (creating it if necessary) and read back the values it holds
+    ///
+    /// \throw goby::Exception if the journal file cannot be opened or mapped
+    BufferJournal(const std::string& path, const Config& cfg);
+    ~BufferJournal();
+
+    /// \brief The values that were live when the journal was last written, in the order they were pushed
+    std::vector<protobuf::BufferJournalRecord> replay() const;
+
+    /// \brief Journal a new value
+    ///
+    /// \param record PUSH record (without id)
+    /// \return id to use with erase()
+    std::uint64_t push(protobuf::BufferJournalRecord record);
+
+    /// \brief Journal the removal of a value
+    ///
+    /// \param id Value returned by push()
+    /// \param type ERASE or ACK
+    void erase(std::uint64_t id, protobuf::BufferJournalRecord::RecordType type =
+                                     protobuf::BufferJournalRecord::ERASE);
+
+    /// \brief Rewrite the journal with only the live values if enough of it is dead
+    ///
+    /// \return true if the journal was compacted
+    bool compact_if_needed();
+
+    /// \brief Number of live values
+    std::size_t size() const { return live_.size(); }
+
+    /// \brief Bytes written to the journal file (live and dead records)
+    std::size_t bytes() const { return end_; }
+
+    const std::string& path() const { return path_; }
+
+  private:
+    void append(const std::string& record);
+    void open_and_map(const std::string& path);
+    void grow(std::size_t min_size);
+    void close();
+    void compact();
+
+  private:
+    const std::string path_;
+    const Config cfg_;
+
+    int fd_{-1};
+    char* data_{nullptr};
+    std::size_t mapped_size_{0};
+    // offset one past the last valid record
+    std::size_t end_{0};
+
+    std::uint64_t next_id_{0};
+    // id -> serialized PUSH record for each live value (in push order), used to compact
+    std::map<std::uint64_t, std::string> live_;
+    std::size_t live_bytes_{0};
+};
+} // namespace intervehicle
+} // namespace middleware
+} // namespace goby
+
+#endif
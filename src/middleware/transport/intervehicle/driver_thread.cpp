@@ -44,6 +44,7 @@
 #include "goby/acomms/modemdriver/iridium_shore_driver.h"   // for IridiumS...
 #include "goby/acomms/modemdriver/mm_driver.h"              // for MMDriver
 #include "goby/acomms/modemdriver/popoto_driver.h"          // for PopotoDr...
+#include "goby/acomms/modemdriver/sim_channel_driver.h"     // for SimChann...
 #include "goby/acomms/modemdriver/udp_driver.h"             // for UDPDriver
 #include "goby/acomms/modemdriver/udp_multicast_driver.h"   // for UDPMulti...
 #include "goby/acomms/protobuf/buffer.pb.h"                 // for DynamicB...
@@ -119,6 +120,28 @@ std::map<std::string, void*> load_plugins()
 std::map<std::string, void*>
     goby::middleware::intervehicle::ModemDriverThread::driver_plugins_(load_plugins());
 
+namespace
+{
+using QueueDepthHelper =
+    goby::middleware::SerializerParserHelper<goby::middleware::intervehicle::protobuf::QueueDepth,
+                                             goby::middleware::MarshallingScheme::DCCL>;
+
+using SlotAllocationHelper = goby::middleware::SerializerParserHelper<
+    goby::middleware::intervehicle::protobuf::SlotAllocation,
+    goby::middleware::MarshallingScheme::DCCL>;
+
+std::size_t queue_depth_bytes()
+{
+    goby::middleware::intervehicle::protobuf::QueueDepth queue_depth;
+    queue_depth.set_depth(0);
+    return QueueDepthHelper::serialize(queue_depth).size();
+}
+
+// from intervehicle.proto QueueDepth and SlotAllocation definitions
+constexpr unsigned max_queue_depth{255};
+constexpr int max_allocation_depths{30};
+} // namespace
+
 goby::middleware::intervehicle::ModemDriverThread::ModemDriverThread(
     const intervehicle::protobuf::PortalConfig::LinkConfig& config)
     : goby::middleware::Thread<intervehicle::protobuf::PortalConfig::LinkConfig,
@@ -130,7 +153,17 @@ goby::middleware::intervehicle::ModemDriverThread::ModemDriverThread(
                   goby::acomms::ModemDriverBase::driver_name(cfg().driver())),
       next_modem_report_time_(goby::time::SteadyClock::now()),
       modem_report_interval_(goby::time::convert_duration<goby::time::SteadyClock::duration>(
-          cfg().modem_report_interval_with_units()))
+          cfg().modem_report_interval_with_units())),
+      fragment_sender_(cfg().has_fragmentation()
+                           ? std::make_unique<FragmentSender>(
+                                 cfg().fragmentation().max_frame_bytes(), glog_group_)
+                           : nullptr),
+      reassembler_(goby::time::convert_duration<goby::time::SteadyClock::duration>(
+                       cfg().fragmentation().reassembly_timeout_with_units()),
+                   glog_group_),
+      queue_depth_dccl_id_(QueueDepthHelper::id()),
+      slot_allocation_dccl_id_(SlotAllocationHelper::id()),
+      queue_depth_bytes_(queue_depth_bytes())
 {
     goby::glog.add_group(glog_group_, util::Colors::blue);
     interthread_ = std::make_unique<InterThreadTransporter>();
@@ -214,6 +247,10 @@ goby::middleware::intervehicle::ModemDriverThread::ModemDriverThread(
                 driver_ = std::make_unique<goby::acomms::PopotoDriver>();
                 break;
 
+            case goby::acomms::protobuf::DRIVER_SIM_CHANNEL:
+                driver_ = std::make_unique<goby::acomms::SimChannelDriver>();
+                break;
+
             case goby::acomms::protobuf::DRIVER_NONE:
             case goby::acomms::protobuf::DRIVER_ABC_EXAMPLE_MODEM:
             case goby::acomms::protobuf::DRIVER_UFIELD_SIM_DRIVER:
@@ -287,12 +324,20 @@ goby::middleware::intervehicle::ModemDriverThread::ModemDriverThread(
     subscription_key_.set_type(intervehicle::protobuf::Subscription::descriptor()->full_name());
     subscription_key_.set_group_numeric(Group::broadcast_group);
 
+    if (cfg().has_buffer_journal())
+        _replay_journal();
+
     goby::glog.is_debug1() && goby::glog << group(glog_group_) << "Driver ready" << std::endl;
     interthread_->publish<groups::modem_driver_ready, bool>(true);
 }
 
 void goby::middleware::intervehicle::ModemDriverThread::loop()
 {
+    reassembler_.expire();
+
+    if (journal_)
+        journal_->compact_if_needed();
+
     auto expired = buffer_.expire();
 
     if (!expired.empty())
@@ -322,6 +367,21 @@ void goby::middleware::intervehicle::ModemDriverThread::_expire_value(
     const goby::acomms::DynamicBuffer<buffer_data_type>::Value& value,
     intervehicle::protobuf::ExpireData::ExpireReason reason)
 {
+    if (_is_fragment(value.data))
+    {
+        // expiring any fragment expires the entire original message
+        std::vector<goby::acomms::DynamicBuffer<buffer_data_type>::Value> outstanding;
+        auto original = fragment_sender_->expire(value, &outstanding);
+        if (!original)
+            return;
+
+        for (const auto& fragment : outstanding) buffer_.erase(fragment);
+        _expire_value(now, *original, reason);
+        return;
+    }
+
+    _journal_erase(value);
+
     protobuf::ExpireMessagePair expire_pair;
     protobuf::ExpireData& expire_data = *expire_pair.mutable_data();
     expire_data.mutable_header()->set_src(goby::acomms::BROADCAST_ID);
@@ -351,7 +411,7 @@ void goby::middleware::intervehicle::ModemDriverThread::_forward_subscription(
         if (!_dest_is_in_subnet(dest))
             continue;
 
-        auto buffer_id = _create_buffer_id(subscription_key_);
+        const auto& buffer_id = _create_buffer_id(subscription_key_);
         if (!subscription_subbuffers_.count(dest))
         {
             auto subscription_buffer_cfg = cfg().subscription_buffer();
@@ -406,17 +466,45 @@ void goby::middleware::intervehicle::ModemDriverThread::_data_request(
          frame_number < total_frames; ++frame_number)
     {
         std::string* frame = msg->add_frame();
+        std::vector<std::string> frame_messages;
+        // dccl_id -> (number of messages, total unpacked bytes), to track the packed frame size
+        std::map<unsigned, std::pair<std::size_t, std::size_t>> frame_ids;
+        std::size_t frame_size = 0;
 
-        while (frame->size() < msg->max_frame_bytes())
+        std::size_t max_frame_bytes = msg->max_frame_bytes();
+        if (_adaptive_mac() && frame_number == msg->frame_start())
+            max_frame_bytes -= std::min(max_frame_bytes, _mac_header_bytes(*msg));
+
+        while (frame_size < max_frame_bytes)
         {
             try
             {
                 auto buffer_value =
-                    buffer_.top(dest, msg->max_frame_bytes() - frame->size(),
+                    buffer_.top(dest, max_frame_bytes - frame_size,
                                 goby::time::convert_duration<std::chrono::microseconds>(
                                     cfg().ack_timeout_with_units()));
                 dest = buffer_value.modem_id;
-                *frame += buffer_value.data.data();
+                const std::string& bytes = buffer_value.data.data();
+                if (cfg().pack_frames())
+                {
+                    // pack once the frame is full, but track the size it will have so that the
+                    // space saved by shared DCCL ID prefixes is offered to further messages
+                    auto dccl_id =
+                        detail::DCCLSerializerParserHelperBase::id(bytes.begin(), bytes.end());
+                    auto& same_id = frame_ids[dccl_id];
+                    frame_size -= detail::DCCLSerializerParserHelperBase::packed_size(
+                        dccl_id, same_id.first, same_id.second);
+                    ++same_id.first;
+                    same_id.second += bytes.size();
+                    frame_size += detail::DCCLSerializerParserHelperBase::packed_size(
+                        dccl_id, same_id.first, same_id.second);
+                    frame_messages.push_back(bytes);
+                }
+                else
+                {
+                    *frame += bytes;
+                    frame_size = frame->size();
+                }
 
                 bool ack_required = buffer_.sub(buffer_value.modem_id, buffer_value.subbuffer_id)
                                         .cfg()
@@ -425,6 +513,10 @@ void goby::middleware::intervehicle::ModemDriverThread::_data_request(
                 if (!ack_required)
                 {
                     buffer_.erase(buffer_value);
+                    if (!_is_fragment(buffer_value.data))
+                        _journal_erase(buffer_value);
+                    else if (auto original = fragment_sender_->dispose(buffer_value))
+                        _journal_erase(*original);
                 }
                 else
                 {
@@ -437,28 +529,41 @@ void goby::middleware::intervehicle::ModemDriverThread::_data_request(
                 break;
             }
         }
+
+        if (!frame_messages.empty())
+            *frame = detail::DCCLSerializerParserHelperBase::pack(frame_messages);
     }
 
     if (!msg->has_ack_requested())
         msg->set_ack_requested(false);
 
+    if (_adaptive_mac())
+        _advertise_queue_depth(msg);
+
     // convert src,dest to values with in subnet for modems that can't address large ids
     // e.g. 0x34 -> 0x04 for subnet mask 0xFFF0
     msg->set_src(_id_within_subnet(msg->src()));
     msg->set_dest(_id_within_subnet(dest));
 }
 
-goby::middleware::intervehicle::ModemDriverThread::subbuffer_id_type
+const goby::middleware::intervehicle::ModemDriverThread::subbuffer_id_type&
 goby::middleware::intervehicle::ModemDriverThread::_create_buffer_id(unsigned dccl_id,
                                                                      unsigned group)
 {
-    return "/group:" + std::to_string(group) + "/id:" + std::to_string(dccl_id) + "/";
+    auto key = std::make_pair(dccl_id, group);
+    auto it = buffer_ids_.find(key);
+    if (it == buffer_ids_.end())
+        it = buffer_ids_
+                 .insert(std::make_pair(key, "/group:" + std::to_string(group) +
+                                                 "/id:" + std::to_string(dccl_id) + "/"))
+                 .first;
+    return it->second;
 }
 
 void goby::middleware::intervehicle::ModemDriverThread::_accept_subscription(
     const intervehicle::protobuf::Subscription& subscription)
 {
-    auto buffer_id = _create_buffer_id(subscription);
+    const auto& buffer_id = _create_buffer_id(subscription);
 
     glog.is_debug2() &&
         glog << group(glog_group_) << "Received new forwarded subscription/unsubscription: "
@@ -514,7 +619,11 @@ void goby::middleware::intervehicle::ModemDriverThread::_accept_subscription(
                 if (!subscriber_buffer_cfg_[dest].count(buffer_id))
                 {
                     subbuffers_created_[buffer_id].erase(dest);
+                    _journal_remove(dest, buffer_id);
                     buffer_.remove(dest, buffer_id);
+                    buffer_.remove(dest, _fragment_buffer_id(buffer_id));
+                    if (fragment_sender_)
+                        fragment_sender_->remove(dest, buffer_id);
                     glog.is_debug2() && glog << group(glog_group_)
                                              << "No more subscribers, removing buffer for "
                                              << buffer_id << std::endl;
@@ -623,7 +732,7 @@ void goby::middleware::intervehicle::ModemDriverThread::_buffer_message(
         interprocess_->publish<groups::metadata_request>(meta_request);
     }
 
-    auto buffer_id = _create_buffer_id(dccl_id, msg->key().group_numeric());
+    const auto& buffer_id = _create_buffer_id(dccl_id, msg->key().group_numeric());
 
     glog.is_debug3() && glog << group(glog_group_) << "Buffering message with id: " << buffer_id
                              << " from " << msg->ShortDebugString() << std::endl;
@@ -649,6 +758,18 @@ void goby::middleware::intervehicle::ModemDriverThread::_buffer_message(
         }
     }
 
+    if (_too_large(*msg))
+    {
+        glog.is_warn() && glog << group(glog_group_) << "Message of " << msg->data().size()
+                               << " bytes would require " << fragment_sender_->num_fragments(*msg)
+                               << " fragments, exceeding the maximum of "
+                               << FragmentSender::max_num_fragments << std::endl;
+        auto now = _next_push_time();
+        _expire_value(now, {cfg().driver().modem_id(), buffer_id, now, *msg},
+                      intervehicle::protobuf::ExpireData::EXPIRED_TOO_LARGE);
+        return;
+    }
+
     if (!subbuffers_created_[buffer_id].empty())
     {
         // push to all subscribed buffers
@@ -657,8 +778,11 @@ void goby::middleware::intervehicle::ModemDriverThread::_buffer_message(
             if (!_dest_is_in_subnet(dest_id))
                 continue;
 
+            goby::acomms::DynamicBuffer<buffer_data_type>::Value value{
+                dest_id, buffer_id, _next_push_time(), *msg};
             auto exceeded =
-                buffer_.push({dest_id, buffer_id, goby::time::SteadyClock::now(), *msg});
+                _needs_fragmentation(*msg) ? _push_fragments(value) : buffer_.push(value);
+            _journal_push(value);
             if (!exceeded.empty())
             {
                 auto now = goby::time::SteadyClock::now();
@@ -670,7 +794,7 @@ void goby::middleware::intervehicle::ModemDriverThread::_buffer_message(
     }
     else
     {
-        auto now = goby::time::SteadyClock::now();
+        auto now = _next_push_time();
         _expire_value(now, {cfg().driver().modem_id(), buffer_id, now, *msg},
                       intervehicle::protobuf::ExpireData::EXPIRED_NO_SUBSCRIBERS);
     }
@@ -719,16 +843,29 @@ void goby::middleware::intervehicle::ModemDriverThread::_receive(
                                         << " acks for frame: " << frame_number << std::endl;
                 for (const auto& value : values_to_ack_it->second)
                 {
+                    buffer_.erase(value);
+
+                    // only ack the original message once all of its fragments are acked
+                    std::unique_ptr<goby::acomms::DynamicBuffer<buffer_data_type>::Value> original;
+                    if (_is_fragment(value.data))
+                    {
+                        original = fragment_sender_->dispose(value);
+                        if (!original)
+                            continue;
+                    }
+                    const auto& acked_value = original ? *original : value;
+                    _journal_erase(acked_value, protobuf::BufferJournalRecord::ACK);
+
                     goby::glog.is_debug1() && goby::glog << group(glog_group_)
                                                          << "Publishing ack for "
-                                                         << value.subbuffer_id << std::endl;
+                                                         << acked_value.subbuffer_id << std::endl;
 
                     ack_data.set_latency_with_units(
-                        goby::time::convert_duration<goby::time::MicroTime>(now - value.push_time));
+                        goby::time::convert_duration<goby::time::MicroTime>(
+                            now - acked_value.push_time));
 
-                    *ack_pair.mutable_serializer() = value.data;
+                    *ack_pair.mutable_serializer() = acked_value.data;
                     interprocess_->publish<groups::modem_ack_in>(ack_pair);
-                    buffer_.erase(value);
                 }
                 pending_ack_.erase(values_to_ack_it);
                 // TODO publish acks for other drivers to erase the same piece of data (if they have it and the ack'ing party is the same vehicle - need a distinction between modem_id and vehicle_id ?)
@@ -737,6 +874,10 @@ void goby::middleware::intervehicle::ModemDriverThread::_receive(
     }
     else
     {
+        // overheard transmissions still count toward the adaptive MAC schedule
+        if (_adaptive_mac())
+            _handle_queue_depth(rx_msg, full_src);
+
         if (full_dest == _broadcast_id() || full_dest == cfg().driver().modem_id())
         {
             for (auto& frame : rx_msg.frame())
@@ -745,6 +886,14 @@ void goby::middleware::intervehicle::ModemDriverThread::_receive(
                 {
                     intervehicle::protobuf::DCCLForwardedData packets(
                         detail::DCCLSerializerParserHelperBase::unpack(frame));
+                    reassembler_.reassemble(&packets, full_src);
+                    if (packets.frame_size() > 0 &&
+                        (packets.frame(0).dccl_id() == static_cast<int>(queue_depth_dccl_id_) ||
+                         packets.frame(0).dccl_id() == static_cast<int>(slot_allocation_dccl_id_)))
+                        packets.mutable_frame()->erase(packets.mutable_frame()->begin());
+                    if (packets.frame_size() == 0)
+                        continue;
+
                     packets.mutable_header()->set_src(full_src);
                     packets.mutable_header()->add_dest(full_dest);
                     *packets.mutable_header()->mutable_modem_msg() = rx_msg;
@@ -775,3 +924,218 @@ void goby::middleware::intervehicle::ModemDriverThread::_publish_subscription_re
     *report.mutable_changed() = changed;
     interprocess_->publish<groups::subscription_report>(report);
 }
+
+std::vector<goby::acomms::DynamicBuffer<
+    goby::middleware::intervehicle::ModemDriverThread::buffer_data_type>::Value>
+goby::middleware::intervehicle::ModemDriverThread::_push_fragments(
+    const goby::acomms::DynamicBuffer<buffer_data_type>::Value& original)
+{
+    // fragments use their own subbuffer so that max_queue still refers to whole messages
+    auto fragment_buffer_id = _fragment_buffer_id(original.subbuffer_id);
+    auto fragment_buffer_cfg = buffer_.sub(original.modem_id, original.subbuffer_id).cfg();
+    fragment_buffer_cfg.set_max_queue(fragment_buffer_cfg.max_queue() *
+                                      FragmentSender::max_num_fragments);
+    buffer_.update(original.modem_id, fragment_buffer_id, fragment_buffer_cfg);
+
+    // pushing may expire (and so erase from fragment_sender_) earlier fragments of this message
+    auto fragments = fragment_sender_->fragment(original, fragment_buffer_id);
+    std::vector<goby::acomms::DynamicBuffer<buffer_data_type>::Value> exceeded;
+    for (const auto& fragment : fragments)
+    {
+        auto fragment_exceeded = buffer_.push(fragment);
+        exceeded.insert(exceeded.end(), fragment_exceeded.begin(), fragment_exceeded.end());
+    }
+    return exceeded;
+}
+
+std::size_t goby::middleware::intervehicle::ModemDriverThread::_mac_header_bytes(
+    const goby::acomms::protobuf::ModemTransmission& msg)
+{
+    if (!_allocation_slot(msg))
+        return queue_depth_bytes_;
+
+    intervehicle::protobuf::SlotAllocation allocation;
+    for (auto depth : mac_.allocation_depths()) allocation.add_depth(depth);
+    return SlotAllocationHelper::serialize(allocation).size();
+}
+
+void goby::middleware::intervehicle::ModemDriverThread::_advertise_queue_depth(
+    goby::acomms::protobuf::ModemTransmission* msg)
+{
+    // values awaiting an ack stay in buffer_ but don't need another slot unless the ack is lost
+    std::size_t pending = 0;
+    for (const auto& frame_values_pair : pending_ack_) pending += frame_values_pair.second.size();
+    auto buffered = buffer_.size();
+    unsigned depth = std::min<std::size_t>(buffered > pending ? buffered - pending : 0,
+                                           max_queue_depth);
+
+    if (_allocation_slot(*msg))
+    {
+        // the leader's own depth counts from the next cycle, like everyone else's
+        mac_.handle_queue_depth(cfg().modem_id(), depth);
+
+        // sent even if we have no data, as the other nodes can't use their slots without it
+        const auto& depths = mac_.allocation_depths();
+        if (static_cast<int>(depths.size()) > max_allocation_depths)
+        {
+            goby::glog.is_warn() && goby::glog << group(glog_group_) << "Cannot send allocation for "
+                                               << depths.size() << " nodes (max "
+                                               << max_allocation_depths << ")" << std::endl;
+            return;
+        }
+
+        intervehicle::protobuf::SlotAllocation allocation;
+        for (auto allocation_depth : depths) allocation.add_depth(allocation_depth);
+        auto bytes = SlotAllocationHelper::serialize(allocation);
+        if (msg->frame_size() == 0)
+            msg->add_frame();
+        msg->mutable_frame(0)->insert(0, std::string(bytes.begin(), bytes.end()));
+        return;
+    }
+
+    // a silent slot already tells the other nodes that we have nothing to send
+    if (msg->frame_size() == 0 || msg->frame(0).empty())
+        return;
+
+    intervehicle::protobuf::QueueDepth queue_depth;
+    queue_depth.set_depth(depth);
+    auto bytes = QueueDepthHelper::serialize(queue_depth);
+    msg->mutable_frame(0)->insert(0, std::string(bytes.begin(), bytes.end()));
+
+    // use the advertised value (not the live buffer size) so the leader's view matches ours
+    mac_.handle_queue_depth(cfg().modem_id(), depth);
+}
+
+void goby::middleware::intervehicle::ModemDriverThread::_handle_queue_depth(
+    const goby::acomms::protobuf::ModemTransmission& rx_msg, modem_id_type src)
+{
+    if (rx_msg.frame_size() == 0 || rx_msg.frame(0).empty())
+        return;
+
+    const std::string& frame = rx_msg.frame(0);
+    try
+    {
+        auto dccl_id = detail::DCCLSerializerParserHelperBase::id(frame.begin(), frame.end());
+        std::string::const_iterator actual_end;
+        if (dccl_id == queue_depth_dccl_id_)
+        {
+            auto queue_depth = QueueDepthHelper::parse(frame.begin(), frame.end(), actual_end);
+            mac_.handle_queue_depth(src, queue_depth->depth());
+        }
+        else if (dccl_id == slot_allocation_dccl_id_)
+        {
+            auto allocation = SlotAllocationHelper::parse(frame.begin(), frame.end(), actual_end);
+            mac_.handle_allocation(
+                src, std::vector<unsigned>(allocation->depth().begin(), allocation->depth().end()));
+        }
+    }
+    catch (const std::exception& e)
+    {
+        goby::glog.is_warn() && goby::glog << group(glog_group_)
+                                           << "Failed to parse queue depth or slot allocation: "
+                                           << e.what() << std::endl;
+    }
+}
+
+void goby::middleware::intervehicle::ModemDriverThread::_replay_journal()
+{
+    const auto& dir = cfg().buffer_journal().dir();
+    std::string path = dir;
+    if (!dir.empty() && dir.back() != '/')
+        path += "/";
+    path += "goby_intervehicle_buffer_" + cfg().buffer_journal().name() + "_" +
+            std::to_string(cfg().modem_id()) + ".journal";
+
+    journal_ = std::make_unique<BufferJournal>(path, cfg().buffer_journal());
+
+    auto steady_now = goby::time::SteadyClock::now();
+    auto system_now = goby::time::SystemClock::now<goby::time::MicroTime>();
+
+    for (const auto& record : journal_->replay())
+    {
+        buffer_.update(record.modem_id(), record.subbuffer_id(), record.buffer_cfg());
+        subbuffers_created_[record.subbuffer_id()].insert(record.modem_id());
+
+        // push times are journaled as system time since the steady clock restarts with us
+        goby::acomms::DynamicBuffer<buffer_data_type>::Value value{
+            record.modem_id(), record.subbuffer_id(),
+            _next_push_time(steady_now -
+                            goby::time::convert_duration<goby::time::SteadyClock::duration>(
+                                system_now - record.push_time_with_units())),
+            record.data()};
+
+        journal_ids_[value.push_time] = {value.modem_id, value.subbuffer_id, record.id()};
+
+        // fragmentation.max_frame_bytes may have been reduced since this was journaled
+        if (_too_large(value.data))
+        {
+            _expire_value(steady_now, value, intervehicle::protobuf::ExpireData::EXPIRED_TOO_LARGE);
+            continue;
+        }
+
+        auto exceeded = _needs_fragmentation(value.data) ? _push_fragments(value)
+                                                         : buffer_.push(value);
+
+        for (const auto& exceeded_value : exceeded)
+            _expire_value(steady_now, exceeded_value,
+                          intervehicle::protobuf::ExpireData::EXPIRED_BUFFER_OVERFLOW);
+    }
+
+    goby::glog.is_debug1() && goby::glog << group(glog_group_) << "Requeued " << journal_->size()
+                                         << " values from " << journal_->path() << std::endl;
+}
+
+void goby::middleware::intervehicle::ModemDriverThread::_journal_push(
+    const goby::acomms::DynamicBuffer<buffer_data_type>::Value& value)
+{
+    if (!journal_)
+        return;
+
+    protobuf::BufferJournalRecord record;
+    record.set_modem_id(value.modem_id);
+    record.set_subbuffer_id(value.subbuffer_id);
+    record.set_push_time_with_units(
+        goby::time::SystemClock::now<goby::time::MicroTime>() -
+        goby::time::convert_duration<goby::time::MicroTime>(goby::time::SteadyClock::now() -
+                                                            value.push_time));
+    *record.mutable_buffer_cfg() = buffer_.sub(value.modem_id, value.subbuffer_id).cfg();
+    *record.mutable_data() = value.data;
+
+    journal_ids_[value.push_time] = {value.modem_id, value.subbuffer_id, journal_->push(record)};
+}
+
+void goby::middleware::intervehicle::ModemDriverThread::_journal_erase(
+    const goby::acomms::DynamicBuffer<buffer_data_type>::Value& value,
+    protobuf::BufferJournalRecord::RecordType type)
+{
+    if (!journal_)
+        return;
+
+    auto it = journal_ids_.find(value.push_time);
+    if (it == journal_ids_.end() || it->second.modem_id != value.modem_id ||
+        it->second.subbuffer_id != value.subbuffer_id)
+        return;
+
+    journal_->erase(it->second.id, type);
+    journal_ids_.erase(it);
+}
+
+void goby::middleware::intervehicle::ModemDriverThread::_journal_remove(
+    modem_id_type dest_id, const subbuffer_id_type& buffer_id)
+{
+    if (!journal_)
+        return;
+
+    for (auto it = journal_ids_.begin(); it != journal_ids_.end();)
+    {
+        if (it->second.modem_id == dest_id && it->second.subbuffer_id == buffer_id)
+        {
+            journal_->erase(it->second.id);
+            it = journal_ids_.erase(it);
+        }
+        else
+        {
+            ++it;
+        }
+    }
+}
@@ -27,6 +27,7 @@
 #include <algorithm>
 #include <chrono>
 #include <cstddef>
+#include <limits>
 #include <map>
 #include <memory>
 #include <ostream>
@@ -48,6 +49,8 @@
 #include "goby/middleware/protobuf/serializer_transporter.pb.h"
 #include "goby/middleware/transport/interprocess.h"
 #include "goby/middleware/transport/interthread.h"
+#include "goby/middleware/transport/intervehicle/buffer_journal.h"
+#include "goby/middleware/transport/intervehicle/fragmentation.h"
 #include "goby/time/convert.h"
 #include "goby/time/steady_clock.h"
 #include "goby/time/system_clock.h"
@@ -151,16 +154,17 @@ class ModemDriverThread
                        const goby::acomms::DynamicBuffer<buffer_data_type>::Value& value,
                        intervehicle::protobuf::ExpireData::ExpireReason reason);
 
-    subbuffer_id_type _create_buffer_id(unsigned dccl_id, unsigned group);
+    const subbuffer_id_type& _create_buffer_id(unsigned dccl_id, unsigned group);
 
-    subbuffer_id_type
+    const subbuffer_id_type&
     _create_buffer_id(const goby::middleware::protobuf::SerializerTransporterKey& key)
     {
         return _create_buffer_id(detail::DCCLSerializerParserHelperBase::id(key.type()),
                                  key.group_numeric());
     }
 
-    subbuffer_id_type _create_buffer_id(const intervehicle::protobuf::Subscription& subscription)
+    const subbuffer_id_type&
+    _create_buffer_id(const intervehicle::protobuf::Subscription& subscription)
     {
         return _create_buffer_id(subscription.dccl_id(), subscription.group());
     }
@@ -190,6 +194,62 @@ class ModemDriverThread
 
     void _publish_subscription_report(const intervehicle::protobuf::Subscription& changed);
 
+    // fragmentation of messages too large for a single frame
+    bool _needs_fragmentation(const buffer_data_type& data)
+    {
+        return fragment_sender_ && fragment_sender_->needs_fragmentation(data);
+    }
+    // messages that would need more fragments than a Fragment can describe
+    bool _too_large(const buffer_data_type& data)
+    {
+        return _needs_fragmentation(data) && !fragment_sender_->can_fragment(data);
+    }
+    bool _is_fragment(const buffer_data_type& data)
+    {
+        return fragment_sender_ && fragment_sender_->is_fragment(data);
+    }
+
+    std::vector<goby::acomms::DynamicBuffer<buffer_data_type>::Value>
+    _push_fragments(const goby::acomms::DynamicBuffer<buffer_data_type>::Value& original);
+    subbuffer_id_type _fragment_buffer_id(const subbuffer_id_type& buffer_id)
+    {
+        return buffer_id + "fragment/";
+    }
+
+    // queue depth advertisements and slot allocations for MAC_ADAPTIVE_DECENTRALIZED
+    bool _adaptive_mac()
+    {
+        return cfg().mac().type() == goby::acomms::protobuf::MAC_ADAPTIVE_DECENTRALIZED;
+    }
+    // true if we are the cycle leader and msg is for the first slot, so must carry the allocation
+    bool _allocation_slot(const goby::acomms::protobuf::ModemTransmission& msg)
+    {
+        return _adaptive_mac() && msg.slot_index() == 0 &&
+               mac_.cycle_leader() == static_cast<int>(cfg().modem_id());
+    }
+    // bytes to reserve at the start of the first frame of msg
+    std::size_t _mac_header_bytes(const goby::acomms::protobuf::ModemTransmission& msg);
+    void _advertise_queue_depth(goby::acomms::protobuf::ModemTransmission* msg);
+
+    // persistence of buffer_ across restarts
+    void _replay_journal();
+    void _journal_push(const goby::acomms::DynamicBuffer<buffer_data_type>::Value& value);
+    void _journal_erase(const goby::acomms::DynamicBuffer<buffer_data_type>::Value& value,
+                        protobuf::BufferJournalRecord::RecordType type =
+                            protobuf::BufferJournalRecord::ERASE);
+    void _journal_remove(modem_id_type dest_id, const subbuffer_id_type& buffer_id);
+    // strictly increasing, so that the push time is a sequence number identifying each value
+    goby::time::SteadyClock::time_point
+    _next_push_time(goby::time::SteadyClock::time_point t = goby::time::SteadyClock::now())
+    {
+        if (t <= last_push_time_)
+            t = last_push_time_ + goby::time::SteadyClock::duration(1);
+        last_push_time_ = t;
+        return t;
+    }
+    void _handle_queue_depth(const goby::acomms::protobuf::ModemTransmission& rx_msg,
+                             modem_id_type src);
+
   private:
     std::unique_ptr<InterThreadTransporter> interthread_;
     std::unique_ptr<InterProcessForwarder<InterThreadTransporter>> interprocess_;
@@ -202,6 +262,9 @@ class ModemDriverThread
 
     std::map<subbuffer_id_type, std::set<modem_id_type>> subbuffers_created_;
 
+    // (dccl_id, group) -> subbuffer id, to avoid rebuilding the string for every message
+    std::map<std::pair<unsigned, unsigned>, subbuffer_id_type> buffer_ids_;
+
     goby::middleware::protobuf::SerializerTransporterKey subscription_key_;
     std::set<modem_id_type> subscription_subbuffers_;
 
@@ -220,6 +283,27 @@ class ModemDriverThread
 
     goby::time::SteadyClock::time_point next_modem_report_time_;
     const goby::time::SteadyClock::duration modem_report_interval_;
+
+    // null unless fragmentation is configured
+    std::unique_ptr<FragmentSender> fragment_sender_;
+    FragmentReassembler reassembler_;
+
+    const unsigned queue_depth_dccl_id_;
+    const unsigned slot_allocation_dccl_id_;
+    // bytes reserved at the start of the first frame for the QueueDepth message
+    const std::size_t queue_depth_bytes_;
+
+    goby::time::SteadyClock::time_point last_push_time_{goby::time::SteadyClock::time_point::min()};
+
+    std::unique_ptr<BufferJournal> journal_;
+    struct JournalEntry
+    {
+        modem_id_type modem_id;
+        subbuffer_id_type subbuffer_id;
+        std::uint64_t id;
+    };
+    // push time (see _next_push_time()) -> journal record of each journaled value
+    std::map<goby::time::SteadyClock::time_point, JournalEntry> journal_ids_;
 };
 
 } // namespace intervehicle
@@ -0,0 +1,363 @@
+// Copyright 2023:
+//   GobySoft, LLC (2013-)
+//   Community contributors (see AUTHORS file)
+// File authors:
+//   Toby Schneider <toby@gobysoft.org>
+//
+//
+// This file is part of the Goby Underwater Autonomy Project Libraries
+// ("The Goby Libraries").
+//
+// The Goby Libraries are free software: you can redistribute them and/or modify
+// them under the terms of the GNU Lesser General Public License as published by
+// the Free Software Foundation, either version 2.1 of the License, or
+// (at your option) any later version.
+//
+// The Goby Libraries are distributed in the hope that they will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU Lesser General Public License for more details.
+//
+// You should have received a copy of the GNU Lesser General Public License
+// along with Goby.  If not, see <http://www.gnu.org/licenses/>.
+
+#include <algorithm> // for min
+#include <exception> // for exception
+#include <random>    // for random_device
+
+#include "goby/exception.h"                             // for Exception
+#include "goby/middleware/marshalling/dccl.h"           // for SerializerParserHelper
+#include "goby/util/debug_logger/flex_ostreambuf.h"     // for DEBUG1
+#include "goby/util/debug_logger/logger_manipulators.h" // for operator<<
+
+#include "fragmentation.h"
+
+using goby::glog;
+
+namespace
+{
+using FragmentHelper =
+    goby::middleware::SerializerParserHelper<goby::middleware::intervehicle::protobuf::Fragment,
+                                             goby::middleware::MarshallingScheme::DCCL>;
+
+// from intervehicle.proto Fragment definition
+constexpr std::size_t max_fragment_data_bytes{1024};
+constexpr unsigned max_fragment_message_id{65535};
+} // namespace
+
+constexpr unsigned goby::middleware::intervehicle::FragmentSender::max_num_fragments;
+constexpr unsigned goby::middleware::intervehicle::FragmentSender::max_session;
+
+goby::middleware::intervehicle::FragmentSender::FragmentSender(std::size_t max_frame_bytes,
+                                                               std::string glog_group,
+                                                               unsigned session)
+    : glog_group_(std::move(glog_group)),
+      fragment_type_(FragmentHelper::type_name()),
+      max_frame_bytes_(max_frame_bytes),
+      data_per_fragment_(max_frame_bytes > overhead()
+                             ? std::min(max_fragment_data_bytes, max_frame_bytes - overhead())
+                             : 0),
+      session_(session)
+{
+    if (data_per_fragment_ == 0)
+        throw(goby::Exception("fragmentation.max_frame_bytes must be larger than " +
+                              std::to_string(overhead()) + " bytes"));
+    if (session_ > max_session)
+        throw(goby::Exception("Fragment session must be no larger than " +
+                              std::to_string(max_session)));
+}
+
+unsigned goby::middleware::intervehicle::FragmentSender::random_session()
+{
+    std::random_device rd;
+    return std::uniform_int_distribution<unsigned>(0, max_session)(rd);
+}
+
+std::size_t goby::middleware::intervehicle::FragmentSender::overhead()
+{
+    intervehicle::protobuf::Fragment empty_fragment;
+    empty_fragment.set_message_id(0);
+    empty_fragment.set_fragment_index(0);
+    empty_fragment.set_num_fragments(1);
+    empty_fragment.set_data("");
+    empty_fragment.set_session(0);
+    return FragmentHelper::serialize(empty_fragment).size();
+}
+
+std::vector<goby::middleware::intervehicle::FragmentSender::Value>
+goby::middleware::intervehicle::FragmentSender::fragment(const Value& original,
+                                                         const subbuffer_id_type& fragment_buffer_id)
+{
+    const std::string& bytes = original.data.data();
+    const unsigned n = num_fragments(original.data);
+    if (n > max_num_fragments)
+        throw(goby::Exception("Message of " + std::to_string(bytes.size()) +
+                              " bytes would require " + std::to_string(n) +
+                              " fragments, exceeding the maximum of " +
+                              std::to_string(max_num_fragments)));
+
+    while (outgoing_.count(next_message_id_))
+        next_message_id_ = (next_message_id_ + 1) % (max_fragment_message_id + 1);
+    const unsigned message_id = next_message_id_;
+    next_message_id_ = (next_message_id_ + 1) % (max_fragment_message_id + 1);
+
+    OutgoingMessage& outgoing = outgoing_[message_id];
+    outgoing.original = original;
+
+    std::vector<Value> fragments;
+    for (unsigned i = 0; i < n; ++i)
+    {
+        intervehicle::protobuf::Fragment fragment;
+        fragment.set_message_id(message_id);
+        fragment.set_fragment_index(i);
+        fragment.set_num_fragments(n);
+        fragment.set_data(bytes.substr(i * data_per_fragment_, data_per_fragment_));
+        fragment.set_session(session_);
+
+        std::vector<char> fragment_bytes(FragmentHelper::serialize(fragment));
+        buffer_data_type fragment_msg;
+        *fragment_msg.mutable_key() = original.data.key();
+        fragment_msg.mutable_key()->set_type(fragment_type_);
+        fragment_msg.mutable_key()->clear_metadata();
+        fragment_msg.set_data(std::string(fragment_bytes.begin(), fragment_bytes.end()));
+
+        fragments.push_back(
+            Value{original.modem_id, fragment_buffer_id, original.push_time, fragment_msg});
+        outgoing.outstanding.insert(std::make_pair(i, fragments.back()));
+    }
+
+    glog.is_debug1() && glog << group(glog_group_) << "Split message of " << bytes.size()
+                             << " bytes into " << n << " fragments (session: " << session_
+                             << ", message_id: " << message_id << ")" << std::endl;
+
+    return fragments;
+}
+
+std::unique_ptr<goby::middleware::intervehicle::FragmentSender::Value>
+goby::middleware::intervehicle::FragmentSender::dispose(const Value& fragment_value)
+{
+    std::string::const_iterator actual_end;
+    auto fragment = FragmentHelper::parse(fragment_value.data.data().begin(),
+                                          fragment_value.data.data().end(), actual_end);
+    if (fragment->session() != session_)
+        return nullptr;
+
+    auto it = outgoing_.find(fragment->message_id());
+    if (it == outgoing_.end())
+        return nullptr;
+
+    it->second.outstanding.erase(fragment->fragment_index());
+
+    glog.is_debug2() && glog << group(glog_group_) << "Fragment " << fragment->fragment_index()
+                             << "/" << fragment->num_fragments()
+                             << " sent (message_id: " << fragment->message_id() << "), "
+                             << it->second.outstanding.size() << " outstanding" << std::endl;
+
+    if (!it->second.outstanding.empty())
+        return nullptr;
+
+    auto original = std::make_unique<Value>(it->second.original);
+    outgoing_.erase(it);
+    return original;
+}
+
+std::unique_ptr<goby::middleware::intervehicle::FragmentSender::Value>
+goby::middleware::intervehicle::FragmentSender::expire(const Value& fragment,
+                                                       std::vector<Value>* outstanding)
+{
+    unsigned id;
+    if (!message_id(fragment, &id))
+        return nullptr;
+
+    auto it = outgoing_.find(id);
+    if (it == outgoing_.end())
+        return nullptr;
+
+    for (const auto& outstanding_p : it->second.outstanding)
+        outstanding->push_back(outstanding_p.second);
+
+    auto original = std::make_unique<Value>(it->second.original);
+    outgoing_.erase(it);
+    return original;
+}
+
+void goby::middleware::intervehicle::FragmentSender::remove(modem_id_type dest,
+                                                            const subbuffer_id_type& subbuffer_id)
+{
+    for (auto it = outgoing_.begin(); it != outgoing_.end();)
+    {
+        const auto& original = it->second.original;
+        if (original.modem_id == dest && original.subbuffer_id == subbuffer_id)
+            it = outgoing_.erase(it);
+        else
+            ++it;
+    }
+}
+
+bool goby::middleware::intervehicle::FragmentSender::message_id(const Value& fragment,
+                                                                unsigned* id) const
+{
+    std::string::const_iterator actual_end;
+    auto parsed =
+        FragmentHelper::parse(fragment.data.data().begin(), fragment.data.data().end(), actual_end);
+    if (parsed->session() != session_)
+        return false;
+    *id = parsed->message_id();
+    return true;
+}
+
+goby::middleware::intervehicle::FragmentReassembler::FragmentReassembler(
+    goby::time::SteadyClock::duration timeout, std::string glog_group)
+    : timeout_(timeout), glog_group_(std::move(glog_group)), fragment_dccl_id_(FragmentHelper::id())
+{
+}
+
+void goby::middleware::intervehicle::FragmentReassembler::reassemble(
+    intervehicle::protobuf::DCCLForwardedData* packets, modem_id_type src,
+    goby::time::SteadyClock::time_point now)
+{
+    google::protobuf::RepeatedPtrField<intervehicle::protobuf::DCCLPacket> frames;
+    frames.Swap(packets->mutable_frame());
+
+    for (auto& packet : frames)
+    {
+        if (packet.dccl_id() != fragment_dccl_id_)
+        {
+            packets->add_frame()->Swap(&packet);
+            continue;
+        }
+
+        // a corrupt fragment only loses itself, not the rest of the frame
+        std::shared_ptr<intervehicle::protobuf::Fragment> fragment;
+        try
+        {
+            std::string::const_iterator actual_end;
+            fragment =
+                FragmentHelper::parse(packet.data().begin(), packet.data().end(), actual_end);
+        }
+        catch (const std::exception& e)
+        {
+            glog.is_warn() && glog << group(glog_group_)
+                                   << "Failed to parse fragment: " << e.what() << std::endl;
+            continue;
+        }
+
+        auto session_it = sessions_.find(src);
+        if (session_it == sessions_.end())
+        {
+            sessions_.insert(std::make_pair(src, fragment->session()));
+        }
+        else if (session_it->second != fragment->session())
+        {
+            // the sender restarted, so its message_ids have started again
+            glog.is_debug1() && glog << group(glog_group_) << "New fragment session "
+                                     << fragment->session() << " from src: " << src
+                                     << " (was " << session_it->second << ")" << std::endl;
+            session_it->second = fragment->session();
+            for (auto it = incoming_.begin(); it != incoming_.end();)
+            {
+                if (std::get<0>(it->first) == src && std::get<1>(it->first) != fragment->session())
+                {
+                    if (!it->second.complete)
+                        glog.is_warn() &&
+                            glog << group(glog_group_)
+                                 << "Discarding incomplete message (src: " << src
+                                 << ", session: " << std::get<1>(it->first)
+                                 << ", message_id: " << std::get<2>(it->first) << ") with "
+                                 << it->second.fragments.size() << "/" << it->second.num_fragments
+                                 << " fragments received, as the sender has restarted"
+                                 << std::endl;
+                    it = incoming_.erase(it);
+                }
+                else
+                {
+                    ++it;
+                }
+            }
+        }
+
+        auto& incoming =
+            incoming_[std::make_tuple(src, fragment->session(), fragment->message_id())];
+
+        // duplicates of a completed message are ignored, and don't extend the time it is kept
+        if (incoming.complete)
+            continue;
+
+        incoming.last_received = now;
+
+        if (incoming.num_fragments != fragment->num_fragments())
+        {
+            incoming.num_fragments = fragment->num_fragments();
+            incoming.fragments.clear();
+        }
+
+        if (fragment->fragment_index() >= incoming.num_fragments)
+        {
+            glog.is_warn() && glog << group(glog_group_)
+                                   << "Invalid fragment: " << fragment->ShortDebugString()
+                                   << std::endl;
+            continue;
+        }
+
+        incoming.fragments.insert(
+            std::make_pair(fragment->fragment_index(), std::move(*fragment->mutable_data())));
+
+        if (incoming.fragments.size() < incoming.num_fragments)
+            continue;
+
+        std::string bytes;
+        for (const auto& fragment_p : incoming.fragments) bytes += fragment_p.second;
+        incoming.complete = true;
+        incoming.fragments.clear();
+
+        try
+        {
+            auto dccl_id = detail::DCCLSerializerParserHelperBase::id(bytes.begin(), bytes.end());
+            auto* reassembled = packets->add_frame();
+            reassembled->set_dccl_id(dccl_id);
+            reassembled->set_data(bytes);
+        }
+        catch (const std::exception& e)
+        {
+            glog.is_warn() && glog << group(glog_group_)
+                                   << "Failed to read DCCL id of reassembled message: " << e.what()
+                                   << std::endl;
+            continue;
+        }
+
+        glog.is_debug1() && glog << group(glog_group_) << "Reassembled " << bytes.size()
+                                 << " bytes from " << incoming.num_fragments
+                                 << " fragments (src: " << src << ", session: " << fragment->session()
+                                 << ", message_id: " << fragment->message_id() << ")" << std::endl;
+    }
+}
+
+std::size_t
+goby::middleware::intervehicle::FragmentReassembler::expire(goby::time::SteadyClock::time_point now)
+{
+    std::size_t discarded = 0;
+    for (auto it = incoming_.begin(); it != incoming_.end();)
+    {
+        if (it->second.last_received + timeout_ < now)
+        {
+            if (!it->second.complete)
+            {
+                ++discarded;
+                glog.is_warn() && glog << group(glog_group_)
+                                       << "Discarding incomplete message (src: "
+                                       << std::get<0>(it->first)
+                                       << ", session: " << std::get<1>(it->first)
+                                       << ", message_id: " << std::get<2>(it->first) << ") with "
+                                       << it->second.fragments.size() << "/"
+                                       << it->second.num_fragments << " fragments received"
+                                       << std::endl;
+            }
+            it = incoming_.erase(it);
+        }
+        else
+        {
+            ++it;
+        }
+    }
+    return discarded;
+}
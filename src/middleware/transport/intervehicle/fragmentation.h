@@ -0,0 +1,208 @@
+// Copyright 2023:
+//   GobySoft, LLC (2013-)
+//   Community contributors (see AUTHORS file)
+// File authors:
+//   Toby Schneider <toby@gobysoft.org>
+//
+//
+// This file is part of the Goby Underwater Autonomy Project Libraries
+// ("The Goby Libraries").
+//
+// The Goby Libraries are free software: you can redistribute them and/or modify
+// them under the terms of the GNU Lesser General Public License as published by
+// the Free Software Foundation, either version 2.1 of the License, or
+// (at your option) any later version.
+//
+// The Goby Libraries are distributed in the hope that they will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU Lesser General Public License for more details.
+//
+// You should have received a copy of the GNU Lesser General Public License
+// along with Goby.  If not, see <http://www.gnu.org/licenses/>.
+
+#ifndef GOBY_MIDDLEWARE_TRANSPORT_INTERVEHICLE_FRAGMENTATION_H
+#define GOBY_MIDDLEWARE_TRANSPORT_INTERVEHICLE_FRAGMENTATION_H
+
+#include <cstddef> // for size_t
+#include <map>     // for map
+#include <memory>  // for unique_ptr
+#include <string>  // for string
+#include <tuple>   // for tuple
+#include <utility> // for pair
+#include <vector>  // for vector
+
+#include "goby/acomms/buffer/dynamic_buffer.h"
+#include "goby/middleware/protobuf/intervehicle.pb.h"
+#include "goby/middleware/protobuf/serializer_transporter.pb.h"
+#include "goby/time/steady_clock.h"
+
+namespace goby
+{
+namespace middleware
+{
+namespace intervehicle
+{
+/// \brief Splits DCCL messages that are too large for a single modem frame into protobuf::Fragment messages, and tracks which fragments of each message are still outstanding.
+///
+/// Each fragment is buffered (and acked) on its own, so only the fragments that are lost need to be sent again (selective repeat). The original message is complete once all of its fragments are disposed of.
+///
+/// Every Fragment carries the sender's session, which is chosen at random on construction. Message ids start again from zero when the sender is restarted, and the session keeps the receiver from matching them with the messages it still holds from before the restart.
+class FragmentSender
+{
+  public:
+    using buffer_data_type = goby::middleware::protobuf::SerializerTransporterMessage;
+    using Value = goby::acomms::DynamicBuffer<buffer_data_type>::Value;
+    using modem_id_type = goby::acomms::DynamicBuffer<buffer_data_type>::modem_id_type;
+    using subbuffer_id_type = goby::acomms::DynamicBuffer<buffer_data_type>::subbuffer_id_type;
+
+    /// \brief Largest number of fragments a message can be split into (from intervehicle.proto Fragment definition)
+    static constexpr unsigned max_num_fragments{256};
+
+    /// \brief Largest session value (from intervehicle.proto Fragment definition)
+    static constexpr unsigned max_session{255};
+
+    /// \param max_frame_bytes Maximum encoded size of each Fragment
+    /// \param glog_group Group to use for debug output
+    /// \param session Session to send in each Fragment (0 to max_session)
+    /// \throw goby::Exception if max_frame_bytes is too small to hold any data, or session is out of range
+    FragmentSender(std::size_t max_frame_bytes, std::string glog_group,
+                   unsigned session = random_session());
+
+    /// \brief Returns a random session value
+    static unsigned random_session();
+
+    /// \brief Session sent in each Fragment
+    unsigned session() const { return session_; }
+
+    /// \brief Encoded size of a Fragment with no data
+    static std::size_t overhead();
+
+    /// \brief Returns true if the data are too large to be sent in a single frame
+    bool needs_fragmentation(const buffer_data_type& data) const
+    {
+        return data.data().size() > max_frame_bytes_;
+    }
+
+    /// \brief Returns the number of fragments the data would be split into
+    unsigned num_fragments(const buffer_data_type& data) const
+    {
+        return (data.data().size() + data_per_fragment_ - 1) / data_per_fragment_;
+    }
+
+    /// \brief Returns false if the data would need more than max_num_fragments
+    bool can_fragment(const buffer_data_type& data) const
+    {
+        return num_fragments(data) <= max_num_fragments;
+    }
+
+    /// \brief Returns true if the data are a Fragment created by this class
+    bool is_fragment(const buffer_data_type& data) const
+    {
+        return data.key().type() == fragment_type_;
+    }
+
+    /// \brief Split a message into fragments, which are tracked until disposed of or expired
+    ///
+    /// \param original Message to split (must satisfy can_fragment())
+    /// \param fragment_buffer_id Subbuffer that the fragments will be pushed to
+    /// \return the fragments, in order
+    /// \throw goby::Exception if the message requires more than max_num_fragments
+    std::vector<Value> fragment(const Value& original, const subbuffer_id_type& fragment_buffer_id);
+
+    /// \brief Mark a fragment as delivered (acked, or sent if no ack is required)
+    ///
+    /// \return the original message if this was its last outstanding fragment, otherwise nullptr
+    std::unique_ptr<Value> dispose(const Value& fragment);
+
+    /// \brief Abandon the message that a fragment belongs to (when any one of its fragments expires, the message can no longer be delivered)
+    ///
+    /// \param fragment The fragment that expired
+    /// \param outstanding Set to the message's fragments that have not been disposed of (including the expired one), which should be removed from the buffer
+    /// \return the original message, or nullptr if it is no longer being tracked
+    std::unique_ptr<Value> expire(const Value& fragment, std::vector<Value>* outstanding);
+
+    /// \brief Stop tracking all the messages for the given destination and (original) subbuffer
+    void remove(modem_id_type dest, const subbuffer_id_type& subbuffer_id);
+
+    /// \brief Number of messages with outstanding fragments
+    std::size_t size() const { return outgoing_.size(); }
+
+  private:
+    struct OutgoingMessage
+    {
+        Value original;
+        // fragment_index -> fragment still buffered
+        std::map<unsigned, Value> outstanding;
+    };
+
+    // returns the Fragment's message_id if it belongs to this session
+    bool message_id(const Value& fragment, unsigned* id) const;
+
+  private:
+    const std::string glog_group_;
+    const std::string fragment_type_;
+    const std::size_t max_frame_bytes_;
+    const std::size_t data_per_fragment_;
+    const unsigned session_;
+
+    // message_id -> message
+    std::map<unsigned, OutgoingMessage> outgoing_;
+    unsigned next_message_id_{0};
+};
+
+/// \brief Collects the protobuf::Fragment messages received from other nodes and reassembles the original DCCL messages.
+///
+/// Fragments may arrive in any order and more than once (e.g. resent after a lost ack). A message is kept for the reassembly timeout after it is completed so that late duplicate fragments are ignored rather than starting a new message. Duplicates do not extend this time.
+///
+/// Messages are identified by (src, session, message_id). A fragment with a new session from a src means that the sender has restarted, so the messages held from that src's previous session are discarded.
+class FragmentReassembler
+{
+  public:
+    using modem_id_type = FragmentSender::modem_id_type;
+
+    /// \param timeout Time without a new fragment after which a message is discarded
+    /// \param glog_group Group to use for debug output
+    FragmentReassembler(goby::time::SteadyClock::duration timeout, std::string glog_group);
+
+    /// \brief Replace the Fragment packets with the messages that they complete
+    ///
+    /// \param packets Packets received in a single frame: Fragment packets are removed, other packets are kept in order, and any reassembled messages are appended
+    /// \param src Modem id that sent the packets
+    /// \param now Time the packets were received
+    void reassemble(intervehicle::protobuf::DCCLForwardedData* packets, modem_id_type src,
+                    goby::time::SteadyClock::time_point now = goby::time::SteadyClock::now());
+
+    /// \brief Discard the messages that have not received a fragment within the timeout
+    ///
+    /// \return Number of incomplete messages discarded
+    std::size_t expire(goby::time::SteadyClock::time_point now = goby::time::SteadyClock::now());
+
+    /// \brief Number of messages being reassembled (or recently completed)
+    std::size_t size() const { return incoming_.size(); }
+
+  private:
+    struct IncomingMessage
+    {
+        goby::time::SteadyClock::time_point last_received;
+        unsigned num_fragments{0};
+        std::map<unsigned, std::string> fragments;
+        bool complete{false};
+    };
+
+  private:
+    const goby::time::SteadyClock::duration timeout_;
+    const std::string glog_group_;
+    const int fragment_dccl_id_;
+
+    // (src, session, message_id) -> message
+    std::map<std::tuple<modem_id_type, unsigned, unsigned>, IncomingMessage> incoming_;
+    // src -> most recent session
+    std::map<modem_id_type, unsigned> sessions_;
+};
+
+} // namespace intervehicle
+} // namespace middleware
+} // namespace goby
+
+#endif
@@ -0,0 +1,211 @@
+// Copyright 2023:
+//   GobySoft, LLC (2013-)
+//   Community contributors (see AUTHORS file)
+// File authors:
+//   Toby Schneider <toby@gobysoft.org>
+//
+//
+// This file is part of the Goby Underwater Autonomy Project Libraries
+// ("The Goby Libraries").
+//
+// The Goby Libraries are free software: you can redistribute them and/or modify
+// them under the terms of the GNU Lesser General Public License as published by
+// the Free Software Foundation, either version 2.1 of the License, or
+// (at your option) any later version.
+//
+// The Goby Libraries are distributed in the hope that they will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU Lesser General Public License for more details.
+//
+// You should have received a copy of the GNU Lesser General Public License
+// along with Goby.  If not, see <http://www.gnu.org/licenses/>.
+
+
+#include <mutex> // for lock_guard
+
+#include "goby/time/convert.h"
+#include "goby/time/system_clock.h"
+#include "goby/time/types.h"
+
+#include "metrics.h"
+
+std::atomic<bool> goby::middleware::metrics::Registry::enabled_{false};
+goby::middleware::protobuf::AppConfig::Metrics goby::middleware::metrics::Registry::cfg_;
+std::shared_timed_mutex goby::middleware::metrics::Registry::mutex_;
+std::map<std::tuple<int, std::string, std::string>,
+         std::unique_ptr<goby::middleware::metrics::Counters>>
+    goby::middleware::metrics::Registry::counters_;
+
+namespace
+{
+void atomic_max(std::atomic<std::uint64_t>& a, std::uint64_t value)
+{
+    auto current = a.load(std::memory_order_relaxed);
+    while (value > current &&
+           !a.compare_exchange_weak(current, value, std::memory_order_relaxed))
+    {
+    }
+}
+} // namespace
+
+void goby::middleware::metrics::DurationHistogram::add(Clock::duration d)
+{
+    auto us = std::chrono::duration_cast<std::chrono::microseconds>(d).count();
+    std::uint64_t value = us > 0 ? us : 0;
+
+    // bucket 0: < 1 us, bucket i: [2^(i-1), 2^i) us
+    int bucket = 0;
+    for (auto v = value; v > 0 && bucket < num_buckets - 1; v >>= 1) ++bucket;
+
+    buckets_[bucket].fetch_add(1, std::memory_order_relaxed);
+    count_.fetch_add(1, std::memory_order_relaxed);
+    sum_.fetch_add(value, std::memory_order_relaxed);
+    atomic_max(max_, value);
+}
+
+void goby::middleware::metrics::DurationHistogram::clear()
+{
+    for (auto& b : buckets_) b.store(0, std::memory_order_relaxed);
+    count_.store(0, std::memory_order_relaxed);
+    sum_.store(0, std::memory_order_relaxed);
+    max_.store(0, std::memory_order_relaxed);
+}
+
+void goby::middleware::metrics::DurationHistogram::to_proto(
+    protobuf::DurationHistogram* histogram) const
+{
+    histogram->set_count(count_.load(std::memory_order_relaxed));
+    histogram->set_sum(sum_.load(std::memory_order_relaxed));
+    histogram->set_max(max_.load(std::memory_order_relaxed));
+
+    int last_bucket = num_buckets - 1;
+    while (last_bucket >= 0 && buckets_[last_bucket].load(std::memory_order_relaxed) == 0)
+        --last_bucket;
+    for (int i = 0; i <= last_bucket; ++i)
+        histogram->add_bucket(buckets_[i].load(std::memory_order_relaxed));
+}
+
+void goby::middleware::metrics::Counters::record_publish(std::size_t bytes,
+                                                         Clock::time_point serialize_start)
+{
+    published.fetch_add(1, std::memory_order_relaxed);
+    published_bytes.fetch_add(bytes, std::memory_order_relaxed);
+    if (serialize_start != Clock::time_point())
+        serialize_time.add(Clock::now() - serialize_start);
+}
+
+void goby::middleware::metrics::Counters::record_receive(std::size_t bytes,
+                                                         Clock::time_point parse_start)
+{
+    received.fetch_add(1, std::memory_order_relaxed);
+    received_bytes.fetch_add(bytes, std::memory_order_relaxed);
+    if (parse_start != Clock::time_point())
+        parse_time.add(Clock::now() - parse_start);
+}
+
+void goby::middleware::metrics::Counters::record_inbox_depth(std::uint64_t depth)
+{
+    inbox_depth.store(depth, std::memory_order_relaxed);
+    atomic_max(max_inbox_depth, depth);
+}
+
+void goby::middleware::metrics::Counters::record_drop()
+{
+    dropped.fetch_add(1, std::memory_order_relaxed);
+}
+
+void goby::middleware::metrics::Counters::clear()
+{
+    for (auto* c :
+         {&published, &published_bytes, &received, &received_bytes, &inbox_depth, &max_inbox_depth,
+          &dropped})
+        c->store(0, std::memory_order_relaxed);
+    latency.clear();
+    serialize_time.clear();
+    parse_time.clear();
+}
+
+void goby::middleware::metrics::Counters::to_proto(protobuf::TransporterMetrics::Entry* entry) const
+{
+    entry->set_published(published.load(std::memory_order_relaxed));
+    entry->set_received(received.load(std::memory_order_relaxed));
+
+    if (auto b = published_bytes.load(std::memory_order_relaxed))
+        entry->set_published_bytes(b);
+    if (auto b = received_bytes.load(std::memory_order_relaxed))
+        entry->set_received_bytes(b);
+    if (latency.count())
+        latency.to_proto(entry->mutable_latency());
+    if (serialize_time.count())
+        serialize_time.to_proto(entry->mutable_serialize_time());
+    if (parse_time.count())
+        parse_time.to_proto(entry->mutable_parse_time());
+    if (auto d = max_inbox_depth.load(std::memory_order_relaxed))
+    {
+        entry->set_inbox_depth(inbox_depth.load(std::memory_order_relaxed));
+        entry->set_max_inbox_depth(d);
+    }
+    if (auto d = dropped.load(std::memory_order_relaxed))
+        entry->set_dropped(d);
+}
+
+void goby::middleware::metrics::Registry::configure(const protobuf::AppConfig::Metrics& cfg)
+{
+    std::lock_guard<std::shared_timed_mutex> lock(mutex_);
+    cfg_ = cfg;
+    enabled_ = cfg_.enable();
+}
+
+goby::middleware::protobuf::AppConfig::Metrics goby::middleware::metrics::Registry::cfg()
+{
+    std::shared_lock<std::shared_timed_mutex> lock(mutex_);
+    return cfg_;
+}
+
+goby::middleware::metrics::Counters&
+goby::middleware::metrics::Registry::counters(protobuf::Layer layer, const std::string& group,
+                                              const std::string& type)
+{
+    auto key = std::make_tuple(static_cast<int>(layer), group, type);
+    {
+        std::shared_lock<std::shared_timed_mutex> lock(mutex_);
+        auto it = counters_.find(key);
+        if (it != counters_.end())
+            return *it->second;
+    }
+
+    std::lock_guard<std::shared_timed_mutex> lock(mutex_);
+    auto& counters = counters_[key];
+    if (!counters)
+        counters.reset(new Counters);
+    return *counters;
+}
+
+goby::middleware::protobuf::TransporterMetrics goby::middleware::metrics::Registry::snapshot()
+{
+    protobuf::TransporterMetrics metrics;
+    metrics.set_time_with_units(goby::time::SystemClock::now<goby::time::MicroTime>());
+
+    std::shared_lock<std::shared_timed_mutex> lock(mutex_);
+    for (const auto& p : counters_)
+    {
+        const auto& counters = *p.second;
+        if (counters.published.load(std::memory_order_relaxed) == 0 &&
+            counters.received.load(std::memory_order_relaxed) == 0)
+            continue;
+
+        auto& entry = *metrics.add_entry();
+        entry.set_layer(static_cast<protobuf::Layer>(std::get<0>(p.first)));
+        entry.set_group(std::get<1>(p.first));
+        entry.set_type(std::get<2>(p.first));
+        counters.to_proto(&entry);
+    }
+    return metrics;
+}
+
+void goby::middleware::metrics::Registry::clear()
+{
+    std::shared_lock<std::shared_timed_mutex> lock(mutex_);
+    for (auto& p : counters_) p.second->clear();
+}
@@ -0,0 +1,177 @@
+// Copyright 2023:
+//   GobySoft, LLC (2013-)
+//   Community contributors (see AUTHORS file)
+// File authors:
+//   Toby Schneider <toby@gobysoft.org>
+//
+//
+// This file is part of the Goby Underwater Autonomy Project Libraries
+// ("The Goby Libraries").
+//
+// The Goby Libraries are free software: you can redistribute them and/or modify
+// them under the terms of the GNU Lesser General Public License as published by
+// the Free Software Foundation, either version 2.1 of the License, or
+// (at your option) any later version.
+//
+// The Goby Libraries are distributed in the hope that they will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU Lesser General Public License for more details.
+//
+// You should have received a copy of the GNU Lesser General Public License
+// along with Goby.  If not, see <http://www.gnu.org/licenses/>.
+
+
+#ifndef GOBY_MIDDLEWARE_TRANSPORT_METRICS_H
+#define GOBY_MIDDLEWARE_TRANSPORT_METRICS_H
+
+#include <array>         // for array
+#include <atomic>        // for atomic
+#include <chrono>        // for steady_clock
+#include <cstddef>       // for size_t
+#include <cstdint>       // for uint64_t
+#include <map>           // for map
+#include <memory>        // for unique_ptr
+#include <shared_mutex>  // for shared_timed_mutex
+#include <string>        // for string
+#include <tuple>         // for tuple
+#include <typeinfo>      // for typeid
+#include <unordered_map> // for unordered_map
+#include <utility>       // for pair
+#include <vector>        // for vector
+
+#include <boost/core/demangle.hpp>
+
+#include "goby/middleware/protobuf/app_config.pb.h"
+#include "goby/middleware/protobuf/layer.pb.h"
+#include "goby/middleware/protobuf/transporter_metrics.pb.h"
+
+namespace goby
+{
+namespace middleware
+{
+namespace metrics
+{
+using Clock = std::chrono::steady_clock;
+
+/// \brief Lock-free histogram of durations in power-of-two microsecond buckets
+class DurationHistogram
+{
+  public:
+    static constexpr int num_buckets{32};
+
+    DurationHistogram() { clear(); }
+
+    void add(Clock::duration d);
+    void clear();
+    void to_proto(protobuf::DurationHistogram* histogram) const;
+    std::uint64_t count() const { return count_.load(std::memory_order_relaxed); }
+
+  private:
+    std::array<std::atomic<std::uint64_t>, num_buckets> buckets_;
+    std::atomic<std::uint64_t> count_;
+    std::atomic<std::uint64_t> sum_;
+    std::atomic<std::uint64_t> max_;
+};
+
+/// \brief Counters for a single (layer, group, type). All members may be updated concurrently without locking.
+struct Counters
+{
+    Counters() { clear(); }
+
+    /// \brief Record a publication of a message
+    ///
+    /// \param bytes serialized size (zero if not serialized)
+    /// \param serialize_start time serialization started, or Clock::time_point() if not timed
+    void record_publish(std::size_t bytes, Clock::time_point serialize_start = Clock::time_point());
+
+    /// \brief Record a message passed to a subscription callback
+    ///
+    /// \param bytes serialized size (zero if not serialized)
+    /// \param parse_start time parsing started, or Clock::time_point() if not timed
+    void record_receive(std::size_t bytes, Clock::time_point parse_start = Clock::time_point());
+
+    void record_inbox_depth(std::uint64_t depth);
+
+    /// \brief Record a message discarded by a subscription's queue policy (TransporterConfig::Queue) before reaching the callback
+    void record_drop();
+
+    void clear();
+    void to_proto(protobuf::TransporterMetrics::Entry* entry) const;
+
+    std::atomic<std::uint64_t> published;
+    std::atomic<std::uint64_t> published_bytes;
+    std::atomic<std::uint64_t> received;
+    std::atomic<std::uint64_t> received_bytes;
+    std::atomic<std::uint64_t> inbox_depth;
+    std::atomic<std::uint64_t> max_inbox_depth;
+    std::atomic<std::uint64_t> dropped;
+
+    DurationHistogram latency;
+    DurationHistogram serialize_time;
+    DurationHistogram parse_time;
+};
+
+/// \brief Process-wide store of transporter Counters
+///
+/// Counters are created on first use and never destroyed, so callers may hold on to the returned reference (subscriptions do this so that the receive path does not need to look them up). When metrics are disabled (the default), instrumented code only pays for the enabled() check.
+class Registry
+{
+  public:
+    static bool enabled() { return enabled_.load(std::memory_order_relaxed); }
+    static void configure(const protobuf::AppConfig::Metrics& cfg);
+    static protobuf::AppConfig::Metrics cfg();
+
+    /// \brief Counters for the given layer, group and type (created if necessary)
+    static Counters& counters(protobuf::Layer layer, const std::string& group,
+                              const std::string& type);
+
+    /// \brief Copy all the counters that have seen any traffic
+    static protobuf::TransporterMetrics snapshot();
+
+    /// \brief Zero all the counters
+    static void clear();
+
+  private:
+    static std::atomic<bool> enabled_;
+    static protobuf::AppConfig::Metrics cfg_;
+    static std::shared_timed_mutex mutex_;
+    static std::map<std::tuple<int, std::string, std::string>, std::unique_ptr<Counters>>
+        counters_;
+};
+
+/// \brief Start time for a timed operation, or a default time_point (which is not recorded) if metrics are disabled
+inline Clock::time_point start_time()
+{
+    return Registry::enabled() ? Clock::now() : Clock::time_point();
+}
+
+/// \brief Type name used to identify unserialized (interthread) data
+template <typename Data> const std::string& type_name()
+{
+    static const std::string name(boost::core::demangle(typeid(Data).name()));
+    return name;
+}
+
+/// \brief Registry::counters() for the publish path, cached per thread and per Data (the publishing C++ type, or a tag type for pre-serialized data) so that the Registry lock is only taken the first time a (group, type) is published
+template <protobuf::Layer layer, typename Data>
+Counters& publish_counters(const std::string& group, const std::string& type)
+{
+    // nearly always one type per group, except for runtime-typed or pre-serialized data
+    thread_local std::unordered_map<std::string, std::vector<std::pair<std::string, Counters*>>>
+        cache;
+    auto& types = cache[group];
+    for (const auto& type_counters_pair : types)
+    {
+        if (type_counters_pair.first == type)
+            return *type_counters_pair.second;
+    }
+    types.emplace_back(type, &Registry::counters(layer, group, type));
+    return *types.back().second;
+}
+
+} // namespace metrics
+} // namespace middleware
+} // namespace goby
+
+#endif
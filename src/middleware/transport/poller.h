@@ -42,7 +42,10 @@ template <typename Transporter> class Poller : public PollerInterface
         : // we want the same mutex and cv all the way up
           PollerInterface(
               inner_poller ? inner_poller->poll_mutex() : std::make_shared<std::timed_mutex>(),
-              inner_poller ? inner_poller->cv() : std::make_shared<std::condition_variable_any>()),
+              inner_poller ? inner_poller->cv() : std::make_shared<std::condition_variable_any>(),
+              inner_poller ? inner_poller->wake_hook()
+                           : std::make_shared<detail::PollerWakeHook>(),
+              inner_poller ? inner_poller->timers() : std::make_shared<detail::PollerTimers>()),
           inner_poller_(inner_poller)
     {
     }
@@ -26,6 +26,8 @@
 #define GOBY_MIDDLEWARE_TRANSPORT_SERIALIZATION_HANDLERS_H
 
 #include <chrono>
+#include <deque>
+#include <iterator>
 #include <memory>
 #include <regex>
 #include <thread>
@@ -40,6 +42,7 @@
 #include "goby/middleware/protobuf/serializer_transporter.pb.h"
 
 #include "interface.h"
+#include "metrics.h"
 #include "null.h"
 
 namespace goby
@@ -112,11 +115,11 @@ class SerializationHandlerBase : public SerializationHandlerPostSelector<Metadat
     };
     virtual SubscriptionAction action() const = 0;
 
-    std::thread::id thread_id() const { return thread_id_; }
+    ThreadId thread_id() const { return thread_id_; }
     virtual std::string subscriber_id() const { return subscriber_id_; }
 
   private:
-    const std::thread::id thread_id_{std::this_thread::get_id()};
+    const ThreadId thread_id_{this_thread_id()};
     const std::string subscriber_id_{goby::middleware::thread_id(thread_id_)};
 };
 
@@ -144,7 +147,9 @@ class SerializationSubscription : public SerializationHandlerBase<>
         : handler_(handler),
           type_name_(SerializerParserHelper<Data, scheme_id>::type_name()),
           group_(group),
-          subscriber_(subscriber)
+          subscriber_(subscriber),
+          metrics_(metrics::Registry::counters(protobuf::LAYER_INTERPROCESS, std::string(group_),
+                                               type_name_))
     {
     }
 
@@ -179,12 +184,17 @@ class SerializationSubscription : public SerializationHandlerBase<>
     template <typename CharIterator>
     CharIterator _post(CharIterator bytes_begin, CharIterator bytes_end) const
     {
+        auto parse_start = metrics::start_time();
         CharIterator actual_end;
         auto msg = SerializerParserHelper<Data, scheme_id>::parse(bytes_begin, bytes_end,
                                                                   actual_end, type_name_);
 
         if (subscribed_group() == subscriber_.group(*msg) && handler_)
+        {
+            if (metrics::Registry::enabled())
+                metrics_.record_receive(actual_end - bytes_begin, parse_start);
             handler_(msg);
+        }
 
         return actual_end;
     }
@@ -194,6 +204,86 @@ class SerializationSubscription : public SerializationHandlerBase<>
     const std::string type_name_;
     const Group group_;
     Subscriber<Data> subscriber_;
+    metrics::Counters& metrics_;
+};
+
+/// \brief Interface to subscriptions that accumulate data between calls to flush()
+class SerializationBatchHandlerBase
+{
+  public:
+    SerializationBatchHandlerBase() = default;
+    virtual ~SerializationBatchHandlerBase() = default;
+
+    /// \brief Call the batch handler with all the data posted since the last flush (if any)
+    ///
+    /// \return number of data passed to the handler
+    virtual int flush() = 0;
+};
+
+/// \brief Represents a subscription to a serialized data type that passes the data to its handler in batches (interprocess layer).
+///
+/// Each call to post() parses the data and queues the result (subject to the subscriber's cfg().queue() limits); flush() then passes everything queued to the handler in a single call. The limits therefore apply to the data posted between two flushes, not to any backlog upstream of post().
+/// \tparam Data Subscribed data type
+/// \tparam scheme_id Marshalling scheme id (typically MarshallingScheme::MarshallingSchemeEnum).
+template <typename Data, int scheme_id>
+class SerializationBatchSubscription : public SerializationSubscription<Data, scheme_id>,
+                                       public SerializationBatchHandlerBase
+{
+  public:
+    typedef std::vector<std::shared_ptr<const Data>> BatchType;
+    typedef std::function<void(const BatchType& data)> BatchHandlerType;
+
+    SerializationBatchSubscription(BatchHandlerType handler,
+                                   const Group& group = Group(Group::broadcast_group),
+                                   const Subscriber<Data>& subscriber = Subscriber<Data>())
+        : SerializationBatchSubscription(handler, group, subscriber, std::make_shared<QueueType>())
+    {
+    }
+
+    int flush() override
+    {
+        if (pending_->empty())
+            return 0;
+
+        BatchType batch(std::make_move_iterator(pending_->begin()),
+                        std::make_move_iterator(pending_->end()));
+        pending_->clear();
+        batch_handler_(batch);
+        return batch.size();
+    }
+
+  private:
+    // a deque so that DROP_OLDEST doesn't shift the whole queue
+    typedef std::deque<std::shared_ptr<const Data>> QueueType;
+
+    SerializationBatchSubscription(BatchHandlerType handler, const Group& group,
+                                   const Subscriber<Data>& subscriber,
+                                   std::shared_ptr<QueueType> pending)
+        : SerializationSubscription<Data, scheme_id>(
+              [pending, queue_cfg = subscriber.cfg().queue(),
+               &counters = metrics::Registry::counters(
+                   protobuf::LAYER_INTERPROCESS, std::string(group),
+                   SerializerParserHelper<Data, scheme_id>::type_name())](
+                  std::shared_ptr<const Data> d) {
+                  if (queue_cfg.max_size() > 0 && pending->size() >= queue_cfg.max_size())
+                  {
+                      if (metrics::Registry::enabled())
+                          counters.record_drop();
+                      if (queue_cfg.overflow() == protobuf::TransporterConfig::Queue::DROP_NEWEST)
+                          return;
+                      pending->pop_front();
+                  }
+                  pending->push_back(std::move(d));
+              },
+              group, subscriber),
+          batch_handler_(handler),
+          pending_(pending)
+    {
+    }
+
+  private:
+    BatchHandlerType batch_handler_;
+    std::shared_ptr<QueueType> pending_;
 };
 
 /// \brief Represents a subscription to a serialized data type (intervehicle layer).
@@ -213,7 +303,9 @@ class IntervehicleSerializationSubscription
         : handler_(handler),
           type_name_(SerializerParserHelper<Data, scheme_id>::type_name()),
           group_(group),
-          subscriber_(subscriber)
+          subscriber_(subscriber),
+          metrics_(metrics::Registry::counters(protobuf::LAYER_INTERVEHICLE, std::string(group_),
+                                               type_name_))
     {
     }
 
@@ -256,6 +348,7 @@ class IntervehicleSerializationSubscription
     CharIterator _post(CharIterator bytes_begin, CharIterator bytes_end,
                        const intervehicle::protobuf::Header& header) const
     {
+        auto parse_start = metrics::start_time();
         CharIterator actual_end;
         auto msg = SerializerParserHelper<Data, scheme_id>::parse(bytes_begin, bytes_end,
                                                                   actual_end, type_name_);
@@ -263,7 +356,11 @@ class IntervehicleSerializationSubscription
         subscriber_.set_link_data(*msg, header);
 
         if (subscribed_group() == subscriber_.group(*msg) && handler_)
+        {
+            if (metrics::Registry::enabled())
+                metrics_.record_receive(actual_end - bytes_begin, parse_start);
             handler_(msg);
+        }
 
         return actual_end;
     }
@@ -273,6 +370,7 @@ class IntervehicleSerializationSubscription
     const std::string type_name_;
     const Group group_;
     Subscriber<Data> subscriber_;
+    metrics::Counters& metrics_;
 };
 
 /// \brief Represents a callback for a published data type (e.g. acked_func or expired_func)
@@ -427,7 +525,7 @@ class SerializationSubscriptionRegex
         }
     }
 
-    std::thread::id thread_id() const { return thread_id_; }
+    ThreadId thread_id() const { return thread_id_; }
     std::string subscriber_id() const { return subscriber_id_; }
 
   private:
@@ -435,7 +533,7 @@ class SerializationSubscriptionRegex
     const std::set<int> schemes_;
     std::regex type_regex_;
     std::regex group_regex_;
-    const std::thread::id thread_id_{std::this_thread::get_id()};
+    const ThreadId thread_id_{this_thread_id()};
     const std::string subscriber_id_{goby::middleware::thread_id(thread_id_)};
 };
 
@@ -443,11 +541,11 @@ class SerializationSubscriptionRegex
 class SerializationUnSubscribeAll
 {
   public:
-    std::thread::id thread_id() const { return thread_id_; }
+    ThreadId thread_id() const { return thread_id_; }
     std::string subscriber_id() const { return subscriber_id_; }
 
   private:
-    const std::thread::id thread_id_{std::this_thread::get_id()};
+    const ThreadId thread_id_{this_thread_id()};
     const std::string subscriber_id_{goby::middleware::thread_id(thread_id_)};
 };
 
@@ -518,7 +616,7 @@ class SerializationInterModuleSubscription : public SerializationHandlerBase<>
     HandlerType handler_;
     intermodule::protobuf::Subscription sub_cfg_;
     DynamicGroup group_;
-    const std::thread::id thread_id_;
+    const ThreadId thread_id_;
     const std::string subscriber_id_;
 };
 
@@ -0,0 +1,238 @@
+// Copyright 2023:
+//   GobySoft, LLC (2013-)
+//   Community contributors (see AUTHORS file)
+// File authors:
+//   Toby Schneider <toby@gobysoft.org>
+//
+//
+// This file is part of the Goby Underwater Autonomy Project Binaries
+// ("The Goby Binaries").
+//
+// The Goby Binaries are free software: you can redistribute them and/or modify
+// them under the terms of the GNU General Public License as published by
+// the Free Software Foundation, either version 2 of the License, or
+// (at your option) any later version.
+//
+// The Goby Binaries are distributed in the hope that they will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with Goby.  If not, see <http://www.gnu.org/licenses/>.
+
+// measures channel utilization of fixed vs. adaptive TDMA over a simulated channel, using the
+// discrete event clock so that the result doesn't depend on the host's scheduling
+
+#include <cassert>
+#include <chrono>
+#include <condition_variable>
+#include <iomanip>
+#include <iostream>
+#include <memory>
+#include <mutex>
+#include <vector>
+
+#include "goby/acomms/amac.h"
+#include "goby/acomms/bind.h"
+#include "goby/acomms/connect.h"
+#include "goby/acomms/modemdriver/sim_channel_driver.h"
+#include "goby/time/discrete_event.h"
+#include "goby/util/debug_logger.h"
+
+using goby::acomms::protobuf::MACConfig;
+using goby::acomms::protobuf::ModemTransmission;
+
+const std::string channel_name = "amac_adaptive1";
+const int num_cycles = 12;
+
+struct Node
+{
+    Node(int id, unsigned load_per_cycle, unsigned cycles_per_load)
+        : id(id),
+          load_per_cycle(load_per_cycle),
+          cycles_per_load(cycles_per_load),
+          mac(id),
+          driver(new goby::acomms::SimChannelDriver)
+    {
+    }
+
+    int id;
+    // offered load: load_per_cycle messages every cycles_per_load cycles
+    unsigned load_per_cycle;
+    unsigned cycles_per_load;
+
+    goby::acomms::MACManager mac;
+    std::unique_ptr<goby::acomms::SimChannelDriver> driver;
+
+    unsigned queue{0};
+    int cycles{0};
+    int slots{0};
+    int data_slots{0};
+};
+
+std::vector<std::unique_ptr<Node>> nodes;
+
+void handle_slot_start(Node* node, const ModemTransmission& slot)
+{
+    if (slot.slot_index() == 0)
+    {
+        if (node->cycles % node->cycles_per_load == 0)
+            node->queue += node->load_per_cycle;
+        ++node->cycles;
+    }
+    ++node->slots;
+}
+
+void handle_data_request(Node* node, ModemTransmission* msg)
+{
+    // the cycle leader must send the allocation in the first slot, even with nothing queued
+    bool send_allocation = msg->slot_index() == 0 && node->mac.cycle_leader() == node->id;
+    if (node->queue == 0 && !send_allocation)
+        return;
+
+    if (node->queue > 0)
+    {
+        --node->queue;
+        ++node->data_slots;
+    }
+
+    // piggyback our queue depth in the first byte, then the number of allocation depths and the
+    // depths themselves
+    std::string frame(msg->max_frame_bytes(), 0);
+    frame[0] = std::min(node->queue, 255u);
+    node->mac.handle_queue_depth(node->id, std::min(node->queue, 255u));
+    if (send_allocation)
+    {
+        const auto& depths = node->mac.allocation_depths();
+        frame[1] = depths.size();
+        for (std::size_t i = 0, n = depths.size(); i < n; ++i) frame[2 + i] = depths[i];
+    }
+    msg->add_frame(frame);
+}
+
+void handle_receive(Node* node, const ModemTransmission& msg)
+{
+    if (msg.type() != ModemTransmission::DATA || msg.frame_size() == 0 || msg.frame(0).empty())
+        return;
+
+    const std::string& frame = msg.frame(0);
+    node->mac.handle_queue_depth(msg.src(), static_cast<unsigned char>(frame[0]));
+
+    std::vector<unsigned> depths;
+    for (int i = 0, n = static_cast<unsigned char>(frame[1]); i < n; ++i)
+        depths.push_back(static_cast<unsigned char>(frame[2 + i]));
+    if (!depths.empty())
+        node->mac.handle_allocation(msg.src(), depths);
+}
+
+// advance the simulated time (we are the only participant, so this returns immediately)
+void step(std::chrono::microseconds dt)
+{
+    std::timed_mutex mutex;
+    std::condition_variable_any cv;
+    std::unique_lock<std::timed_mutex> lock(mutex);
+    goby::time::DiscreteEventScheduler::wait_until(cv, lock, goby::time::SteadyClock::now() + dt);
+}
+
+double run(goby::acomms::protobuf::MACType type)
+{
+    MACConfig mac_cfg;
+    mac_cfg.set_type(type);
+    // the busy node and the two light ones start with an equal share of the cycle. Node 1 owns the
+    // first slot, so is the cycle leader for MAC_ADAPTIVE_DECENTRALIZED
+    for (int i = 0; i < 6; ++i)
+    {
+        auto* slot = mac_cfg.add_slot();
+        slot->set_src(nodes[i % nodes.size()]->id);
+        slot->set_rate(0);
+        slot->set_type(ModemTransmission::DATA);
+        slot->set_ack_requested(false);
+        slot->set_slot_seconds(0.1);
+    }
+
+    auto stats_before = goby::acomms::SimChannelDriver::channel_statistics(channel_name);
+
+    for (auto& node : nodes)
+    {
+        node->queue = node->cycles = node->slots = node->data_slots = 0;
+        mac_cfg.set_modem_id(node->id);
+        node->mac.startup(mac_cfg);
+    }
+
+    while (nodes.front()->cycles <= num_cycles)
+    {
+        for (auto& node : nodes)
+        {
+            node->mac.do_work();
+            node->driver->do_work();
+        }
+        step(std::chrono::milliseconds(1));
+    }
+
+    for (auto& node : nodes) node->mac.shutdown();
+
+    int data_slots = 0;
+    for (auto& node : nodes) data_slots += node->data_slots;
+    double utilization = static_cast<double>(data_slots) / nodes.front()->slots;
+
+    auto stats = goby::acomms::SimChannelDriver::channel_statistics(channel_name);
+    std::cout << goby::acomms::protobuf::MACType_Name(type) << ": " << data_slots << "/"
+              << nodes.front()->slots << " slots used, utilization: " << std::fixed
+              << std::setprecision(2) << utilization << ", busy node backlog: "
+              << nodes.front()->queue << std::endl;
+
+    // all nodes must agree on the schedule (or stay silent)
+    assert(stats.frames_lost_collision == stats_before.frames_lost_collision);
+    assert(stats.frames_lost_half_duplex == stats_before.frames_lost_half_duplex);
+
+    return utilization;
+}
+
+int main(int /*argc*/, char* argv[])
+{
+    goby::glog.add_stream(goby::util::logger::DEBUG1, &std::cerr);
+    goby::glog.set_name(argv[0]);
+
+    goby::time::SimulatorSettings::using_sim_time = true;
+    goby::time::DiscreteEventScheduler::enable();
+    goby::time::DiscreteEventScheduler::Participant participant;
+
+    // node 1 offers more than its fixed share; nodes 2 and 3 are mostly idle
+    nodes.emplace_back(new Node(1, 5, 1));
+    nodes.emplace_back(new Node(2, 1, 4));
+    nodes.emplace_back(new Node(3, 1, 4));
+
+    for (auto& node : nodes)
+    {
+        goby::acomms::protobuf::DriverConfig driver_cfg;
+        driver_cfg.set_modem_id(node->id);
+        auto* sim_cfg = driver_cfg.MutableExtension(goby::acomms::sim_channel::protobuf::config);
+        sim_cfg->set_channel(channel_name);
+        sim_cfg->mutable_position()->set_x(10 * node->id);
+        auto* rate = sim_cfg->add_rate();
+        rate->set_rate(0);
+        rate->set_bits_per_second(20000);
+        rate->set_max_frame_bytes(32);
+
+        Node* n = node.get();
+        goby::acomms::bind(n->mac, *n->driver);
+        goby::acomms::connect(&n->mac.signal_slot_start,
+                              [n](const ModemTransmission& slot) { handle_slot_start(n, slot); });
+        goby::acomms::connect(&n->driver->signal_data_request,
+                              [n](ModemTransmission* msg) { handle_data_request(n, msg); });
+        goby::acomms::connect(&n->driver->signal_receive,
+                              [n](const ModemTransmission& msg) { handle_receive(n, msg); });
+        n->driver->startup(driver_cfg);
+    }
+
+    double fixed = run(goby::acomms::protobuf::MAC_FIXED_DECENTRALIZED);
+    double adaptive = run(goby::acomms::protobuf::MAC_ADAPTIVE_DECENTRALIZED);
+
+    // the busy node picks up the slots the idle nodes don't need
+    assert(adaptive > fixed + 0.15);
+
+    for (auto& node : nodes) node->driver->shutdown();
+
+    std::cout << "all tests passed" << std::endl;
+}
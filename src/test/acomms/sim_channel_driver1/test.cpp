@@ -0,0 +1,156 @@
+// Copyright 2023:
+//   GobySoft, LLC (2013-)
+//   Community contributors (see AUTHORS file)
+// File authors:
+//   Toby Schneider <toby@gobysoft.org>
+//
+//
+// This file is part of the Goby Underwater Autonomy Project Binaries
+// ("The Goby Binaries").
+//
+// The Goby Binaries are free software: you can redistribute them and/or modify
+// them under the terms of the GNU General Public License as published by
+// the Free Software Foundation, either version 2 of the License, or
+// (at your option) any later version.
+//
+// The Goby Binaries are distributed in the hope that they will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with Goby.  If not, see <http://www.gnu.org/licenses/>.
+
+// tests functionality of the SimChannelDriver
+
+#include "../driver_tester/driver_tester.h"
+#include "goby/acomms/acomms_constants.h" // for BROADCAST_ID
+#include "goby/acomms/modemdriver/driver_exception.h"
+#include "goby/acomms/modemdriver/sim_channel_driver.h"
+#include "goby/acomms/protobuf/modem_message.pb.h"
+#include "goby/acomms/protobuf/sim_channel_driver.pb.h"
+
+using goby::acomms::sim_channel::protobuf::config;
+
+std::shared_ptr<goby::acomms::ModemDriverBase> driver1, driver2;
+
+void configure(goby::acomms::protobuf::DriverConfig* cfg, int modem_id, double x)
+{
+    cfg->set_modem_id(modem_id);
+    auto* sim_cfg = cfg->MutableExtension(config);
+    sim_cfg->set_channel("sim_channel_driver1");
+    sim_cfg->mutable_position()->set_x(x);
+    sim_cfg->mutable_position()->set_z(10);
+
+    // rate 0 uses the defaults (one 32 byte frame at 80 bps)
+    auto* rate2 = sim_cfg->add_rate();
+    rate2->set_rate(2);
+    rate2->set_bits_per_second(5000);
+    rate2->set_max_frame_bytes(64);
+    rate2->set_max_frames(3);
+}
+
+// frames larger than max_frame_bytes are discarded rather than sent
+void test_oversized_frames()
+{
+    goby::acomms::protobuf::DriverConfig cfg;
+    configure(&cfg, 3, 0);
+    cfg.MutableExtension(config)->set_channel("sim_channel_driver1_oversized");
+
+    goby::acomms::SimChannelDriver driver;
+    driver.startup(cfg);
+
+    std::vector<std::string> frames;
+    driver.signal_data_request.connect([&](goby::acomms::protobuf::ModemTransmission* msg) {
+        for (const auto& frame : frames) msg->add_frame(frame);
+    });
+
+    goby::acomms::protobuf::ModemTransmission transmission;
+    transmission.set_src(3);
+    transmission.set_dest(goby::acomms::BROADCAST_ID);
+    transmission.set_type(goby::acomms::protobuf::ModemTransmission::DATA);
+
+    // rate 0: a single 32 byte frame, so nothing is left to send
+    frames = {std::string(33, 'a')};
+    transmission.set_rate(0);
+    driver.handle_initiate_transmission(transmission);
+    assert(goby::acomms::SimChannelDriver::channel_statistics("sim_channel_driver1_oversized")
+               .transmissions == 0);
+
+    // rate 2: the first of the three 64 byte frames is discarded, the second is still sent
+    frames = {std::string(65, 'a'), std::string(10, 'b')};
+    transmission.set_rate(2);
+    driver.handle_initiate_transmission(transmission);
+    assert(goby::acomms::SimChannelDriver::channel_statistics("sim_channel_driver1_oversized")
+               .transmissions == 1);
+
+    driver.shutdown();
+}
+
+// a rate without a positive bits_per_second is rejected at startup
+void test_invalid_rate()
+{
+    goby::acomms::protobuf::DriverConfig cfg;
+    configure(&cfg, 4, 0);
+    cfg.MutableExtension(config)->set_channel("sim_channel_driver1_invalid");
+    cfg.MutableExtension(config)->mutable_rate(0)->set_bits_per_second(0);
+
+    goby::acomms::SimChannelDriver driver;
+    bool threw = false;
+    try
+    {
+        driver.startup(cfg);
+    }
+    catch (const goby::acomms::ModemDriverException& e)
+    {
+        threw = true;
+        assert(e.status() == goby::acomms::protobuf::ModemDriverStatus::INVALID_CONFIGURATION);
+    }
+    assert(threw);
+}
+
+int main(int argc, char* argv[])
+{
+    goby::glog.add_stream(goby::util::logger::DEBUG3, &std::clog);
+    std::ofstream fout;
+
+    if (argc == 2)
+    {
+        fout.open(argv[1]);
+        goby::glog.add_stream(goby::util::logger::DEBUG3, &fout);
+    }
+
+    goby::glog.set_name(argv[0]);
+
+    driver1.reset(new goby::acomms::SimChannelDriver);
+    driver2.reset(new goby::acomms::SimChannelDriver);
+
+    goby::acomms::protobuf::DriverConfig cfg1, cfg2;
+    configure(&cfg1, 1, 0);
+    configure(&cfg2, 2, 1500);
+
+    std::vector<int> tests_to_run;
+    tests_to_run.push_back(4);
+    tests_to_run.push_back(5);
+
+    goby::test::acomms::DriverTester tester(driver1, driver2, cfg1, cfg2, tests_to_run,
+                                            goby::acomms::protobuf::DRIVER_SIM_CHANNEL);
+    int result = tester.run();
+
+    auto stats = goby::acomms::SimChannelDriver::channel_statistics("sim_channel_driver1");
+    std::cout << "transmissions: " << stats.transmissions
+              << ", frames sent: " << stats.frames_sent
+              << ", frames received: " << stats.frames_received << std::endl;
+
+    // two data transmissions (1 + 3 frames) and two acks, all received over a perfect channel
+    assert(stats.transmissions == 4);
+    assert(stats.frames_sent == 4);
+    assert(stats.frames_received == 4);
+    assert(stats.frames_lost_error == 0 && stats.frames_lost_collision == 0 &&
+           stats.frames_lost_half_duplex == 0);
+
+    test_oversized_frames();
+    test_invalid_rate();
+
+    return result;
+}
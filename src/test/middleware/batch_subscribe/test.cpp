@@ -0,0 +1,121 @@
+// Copyright 2023:
+//   GobySoft, LLC (2013-)
+//   Community contributors (see AUTHORS file)
+// File authors:
+//   Toby Schneider <toby@gobysoft.org>
+//
+//
+// This file is part of the Goby Underwater Autonomy Project Binaries
+// ("The Goby Binaries").
+//
+// The Goby Binaries are free software: you can redistribute them and/or modify
+// them under the terms of the GNU General Public License as published by
+// the Free Software Foundation, either version 2 of the License, or
+// (at your option) any later version.
+//
+// The Goby Binaries are distributed in the hope that they will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with Goby.  If not, see <http://www.gnu.org/licenses/>.
+
+#include <atomic>
+#include <cassert>
+#include <iostream>
+#include <thread>
+#include <vector>
+
+#include "goby/middleware/transport/interthread.h"
+
+// tests InterThreadTransporter::subscribe_batch
+
+using goby::glog;
+using namespace goby::util::logger;
+
+extern constexpr goby::middleware::Group ping{"Ping"};
+extern constexpr goby::middleware::Group single{"Single"};
+
+struct Ping
+{
+    int n;
+};
+
+const int max_publish = 100;
+
+std::atomic<bool> subscribed{false};
+std::atomic<bool> published{false};
+std::vector<std::shared_ptr<const Ping>> sent;
+
+void publisher()
+{
+    goby::middleware::InterThreadTransporter interthread;
+    while (!subscribed) std::this_thread::sleep_for(std::chrono::milliseconds(1));
+
+    for (int i = 0; i < max_publish; ++i)
+    {
+        auto p = std::make_shared<Ping>();
+        p->n = i;
+        sent.push_back(p);
+        interthread.publish<ping>(sent.back());
+        interthread.publish<single>(sent.back());
+    }
+    published = true;
+}
+
+int main(int /*argc*/, char* argv[])
+{
+    goby::glog.add_stream(goby::util::logger::DEBUG3, &std::cerr);
+    goby::glog.set_name(argv[0]);
+    goby::glog.set_lock_action(goby::util::logger_lock::lock);
+
+    goby::middleware::InterThreadTransporter interthread;
+
+    int batch_count = 0;
+    int batch_received = 0;
+    int single_received = 0;
+    std::vector<std::shared_ptr<const Ping>> received;
+
+    interthread.subscribe_batch<ping, Ping>(
+        [&](const std::vector<std::shared_ptr<const Ping>>& batch) {
+            assert(!batch.empty());
+            ++batch_count;
+            for (const auto& p : batch)
+            {
+                assert(p->n == batch_received);
+                ++batch_received;
+                received.push_back(p);
+            }
+        });
+
+    interthread.subscribe<single, Ping>([&](const Ping& p) {
+        assert(p.n == single_received);
+        ++single_received;
+    });
+
+    std::thread t(publisher);
+    subscribed = true;
+
+    // wait for all the data to be queued, so we should get everything in a single batch
+    while (!published) std::this_thread::sleep_for(std::chrono::milliseconds(1));
+    int items = interthread.poll(std::chrono::seconds(1));
+    t.join();
+
+    glog.is_verbose() && glog << "Polled " << items << " items in " << batch_count << " batch(es)"
+                              << std::endl;
+
+    assert(items == 2 * max_publish);
+    assert(batch_count == 1);
+    assert(batch_received == max_publish);
+    assert(single_received == max_publish);
+
+    // the batch contains the published pointers, not copies
+    for (int i = 0; i < max_publish; ++i) assert(received[i].get() == sent[i].get());
+
+    // nothing left over
+    assert(interthread.poll(std::chrono::milliseconds(10)) == 0);
+    assert(batch_count == 1);
+
+    std::cout << "all tests passed" << std::endl;
+}
@@ -0,0 +1,141 @@
+// Copyright 2023:
+//   GobySoft, LLC (2013-)
+//   Community contributors (see AUTHORS file)
+// File authors:
+//   Toby Schneider <toby@gobysoft.org>
+//
+//
+// This file is part of the Goby Underwater Autonomy Project Binaries
+// ("The Goby Binaries").
+//
+// The Goby Binaries are free software: you can redistribute them and/or modify
+// them under the terms of the GNU General Public License as published by
+// the Free Software Foundation, either version 2 of the License, or
+// (at your option) any later version.
+//
+// The Goby Binaries are distributed in the hope that they will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with Goby.  If not, see <http://www.gnu.org/licenses/>.
+
+#include <cassert>
+#include <cstdio>
+#include <fstream>
+#include <iostream>
+#include <map>
+#include <vector>
+
+#include "goby/middleware/transport/intervehicle/buffer_journal.h"
+#include "goby/util/debug_logger.h"
+
+using goby::middleware::intervehicle::BufferJournal;
+using goby::middleware::intervehicle::protobuf::BufferJournalRecord;
+
+const std::string path = "/tmp/goby_test_buffer_journal.journal";
+
+BufferJournal::Config config()
+{
+    BufferJournal::Config cfg;
+    cfg.set_dir("/tmp");
+    cfg.set_initial_size(4096);
+    cfg.set_compaction_min_bytes(1024);
+    return cfg;
+}
+
+BufferJournalRecord record(int i)
+{
+    BufferJournalRecord r;
+    r.set_modem_id(i % 3);
+    r.set_subbuffer_id("/group:1/id:" + std::to_string(i % 5) + "/");
+    r.set_push_time(1600000000000000ull + i);
+    r.mutable_data()->set_data(std::string(50, 'a' + i % 26));
+    r.mutable_data()->mutable_key()->set_marshalling_scheme(2);
+    r.mutable_data()->mutable_key()->set_type("test");
+    r.mutable_data()->mutable_key()->set_group("test_group");
+    return r;
+}
+
+void check_replay(const std::vector<int>& expected)
+{
+    BufferJournal journal(path, config());
+    auto replayed = journal.replay();
+    assert(replayed.size() == expected.size());
+    for (std::size_t i = 0; i < expected.size(); ++i)
+    {
+        auto expected_record = record(expected[i]);
+        assert(replayed[i].type() == BufferJournalRecord::PUSH);
+        assert(replayed[i].subbuffer_id() == expected_record.subbuffer_id());
+        assert(replayed[i].push_time() == expected_record.push_time());
+        assert(replayed[i].data().SerializeAsString() ==
+               expected_record.data().SerializeAsString());
+    }
+}
+
+int main(int /*argc*/, char* argv[])
+{
+    goby::glog.add_stream(goby::util::logger::DEBUG3, &std::cerr);
+    goby::glog.set_name(argv[0]);
+
+    std::remove(path.c_str());
+
+    std::vector<int> live;
+    {
+        BufferJournal journal(path, config());
+        assert(journal.size() == 0);
+
+        std::map<int, std::uint64_t> ids;
+        // enough to grow the file past its initial size
+        for (int i = 0; i < 200; ++i) ids[i] = journal.push(record(i));
+
+        // erase / ack all but every 10th
+        for (int i = 0; i < 200; ++i)
+        {
+            if (i % 10 == 0)
+                live.push_back(i);
+            else
+                journal.erase(ids[i],
+                              i % 2 ? BufferJournalRecord::ACK : BufferJournalRecord::ERASE);
+        }
+        assert(journal.size() == live.size());
+
+        auto bytes_before = journal.bytes();
+        assert(journal.compact_if_needed());
+        assert(journal.bytes() < bytes_before / 5);
+        assert(!journal.compact_if_needed());
+
+        // records after compaction go to the new file
+        ids[200] = journal.push(record(200));
+        live.push_back(200);
+        journal.erase(ids[0]);
+        live.erase(live.begin());
+    }
+    std::cout << "Replaying " << live.size() << " values" << std::endl;
+    check_replay(live);
+
+    // simulate a crash part way through writing a record
+    {
+        std::fstream f(path, std::ios::in | std::ios::out | std::ios::binary);
+        BufferJournal journal(path, config());
+        auto end = journal.bytes();
+        // size and CRC that don't match the (missing) payload
+        f.seekp(end);
+        std::uint32_t size = 100, crc = 12345;
+        f.write(reinterpret_cast<const char*>(&size), sizeof(size));
+        f.write(reinterpret_cast<const char*>(&crc), sizeof(crc));
+    }
+    check_replay(live);
+
+    // and the journal is still usable afterwards
+    {
+        BufferJournal journal(path, config());
+        journal.push(record(201));
+        live.push_back(201);
+    }
+    check_replay(live);
+
+    std::remove(path.c_str());
+    std::cout << "all tests passed" << std::endl;
+}
@@ -0,0 +1,187 @@
+// Copyright 2023:
+//   GobySoft, LLC (2013-)
+//   Community contributors (see AUTHORS file)
+// File authors:
+//   Toby Schneider <toby@gobysoft.org>
+//
+//
+// This file is part of the Goby Underwater Autonomy Project Binaries
+// ("The Goby Binaries").
+//
+// The Goby Binaries are free software: you can redistribute them and/or modify
+// them under the terms of the GNU General Public License as published by
+// the Free Software Foundation, either version 2 of the License, or
+// (at your option) any later version.
+//
+// The Goby Binaries are distributed in the hope that they will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with Goby.  If not, see <http://www.gnu.org/licenses/>.
+
+#include <atomic>
+#include <cassert>
+#include <cerrno>
+#include <chrono>
+#include <cstring>
+#include <iostream>
+
+#include <net/if.h>
+#include <sys/socket.h>
+#include <unistd.h>
+
+#include "goby/middleware/application/multi_thread.h"
+#include "goby/middleware/io/can.h"
+
+#include "goby/test/middleware/can_batch/test.pb.h"
+
+// tests CanThread with CanConfig::batch_size > 1 (frames published individually and as a CanFrameBatch) on a virtual CAN interface. Skipped if the interface does not exist, e.g. create it with:
+//   ip link add dev vcan0 type vcan && ip link set up vcan0
+
+using goby::glog;
+using goby::middleware::io::CanFrameBatch;
+using goby::middleware::io::PubSubLayer;
+using goby::middleware::protobuf::IOData;
+using goby::middleware::protobuf::IOStatus;
+using goby::test::middleware::protobuf::TestConfig;
+using namespace goby::util::logger;
+
+extern constexpr goby::middleware::Group can_in{"can::in"};
+extern constexpr goby::middleware::Group can_out{"can::out"};
+
+using CanThread =
+    goby::middleware::io::CanThread<can_in, can_out, PubSubLayer::INTERTHREAD,
+                                    PubSubLayer::INTERTHREAD>;
+
+const char* interface = "vcan0";
+const int num_frames = 1000;
+const unsigned batch_size = 16;
+const std::chrono::seconds timeout(30);
+
+// sends frames to the interface from a separate raw socket (CanThread does not receive its own frames)
+void send_frames()
+{
+    int s = socket(PF_CAN, SOCK_RAW, CAN_RAW);
+    assert(s >= 0);
+
+    sockaddr_can addr{};
+    addr.can_family = AF_CAN;
+    addr.can_ifindex = if_nametoindex(interface);
+    int result = bind(s, reinterpret_cast<sockaddr*>(&addr), sizeof(addr));
+    assert(result == 0);
+
+    for (int i = 0; i < num_frames; ++i)
+    {
+        can_frame frame{};
+        frame.can_id = i & CAN_SFF_MASK;
+        frame.can_dlc = sizeof(std::int32_t);
+        std::memcpy(frame.data, &i, sizeof(i));
+        while (write(s, &frame, sizeof(frame)) != sizeof(frame))
+        {
+            // transmit queue full
+            assert(errno == ENOBUFS);
+            usleep(1000);
+        }
+    }
+    close(s);
+}
+
+class TestApp : public goby::middleware::MultiThreadStandaloneApplication<TestConfig>
+{
+  public:
+    TestApp() : goby::middleware::MultiThreadStandaloneApplication<TestConfig>(10)
+    {
+        goby::middleware::protobuf::CanConfig can_cfg;
+        can_cfg.set_interface(interface);
+        can_cfg.set_batch_size(batch_size);
+
+        interthread().subscribe<can_in, IOStatus>([this](const IOStatus& status) {
+            if (status.state() == goby::middleware::protobuf::IO__LINK_OPEN && !sender_.joinable())
+                sender_ = std::thread(send_frames);
+        });
+
+        interthread().subscribe<can_in, can_frame>([this](const can_frame& frame) {
+            std::int32_t n;
+            std::memcpy(&n, frame.data, sizeof(n));
+            assert(n == individual_frames_);
+            ++individual_frames_;
+        });
+
+        interthread().subscribe<can_in, CanFrameBatch>(
+            [this](std::shared_ptr<const CanFrameBatch> batch) {
+                assert(!batch->frames.empty() && batch->frames.size() <= batch_size);
+                for (const auto& batch_frame : batch->frames)
+                {
+                    assert(!batch_frame.is_fd);
+                    std::int32_t n;
+                    std::memcpy(&n, batch_frame.frame.data, sizeof(n));
+                    assert(n == batch_frames_);
+                    ++batch_frames_;
+                }
+                ++batches_;
+            });
+
+        interthread().subscribe<can_in, IOData>([this](const IOData& io_msg) {
+            assert(io_msg.data().size() == CAN_MTU);
+            ++io_data_;
+        });
+
+        launch_thread<CanThread>(can_cfg);
+    }
+
+    void loop() override
+    {
+        assert(std::chrono::steady_clock::now() < start_time_ + timeout);
+
+        if (batch_frames_ == num_frames && individual_frames_ == num_frames &&
+            io_data_ == num_frames)
+        {
+            sender_.join();
+            join_thread<CanThread>();
+            quit();
+        }
+    }
+
+    void post_finalize() override
+    {
+        goby::middleware::MultiThreadStandaloneApplication<TestConfig>::post_finalize();
+        glog.is_verbose() && glog << "Received " << batch_frames_ << " frames in " << batches_
+                                  << " batches" << std::endl;
+        assert(individual_frames_ == num_frames);
+        std::cout << "all tests passed" << std::endl;
+    }
+
+  private:
+    std::thread sender_;
+    int individual_frames_{0};
+    int batch_frames_{0};
+    int batches_{0};
+    int io_data_{0};
+    std::chrono::steady_clock::time_point start_time_{std::chrono::steady_clock::now()};
+};
+
+class TestConfigurator : public goby::middleware::ConfiguratorInterface<TestConfig>
+{
+  public:
+    TestConfigurator(char* argv0)
+    {
+        auto& app_cfg = mutable_app_configuration();
+        app_cfg.set_name(argv0);
+    }
+
+  private:
+    std::string str() const override { return ""; }
+};
+
+int main(int argc, char* argv[])
+{
+    if (if_nametoindex(interface) == 0)
+    {
+        std::cout << interface << " is not available, skipping test" << std::endl;
+        return 0;
+    }
+
+    return goby::run<TestApp>(TestConfigurator(argv[0]));
+}
@@ -0,0 +1,334 @@
+// Copyright 2023:
+//   GobySoft, LLC (2013-)
+//   Community contributors (see AUTHORS file)
+// File authors:
+//   Toby Schneider <toby@gobysoft.org>
+//
+//
+// This file is part of the Goby Underwater Autonomy Project Binaries
+// ("The Goby Binaries").
+//
+// The Goby Binaries are free software: you can redistribute them and/or modify
+// them under the terms of the GNU General Public License as published by
+// the Free Software Foundation, either version 2 of the License, or
+// (at your option) any later version.
+//
+// The Goby Binaries are distributed in the hope that they will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with Goby.  If not, see <http://www.gnu.org/licenses/>.
+
+
+#include <cassert>
+#include <chrono>
+#include <cstring>
+#include <iostream>
+#include <istream>
+#include <random>
+#include <string>
+#include <vector>
+
+#include <boost/asio/buffers_iterator.hpp>
+#include <boost/asio/streambuf.hpp>
+
+#include "goby/middleware/io/cobs/common.h"
+#include "goby/middleware/io/detail/io_data_pool.h"
+#include "goby/util/thirdparty/cobs/cobs.h"
+
+// tests that the block COBS encoder and in-place decoder match the reference implementation (goby/util/thirdparty/cobs/cobs.h), and compares the framing cost against the previous (streambuf and copy) approach
+
+using goby::middleware::io::cobs_decode_in_place;
+using goby::middleware::io::cobs_encode_block;
+using goby::middleware::io::cobs_encoded_size_max;
+using goby::middleware::io::detail::COBSReadBuffer;
+using goby::middleware::io::detail::IODataPool;
+
+// random data of the given length, where each byte is zero with the given probability
+std::string random_data(std::mt19937& gen, std::size_t length, double zero_probability)
+{
+    std::bernoulli_distribution zero(zero_probability);
+    std::uniform_int_distribution<> byte(1, 255);
+    std::string data(length, '\0');
+    for (auto& c : data)
+        if (!zero(gen))
+            c = static_cast<char>(byte(gen));
+    return data;
+}
+
+// encoded with the reference implementation, including the delimiter
+std::string reference_encode(const std::string& data)
+{
+    std::string encoded(cobs_encoded_size_max(data.size()), '\0');
+    auto size = cobs_encode(reinterpret_cast<const std::uint8_t*>(data.data()), data.size(),
+                            reinterpret_cast<std::uint8_t*>(&encoded[0]));
+    encoded.resize(size);
+    encoded += '\0';
+    return encoded;
+}
+
+void test_equivalence()
+{
+    std::mt19937 gen(1);
+    std::vector<std::size_t> lengths{0, 1, 2, 253, 254, 255, 256, 508, 509, 510, 1000, 4000};
+    for (int i = 0; i < 200; ++i) lengths.push_back(std::uniform_int_distribution<>(0, 2000)(gen));
+
+    for (auto zero_probability : {0.0, 0.01, 0.1, 0.5, 1.0})
+    {
+        for (auto length : lengths)
+        {
+            auto data = random_data(gen, length, zero_probability);
+            auto expected = reference_encode(data);
+
+            std::string encoded;
+            assert(goby::middleware::io::cobs_encode_frame(data, encoded));
+            assert(encoded == expected);
+            assert(encoded.size() <= cobs_encoded_size_max(length));
+            assert(std::memchr(encoded.data(), 0, encoded.size() - 1) == nullptr);
+
+            // decode without the delimiter
+            std::string frame = encoded.substr(0, encoded.size() - 1);
+            assert(cobs_decode_in_place(frame));
+            assert(frame == data);
+        }
+    }
+
+    // invalid frames: code runs past the end, and zero within the frame
+    std::string past_end("\x05\x01\x02", 3);
+    assert(!cobs_decode_in_place(past_end));
+    std::string zero_code("\x02\x01\x00\x01", 4);
+    assert(!cobs_decode_in_place(zero_code));
+
+    std::cout << "Block encoder and in-place decoder match the reference implementation"
+              << std::endl;
+}
+
+// passes the stream to the reader in chunks of the given size (as returned by async_read_some)
+template <typename FrameHandler>
+bool read_stream(COBSReadBuffer& reader, IODataPool& pool, const std::string& stream,
+                 std::size_t chunk_size, FrameHandler handle_frame)
+{
+    auto make_io_data = [&pool]() { return pool.acquire(); };
+    for (std::size_t i = 0; i < stream.size(); i += chunk_size)
+    {
+        auto buffer = reader.read_buffer();
+        std::size_t n = std::min({chunk_size, stream.size() - i, buffer.size()});
+        std::memcpy(buffer.data(), stream.data() + i, n);
+        if (!reader.parse(n, make_io_data, handle_frame))
+            return false;
+        // a short read_buffer() means the rest of the chunk is passed next time
+        i -= chunk_size - n;
+    }
+    return true;
+}
+
+void test_reader()
+{
+    std::mt19937 gen(2);
+    std::vector<std::string> messages;
+    std::string stream;
+    std::size_t expected_bytes = 0;
+    for (int i = 0; i < 500; ++i)
+    {
+        auto data =
+            random_data(gen, std::uniform_int_distribution<>(0, 1500)(gen), (i % 3) * 0.05);
+        auto encoded = reference_encode(data);
+        stream += encoded;
+        // leading or extra delimiters are skipped
+        if (i % 7 == 0)
+            stream += '\0';
+        messages.push_back(data);
+        expected_bytes += encoded.size();
+    }
+
+    for (std::size_t chunk_size : {1, 7, 255, 4096, 100000})
+    {
+        COBSReadBuffer reader;
+        IODataPool pool;
+        std::size_t index = 0, bytes = 0;
+        bool ok = read_stream(
+            reader, pool, stream, chunk_size,
+            [&](std::size_t encoded_size,
+                std::shared_ptr<goby::middleware::protobuf::IOData> io_msg) {
+                bytes += encoded_size + 1;
+                assert(cobs_decode_in_place(*io_msg->mutable_data()));
+                assert(index < messages.size());
+                // an empty message is encoded as a single byte, so is not skipped
+                assert(io_msg->data() == messages[index]);
+                ++index;
+                return true;
+            });
+        assert(ok);
+        assert(index == messages.size());
+        assert(bytes == expected_bytes);
+        // messages are released by the handler, so the pool is reused
+        assert(pool.allocated() < 3);
+    }
+
+    // decoding stops at a bad frame
+    {
+        COBSReadBuffer reader;
+        IODataPool pool;
+        std::string bad_stream = reference_encode("abc") + std::string("\x09\x01\x00", 3) +
+                                 reference_encode("def");
+        int frames = 0;
+        bool ok = read_stream(reader, pool, bad_stream, bad_stream.size(),
+                              [&](std::size_t,
+                                  std::shared_ptr<goby::middleware::protobuf::IOData> io_msg) {
+                                  ++frames;
+                                  return cobs_decode_in_place(*io_msg->mutable_data());
+                              });
+        assert(!ok);
+        assert(frames == 2);
+    }
+
+    std::cout << "COBSReadBuffer splits frames identically for all read sizes" << std::endl;
+}
+
+// one second of traffic at 1 MB/s
+std::vector<std::string> make_traffic(std::size_t& total_bytes)
+{
+    std::mt19937 gen(3);
+    std::vector<std::string> messages;
+    total_bytes = 0;
+    while (total_bytes < 1000000)
+    {
+        messages.push_back(
+            random_data(gen, std::uniform_int_distribution<>(16, 1024)(gen), 0.05));
+        total_bytes += messages.back().size();
+    }
+    return messages;
+}
+
+void report(const std::string& name, std::chrono::steady_clock::duration elapsed, int repeats)
+{
+    double seconds = std::chrono::duration<double>(elapsed).count() / repeats;
+    std::cout << name << ": " << seconds * 1e3 << " ms per MB (" << seconds * 100
+              << "% of one core at 1 MB/s)" << std::endl;
+}
+
+void benchmark()
+{
+    std::size_t total_bytes;
+    auto messages = make_traffic(total_bytes);
+    const int repeats = 20;
+    const std::size_t chunk_size = 4096;
+    std::cout << "Benchmark: " << messages.size() << " messages, " << total_bytes << " bytes"
+              << std::endl;
+
+    // encoding: previously a new string per message, captured (copied) by the write handler
+    std::string stream;
+    {
+        std::size_t check = 0;
+        auto start = std::chrono::steady_clock::now();
+        for (int r = 0; r < repeats; ++r)
+        {
+            for (const auto& data : messages)
+            {
+                std::string cobs_encoded(data.size() + (data.size() / 254) + 1, '\0');
+                auto cobs_size =
+                    cobs_encode(reinterpret_cast<const std::uint8_t*>(data.data()), data.size(),
+                                reinterpret_cast<std::uint8_t*>(&cobs_encoded[0]));
+                cobs_encoded.resize(cobs_size);
+                cobs_encoded += '\0';
+                auto handler = [cobs_encoded]() { return cobs_encoded.size(); };
+                check += handler();
+            }
+        }
+        report("encode (previous)", std::chrono::steady_clock::now() - start, repeats);
+        assert(check > total_bytes * repeats);
+    }
+    {
+        IODataPool pool;
+        std::size_t check = 0;
+        auto start = std::chrono::steady_clock::now();
+        for (int r = 0; r < repeats; ++r)
+        {
+            for (const auto& data : messages)
+            {
+                auto encoded_msg = pool.acquire();
+                goby::middleware::io::cobs_encode_frame(data, *encoded_msg->mutable_data());
+                auto handler = [encoded_msg]() { return encoded_msg->data().size(); };
+                check += handler();
+                if (r == 0)
+                    stream += encoded_msg->data();
+            }
+        }
+        report("encode (pooled, block)", std::chrono::steady_clock::now() - start, repeats);
+        assert(check > total_bytes * repeats);
+    }
+
+    // decoding: previously read_until into a streambuf, copied through an istream into a
+    // string, then decoded into the message
+    {
+        std::size_t decoded = 0;
+        auto start = std::chrono::steady_clock::now();
+        for (int r = 0; r < repeats; ++r)
+        {
+            boost::asio::streambuf buffer;
+            for (std::size_t i = 0; i < stream.size(); i += chunk_size)
+            {
+                std::size_t n = std::min(chunk_size, stream.size() - i);
+                auto prepared = buffer.prepare(n);
+                std::memcpy(prepared.data(), stream.data() + i, n);
+                buffer.commit(n);
+
+                while (true)
+                {
+                    auto data = buffer.data();
+                    auto begin = boost::asio::buffers_begin(data);
+                    auto end = boost::asio::buffers_end(data);
+                    auto it = std::find(begin, end, '\0');
+                    if (it == end)
+                        break;
+                    std::size_t bytes_transferred = it - begin + 1;
+
+                    std::string bytes(bytes_transferred, '\0');
+                    std::istream is(&buffer);
+                    is.read(&bytes[0], bytes_transferred);
+
+                    auto io_msg = std::make_shared<goby::middleware::protobuf::IOData>();
+                    auto& cobs_decoded = *io_msg->mutable_data();
+                    cobs_decoded.resize(bytes_transferred);
+                    auto decoded_size =
+                        cobs_decode(reinterpret_cast<const std::uint8_t*>(bytes.data()),
+                                    bytes_transferred,
+                                    reinterpret_cast<std::uint8_t*>(&cobs_decoded[0]));
+                    cobs_decoded.resize(decoded_size - 1);
+                    decoded += cobs_decoded.size();
+                }
+            }
+        }
+        report("decode (previous)", std::chrono::steady_clock::now() - start, repeats);
+        assert(decoded == total_bytes * repeats);
+    }
+    {
+        std::size_t decoded = 0;
+        COBSReadBuffer reader;
+        IODataPool pool;
+        auto start = std::chrono::steady_clock::now();
+        for (int r = 0; r < repeats; ++r)
+        {
+            read_stream(reader, pool, stream, chunk_size,
+                        [&](std::size_t,
+                            std::shared_ptr<goby::middleware::protobuf::IOData> io_msg) {
+                            bool ok = cobs_decode_in_place(*io_msg->mutable_data());
+                            decoded += io_msg->data().size();
+                            return ok;
+                        });
+        }
+        report("decode (pooled, in place)", std::chrono::steady_clock::now() - start, repeats);
+        assert(decoded == total_bytes * repeats);
+    }
+}
+
+int main(int argc, char* argv[])
+{
+    test_equivalence();
+    test_reader();
+    benchmark();
+
+    std::cout << "all tests passed" << std::endl;
+}
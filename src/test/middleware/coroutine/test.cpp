@@ -0,0 +1,127 @@
+// Copyright 2023:
+//   GobySoft, LLC (2013-)
+//   Community contributors (see AUTHORS file)
+// File authors:
+//   Toby Schneider <toby@gobysoft.org>
+//
+//
+// This file is part of the Goby Underwater Autonomy Project Binaries
+// ("The Goby Binaries").
+//
+// The Goby Binaries are free software: you can redistribute them and/or modify
+// them under the terms of the GNU General Public License as published by
+// the Free Software Foundation, either version 2 of the License, or
+// (at your option) any later version.
+//
+// The Goby Binaries are distributed in the hope that they will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with Goby.  If not, see <http://www.gnu.org/licenses/>.
+
+#include <atomic>
+#include <cassert>
+#include <iostream>
+#include <thread>
+
+#include "goby/middleware/transport/coroutine.h"
+#include "goby/middleware/transport/interthread.h"
+
+// tests coro::next() and coro::sleep_for() with InterThreadTransporter
+
+using goby::glog;
+using namespace goby::util::logger;
+using goby::time::SteadyClock;
+namespace coro = goby::middleware::coro;
+
+#ifndef GOBY_MIDDLEWARE_HAS_COROUTINES
+#error "Expected coroutine support"
+#endif
+
+extern constexpr goby::middleware::Group request{"Request"};
+extern constexpr goby::middleware::Group response{"Response"};
+
+struct Request
+{
+    int n;
+};
+
+struct Response
+{
+    int n;
+};
+
+std::atomic<bool> responder_ready{false};
+std::atomic<bool> done{false};
+
+void responder()
+{
+    goby::middleware::InterThreadTransporter interthread;
+    interthread.subscribe<request>([&](const Request& r) {
+        // don't respond to the third request, so that next() times out
+        if (r.n < 3)
+            interthread.publish<response>(Response{r.n});
+    });
+    responder_ready = true;
+    while (!done) interthread.poll(std::chrono::milliseconds(10));
+}
+
+int stage = 0;
+int responses_received = 0;
+
+coro::Task request_response(goby::middleware::InterThreadTransporter& interthread)
+{
+    for (int n = 1; n <= 2; ++n)
+    {
+        interthread.publish<request>(Request{n});
+        auto r = co_await coro::next<response, Response>(interthread, std::chrono::seconds(10));
+        assert(r);
+        assert(r->n == n);
+        stage = n;
+    }
+
+    auto start = SteadyClock::now();
+    co_await coro::sleep_for(interthread, std::chrono::milliseconds(100));
+    assert(SteadyClock::now() - start >= std::chrono::milliseconds(100));
+    stage = 3;
+
+    interthread.publish<request>(Request{3});
+    auto none = co_await coro::next<response, Response>(interthread, std::chrono::milliseconds(50));
+    assert(!none);
+    stage = 4;
+}
+
+int main(int /*argc*/, char* argv[])
+{
+    goby::glog.add_stream(goby::util::logger::DEBUG3, &std::cerr);
+    goby::glog.set_name(argv[0]);
+    goby::glog.set_lock_action(goby::util::logger_lock::lock);
+
+    goby::middleware::InterThreadTransporter interthread;
+
+    // other subscriptions to the same group are unaffected by next()
+    interthread.subscribe<response>([&](const Response& /*r*/) { ++responses_received; });
+
+    std::thread t(responder);
+    while (!responder_ready) std::this_thread::sleep_for(std::chrono::milliseconds(1));
+
+    // runs until the first co_await
+    request_response(interthread);
+    assert(stage == 0);
+
+    auto start = std::chrono::steady_clock::now();
+    while (stage < 4)
+    {
+        interthread.poll(std::chrono::seconds(1));
+        assert(std::chrono::steady_clock::now() - start < std::chrono::seconds(10));
+    }
+
+    done = true;
+    t.join();
+
+    assert(responses_received == 2);
+
+    std::cout << "all tests passed" << std::endl;
+}
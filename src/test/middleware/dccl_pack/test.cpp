@@ -0,0 +1,182 @@
+// Copyright 2023:
+//   GobySoft, LLC (2013-)
+//   Community contributors (see AUTHORS file)
+// File authors:
+//   Toby Schneider <toby@gobysoft.org>
+//
+//
+// This file is part of the Goby Underwater Autonomy Project Binaries
+// ("The Goby Binaries").
+//
+// The Goby Binaries are free software: you can redistribute them and/or modify
+// them under the terms of the GNU General Public License as published by
+// the Free Software Foundation, either version 2 of the License, or
+// (at your option) any later version.
+//
+// The Goby Binaries are distributed in the hope that they will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with Goby.  If not, see <http://www.gnu.org/licenses/>.
+
+#include <cassert>
+#include <iomanip>
+#include <iostream>
+#include <map>
+
+#include "goby/middleware/marshalling/dccl.h"
+#include "goby/util/debug_logger.h"
+
+#include "goby/test/middleware/dccl_pack/test.pb.h"
+
+using goby::test::middleware::protobuf::LongIDSample;
+using goby::test::middleware::protobuf::ShortIDSample;
+
+using Base = goby::middleware::detail::DCCLSerializerParserHelperBase;
+
+template <typename Data> std::string encode(const Data& d)
+{
+    auto bytes = goby::middleware::SerializerParserHelper<
+        Data, goby::middleware::MarshallingScheme::DCCL>::serialize(d);
+    return std::string(bytes.begin(), bytes.end());
+}
+
+std::vector<std::string> make_messages(int num_short, int num_long)
+{
+    std::vector<std::string> messages;
+    for (int i = 0; i < std::max(num_short, num_long); ++i)
+    {
+        // interleave the types to check that pack() groups them
+        if (i < num_short)
+        {
+            ShortIDSample s;
+            s.set_a(1000 + i);
+            messages.push_back(encode(s));
+        }
+        if (i < num_long)
+        {
+            LongIDSample l;
+            l.set_b(i);
+            l.set_depth(10.5 * i);
+            messages.push_back(encode(l));
+        }
+    }
+    return messages;
+}
+
+void check_roundtrip(int num_short, int num_long)
+{
+    auto messages = make_messages(num_short, num_long);
+
+    std::string concatenated;
+    for (const auto& m : messages) concatenated += m;
+
+    auto packed = Base::pack(messages);
+    std::cout << "short: " << num_short << ", long: " << num_long
+              << ", concatenated: " << concatenated.size() << " bytes, packed: " << packed.size()
+              << " bytes" << std::endl;
+    assert(packed.size() <= concatenated.size());
+
+    // packed_size() predicts the packed frame without packing it
+    std::map<unsigned, std::pair<std::size_t, std::size_t>> ids;
+    for (const auto& m : messages)
+    {
+        auto& same_id = ids[Base::id(m.begin(), m.end())];
+        ++same_id.first;
+        same_id.second += m.size();
+    }
+    std::size_t predicted = 0;
+    for (const auto& id_p : ids)
+        predicted += Base::packed_size(id_p.first, id_p.second.first, id_p.second.second);
+    assert(predicted == packed.size());
+
+    auto unpacked = Base::unpack(packed);
+    assert(unpacked.frame_size() == static_cast<int>(messages.size()));
+
+    // pack() groups by DCCL ID, but each type keeps its relative order
+    int short_index = 0, long_index = 0;
+    for (const auto& packet : unpacked.frame())
+    {
+        if (packet.dccl_id() == 127)
+        {
+            ShortIDSample s;
+            s.set_a(1000 + short_index++);
+            assert(packet.data() == encode(s));
+        }
+        else
+        {
+            assert(packet.dccl_id() == 200);
+            LongIDSample l;
+            l.set_b(long_index);
+            l.set_depth(10.5 * long_index++);
+            assert(packet.data() == encode(l));
+        }
+    }
+    assert(short_index == num_short);
+    assert(long_index == num_long);
+
+    // unpacked frames are still understood
+    assert(Base::unpack(concatenated).frame_size() == static_cast<int>(messages.size()));
+}
+
+// user payload (all but DCCL IDs and aggregate headers) per frame, with and without packing
+void goodput(std::size_t frame_size)
+{
+    for (bool pack : {false, true})
+    {
+        std::vector<std::string> frame_messages;
+        std::string frame;
+        std::size_t payload = 0;
+        for (int i = 0;; ++i)
+        {
+            LongIDSample l;
+            l.set_b(i % 256);
+            l.set_depth(i);
+            auto message = encode(l);
+
+            frame_messages.push_back(message);
+            std::string next_frame;
+            if (pack)
+            {
+                next_frame = Base::pack(frame_messages);
+            }
+            else
+            {
+                next_frame = frame;
+                next_frame += message;
+            }
+
+            if (next_frame.size() > frame_size)
+                break;
+
+            frame = next_frame;
+            payload += message.size() - 2;
+        }
+
+        std::cout << "frame: " << std::setw(5) << frame_size << " bytes, "
+                  << (pack ? "packed:   " : "unpacked: ") << std::setw(3)
+                  << Base::unpack(frame).frame_size() << " messages, goodput: " << std::fixed
+                  << std::setprecision(1) << 100.0 * payload / frame_size << "%" << std::endl;
+    }
+}
+
+int main(int argc, char* argv[])
+{
+    goby::glog.add_stream(goby::util::logger::DEBUG3, &std::cerr);
+    goby::glog.set_name(argv[0]);
+
+    check_roundtrip(1, 0);
+    check_roundtrip(0, 1);
+    check_roundtrip(1, 1);
+    check_roundtrip(3, 0);
+    check_roundtrip(4, 0);
+    check_roundtrip(0, 3);
+    check_roundtrip(10, 10);
+    check_roundtrip(300, 2);
+
+    for (auto frame_size : {32, 64, 256, 1024, 1500}) goodput(frame_size);
+
+    std::cout << "all tests passed" << std::endl;
+}
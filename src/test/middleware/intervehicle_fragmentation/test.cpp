@@ -0,0 +1,415 @@
+// Copyright 2023:
+//   GobySoft, LLC (2013-)
+//   Community contributors (see AUTHORS file)
+// File authors:
+//   Toby Schneider <toby@gobysoft.org>
+//
+//
+// This file is part of the Goby Underwater Autonomy Project Binaries
+// ("The Goby Binaries").
+//
+// The Goby Binaries are free software: you can redistribute them and/or modify
+// them under the terms of the GNU General Public License as published by
+// the Free Software Foundation, either version 2 of the License, or
+// (at your option) any later version.
+//
+// The Goby Binaries are distributed in the hope that they will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with Goby.  If not, see <http://www.gnu.org/licenses/>.
+
+#include <cassert>
+#include <iostream>
+
+#include "goby/exception.h"
+#include "goby/middleware/marshalling/dccl.h"
+#include "goby/middleware/transport/intervehicle/fragmentation.h"
+#include "goby/util/debug_logger.h"
+
+#include "goby/test/middleware/intervehicle_fragmentation/test.pb.h"
+
+using goby::middleware::intervehicle::FragmentReassembler;
+using goby::middleware::intervehicle::FragmentSender;
+using goby::middleware::intervehicle::protobuf::DCCLForwardedData;
+using goby::test::middleware::protobuf::LargeSample;
+
+using Value = FragmentSender::Value;
+
+constexpr FragmentSender::modem_id_type src{1};
+constexpr FragmentSender::modem_id_type dest{2};
+constexpr std::size_t max_frame_bytes{64};
+constexpr int large_sample_dccl_id{125};
+const std::string glog_group{"test"};
+const auto reassembly_timeout = std::chrono::seconds(10);
+
+int fragment_dccl_id()
+{
+    return goby::middleware::SerializerParserHelper<
+        goby::middleware::intervehicle::protobuf::Fragment,
+        goby::middleware::MarshallingScheme::DCCL>::id();
+}
+
+Value make_original(int index, std::size_t payload_bytes)
+{
+    LargeSample sample;
+    sample.set_index(index);
+    sample.set_payload(std::string(payload_bytes, 'a' + index));
+    auto bytes = goby::middleware::SerializerParserHelper<
+        LargeSample, goby::middleware::MarshallingScheme::DCCL>::serialize(sample);
+
+    FragmentSender::buffer_data_type data;
+    data.mutable_key()->set_type(LargeSample::descriptor()->full_name());
+    data.set_data(std::string(bytes.begin(), bytes.end()));
+    return Value{dest, "125::1", goby::time::SteadyClock::now(), data};
+}
+
+// one frame carrying the given fragments, plus an unrelated (non-fragment) packet at the start
+DCCLForwardedData make_frame(const std::vector<Value>& fragments)
+{
+    DCCLForwardedData packets;
+    auto* other = packets.add_frame();
+    other->set_dccl_id(1);
+    other->set_data("other");
+    for (const auto& fragment : fragments)
+    {
+        auto* packet = packets.add_frame();
+        packet->set_dccl_id(fragment_dccl_id());
+        packet->set_data(fragment.data.data());
+    }
+    return packets;
+}
+
+// returns the reassembled packets, checking that the unrelated packet is passed through first
+std::vector<goby::middleware::intervehicle::protobuf::DCCLPacket>
+receive(FragmentReassembler& reassembler, const std::vector<Value>& fragments,
+        goby::time::SteadyClock::time_point now = goby::time::SteadyClock::now())
+{
+    auto packets = make_frame(fragments);
+    reassembler.reassemble(&packets, src, now);
+    assert(packets.frame_size() >= 1);
+    assert(packets.frame(0).dccl_id() == 1 && packets.frame(0).data() == "other");
+    return {packets.frame().begin() + 1, packets.frame().end()};
+}
+
+void check_reassembled(const std::vector<goby::middleware::intervehicle::protobuf::DCCLPacket>& out,
+                       const Value& original)
+{
+    assert(out.size() == 1);
+    assert(out[0].dccl_id() == large_sample_dccl_id);
+    assert(out[0].data() == original.data.data());
+}
+
+void test_in_order()
+{
+    FragmentSender sender(max_frame_bytes, glog_group);
+    FragmentReassembler reassembler(reassembly_timeout, glog_group);
+
+    auto small = make_original(0, 10);
+    assert(!sender.needs_fragmentation(small.data));
+
+    auto original = make_original(1, 500);
+    assert(sender.needs_fragmentation(original.data));
+    assert(sender.can_fragment(original.data));
+
+    auto fragments = sender.fragment(original, "125::1fragment/");
+    assert(fragments.size() == sender.num_fragments(original.data));
+    assert(fragments.size() > 1);
+    for (const auto& fragment : fragments)
+    {
+        assert(sender.is_fragment(fragment.data));
+        assert(!sender.is_fragment(original.data));
+        assert(fragment.data.data().size() <= max_frame_bytes);
+        assert(fragment.subbuffer_id == "125::1fragment/");
+    }
+
+    // all in a single frame
+    check_reassembled(receive(reassembler, fragments), original);
+
+    // the original is only returned once every fragment is disposed of
+    for (std::size_t i = 0, n = fragments.size(); i < n; ++i)
+    {
+        auto disposed = sender.dispose(fragments[i]);
+        if (i + 1 < n)
+        {
+            assert(!disposed);
+        }
+        else
+        {
+            assert(disposed);
+            assert(disposed->data.data() == original.data.data());
+        }
+    }
+    assert(sender.size() == 0);
+    std::cout << "in order: passed" << std::endl;
+}
+
+void test_out_of_order()
+{
+    FragmentSender sender(max_frame_bytes, glog_group);
+    FragmentReassembler reassembler(reassembly_timeout, glog_group);
+
+    auto original = make_original(2, 400);
+    auto fragments = sender.fragment(original, "125::1fragment/");
+    assert(fragments.size() > 2);
+
+    // last to first, one per frame
+    for (auto it = fragments.rbegin(), end = fragments.rend(); it != end; ++it)
+    {
+        auto out = receive(reassembler, {*it});
+        if (it + 1 != end)
+            assert(out.empty());
+        else
+            check_reassembled(out, original);
+    }
+
+    // interleaved with a second message from the same sender
+    auto original2 = make_original(3, 300);
+    auto fragments2 = sender.fragment(original2, "125::1fragment/");
+    auto original3 = make_original(4, 300);
+    auto fragments3 = sender.fragment(original3, "125::1fragment/");
+    assert(fragments2.size() == fragments3.size());
+
+    std::vector<goby::middleware::intervehicle::protobuf::DCCLPacket> out;
+    for (std::size_t i = 0; i < fragments2.size(); ++i)
+    {
+        auto frame_out = receive(reassembler, {fragments3[fragments3.size() - 1 - i], fragments2[i]});
+        out.insert(out.end(), frame_out.begin(), frame_out.end());
+    }
+    assert(out.size() == 2);
+    assert(out[0].data() == original3.data.data() || out[1].data() == original3.data.data());
+    assert(out[0].data() == original2.data.data() || out[1].data() == original2.data.data());
+    std::cout << "out of order: passed" << std::endl;
+}
+
+void test_selective_repeat()
+{
+    FragmentSender sender(max_frame_bytes, glog_group);
+    FragmentReassembler reassembler(reassembly_timeout, glog_group);
+
+    auto original = make_original(5, 500);
+    auto fragments = sender.fragment(original, "125::1fragment/");
+    const std::size_t lost = fragments.size() / 2;
+
+    // all but one fragment arrive (and are acked)
+    for (std::size_t i = 0; i < fragments.size(); ++i)
+    {
+        if (i == lost)
+            continue;
+        assert(receive(reassembler, {fragments[i]}).empty());
+        assert(!sender.dispose(fragments[i]));
+    }
+    assert(sender.size() == 1);
+
+    // only the lost fragment is resent
+    check_reassembled(receive(reassembler, {fragments[lost]}), original);
+    auto disposed = sender.dispose(fragments[lost]);
+    assert(disposed && disposed->data.data() == original.data.data());
+
+    // duplicates after completion (e.g. resent after a lost ack) do not restart the message
+    assert(receive(reassembler, {fragments[lost]}).empty());
+    assert(receive(reassembler, fragments).empty());
+    assert(reassembler.size() == 1);
+
+    // nor does disposing of them again on the sending side
+    assert(!sender.dispose(fragments[lost]));
+    std::cout << "selective repeat: passed" << std::endl;
+}
+
+void test_reassembly_timeout()
+{
+    FragmentSender sender(max_frame_bytes, glog_group);
+    FragmentReassembler reassembler(reassembly_timeout, glog_group);
+
+    auto start = goby::time::SteadyClock::now();
+
+    auto complete = make_original(6, 200);
+    auto complete_fragments = sender.fragment(complete, "125::1fragment/");
+    check_reassembled(receive(reassembler, complete_fragments, start), complete);
+
+    auto incomplete = make_original(7, 200);
+    auto incomplete_fragments = sender.fragment(incomplete, "125::1fragment/");
+    auto last = incomplete_fragments.back();
+    incomplete_fragments.pop_back();
+    assert(receive(reassembler, incomplete_fragments, start).empty());
+    assert(reassembler.size() == 2);
+
+    // a new fragment restarts the timeout
+    assert(reassembler.expire(start + reassembly_timeout) == 0);
+    assert(reassembler.size() == 2);
+
+    // only the incomplete message counts as discarded
+    assert(reassembler.expire(start + reassembly_timeout + std::chrono::seconds(1)) == 1);
+    assert(reassembler.size() == 0);
+
+    // once discarded, the missing fragment alone cannot complete the message
+    assert(receive(reassembler, {last}).empty());
+    std::cout << "reassembly timeout: passed" << std::endl;
+}
+
+void test_restart()
+{
+    FragmentReassembler reassembler(reassembly_timeout, glog_group);
+    auto start = goby::time::SteadyClock::now();
+
+    // a completed message is still held when the sender restarts and reuses its message_id
+    FragmentSender sender(max_frame_bytes, glog_group, 1);
+    auto before = make_original(11, 300);
+    check_reassembled(receive(reassembler, sender.fragment(before, "125::1fragment/"), start),
+                      before);
+
+    FragmentSender restarted(max_frame_bytes, glog_group, 2);
+    auto after = make_original(12, 300);
+    auto after_fragments = restarted.fragment(after, "125::1fragment/");
+    check_reassembled(receive(reassembler, after_fragments, start), after);
+
+    // a partially received message with the same message_id and number of fragments is not
+    // spliced into the message sent after the restart
+    FragmentSender sender2(max_frame_bytes, glog_group, 3);
+    auto partial = make_original(13, 300);
+    auto partial_fragments = sender2.fragment(partial, "125::1fragment/");
+    partial_fragments.pop_back();
+    assert(receive(reassembler, partial_fragments, start).empty());
+
+    FragmentSender restarted2(max_frame_bytes, glog_group, 4);
+    auto replacement = make_original(14, 300);
+    auto replacement_fragments = restarted2.fragment(replacement, "125::1fragment/");
+    assert(replacement_fragments.size() == partial_fragments.size() + 1);
+    std::vector<goby::middleware::intervehicle::protobuf::DCCLPacket> out;
+    for (const auto& fragment : replacement_fragments)
+    {
+        auto frame_out = receive(reassembler, {fragment}, start);
+        out.insert(out.end(), frame_out.begin(), frame_out.end());
+    }
+    check_reassembled(out, replacement);
+    // only the replacement is still held: the earlier sessions were discarded
+    assert(reassembler.size() == 1);
+
+    // duplicates of a completed message do not keep it alive past the timeout
+    assert(receive(reassembler, replacement_fragments, start + reassembly_timeout).empty());
+    assert(reassembler.expire(start + reassembly_timeout + std::chrono::seconds(1)) == 0);
+    assert(reassembler.size() == 0);
+
+    // the sending side ignores fragments from another session
+    assert(!restarted2.dispose(after_fragments.front()));
+    std::vector<Value> outstanding;
+    assert(!restarted2.expire(after_fragments.front(), &outstanding));
+    assert(outstanding.empty());
+    assert(restarted2.size() == 1);
+    std::cout << "restart: passed" << std::endl;
+}
+
+void test_expire()
+{
+    FragmentSender sender(max_frame_bytes, glog_group);
+
+    auto original = make_original(8, 500);
+    auto fragments = sender.fragment(original, "125::1fragment/");
+    assert(fragments.size() > 3);
+
+    // the first two are delivered, then the third expires in the buffer
+    assert(!sender.dispose(fragments[0]));
+    assert(!sender.dispose(fragments[1]));
+
+    std::vector<Value> outstanding;
+    auto expired = sender.expire(fragments[2], &outstanding);
+    assert(expired && expired->data.data() == original.data.data());
+    assert(outstanding.size() == fragments.size() - 2);
+    for (const auto& fragment : outstanding)
+        assert(fragment.data.data() != fragments[0].data.data() &&
+               fragment.data.data() != fragments[1].data.data());
+    assert(sender.size() == 0);
+
+    // other fragments of the same message expiring (or being acked) later are ignored
+    outstanding.clear();
+    assert(!sender.expire(fragments[3], &outstanding));
+    assert(outstanding.empty());
+    assert(!sender.dispose(fragments[3]));
+
+    // remove() drops messages for a destination and subbuffer
+    sender.fragment(original, "125::1fragment/");
+    sender.remove(dest + 1, original.subbuffer_id);
+    assert(sender.size() == 1);
+    sender.remove(dest, original.subbuffer_id);
+    assert(sender.size() == 0);
+    std::cout << "expire: passed" << std::endl;
+}
+
+void test_errors()
+{
+    // max_frame_bytes too small for any data
+    bool threw = false;
+    try
+    {
+        FragmentSender sender(FragmentSender::overhead(), glog_group);
+    }
+    catch (const goby::Exception&)
+    {
+        threw = true;
+    }
+    assert(threw);
+
+    // session out of range
+    threw = false;
+    try
+    {
+        FragmentSender sender(max_frame_bytes, glog_group, FragmentSender::max_session + 1);
+    }
+    catch (const goby::Exception&)
+    {
+        threw = true;
+    }
+    assert(threw);
+
+    // more fragments than a Fragment can describe
+    FragmentSender sender(FragmentSender::overhead() + 1, glog_group);
+    auto original = make_original(9, 1000);
+    assert(sender.num_fragments(original.data) > FragmentSender::max_num_fragments);
+    assert(!sender.can_fragment(original.data));
+    threw = false;
+    try
+    {
+        sender.fragment(original, "125::1fragment/");
+    }
+    catch (const goby::Exception&)
+    {
+        threw = true;
+    }
+    assert(threw);
+    assert(sender.size() == 0);
+
+    // a corrupt fragment is dropped without losing the rest of the frame
+    FragmentSender good_sender(max_frame_bytes, glog_group);
+    FragmentReassembler reassembler(reassembly_timeout, glog_group);
+    auto good = make_original(10, 100);
+    auto fragments = good_sender.fragment(good, "125::1fragment/");
+    auto packets = make_frame(fragments);
+    auto* corrupt = packets.mutable_frame()->Add();
+    corrupt->set_dccl_id(fragment_dccl_id());
+    corrupt->set_data("\x03");
+    packets.mutable_frame()->SwapElements(1, packets.frame_size() - 1);
+    reassembler.reassemble(&packets, src);
+    assert(packets.frame_size() == 2);
+    assert(packets.frame(0).data() == "other");
+    assert(packets.frame(1).data() == good.data.data());
+    std::cout << "errors: passed" << std::endl;
+}
+
+int main(int argc, char* argv[])
+{
+    goby::glog.add_stream(goby::util::logger::DEBUG3, &std::cerr);
+    goby::glog.set_name(argv[0]);
+    goby::glog.add_group(glog_group, goby::util::Colors::blue);
+
+    test_in_order();
+    test_out_of_order();
+    test_selective_repeat();
+    test_reassembly_timeout();
+    test_restart();
+    test_expire();
+    test_errors();
+
+    std::cout << "all tests passed" << std::endl;
+}
@@ -0,0 +1,82 @@
+// Copyright 2023:
+//   GobySoft, LLC (2013-)
+//   Community contributors (see AUTHORS file)
+// File authors:
+//   Toby Schneider <toby@gobysoft.org>
+//
+//
+// This file is part of the Goby Underwater Autonomy Project Binaries
+// ("The Goby Binaries").
+//
+// The Goby Binaries are free software: you can redistribute them and/or modify
+// them under the terms of the GNU General Public License as published by
+// the Free Software Foundation, either version 2 of the License, or
+// (at your option) any later version.
+//
+// The Goby Binaries are distributed in the hope that they will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with Goby.  If not, see <http://www.gnu.org/licenses/>.
+
+
+#include <cassert>
+#include <iostream>
+#include <thread>
+
+#include "goby/middleware/io/detail/io_data_pool.h"
+
+// tests recycling of IOData messages by IODataPool
+
+using goby::middleware::io::detail::IODataPool;
+
+int main(int argc, char* argv[])
+{
+    IODataPool pool(2);
+
+    // released immediately: reused every time, keeping the capacity of the data
+    {
+        auto msg = pool.acquire();
+        msg->set_data(std::string(1000, 'a'));
+        msg->set_index(3);
+    }
+    const std::string* data_ptr = nullptr;
+    for (int i = 0; i < 10; ++i)
+    {
+        auto msg = pool.acquire();
+        assert(!msg->has_data());
+        assert(!msg->has_index());
+        assert(msg->data().capacity() >= 1000);
+        if (data_ptr)
+            assert(&msg->data() == data_ptr);
+        data_ptr = &msg->data();
+    }
+    assert(pool.allocated() == 1);
+    assert(pool.reused() == 10);
+
+    // held by a "subscriber": not reused until released
+    {
+        auto held1 = pool.acquire();
+        auto held2 = pool.acquire();
+        assert(held1 != held2);
+        assert(pool.allocated() == 2);
+
+        // pool is full and all the messages are in use, so a new one is allocated
+        auto held3 = pool.acquire();
+        assert(held3 != held1 && held3 != held2);
+        assert(pool.allocated() == 3);
+
+        // released by another thread
+        std::thread t([held1]() mutable { held1.reset(); });
+        held1.reset();
+        t.join();
+    }
+
+    auto msg = pool.acquire();
+    assert(pool.reused() == 12);
+    assert(msg->ByteSizeLong() == 0);
+
+    std::cout << "all tests passed" << std::endl;
+}
@@ -0,0 +1,223 @@
+// Copyright 2023:
+//   GobySoft, LLC (2013-)
+//   Community contributors (see AUTHORS file)
+// File authors:
+//   Toby Schneider <toby@gobysoft.org>
+//
+//
+// This file is part of the Goby Underwater Autonomy Project Binaries
+// ("The Goby Binaries").
+//
+// The Goby Binaries are free software: you can redistribute them and/or modify
+// them under the terms of the GNU General Public License as published by
+// the Free Software Foundation, either version 2 of the License, or
+// (at your option) any later version.
+//
+// The Goby Binaries are distributed in the hope that they will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with Goby.  If not, see <http://www.gnu.org/licenses/>.
+
+#include <atomic>
+#include <cassert>
+#include <chrono>
+#include <iostream>
+#include <memory>
+#include <thread>
+
+#include "goby/middleware/application/multi_thread.h"
+#include "goby/middleware/io/udp_point_to_point.h"
+#include "goby/middleware/transport/interface.h"
+
+#include "goby/test/middleware/io_wake_hook/test.pb.h"
+
+// tests that PollerWakeHook::clear() waits for hooks running on other threads and throws if called from within the hook, and that an IOThread (which posts to its io_context from the wake hook) can be destroyed while another thread is publishing to it
+
+using goby::glog;
+using goby::middleware::io::PubSubLayer;
+using goby::middleware::protobuf::IOData;
+using goby::middleware::protobuf::IOStatus;
+using goby::test::middleware::protobuf::TestConfig;
+using namespace goby::util::logger;
+
+extern constexpr goby::middleware::Group udp_in{"udp::in"};
+extern constexpr goby::middleware::Group udp_out{"udp::out"};
+
+using UDPThread = goby::middleware::io::UDPPointToPointThread<
+    udp_in, udp_out, PubSubLayer::INTERTHREAD, PubSubLayer::INTERTHREAD>;
+
+// nothing listens on this port, so the datagrams are simply discarded
+const int remote_port = 54873;
+const int num_cycles = 20;
+const std::chrono::seconds timeout(60);
+
+std::atomic<bool> publishing{true};
+std::atomic<int> published{0};
+
+void test_clear_waits_for_hook()
+{
+    goby::middleware::detail::PollerWakeHook hook;
+
+    std::atomic<bool> in_hook{false};
+    std::atomic<bool> cleared{false};
+    hook.set([&]() {
+        in_hook = true;
+        std::this_thread::sleep_for(std::chrono::milliseconds(100));
+        // clear() must not have returned while we are still running
+        assert(!cleared);
+    });
+
+    std::thread publisher([&]() { hook(); });
+    while (!in_hook) std::this_thread::yield();
+    hook.clear();
+    cleared = true;
+    publisher.join();
+
+    // no-op once cleared
+    hook();
+}
+
+void test_reentry()
+{
+    goby::middleware::detail::PollerWakeHook hook;
+
+    // clear() or set() from within the hook would deadlock, so must throw
+    int calls = 0;
+    bool clear_threw = false, set_threw = false;
+    hook.set([&]() {
+        ++calls;
+        try
+        {
+            hook.clear();
+        }
+        catch (const goby::Exception&)
+        {
+            clear_threw = true;
+        }
+        try
+        {
+            hook.set([]() {});
+        }
+        catch (const goby::Exception&)
+        {
+            set_threw = true;
+        }
+
+        // running the same hook again from within itself (e.g. by publishing to our own poller)
+        if (calls == 1)
+            hook();
+    });
+    hook();
+    assert(calls == 2);
+    assert(clear_threw && set_threw);
+
+    // fine once the hook has returned
+    hook.clear();
+    hook();
+    assert(calls == 2);
+}
+
+class PublisherThread : public goby::middleware::SimpleThread<TestConfig>
+{
+  public:
+    PublisherThread(const TestConfig& cfg) : SimpleThread(cfg, 1000) {}
+
+  private:
+    void loop() override
+    {
+        if (!publishing)
+            return;
+
+        for (int i = 0; i < 10; ++i)
+        {
+            auto io_msg = std::make_shared<IOData>();
+            io_msg->set_data(std::to_string(published++));
+            interthread().publish<udp_out>(io_msg);
+        }
+    }
+};
+
+class TestApp : public goby::middleware::MultiThreadStandaloneApplication<TestConfig>
+{
+  public:
+    TestApp() : goby::middleware::MultiThreadStandaloneApplication<TestConfig>(100)
+    {
+        udp_cfg_.set_remote_address("127.0.0.1");
+        udp_cfg_.set_remote_port(remote_port);
+
+        interthread().subscribe<udp_in, IOStatus>([this](const IOStatus& status) {
+            if (status.state() == goby::middleware::protobuf::IO__LINK_OPEN)
+                link_open_ = true;
+        });
+
+        launch_thread<PublisherThread>();
+        launch_thread<UDPThread>(udp_cfg_);
+    }
+
+    void loop() override
+    {
+        assert(std::chrono::steady_clock::now() < start_time_ + timeout);
+
+        if (link_open_)
+        {
+            // destroy the IOThread while PublisherThread continues to publish to it
+            link_open_ = false;
+            joining_ = true;
+            join_thread<UDPThread>();
+        }
+        else if (joining_ && running_thread_count() == 1)
+        {
+            // only PublisherThread remains
+            joining_ = false;
+            if (++cycles_ < num_cycles)
+            {
+                launch_thread<UDPThread>(udp_cfg_);
+            }
+            else
+            {
+                publishing = false;
+                join_thread<PublisherThread>();
+                quit();
+            }
+        }
+    }
+
+    void post_finalize() override
+    {
+        goby::middleware::MultiThreadStandaloneApplication<TestConfig>::post_finalize();
+        glog.is_verbose() && glog << "Published " << published << " messages over " << cycles_
+                                  << " IOThread lifetimes" << std::endl;
+        assert(published > 0);
+        std::cout << "all tests passed" << std::endl;
+    }
+
+  private:
+    goby::middleware::protobuf::UDPPointToPointConfig udp_cfg_;
+    bool link_open_{false};
+    bool joining_{false};
+    int cycles_{0};
+    std::chrono::steady_clock::time_point start_time_{std::chrono::steady_clock::now()};
+};
+
+class TestConfigurator : public goby::middleware::ConfiguratorInterface<TestConfig>
+{
+  public:
+    TestConfigurator(char* argv0)
+    {
+        auto& app_cfg = mutable_app_configuration();
+        app_cfg.set_name(argv0);
+    }
+
+  private:
+    std::string str() const override { return ""; }
+};
+
+int main(int argc, char* argv[])
+{
+    test_clear_waits_for_hook();
+    test_reentry();
+    return goby::run<TestApp>(TestConfigurator(argv[0]));
+}
@@ -0,0 +1,186 @@
+// Copyright 2023:
+//   GobySoft, LLC (2013-)
+//   Community contributors (see AUTHORS file)
+// File authors:
+//   Toby Schneider <toby@gobysoft.org>
+//
+//
+// This file is part of the Goby Underwater Autonomy Project Binaries
+// ("The Goby Binaries").
+//
+// The Goby Binaries are free software: you can redistribute them and/or modify
+// them under the terms of the GNU General Public License as published by
+// the Free Software Foundation, either version 2 of the License, or
+// (at your option) any later version.
+//
+// The Goby Binaries are distributed in the hope that they will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with Goby.  If not, see <http://www.gnu.org/licenses/>.
+
+
+#include <cassert>
+#include <chrono>
+#include <iostream>
+#include <random>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include <fcntl.h>   // for open, O_RDWR
+#include <stdlib.h>  // for posix_openpt, grantpt, unlockpt, ptsname
+#include <termios.h> // for cfmakeraw, tcsetattr
+#include <unistd.h>  // for write, close
+
+#include <boost/asio/io_context.hpp>
+#include <boost/asio/posix/stream_descriptor.hpp>
+#include <boost/asio/read_until.hpp>
+#include <boost/asio/streambuf.hpp>
+
+#include "goby/middleware/io/line_based/common.h"
+
+// tests that match_eol splits lines identically to match_regex, and compares their throughput reading from a PTY
+
+using goby::middleware::io::match_eol;
+using goby::middleware::io::match_regex;
+
+// split the input, arriving in chunks of the given size, the same way boost::asio::read_until does
+template <typename Matcher>
+std::vector<std::string> split(const std::string& input, std::size_t chunk_size,
+                               const Matcher& matcher, bool contiguous)
+{
+    std::vector<std::string> lines;
+    std::string buffer;
+    std::size_t search_position = 0;
+    for (std::size_t i = 0; i < input.size(); i += chunk_size)
+    {
+        buffer += input.substr(i, chunk_size);
+        while (true)
+        {
+            std::size_t match_end;
+            bool matched;
+            if (contiguous)
+            {
+                const char* begin = buffer.data();
+                auto result = matcher(begin + search_position, begin + buffer.size());
+                match_end = result.first - begin;
+                matched = result.second;
+            }
+            else
+            {
+                const std::string& const_buffer = buffer;
+                auto result = matcher(const_buffer.begin() + search_position, const_buffer.end());
+                match_end = result.first - const_buffer.begin();
+                matched = result.second;
+            }
+
+            if (!matched)
+            {
+                search_position = match_end;
+                break;
+            }
+            lines.push_back(buffer.substr(0, match_end));
+            buffer.erase(0, match_end);
+            search_position = 0;
+        }
+    }
+    return lines;
+}
+
+void test_equivalence()
+{
+    struct EOL
+    {
+        std::string eol;
+        bool literal;
+    };
+    std::vector<EOL> eols{{"\n", true},        {"\r\n", true},      {"\\r\\n", true},
+                          {"\r\n|\n", true},   {"\n|\r\n", true},   {"END", true},
+                          {"EN|NE|\n", true},  {"\\.", true},       {"[\r\n]+", false},
+                          {"\\d\n", false},    {"E.D", false},      {"(\r\n|\n)", false},
+                          {"\r?\n", false}};
+
+    std::mt19937 gen(1);
+    const std::string alphabet("abc1.\r\nEND");
+    std::uniform_int_distribution<> dist(0, alphabet.size() - 1);
+    std::string input;
+    for (int i = 0; i < 20000; ++i) input.push_back(alphabet[dist(gen)]);
+
+    for (const auto& eol : eols)
+    {
+        match_eol eol_matcher(eol.eol);
+        match_regex regex_matcher(eol.eol);
+        assert(eol_matcher.is_literal() == eol.literal);
+
+        for (std::size_t chunk_size : {1, 3, 7, 64, 20000})
+        {
+            auto expected = split(input, chunk_size, regex_matcher, true);
+            assert(!expected.empty());
+            assert(split(input, chunk_size, eol_matcher, true) == expected);
+            assert(split(input, chunk_size, eol_matcher, false) == expected);
+        }
+    }
+    std::cout << "match_eol and match_regex results are identical" << std::endl;
+}
+
+template <typename Matcher> void benchmark(const std::string& name, const Matcher& matcher)
+{
+    const int num_lines = 100000;
+    const std::string line(78, 'x');
+
+    int primary = posix_openpt(O_RDWR | O_NOCTTY);
+    assert(primary >= 0);
+    assert(grantpt(primary) == 0);
+    assert(unlockpt(primary) == 0);
+    int secondary = open(ptsname(primary), O_RDWR | O_NOCTTY);
+    assert(secondary >= 0);
+
+    termios ios;
+    tcgetattr(secondary, &ios);
+    cfmakeraw(&ios);
+    tcsetattr(secondary, TCSANOW, &ios);
+
+    std::thread writer([&]() {
+        std::string data;
+        for (int i = 0; i < num_lines; ++i) data += line + "\r\n";
+        for (std::size_t written = 0; written < data.size();)
+        {
+            auto n = write(primary, data.data() + written, data.size() - written);
+            assert(n > 0);
+            written += n;
+        }
+    });
+
+    boost::asio::io_context io;
+    boost::asio::posix::stream_descriptor stream(io, secondary);
+    boost::asio::streambuf buffer;
+
+    auto start = std::chrono::steady_clock::now();
+    for (int i = 0; i < num_lines; ++i)
+    {
+        auto bytes = boost::asio::read_until(stream, buffer, matcher);
+        assert(bytes == line.size() + 2);
+        buffer.consume(bytes);
+    }
+    auto end = std::chrono::steady_clock::now();
+
+    writer.join();
+    close(primary);
+
+    double seconds = std::chrono::duration<double>(end - start).count();
+    std::cout << name << ": " << num_lines << " lines in " << seconds << " s ("
+              << static_cast<int>(num_lines / seconds) << " lines/s)" << std::endl;
+}
+
+int main(int argc, char* argv[])
+{
+    test_equivalence();
+
+    benchmark("match_regex", match_regex("\r\n"));
+    benchmark("match_eol", match_eol("\r\n"));
+
+    std::cout << "all tests passed" << std::endl;
+}
@@ -0,0 +1,334 @@
+// Copyright 2023:
+//   GobySoft, LLC (2013-)
+//   Community contributors (see AUTHORS file)
+// File authors:
+//   Toby Schneider <toby@gobysoft.org>
+//
+//
+// This file is part of the Goby Underwater Autonomy Project Binaries
+// ("The Goby Binaries").
+//
+// The Goby Binaries are free software: you can redistribute them and/or modify
+// them under the terms of the GNU General Public License as published by
+// the Free Software Foundation, either version 2 of the License, or
+// (at your option) any later version.
+//
+// The Goby Binaries are distributed in the hope that they will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with Goby.  If not, see <http://www.gnu.org/licenses/>.
+
+#define BOOST_TEST_MODULE mavlink_frame_parser_test
+#include <boost/test/included/unit_test.hpp>
+
+#include <algorithm> // for min, find
+#include <chrono>    // for steady_clock
+#include <random>    // for mt19937
+#include <string>    // for string
+#include <vector>    // for vector
+
+#include "goby/middleware/io/mavlink/frame_parser.h"
+#include "goby/middleware/marshalling/mavlink.h"
+
+using goby::middleware::SerializerParserHelper;
+using goby::middleware::io::detail::MAVLinkFrameParser;
+
+struct GlogConfig
+{
+    GlogConfig()
+    {
+        goby::glog.add_stream(goby::util::logger::WARN, &std::cerr);
+        goby::glog.set_name("mavlink_frame_parser");
+    }
+    ~GlogConfig() = default;
+};
+
+BOOST_GLOBAL_FIXTURE(GlogConfig);
+
+template <typename MAVLinkMessage> std::string frame(const MAVLinkMessage& packet)
+{
+    auto bytes = SerializerParserHelper<
+        std::tuple<int, int, MAVLinkMessage>,
+        goby::middleware::scheme<std::tuple<int, int, MAVLinkMessage>>()>::
+        serialize(std::make_tuple(1, 1, packet));
+    return std::string(bytes.begin(), bytes.end());
+}
+
+bool contains_stx(const std::string& bytes)
+{
+    return bytes.find(static_cast<char>(MAVLINK_STX)) != std::string::npos ||
+           bytes.find(static_cast<char>(MAVLINK_STX_MAVLINK1)) != std::string::npos;
+}
+
+// stand-in for a recorded autopilot telemetry stream: frames at typical stream rates, with
+// occasional line noise between them
+struct TelemetryStream
+{
+    TelemetryStream(int seconds)
+    {
+        std::mt19937 gen(1);
+        std::uniform_int_distribution<int> noise_byte(0, MAVLINK_STX - 1);
+
+        for (int ms = 0; ms < seconds * 1000; ms += 20)
+        {
+            mavlink::common::msg::ATTITUDE attitude{};
+            attitude.time_boot_ms = ms;
+            attitude.roll = 0.01 * (ms % 100);
+            attitude.pitch = -0.02;
+            attitude.yaw = 1.5;
+            add(frame(attitude));
+
+            if (ms % 100 == 0)
+            {
+                mavlink::common::msg::GLOBAL_POSITION_INT position{};
+                position.time_boot_ms = ms;
+                position.lat = 415000000 + ms;
+                position.lon = -706000000 - ms;
+                position.alt = 12000;
+                position.hdg = 9000;
+                add(frame(position));
+            }
+
+            if (ms % 200 == 0)
+            {
+                mavlink::common::msg::GPS_RAW_INT gps{};
+                gps.time_usec = ms * 1000ull;
+                gps.lat = 415000000 + ms;
+                gps.lon = -706000000 - ms;
+                gps.fix_type = 3;
+                gps.satellites_visible = 12;
+                add(frame(gps));
+            }
+
+            if (ms % 1000 == 0)
+            {
+                mavlink::common::msg::HEARTBEAT heartbeat{};
+                heartbeat.type = 2;
+                heartbeat.autopilot = 3;
+                heartbeat.system_status = 4;
+                add(frame(heartbeat));
+
+                mavlink::common::msg::SYS_STATUS sys_status{};
+                sys_status.voltage_battery = 15800;
+                sys_status.battery_remaining = 80;
+                add(frame(sys_status));
+
+                // noise (without start-of-frame bytes)
+                for (int i = 0; i < 7; ++i) stream.push_back(noise_byte(gen));
+                noise_bytes += 7;
+            }
+        }
+    }
+
+    void add(const std::string& frame)
+    {
+        stream += frame;
+        frames.push_back(frame);
+    }
+
+    std::string stream;
+    std::vector<std::string> frames;
+    int noise_bytes{0};
+};
+
+// parse the stream in pieces of random size (as read from a serial port)
+std::vector<std::string> parse_in_chunks(MAVLinkFrameParser& parser, const std::string& stream,
+                                         std::size_t max_chunk)
+{
+    std::vector<std::string> frames;
+    std::mt19937 gen(2);
+    std::uniform_int_distribution<std::size_t> chunk_size(1, max_chunk);
+    for (std::size_t pos = 0; pos < stream.size();)
+    {
+        std::size_t n = std::min(chunk_size(gen), stream.size() - pos);
+        parser.parse(stream.data() + pos, stream.data() + pos + n,
+                     [&](const char* frame, std::size_t size,
+                         MAVLinkFrameParser::FrameStatus status) {
+                         if (status != MAVLinkFrameParser::FrameStatus::BAD_CRC)
+                             frames.emplace_back(frame, size);
+                     });
+        pos += n;
+    }
+    return frames;
+}
+
+BOOST_AUTO_TEST_CASE(mavlink_crc)
+{
+    std::string data("123456789");
+    // CRC-16/MCRF4XX check value
+    BOOST_CHECK_EQUAL(MAVLinkFrameParser::crc_accumulate(
+                          reinterpret_cast<const std::uint8_t*>(data.data()),
+                          reinterpret_cast<const std::uint8_t*>(data.data() + data.size())),
+                      0x6F91);
+}
+
+BOOST_AUTO_TEST_CASE(mavlink_stream_frames)
+{
+    TelemetryStream telemetry(10);
+
+    for (std::size_t max_chunk : {1, 17, 280, 4096})
+    {
+        MAVLinkFrameParser parser;
+        auto frames = parse_in_chunks(parser, telemetry.stream, max_chunk);
+
+        BOOST_REQUIRE_EQUAL(frames.size(), telemetry.frames.size());
+        BOOST_CHECK(frames == telemetry.frames);
+        BOOST_CHECK_EQUAL(parser.stats().frames, telemetry.frames.size());
+        BOOST_CHECK_EQUAL(parser.stats().bad_crc, 0);
+        BOOST_CHECK_EQUAL(parser.stats().unknown_msgid, 0);
+        BOOST_CHECK_EQUAL(parser.stats().bytes_skipped, telemetry.noise_bytes);
+        BOOST_CHECK_EQUAL(parser.pending(), 0);
+
+        BOOST_CHECK_EQUAL(parser.msg_stats().at(mavlink::common::msg::ATTITUDE::MSG_ID).frames,
+                          500);
+        BOOST_CHECK_EQUAL(parser.msg_stats().at(mavlink::common::msg::HEARTBEAT::MSG_ID).frames,
+                          10);
+    }
+}
+
+BOOST_AUTO_TEST_CASE(mavlink_to_message)
+{
+    // compare with the MAVLink library's (byte at a time) parser
+    TelemetryStream telemetry(2);
+    for (const auto& frame : telemetry.frames)
+    {
+        mavlink::mavlink_message_t msg_buffer{}, expected{};
+        mavlink::mavlink_status_t status{}, status_buffer{};
+        int result = mavlink::MAVLINK_FRAMING_INCOMPLETE;
+        for (char c : frame)
+            result = mavlink::mavlink_frame_char_buffer(&msg_buffer, &status_buffer, c, &expected,
+                                                        &status);
+        BOOST_REQUIRE_EQUAL(result, mavlink::MAVLINK_FRAMING_OK);
+
+        mavlink::mavlink_message_t msg;
+        MAVLinkFrameParser::to_message(frame.data(), msg);
+        BOOST_CHECK_EQUAL(msg.msgid, expected.msgid);
+        BOOST_CHECK_EQUAL(msg.seq, expected.seq);
+        BOOST_CHECK_EQUAL(msg.sysid, expected.sysid);
+        BOOST_CHECK_EQUAL(msg.compid, expected.compid);
+        BOOST_CHECK_EQUAL(msg.len, expected.len);
+        BOOST_CHECK_EQUAL(msg.checksum, expected.checksum);
+        BOOST_CHECK(std::equal(reinterpret_cast<const char*>(msg.payload64),
+                               reinterpret_cast<const char*>(msg.payload64) + msg.len,
+                               reinterpret_cast<const char*>(expected.payload64)));
+
+        std::array<std::uint8_t, MAVLINK_MAX_PACKET_LEN> buffer;
+        auto length = mavlink::mavlink_msg_to_send_buffer(&buffer[0], &msg);
+        BOOST_CHECK_EQUAL(std::string(buffer.begin(), buffer.begin() + length), frame);
+    }
+}
+
+BOOST_AUTO_TEST_CASE(mavlink_resync)
+{
+    mavlink::common::msg::HEARTBEAT heartbeat{};
+    heartbeat.type = 2;
+    std::string good = frame(heartbeat);
+
+    // corrupt the payload of a frame, keeping start-of-frame bytes out of it so that only
+    // the first byte can start a frame
+    std::string bad = frame(heartbeat);
+    for (char& c : bad)
+    {
+        if (&c != &bad[0] && contains_stx(std::string(1, c)))
+            c = 0x10;
+    }
+    bad[11] ^= 0x01;
+
+    // v1 frame (HEARTBEAT)
+    std::string v1{static_cast<char>(MAVLINK_STX_MAVLINK1), 9, 0, 1, 1, 0};
+    v1 += std::string(9, '\0');
+    std::uint16_t crc = MAVLinkFrameParser::crc_accumulate(
+        reinterpret_cast<const std::uint8_t*>(v1.data() + 1),
+        reinterpret_cast<const std::uint8_t*>(v1.data() + v1.size()));
+    std::uint8_t crc_extra = 50;
+    crc = MAVLinkFrameParser::crc_accumulate(&crc_extra, &crc_extra + 1, crc);
+    v1 += static_cast<char>(crc & 0xFF);
+    v1 += static_cast<char>(crc >> 8);
+
+    // unknown msgid: forwarded without checking the CRC
+    std::string unknown = frame(heartbeat);
+    unknown[7] = 0x45;
+    unknown[8] = 0x23;
+    unknown[9] = 0x01;
+
+    std::string stream = good + bad + v1 + unknown + good;
+
+    MAVLinkFrameParser parser;
+    auto frames = parse_in_chunks(parser, stream, 8);
+    std::vector<std::string> expected{good, v1, unknown, good};
+    BOOST_CHECK(frames == expected);
+    BOOST_CHECK_EQUAL(parser.stats().bad_crc, 1);
+    BOOST_CHECK_EQUAL(parser.stats().unknown_msgid, 1);
+    BOOST_CHECK_EQUAL(parser.stats().bytes_skipped, bad.size());
+    BOOST_CHECK_EQUAL(parser.msg_stats().at(0x012345).frames, 1);
+}
+
+BOOST_AUTO_TEST_CASE(mavlink_parse_benchmark)
+{
+    TelemetryStream telemetry(60);
+    const int repeats = 20;
+    const std::size_t read_size = 256;
+    using Clock = std::chrono::steady_clock;
+
+    // previous approach: one byte at a time, then re-serialize each message
+    std::size_t reference_frames = 0;
+    auto reference_start = Clock::now();
+    {
+        mavlink::mavlink_message_t msg_buffer{}, msg{};
+        mavlink::mavlink_status_t status{}, status_buffer{};
+        std::string data;
+        for (int r = 0; r < repeats; ++r)
+        {
+            for (char c : telemetry.stream)
+            {
+                if (mavlink::mavlink_frame_char_buffer(&msg_buffer, &status_buffer, c, &msg,
+                                                       &status) == mavlink::MAVLINK_FRAMING_OK)
+                {
+                    std::array<std::uint8_t, MAVLINK_MAX_PACKET_LEN> buffer;
+                    auto length = mavlink::mavlink_msg_to_send_buffer(&buffer[0], &msg);
+                    data.assign(reinterpret_cast<const char*>(&buffer[0]), length);
+                    ++reference_frames;
+                }
+            }
+        }
+    }
+    std::chrono::duration<double> reference_time = Clock::now() - reference_start;
+
+    std::size_t parser_frames = 0;
+    auto parser_start = Clock::now();
+    {
+        MAVLinkFrameParser parser;
+        mavlink::mavlink_message_t msg;
+        std::string data;
+        for (int r = 0; r < repeats; ++r)
+        {
+            for (std::size_t pos = 0; pos < telemetry.stream.size(); pos += read_size)
+            {
+                const char* begin = telemetry.stream.data() + pos;
+                parser.parse(begin, begin + std::min(read_size, telemetry.stream.size() - pos),
+                             [&](const char* frame, std::size_t size,
+                                 MAVLinkFrameParser::FrameStatus status) {
+                                 if (status == MAVLinkFrameParser::FrameStatus::BAD_CRC)
+                                     return;
+                                 MAVLinkFrameParser::to_message(frame, msg);
+                                 data.assign(frame, size);
+                                 ++parser_frames;
+                             });
+            }
+        }
+    }
+    std::chrono::duration<double> parser_time = Clock::now() - parser_start;
+
+    BOOST_CHECK_EQUAL(reference_frames, telemetry.frames.size() * repeats);
+    BOOST_CHECK_EQUAL(parser_frames, reference_frames);
+
+    double megabytes = telemetry.stream.size() * repeats / 1.0e6;
+    std::cout << "mavlink_frame_char_buffer: " << megabytes / reference_time.count()
+              << " MB/s, " << reference_frames / reference_time.count() << " frames/s"
+              << std::endl;
+    std::cout << "MAVLinkFrameParser: " << megabytes / parser_time.count() << " MB/s, "
+              << parser_frames / parser_time.count() << " frames/s" << std::endl;
+}
@@ -84,8 +84,12 @@ class Subscriber
             [this](std::shared_ptr<const Sample> s) { handle_sample2(std::move(s)); });
         inproc2.subscribe<widget, Widget>(
             [this](std::shared_ptr<const Widget> w) { handle_widget1(std::move(w)); });
+        // second subscription to the same group from this thread: each subscription must
+        // receive each publication exactly once
+        inproc2.subscribe<sample1, Sample>(
+            [this](std::shared_ptr<const Sample> s) { handle_sample1_again(std::move(s)); });
         while (receive_count1 < max_publish || receive_count2 < max_publish ||
-               receive_count3 < max_publish)
+               receive_count3 < max_publish || receive_count4 < max_publish)
         {
             ++ready;
             inproc2.poll();
@@ -109,6 +113,12 @@ class Subscriber
         ++receive_count2;
     }
 
+    void handle_sample1_again(const std::shared_ptr<const Sample>& sample)
+    {
+        assert(sample->a() == receive_count4);
+        ++receive_count4;
+    }
+
     void handle_widget1(const std::shared_ptr<const Widget>& widget)
     {
         //std::thread::id this_id = std::this_thread::get_id();
@@ -121,6 +131,7 @@ class Subscriber
     int receive_count1 = {0};
     int receive_count2 = {0};
     int receive_count3 = {0};
+    int receive_count4 = {0};
 };
 } // namespace middleware
 } // namespace test
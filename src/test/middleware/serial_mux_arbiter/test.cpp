@@ -0,0 +1,197 @@
+// Copyright 2023:
+//   GobySoft, LLC (2013-)
+//   Community contributors (see AUTHORS file)
+// File authors:
+//   Toby Schneider <toby@gobysoft.org>
+//
+//
+// This file is part of the Goby Underwater Autonomy Project Binaries
+// ("The Goby Binaries").
+//
+// The Goby Binaries are free software: you can redistribute them and/or modify
+// them under the terms of the GNU General Public License as published by
+// the Free Software Foundation, either version 2 of the License, or
+// (at your option) any later version.
+//
+// The Goby Binaries are distributed in the hope that they will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with Goby.  If not, see <http://www.gnu.org/licenses/>.
+
+#include <algorithm>
+#include <cassert>
+#include <chrono>
+#include <iostream>
+#include <map>
+#include <string>
+
+#include "goby/util/debug_logger.h"
+
+#include "arbiter.h"
+
+// simulates the goby_serial_mux arbiter sharing a 9600 baud link between four clients
+
+using goby::apps::middleware::SerialMuxArbiter;
+using goby::middleware::protobuf::IOData;
+using Clock = SerialMuxArbiter::Clock;
+
+SerialMuxArbiter::Data line(char client, std::size_t size = 32)
+{
+    auto data = std::make_shared<IOData>();
+    data->set_data(std::string(size - 1, client) + "\n");
+    return data;
+}
+
+// bytes of each write by client (first character of each line)
+std::map<char, std::size_t> split(const IOData& write)
+{
+    std::map<char, std::size_t> bytes;
+    const std::string& data = write.data();
+    for (std::string::size_type pos = 0, eol; pos < data.size(); pos = eol + 1)
+    {
+        eol = data.find('\n', pos);
+        assert(eol != std::string::npos);
+        bytes[data[pos]] += eol + 1 - pos;
+    }
+    return bytes;
+}
+
+void test_order()
+{
+    auto now = Clock::now();
+    SerialMuxArbiter::LinkConfig link;
+    link.max_bytes_in_flight = 1000;
+    SerialMuxArbiter arbiter(link, now);
+    for (int priority : {0, 1, 0}) arbiter.add_client({"", priority});
+
+    // highest priority first, then equal priorities in turn (starting after the last client served)
+    for (int i = 0; i < 2; ++i)
+    {
+        arbiter.enqueue(0, line('a'));
+        arbiter.enqueue(2, line('c'));
+        arbiter.enqueue(1, line('b'));
+    }
+    auto write = arbiter.next_write(now);
+    assert(write);
+    assert(write->data() == line('b')->data() + line('b')->data() + line('c')->data() +
+                                line('a')->data() + line('c')->data() + line('a')->data());
+
+    // nothing left to send
+    assert(!arbiter.next_write(now));
+
+    // lines are never split: a batch ends before a line that does not fit
+    arbiter.enqueue(0, line('a', 200));
+    arbiter.enqueue(2, line('c', 200));
+    write = arbiter.next_write(now);
+    assert(write->data() == line('c', 200)->data());
+
+    // ... but a line larger than max_write_batch is still sent whole
+    arbiter.enqueue(0, line('a', 300));
+    write = arbiter.next_write(now);
+    assert(write->data() == line('a', 200)->data());
+    write = arbiter.next_write(now);
+    assert(write->data() == line('a', 300)->data());
+
+    // the link is now busy until the bytes in flight are transmitted
+    arbiter.enqueue(0, line('a', 300));
+    assert(arbiter.next_write(now));
+    assert(arbiter.bytes_in_flight() >= link.max_bytes_in_flight);
+    arbiter.enqueue(0, line('a'));
+    assert(!arbiter.next_write(now));
+    assert(arbiter.next_write(now + std::chrono::seconds(1)));
+}
+
+void test_simulation()
+{
+    const double link_rate = 960;
+    const double frequency = 50;
+    const int duration = 120;
+
+    auto now = Clock::now();
+    SerialMuxArbiter::LinkConfig link;
+    link.link_rate = link_rate;
+    link.max_bytes_in_flight = 2 * link_rate / frequency;
+    SerialMuxArbiter arbiter(link, now);
+
+    // a: high priority, b: rate-limited flood, c: light, d: flood with a small queue
+    SerialMuxArbiter::ClientConfig a_cfg{"a", 1}, b_cfg{"b", 0, 100, 64}, c_cfg{"c"},
+        d_cfg{"d", 0, 0, 256, 1024};
+    for (const auto& cfg : {a_cfg, b_cfg, c_cfg, d_cfg}) arbiter.add_client(cfg);
+
+    // bytes/s offered by each client, in lines of 32 bytes
+    std::map<char, double> offered_rate{{'a', 160}, {'b', 480}, {'c', 160}, {'d', 1600}};
+    std::map<char, double> offered_bytes;
+    std::map<char, std::size_t> received;
+
+    const auto period = std::chrono::microseconds(static_cast<int>(1e6 / frequency));
+    const int steps = duration * frequency;
+    for (int step = 0; step < steps; ++step)
+    {
+        now += period;
+        for (auto& offered_p : offered_rate)
+        {
+            char client = offered_p.first;
+            double target = offered_p.second * (step + 1) / frequency;
+            while (offered_bytes[client] + 32 <= target)
+            {
+                arbiter.enqueue(client - 'a', line(client));
+                offered_bytes[client] += 32;
+            }
+        }
+
+        if (auto write = arbiter.next_write(now))
+        {
+            for (const auto& bytes_p : split(*write)) received[bytes_p.first] += bytes_p.second;
+        }
+        assert(arbiter.bytes_in_flight() <= link.max_bytes_in_flight + link.max_write_batch);
+    }
+
+    const auto& clients = arbiter.clients();
+    std::size_t total = 0;
+    for (const auto& client : clients)
+    {
+        char name = client.cfg.name[0];
+        std::cout << name << ": offered " << offered_bytes[name] << ", sent " << client.bytes_sent
+                  << ", queued " << client.queue_bytes << ", discarded " << client.bytes_dropped
+                  << std::endl;
+        assert(client.bytes_sent == received[name]);
+        assert(client.bytes_sent + client.queue_bytes + client.bytes_dropped ==
+               offered_bytes[name]);
+        assert(client.queue_bytes <= std::max<std::size_t>(client.cfg.max_queue_bytes, 32));
+        total += client.bytes_sent;
+    }
+
+    // the link stays busy, but is not overrun
+    assert(total <= link_rate * duration + link.max_bytes_in_flight);
+    assert(total >= 0.95 * link_rate * duration);
+
+    // the high priority and light clients receive all they offer
+    assert(clients[0].queue_bytes <= 64 && clients[0].bytes_dropped == 0);
+    assert(clients[2].queue_bytes <= 64 && clients[2].bytes_dropped == 0);
+
+    // the rate-limited client stays within its token bucket (plus at most one line, as lines are not split)
+    assert(clients[1].bytes_sent <= b_cfg.rate_limit * duration + b_cfg.burst + 32);
+    assert(clients[1].bytes_sent >= 0.95 * b_cfg.rate_limit * duration);
+
+    // the flooding clients' queues overflow, discarding their oldest data
+    assert(clients[1].bytes_dropped > 0);
+    assert(clients[3].bytes_dropped > 0);
+
+    // the remaining flood gets what is left of the link
+    assert(clients[3].bytes_sent >=
+           0.95 * (link_rate - offered_rate['a'] - b_cfg.rate_limit - offered_rate['c']) * duration);
+}
+
+int main(int argc, char* argv[])
+{
+    goby::glog.add_stream(goby::util::logger::DEBUG1, &std::cerr);
+    goby::glog.set_name(argv[0]);
+
+    test_order();
+    test_simulation();
+
+    std::cout << "all tests passed" << std::endl;
+}
@@ -0,0 +1,117 @@
+// Copyright 2023:
+//   GobySoft, LLC (2013-)
+//   Community contributors (see AUTHORS file)
+// File authors:
+//   Toby Schneider <toby@gobysoft.org>
+//
+//
+// This file is part of the Goby Underwater Autonomy Project Binaries
+// ("The Goby Binaries").
+//
+// The Goby Binaries are free software: you can redistribute them and/or modify
+// them under the terms of the GNU General Public License as published by
+// the Free Software Foundation, either version 2 of the License, or
+// (at your option) any later version.
+//
+// The Goby Binaries are distributed in the hope that they will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with Goby.  If not, see <http://www.gnu.org/licenses/>.
+
+#include <atomic>
+#include <cassert>
+#include <iostream>
+#include <thread>
+#include <vector>
+
+#include "goby/middleware/transport/interthread.h"
+
+// tests TransporterConfig::Queue (bounded and conflated subscriptions) on the interthread layer
+
+using goby::glog;
+using namespace goby::util::logger;
+
+extern constexpr goby::middleware::Group all{"All"};
+extern constexpr goby::middleware::Group latest{"Latest"};
+extern constexpr goby::middleware::Group oldest{"Oldest"};
+
+struct Ping
+{
+    int n;
+};
+
+const int max_publish = 100;
+const int max_size = 5;
+
+std::atomic<bool> subscribed{false};
+std::atomic<bool> published{false};
+
+void publisher()
+{
+    goby::middleware::InterThreadTransporter interthread;
+    while (!subscribed) std::this_thread::sleep_for(std::chrono::milliseconds(1));
+
+    for (int i = 0; i < max_publish; ++i)
+    {
+        auto p = std::make_shared<Ping>();
+        p->n = i;
+        interthread.publish<all>(p);
+        interthread.publish<latest>(p);
+        interthread.publish<oldest>(p);
+    }
+    published = true;
+}
+
+goby::middleware::Subscriber<Ping> queue_subscriber(
+    int size, goby::middleware::protobuf::TransporterConfig::Queue::OverflowPolicy overflow)
+{
+    goby::middleware::protobuf::TransporterConfig cfg;
+    cfg.mutable_queue()->set_max_size(size);
+    cfg.mutable_queue()->set_overflow(overflow);
+    return goby::middleware::Subscriber<Ping>(cfg);
+}
+
+int main(int /*argc*/, char* argv[])
+{
+    goby::glog.add_stream(goby::util::logger::DEBUG3, &std::cerr);
+    goby::glog.set_name(argv[0]);
+    goby::glog.set_lock_action(goby::util::logger_lock::lock);
+
+    using goby::middleware::protobuf::TransporterConfig;
+    goby::middleware::InterThreadTransporter interthread;
+
+    std::vector<int> all_received, latest_received, oldest_received;
+
+    interthread.subscribe<all, Ping>([&](const Ping& p) { all_received.push_back(p.n); });
+    // conflated: only the newest value is kept
+    interthread.subscribe<latest, Ping>([&](const Ping& p) { latest_received.push_back(p.n); },
+                                        queue_subscriber(1, TransporterConfig::Queue::DROP_OLDEST));
+    // bounded, keeping the first values queued
+    interthread.subscribe<oldest, Ping>(
+        [&](const Ping& p) { oldest_received.push_back(p.n); },
+        queue_subscriber(max_size, TransporterConfig::Queue::DROP_NEWEST));
+
+    std::thread t(publisher);
+    subscribed = true;
+    while (!published) std::this_thread::sleep_for(std::chrono::milliseconds(1));
+    t.join();
+
+    int items = interthread.poll(std::chrono::seconds(1));
+    glog.is_verbose() && glog << "Polled " << items << " items" << std::endl;
+
+    assert(items == max_publish + 1 + max_size);
+
+    assert(all_received.size() == max_publish);
+    for (int i = 0; i < max_publish; ++i) assert(all_received[i] == i);
+
+    assert(latest_received.size() == 1);
+    assert(latest_received[0] == max_publish - 1);
+
+    assert(oldest_received.size() == max_size);
+    for (int i = 0; i < max_size; ++i) assert(oldest_received[i] == i);
+
+    std::cout << "all tests passed" << std::endl;
+}
@@ -0,0 +1,237 @@
+// Copyright 2023:
+//   GobySoft, LLC (2013-)
+//   Community contributors (see AUTHORS file)
+// File authors:
+//   Toby Schneider <toby@gobysoft.org>
+//
+//
+// This file is part of the Goby Underwater Autonomy Project Binaries
+// ("The Goby Binaries").
+//
+// The Goby Binaries are free software: you can redistribute them and/or modify
+// them under the terms of the GNU General Public License as published by
+// the Free Software Foundation, either version 2 of the License, or
+// (at your option) any later version.
+//
+// The Goby Binaries are distributed in the hope that they will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with Goby.  If not, see <http://www.gnu.org/licenses/>.
+
+
+#include <array>
+#include <cassert>
+#include <chrono>
+#include <iostream>
+#include <map>
+#include <memory>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include <boost/asio/io_context.hpp>
+#include <boost/asio/ip/tcp.hpp>
+#include <boost/asio/write.hpp>
+
+#include "goby/middleware/application/multi_thread.h"
+#include "goby/middleware/io/line_based/tcp_client_pool.h"
+
+#include "goby/test/middleware/tcp_client_pool/test.pb.h"
+
+// tests TCPClientPoolThreadLineBased against echo servers: data routed by index, reconnection after the server closes the connection, and connection (with backoff) to a server that starts late
+
+using goby::glog;
+using namespace goby::util::logger;
+using boost::asio::ip::tcp;
+using goby::middleware::io::PubSubLayer;
+using goby::middleware::protobuf::IOData;
+using goby::middleware::protobuf::TCPClientEvent;
+using goby::test::middleware::protobuf::TestConfig;
+
+extern constexpr goby::middleware::Group pool_in{"tcp_pool::in"};
+extern constexpr goby::middleware::Group pool_out{"tcp_pool::out"};
+
+using PoolThread =
+    goby::middleware::io::TCPClientPoolThreadLineBased<pool_in, pool_out, PubSubLayer::INTERTHREAD,
+                                                       PubSubLayer::INTERTHREAD>;
+
+const int base_port = 54881;
+// servers for the first num_servers connections start immediately, the last one late
+const int num_servers = 3;
+const int num_connections = num_servers + 1;
+const std::chrono::seconds timeout(30);
+
+// echoes each line; closes the connection when it reads "close\n"
+class EchoServer
+{
+  public:
+    EchoServer(boost::asio::io_context& io, int port)
+        : acceptor_(io, tcp::endpoint(tcp::v4(), port))
+    {
+        accept();
+    }
+
+  private:
+    void accept()
+    {
+        auto socket = std::make_shared<tcp::socket>(acceptor_.get_executor());
+        acceptor_.async_accept(*socket, [this, socket](const boost::system::error_code& ec) {
+            if (!ec)
+            {
+                read(socket);
+                accept();
+            }
+        });
+    }
+
+    void read(std::shared_ptr<tcp::socket> socket)
+    {
+        auto buffer = std::make_shared<std::array<char, 1024>>();
+        socket->async_read_some(
+            boost::asio::buffer(*buffer),
+            [this, socket, buffer](const boost::system::error_code& ec, std::size_t bytes) {
+                if (ec)
+                    return;
+                std::string data(buffer->data(), bytes);
+                if (data == "close\n")
+                {
+                    socket->close();
+                    return;
+                }
+                boost::asio::write(*socket, boost::asio::buffer(data));
+                read(socket);
+            });
+    }
+
+    tcp::acceptor acceptor_;
+};
+
+class TestApp : public goby::middleware::MultiThreadStandaloneApplication<TestConfig>
+{
+  public:
+    TestApp() : goby::middleware::MultiThreadStandaloneApplication<TestConfig>(10)
+    {
+        for (int i = 0; i < num_servers; ++i)
+            servers_.emplace_back(new EchoServer(server_io_, base_port + i));
+        server_thread_ = std::thread([this]() { server_io_.run(); });
+
+        goby::middleware::protobuf::TCPClientPoolConfig pool_cfg;
+        for (int i = 0; i < num_connections; ++i)
+        {
+            auto& connection = *pool_cfg.add_connection();
+            connection.set_remote_address("127.0.0.1");
+            connection.set_remote_port(base_port + i);
+            // non-default index
+            connection.set_index(10 + i);
+        }
+        pool_cfg.mutable_reconnect()->set_min_backoff_interval(0.05);
+        pool_cfg.mutable_reconnect()->set_max_backoff_interval(0.5);
+
+        interthread().subscribe<pool_in, TCPClientEvent>([this](const TCPClientEvent& event) {
+            int index = event.index();
+            assert(index >= 10 && index < 10 + num_connections);
+            assert(event.remote_endpoint().port() == base_port + index - 10);
+
+            if (event.event() == TCPClientEvent::EVENT_CONNECT)
+            {
+                ++connects_[index];
+                // the late server's connection must have been retried before it started
+                assert(index != 10 + num_servers || late_server_started_);
+                send(index, "hello " + std::to_string(index) + "\n");
+            }
+            else
+            {
+                ++disconnects_[index];
+            }
+        });
+
+        interthread().subscribe<pool_in, IOData>([this](const IOData& io_msg) {
+            int index = io_msg.index();
+            assert(io_msg.data() == "hello " + std::to_string(index) + "\n");
+            assert(io_msg.tcp_src().port() == base_port + index - 10);
+            ++echoes_[index];
+
+            // once all the initial servers have answered, start the late one and close the first
+            // connection (which should be reconnected)
+            if (static_cast<int>(echoes_.size()) == num_servers && !late_server_started_)
+            {
+                late_server_started_ = true;
+                server_io_.post([this]() {
+                    servers_.emplace_back(new EchoServer(server_io_, base_port + num_servers));
+                });
+                send(10, "close\n");
+            }
+        });
+
+        launch_thread<PoolThread>(pool_cfg);
+    }
+
+    ~TestApp() override
+    {
+        server_io_.stop();
+        server_thread_.join();
+    }
+
+    void loop() override
+    {
+        assert(std::chrono::steady_clock::now() < start_time_ + timeout);
+
+        // every connection echoed, and the first one twice (before and after reconnection)
+        if (static_cast<int>(echoes_.size()) == num_connections && echoes_[10] == 2)
+        {
+            join_thread<PoolThread>();
+            quit();
+        }
+    }
+
+    void post_finalize() override
+    {
+        goby::middleware::MultiThreadStandaloneApplication<TestConfig>::post_finalize();
+
+        assert(connects_[10] == 2 && disconnects_[10] >= 1);
+        for (int index = 11; index < 10 + num_connections; ++index)
+            assert(connects_[index] == 1 && echoes_[index] == 1);
+
+        std::cout << "all tests passed" << std::endl;
+    }
+
+  private:
+    void send(int index, const std::string& data)
+    {
+        auto io_msg = std::make_shared<IOData>();
+        io_msg->set_index(index);
+        io_msg->set_data(data);
+        interthread().publish<pool_out>(io_msg);
+    }
+
+  private:
+    boost::asio::io_context server_io_;
+    // keeps server_io_ running until stopped
+    boost::asio::io_context::work server_work_{server_io_};
+    std::vector<std::unique_ptr<EchoServer>> servers_;
+    std::thread server_thread_;
+
+    std::map<int, int> connects_;
+    std::map<int, int> disconnects_;
+    std::map<int, int> echoes_;
+    bool late_server_started_{false};
+    std::chrono::steady_clock::time_point start_time_{std::chrono::steady_clock::now()};
+};
+
+class TestConfigurator : public goby::middleware::ConfiguratorInterface<TestConfig>
+{
+  public:
+    TestConfigurator(char* argv0)
+    {
+        auto& app_cfg = mutable_app_configuration();
+        app_cfg.set_name(argv0);
+    }
+
+  private:
+    std::string str() const override { return ""; }
+};
+
+int main(int argc, char* argv[]) { return goby::run<TestApp>(TestConfigurator(argv[0])); }
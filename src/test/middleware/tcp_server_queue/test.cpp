@@ -0,0 +1,288 @@
+// Copyright 2023:
+//   GobySoft, LLC (2013-)
+//   Community contributors (see AUTHORS file)
+// File authors:
+//   Toby Schneider <toby@gobysoft.org>
+//
+//
+// This file is part of the Goby Underwater Autonomy Project Binaries
+// ("The Goby Binaries").
+//
+// The Goby Binaries are free software: you can redistribute them and/or modify
+// them under the terms of the GNU General Public License as published by
+// the Free Software Foundation, either version 2 of the License, or
+// (at your option) any later version.
+//
+// The Goby Binaries are distributed in the hope that they will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with Goby.  If not, see <http://www.gnu.org/licenses/>.
+
+#include <array>
+#include <atomic>
+#include <cassert>
+#include <chrono>
+#include <iostream>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include <boost/asio/io_context.hpp>
+#include <boost/asio/ip/tcp.hpp>
+#include <boost/asio/read_until.hpp>
+#include <boost/asio/streambuf.hpp>
+
+#include "goby/middleware/application/multi_thread.h"
+#include "goby/middleware/io/line_based/tcp_server.h"
+
+#include "goby/test/middleware/tcp_server_queue/test.pb.h"
+
+// loopback test of TCPServerConfig::write_queue: one client reads everything the server writes, the other does not read until the end. Run with the slow client policy (DROP_OLDEST, DROP_NEWEST or DISCONNECT) as the first argument
+
+using goby::glog;
+using goby::middleware::io::PubSubLayer;
+using goby::middleware::protobuf::IOData;
+using goby::middleware::protobuf::TCPServerConfig;
+using goby::middleware::protobuf::TCPServerEvent;
+using goby::test::middleware::protobuf::TestConfig;
+using namespace goby::util::logger;
+
+extern constexpr goby::middleware::Group server_in{"tcp::server_in"};
+extern constexpr goby::middleware::Group server_out{"tcp::server_out"};
+
+using ServerThread = goby::middleware::io::TCPServerThreadLineBased<
+    server_in, server_out, PubSubLayer::INTERTHREAD, PubSubLayer::INTERTHREAD>;
+
+const int server_port = 54875;
+const int num_messages = 20000;
+const int message_size = 512;
+const int max_queue = 100;
+const int max_write_batch = 10;
+// messages the reading client may be behind by (below max_queue, so that it never overflows)
+const int window = 50;
+const std::chrono::seconds timeout(60);
+
+TCPServerConfig::WriteQueue::SlowClientPolicy policy = TCPServerConfig::WriteQueue::DROP_OLDEST;
+
+std::atomic<int> reader_received{0};
+std::atomic<bool> slow_client_connected{false};
+std::atomic<int> slow_client_port{0};
+// set once everything is published, after which the slow client reads what it can
+std::atomic<bool> slow_client_read{false};
+std::atomic<bool> slow_client_done{false};
+std::vector<int> slow_client_received;
+
+std::string message(int n)
+{
+    std::string data = std::to_string(n);
+    data.resize(message_size - 1, ' ');
+    return data + "\n";
+}
+
+boost::asio::ip::tcp::endpoint server_endpoint()
+{
+    return {boost::asio::ip::address::from_string("127.0.0.1"), server_port};
+}
+
+void reading_client()
+{
+    boost::asio::io_context io;
+    boost::asio::ip::tcp::socket socket(io);
+    socket.connect(server_endpoint());
+
+    boost::asio::streambuf buffer;
+    while (reader_received < num_messages)
+    {
+        boost::asio::read_until(socket, buffer, '\n');
+        std::istream is(&buffer);
+        std::string line;
+        std::getline(is, line);
+        assert(line.size() == message_size - 1);
+        assert(std::stoi(line) == reader_received);
+        ++reader_received;
+    }
+}
+
+void slow_client()
+{
+    boost::asio::io_context io;
+    boost::asio::ip::tcp::socket socket(io);
+    socket.open(boost::asio::ip::tcp::v4());
+    // small buffer so that the server's queue for this client fills quickly
+    socket.set_option(boost::asio::socket_base::receive_buffer_size(4096));
+    socket.connect(server_endpoint());
+    slow_client_port = socket.local_endpoint().port();
+    slow_client_connected = true;
+
+    while (!slow_client_read) std::this_thread::sleep_for(std::chrono::milliseconds(10));
+
+    // read until the server disconnects us or stops sending
+    socket.non_blocking(true);
+    const auto idle_timeout = std::chrono::seconds(2);
+    auto last_read = std::chrono::steady_clock::now();
+    std::string buffer;
+    std::array<char, 4096> data;
+    boost::system::error_code ec;
+    while (std::chrono::steady_clock::now() < last_read + idle_timeout)
+    {
+        std::size_t n = socket.read_some(boost::asio::buffer(data), ec);
+        if (ec == boost::asio::error::would_block)
+        {
+            std::this_thread::sleep_for(std::chrono::milliseconds(10));
+            continue;
+        }
+        else if (ec)
+        {
+            break;
+        }
+        buffer.append(data.data(), n);
+        last_read = std::chrono::steady_clock::now();
+
+        std::string::size_type eol;
+        while ((eol = buffer.find('\n')) != std::string::npos)
+        {
+            assert(eol == message_size - 1);
+            slow_client_received.push_back(std::stoi(buffer.substr(0, eol)));
+            buffer.erase(0, eol + 1);
+        }
+    }
+    glog.is_verbose() && glog << "Slow client stopped reading: " << ec.message() << std::endl;
+    slow_client_done = true;
+}
+
+class TestApp : public goby::middleware::MultiThreadStandaloneApplication<TestConfig>
+{
+  public:
+    TestApp() : goby::middleware::MultiThreadStandaloneApplication<TestConfig>(1000)
+    {
+        TCPServerConfig server_cfg;
+        server_cfg.set_bind_port(server_port);
+        server_cfg.set_set_reuseaddr(true);
+        server_cfg.mutable_write_queue()->set_max_messages(max_queue);
+        server_cfg.mutable_write_queue()->set_max_write_batch(max_write_batch);
+        server_cfg.mutable_write_queue()->set_slow_client_policy(policy);
+
+        interthread().subscribe<server_in, TCPServerEvent>([this](const TCPServerEvent& event) {
+            glog.is_verbose() && glog << "Event: " << event.ShortDebugString() << std::endl;
+            switch (event.event())
+            {
+                case TCPServerEvent::EVENT_BIND:
+                    reader_ = std::thread(reading_client);
+                    slow_ = std::thread(slow_client);
+                    break;
+                case TCPServerEvent::EVENT_CONNECT: ++connected_; break;
+                case TCPServerEvent::EVENT_WRITE_QUEUE_FULL:
+                    // only the slow client falls behind
+                    assert(event.remote_endpoint().port() == slow_client_port);
+                    assert(event.write_queue().depth() <= max_queue);
+                    ++queue_full_events_;
+                    break;
+                case TCPServerEvent::EVENT_DISCONNECT:
+                    if (event.remote_endpoint().port() == slow_client_port)
+                    {
+                        slow_disconnected_ = true;
+                        assert(event.write_queue().max_depth() <= max_queue);
+                        assert(event.write_queue().messages_dropped() > 0);
+                    }
+                    break;
+            }
+        });
+
+        launch_thread<ServerThread>(server_cfg);
+    }
+
+    void loop() override
+    {
+        assert(std::chrono::steady_clock::now() < start_time_ + timeout);
+
+        if (connected_ < 2 || !slow_client_connected)
+            return;
+
+        while (sent_ < num_messages && sent_ - reader_received < window)
+        {
+            auto io_msg = std::make_shared<IOData>();
+            io_msg->set_data(message(sent_++));
+            io_msg->mutable_tcp_dest()->set_all_clients(true);
+            interthread().publish<server_out>(io_msg);
+        }
+
+        if (reader_received == num_messages)
+            slow_client_read = true;
+
+        if (slow_client_done && !quit_requested_)
+        {
+            quit_requested_ = true;
+            reader_.join();
+            slow_.join();
+            join_thread<ServerThread>();
+            quit();
+        }
+    }
+
+    void post_finalize() override
+    {
+        goby::middleware::MultiThreadStandaloneApplication<TestConfig>::post_finalize();
+
+        const auto& received = slow_client_received;
+        glog.is_verbose() && glog << "Slow client received " << received.size() << " messages"
+                                  << std::endl;
+        assert(queue_full_events_ > 0);
+        assert(static_cast<int>(received.size()) < num_messages);
+        for (std::size_t i = 1; i < received.size(); ++i) assert(received[i] > received[i - 1]);
+
+        switch (policy)
+        {
+            case TCPServerConfig::WriteQueue::DROP_OLDEST:
+                // the full queue holds the newest messages (after those already being written), delivered once the client reads
+                assert(static_cast<int>(received.size()) >= max_queue);
+                for (int i = 0; i < max_queue - max_write_batch; ++i)
+                    assert(received[received.size() - 1 - i] == num_messages - 1 - i);
+                break;
+            case TCPServerConfig::WriteQueue::DROP_NEWEST:
+                // the full queue holds the oldest messages
+                assert(static_cast<int>(received.size()) >= max_queue);
+                for (int i = 0; i < max_queue; ++i) assert(received[i] == i);
+                assert(received.back() < num_messages - 1);
+                break;
+            case TCPServerConfig::WriteQueue::DISCONNECT: assert(slow_disconnected_); break;
+        }
+
+        std::cout << "all tests passed" << std::endl;
+    }
+
+  private:
+    std::thread reader_;
+    std::thread slow_;
+    int connected_{0};
+    int sent_{0};
+    int queue_full_events_{0};
+    bool slow_disconnected_{false};
+    bool quit_requested_{false};
+    std::chrono::steady_clock::time_point start_time_{std::chrono::steady_clock::now()};
+};
+
+class TestConfigurator : public goby::middleware::ConfiguratorInterface<TestConfig>
+{
+  public:
+    TestConfigurator(char* argv0)
+    {
+        auto& app_cfg = mutable_app_configuration();
+        app_cfg.set_name(argv0);
+    }
+
+  private:
+    std::string str() const override { return ""; }
+};
+
+int main(int argc, char* argv[])
+{
+    if (argc > 1 && !TCPServerConfig::WriteQueue::SlowClientPolicy_Parse(argv[1], &policy))
+    {
+        std::cerr << "Invalid slow client policy: " << argv[1] << std::endl;
+        return 1;
+    }
+    return goby::run<TestApp>(TestConfigurator(argv[0]));
+}
@@ -0,0 +1,216 @@
+// Copyright 2023:
+//   GobySoft, LLC (2013-)
+//   Community contributors (see AUTHORS file)
+// File authors:
+//   Toby Schneider <toby@gobysoft.org>
+//
+//
+// This file is part of the Goby Underwater Autonomy Project Binaries
+// ("The Goby Binaries").
+//
+// The Goby Binaries are free software: you can redistribute them and/or modify
+// them under the terms of the GNU General Public License as published by
+// the Free Software Foundation, either version 2 of the License, or
+// (at your option) any later version.
+//
+// The Goby Binaries are distributed in the hope that they will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with Goby.  If not, see <http://www.gnu.org/licenses/>.
+
+#include <atomic>
+#include <cassert>
+#include <chrono>
+#include <cmath>
+#include <iostream>
+#include <vector>
+
+#include <pthread.h>
+#include <sched.h>
+
+#include "goby/middleware/application/detail/thread_placement.h"
+#include "goby/middleware/application/multi_thread.h"
+
+#include "goby/test/middleware/thread_placement/test.pb.h"
+
+// tests that invalid AppConfig::thread_placement entries are rejected without changing the thread, and the loop period statistics (ThreadHealth::loop_period) of a fixed frequency Thread
+
+using goby::glog;
+using goby::middleware::detail::apply_thread_placement;
+using goby::middleware::protobuf::AppConfig;
+using goby::test::middleware::protobuf::TestConfig;
+using namespace goby::util::logger;
+
+const double loop_freq_hertz = 100;
+const int num_loops = 200;
+
+std::atomic<bool> loop_test_complete{false};
+
+bool same_affinity(const cpu_set_t& a, const cpu_set_t& b) { return CPU_EQUAL(&a, &b); }
+
+cpu_set_t current_affinity()
+{
+    cpu_set_t cpus;
+    CPU_ZERO(&cpus);
+    int err = pthread_getaffinity_np(pthread_self(), sizeof(cpus), &cpus);
+    assert(err == 0);
+    return cpus;
+}
+
+void test_placement()
+{
+    const cpu_set_t original = current_affinity();
+
+    // out of range values are rejected before reaching the operating system
+    for (int cpu : {-1, CPU_SETSIZE, 1 << 30})
+    {
+        AppConfig::ThreadPlacement placement;
+        placement.set_name(".*");
+        placement.add_cpu(0);
+        placement.add_cpu(cpu);
+        assert(!apply_thread_placement(placement, "test"));
+        assert(same_affinity(current_affinity(), original));
+    }
+
+    for (int node : {-1, 1 << 30})
+    {
+        AppConfig::ThreadPlacement placement;
+        placement.set_name(".*");
+        placement.add_numa_node(node);
+        placement.set_memory_policy(AppConfig::ThreadPlacement::MEMORY__INTERLEAVE);
+        assert(!apply_thread_placement(placement, "test"));
+    }
+
+    // in range, but not a CPU we may run on (refused by the operating system)
+    if (!CPU_ISSET(CPU_SETSIZE - 1, &original))
+    {
+        AppConfig::ThreadPlacement placement;
+        placement.set_name(".*");
+        placement.add_cpu(CPU_SETSIZE - 1);
+        assert(!apply_thread_placement(placement, "test"));
+        assert(same_affinity(current_affinity(), original));
+    }
+
+    // invalid name regex is skipped, the next matching entry is used
+    {
+        google::protobuf::RepeatedPtrField<AppConfig::ThreadPlacement> placements;
+        placements.Add()->set_name("[");
+        auto& valid = *placements.Add();
+        valid.set_name("test.*");
+        for (int cpu = 0; cpu < CPU_SETSIZE; ++cpu)
+            if (CPU_ISSET(cpu, &original))
+                valid.add_cpu(cpu);
+        assert(apply_thread_placement(placements, "test_thread"));
+        assert(!apply_thread_placement(placements, "other_thread"));
+        assert(same_affinity(current_affinity(), original));
+    }
+
+    std::cout << "test_placement: passed" << std::endl;
+}
+
+class LoopThread : public goby::middleware::SimpleThread<TestConfig>
+{
+  public:
+    LoopThread(const TestConfig& cfg) : SimpleThread(cfg, loop_freq_hertz) {}
+
+  private:
+    void loop() override
+    {
+        // our own measurement of the period, using Welford's method for the variance
+        auto now = std::chrono::steady_clock::now();
+        if (loops_ > 0)
+        {
+            double period = std::chrono::duration<double>(now - last_loop_).count();
+            ++count_;
+            double delta = period - mean_;
+            mean_ += delta / count_;
+            m2_ += delta * (period - mean_);
+        }
+        last_loop_ = now;
+
+        if (++loops_ < num_loops || loop_test_complete)
+            return;
+
+        goby::middleware::protobuf::ThreadHealth health;
+        thread_health(health);
+        glog.is_verbose() && glog << health.ShortDebugString() << std::endl;
+
+        assert(health.has_loop_period());
+        const auto& loop_period = health.loop_period();
+        assert(loop_period.count() == static_cast<unsigned>(count_));
+        assert(std::abs(loop_period.expected() - 1.0 / loop_freq_hertz) < 1e-9);
+
+        // loop() is scheduled against absolute deadlines, so the mean period is close to
+        // expected even on a loaded machine
+        assert(std::abs(loop_period.mean() - loop_period.expected()) <
+               0.1 * loop_period.expected());
+
+        // Thread measures just before calling loop(), so the two measurements agree to well within the scheduling jitter
+        const double jitter = count_ > 1 ? std::sqrt(m2_ / (count_ - 1)) : 0;
+        assert(std::abs(loop_period.mean() - mean_) < 1e-4);
+        assert(std::abs(loop_period.jitter() - jitter) < 1e-4);
+        assert(loop_period.jitter() >= 0);
+        assert(loop_period.max_error() >= std::abs(loop_period.mean() - loop_period.expected()));
+
+        loop_test_complete = true;
+    }
+
+  private:
+    int loops_{0};
+    int count_{0};
+    double mean_{0};
+    double m2_{0};
+    std::chrono::steady_clock::time_point last_loop_;
+};
+
+class TestApp : public goby::middleware::MultiThreadStandaloneApplication<TestConfig>
+{
+  public:
+    TestApp() : goby::middleware::MultiThreadStandaloneApplication<TestConfig>(10)
+    {
+        launch_thread<LoopThread>();
+    }
+
+    void loop() override
+    {
+        if (loop_test_complete)
+        {
+            join_thread<LoopThread>();
+            quit();
+        }
+    }
+
+    void post_finalize() override
+    {
+        goby::middleware::MultiThreadStandaloneApplication<TestConfig>::post_finalize();
+        std::cout << "all tests passed" << std::endl;
+    }
+};
+
+class TestConfigurator : public goby::middleware::ConfiguratorInterface<TestConfig>
+{
+  public:
+    TestConfigurator(char* argv0)
+    {
+        auto& app_cfg = mutable_app_configuration();
+        app_cfg.set_name(argv0);
+
+        // invalid placement for the thread is logged and ignored, the thread still runs
+        auto& placement = *app_cfg.add_thread_placement();
+        placement.set_name(".*LoopThread");
+        placement.add_cpu(-1);
+        placement.add_numa_node(-1);
+    }
+
+  private:
+    std::string str() const override { return ""; }
+};
+
+int main(int argc, char* argv[])
+{
+    test_placement();
+    return goby::run<TestApp>(TestConfigurator(argv[0]));
+}
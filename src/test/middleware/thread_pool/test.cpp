@@ -0,0 +1,174 @@
+// Copyright 2023:
+//   GobySoft, LLC (2013-)
+//   Community contributors (see AUTHORS file)
+// File authors:
+//   Toby Schneider <toby@gobysoft.org>
+//
+//
+// This file is part of the Goby Underwater Autonomy Project Binaries
+// ("The Goby Binaries").
+//
+// The Goby Binaries are free software: you can redistribute them and/or modify
+// them under the terms of the GNU General Public License as published by
+// the Free Software Foundation, either version 2 of the License, or
+// (at your option) any later version.
+//
+// The Goby Binaries are distributed in the hope that they will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with Goby.  If not, see <http://www.gnu.org/licenses/>.
+
+#include <atomic>
+#include <cassert>
+#include <iostream>
+#include <limits>
+#include <mutex>
+#include <set>
+#include <thread>
+
+#include "goby/middleware/application/multi_thread.h"
+
+#include "goby/test/middleware/thread_pool/test.pb.h"
+
+// tests MultiThreadApplication with AppConfig::thread_pool_cfg enabled
+
+using goby::glog;
+using goby::test::middleware::protobuf::TestConfig;
+using namespace goby::util::logger;
+
+extern constexpr goby::middleware::Group ping{"Ping"};
+
+struct Ping
+{
+    int n;
+};
+
+const int num_rx_threads = 20;
+const int num_workers = 2;
+const int max_publish = 200;
+
+std::atomic<int> ready{0};
+std::atomic<int> complete{0};
+std::atomic<int> timer_expirations{0};
+std::atomic<int> busy_loops{0};
+
+std::mutex os_threads_mutex;
+std::set<std::thread::id> os_threads;
+
+void record_os_thread()
+{
+    std::lock_guard<std::mutex> lock(os_threads_mutex);
+    os_threads.insert(std::this_thread::get_id());
+}
+
+class RxThread : public goby::middleware::SimpleThread<TestConfig>
+{
+  public:
+    RxThread(const TestConfig& cfg, int index)
+        : SimpleThread(cfg, 0, index), id_(goby::middleware::this_thread_id())
+    {
+        interthread().subscribe<ping>([this](const Ping& p) {
+            // the ThreadId is stable even if the OS thread is not
+            assert(goby::middleware::this_thread_id() == id_);
+            assert(p.n == rx_count_);
+            record_os_thread();
+            if (++rx_count_ == max_publish)
+                ++complete;
+        });
+        ++ready;
+    }
+
+  private:
+    goby::middleware::ThreadId id_;
+    int rx_count_{0};
+};
+
+class TxThread : public goby::middleware::SimpleThread<TestConfig>
+{
+  public:
+    TxThread(const TestConfig& cfg) : SimpleThread(cfg, 1000) {}
+
+    void loop() override
+    {
+        record_os_thread();
+        if (ready < num_rx_threads || tx_count_ == max_publish)
+            return;
+        interthread().publish<ping>(Ping{tx_count_++});
+    }
+
+  private:
+    int tx_count_{0};
+};
+
+// loop() at infinite frequency, one per worker: the pool must still run the other threads and
+// fire the timer
+class BusyThread : public goby::middleware::SimpleThread<TestConfig>
+{
+  public:
+    BusyThread(const TestConfig& cfg, int index)
+        : SimpleThread(cfg, std::numeric_limits<double>::infinity(), index)
+    {
+    }
+
+    void loop() override
+    {
+        record_os_thread();
+        ++busy_loops;
+    }
+};
+
+class TestApp : public goby::middleware::MultiThreadStandaloneApplication<TestConfig>
+{
+  public:
+    TestApp() : goby::middleware::MultiThreadStandaloneApplication<TestConfig>(10)
+    {
+        for (int i = 0; i < num_rx_threads; ++i) launch_thread<RxThread>(i);
+        launch_thread<TxThread>();
+        for (int i = 0; i < num_workers; ++i) launch_thread<BusyThread>(i);
+        launch_timer<0>(20 * boost::units::si::hertz, []() { ++timer_expirations; });
+    }
+
+    void loop() override
+    {
+        if (complete == num_rx_threads && timer_expirations > 0)
+        {
+            for (int i = 0; i < num_rx_threads; ++i) join_thread<RxThread>(i);
+            join_thread<TxThread>();
+            for (int i = 0; i < num_workers; ++i) join_thread<BusyThread>(i);
+            join_timer<0>();
+            quit();
+        }
+    }
+
+    void post_finalize() override
+    {
+        goby::middleware::MultiThreadStandaloneApplication<TestConfig>::post_finalize();
+        assert(running_thread_count() == 0);
+
+        // all the threads shared the pool workers
+        assert(os_threads.size() <= num_workers);
+        assert(busy_loops > 0);
+        std::cout << "all tests passed" << std::endl;
+    }
+};
+
+class TestConfigurator : public goby::middleware::ConfiguratorInterface<TestConfig>
+{
+  public:
+    TestConfigurator(char* argv0)
+    {
+        auto& app_cfg = mutable_app_configuration();
+        app_cfg.set_name(argv0);
+        app_cfg.mutable_glog_config()->set_tty_verbosity(goby::util::protobuf::GLogConfig::DEBUG1);
+        app_cfg.mutable_thread_pool_cfg()->set_enable(true);
+        app_cfg.mutable_thread_pool_cfg()->set_num_workers(num_workers);
+    }
+
+  private:
+    std::string str() const override { return ""; }
+};
+
+int main(int argc, char* argv[]) { return goby::run<TestApp>(TestConfigurator(argv[0])); }
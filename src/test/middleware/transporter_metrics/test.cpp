@@ -0,0 +1,196 @@
+// Copyright 2023:
+//   GobySoft, LLC (2013-)
+//   Community contributors (see AUTHORS file)
+// File authors:
+//   Toby Schneider <toby@gobysoft.org>
+//
+//
+// This file is part of the Goby Underwater Autonomy Project Binaries
+// ("The Goby Binaries").
+//
+// The Goby Binaries are free software: you can redistribute them and/or modify
+// them under the terms of the GNU General Public License as published by
+// the Free Software Foundation, either version 2 of the License, or
+// (at your option) any later version.
+//
+// The Goby Binaries are distributed in the hope that they will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with Goby.  If not, see <http://www.gnu.org/licenses/>.
+
+#include <atomic>
+#include <cassert>
+#include <iostream>
+#include <thread>
+
+#include "goby/middleware/marshalling/protobuf.h"
+#include "goby/middleware/protobuf/terminate.pb.h"
+#include "goby/middleware/transport/interthread.h"
+#include "goby/middleware/transport/metrics.h"
+#include "goby/middleware/transport/serialization_handlers.h"
+#include "goby/util/debug_logger.h"
+
+// tests the transporter metrics (goby::middleware::metrics)
+
+using goby::middleware::metrics::Registry;
+using goby::middleware::protobuf::TransporterMetrics;
+
+extern constexpr goby::middleware::Group sample{"Sample"};
+extern constexpr goby::middleware::Group unsubscribed{"Unsubscribed"};
+
+struct Sample
+{
+    int a;
+};
+
+const int max_publish = 50;
+
+const TransporterMetrics::Entry* find(const TransporterMetrics& metrics,
+                                      goby::middleware::protobuf::Layer layer,
+                                      const std::string& group)
+{
+    for (const auto& entry : metrics.entry())
+    {
+        if (entry.layer() == layer && entry.group() == group)
+            return &entry;
+    }
+    return nullptr;
+}
+
+void enable(bool enable)
+{
+    goby::middleware::protobuf::AppConfig::Metrics cfg;
+    cfg.set_enable(enable);
+    Registry::configure(cfg);
+}
+
+void test_interthread()
+{
+    std::atomic<bool> subscribed(false), publisher_done(false);
+    int received = 0;
+
+    std::thread subscriber([&]() {
+        goby::middleware::InterThreadTransporter interthread;
+        interthread.subscribe<sample>([&](const Sample& s) { ++received; });
+        subscribed = true;
+
+        // let the inbox fill up so we can see it
+        while (!publisher_done) std::this_thread::sleep_for(std::chrono::milliseconds(1));
+        while (received < max_publish) interthread.poll();
+    });
+
+    while (!subscribed) std::this_thread::sleep_for(std::chrono::milliseconds(1));
+
+    goby::middleware::InterThreadTransporter interthread;
+
+    // not counted
+    enable(false);
+    interthread.publish<sample>(Sample{-1});
+
+    enable(true);
+    for (int i = 1; i < max_publish; ++i) interthread.publish<sample>(Sample{i});
+    interthread.publish<unsubscribed>(Sample{0});
+    publisher_done = true;
+    subscriber.join();
+
+    auto metrics = Registry::snapshot();
+    std::cout << metrics.DebugString() << std::endl;
+
+    auto* entry = find(metrics, goby::middleware::protobuf::LAYER_INTERTHREAD, "Sample");
+    assert(entry);
+    assert(entry->type() == "Sample");
+    assert(entry->published() == max_publish - 1);
+    // the first message was published with metrics disabled
+    assert(entry->received() == max_publish - 1);
+    assert(entry->latency().count() == max_publish - 1);
+    assert(entry->max_inbox_depth() == max_publish);
+    assert(!entry->has_published_bytes());
+
+    // publications with no subscribers are still counted
+    auto* unsubscribed_entry =
+        find(metrics, goby::middleware::protobuf::LAYER_INTERTHREAD, "Unsubscribed");
+    assert(unsubscribed_entry);
+    assert(unsubscribed_entry->published() == 1);
+    assert(unsubscribed_entry->received() == 0);
+}
+
+void test_serialized()
+{
+    using goby::middleware::protobuf::TerminateRequest;
+    constexpr int scheme = goby::middleware::MarshallingScheme::PROTOBUF;
+
+    int received = 0;
+    goby::middleware::DynamicGroup group("Terminate");
+    // SerializationSubscription only delivers data whose group (from the Subscriber) matches
+    goby::middleware::SerializationSubscription<TerminateRequest, scheme> subscription(
+        [&](std::shared_ptr<const TerminateRequest> request) { ++received; }, group,
+        goby::middleware::Subscriber<TerminateRequest>(
+            goby::middleware::protobuf::TransporterConfig(),
+            [&](const TerminateRequest&) -> goby::middleware::Group { return group; }));
+
+    TerminateRequest request;
+    request.set_target_name("goby_test_transporter_metrics");
+    auto bytes =
+        goby::middleware::SerializerParserHelper<TerminateRequest, scheme>::serialize(request);
+
+    for (int i = 0; i < max_publish; ++i) subscription.post(bytes.begin(), bytes.end());
+    assert(received == max_publish);
+
+    auto metrics = Registry::snapshot();
+    auto* entry = find(metrics, goby::middleware::protobuf::LAYER_INTERPROCESS, "Terminate");
+    assert(entry);
+    assert(entry->type() == "goby.middleware.protobuf.TerminateRequest");
+    assert(entry->received() == max_publish);
+    assert(entry->received_bytes() == max_publish * bytes.size());
+    assert(entry->parse_time().count() == max_publish);
+
+    std::uint64_t bucket_sum = 0;
+    for (auto b : entry->parse_time().bucket()) bucket_sum += b;
+    assert(bucket_sum == max_publish);
+
+    Registry::clear();
+    assert(find(Registry::snapshot(), goby::middleware::protobuf::LAYER_INTERPROCESS,
+                "Terminate") == nullptr);
+}
+
+void test_publish_counters()
+{
+    using goby::middleware::metrics::publish_counters;
+    using goby::middleware::protobuf::LAYER_INTERPROCESS;
+
+    // the cached counters are the Registry's, whichever thread resolves them first
+    auto& counters = publish_counters<LAYER_INTERPROCESS, Sample>("Cached", "Sample");
+    assert(&counters == &Registry::counters(LAYER_INTERPROCESS, "Cached", "Sample"));
+    auto& again = publish_counters<LAYER_INTERPROCESS, Sample>("Cached", "Sample");
+    assert(&again == &counters);
+
+    goby::middleware::metrics::Counters* other_thread_counters = nullptr;
+    std::thread other([&]() {
+        other_thread_counters = &publish_counters<LAYER_INTERPROCESS, Sample>("Cached", "Sample");
+    });
+    other.join();
+    assert(other_thread_counters == &counters);
+
+    // more than one type per group (e.g. pre-serialized data)
+    auto& a = publish_counters<LAYER_INTERPROCESS, std::vector<char>>("Cached", "A");
+    auto& b = publish_counters<LAYER_INTERPROCESS, std::vector<char>>("Cached", "B");
+    assert(&a != &b);
+    assert(&a == &Registry::counters(LAYER_INTERPROCESS, "Cached", "A"));
+    auto& b_again = publish_counters<LAYER_INTERPROCESS, std::vector<char>>("Cached", "B");
+    assert(&b_again == &b);
+}
+
+int main(int argc, char* argv[])
+{
+    goby::glog.add_stream(goby::util::logger::DEBUG3, &std::cerr);
+    goby::glog.set_name(argv[0]);
+
+    test_interthread();
+    test_serialized();
+    test_publish_counters();
+
+    std::cout << "all tests passed" << std::endl;
+}
@@ -0,0 +1,184 @@
+// Copyright 2023:
+//   GobySoft, LLC (2013-)
+//   Community contributors (see AUTHORS file)
+// File authors:
+//   Toby Schneider <toby@gobysoft.org>
+//
+//
+// This file is part of the Goby Underwater Autonomy Project Binaries
+// ("The Goby Binaries").
+//
+// The Goby Binaries are free software: you can redistribute them and/or modify
+// them under the terms of the GNU General Public License as published by
+// the Free Software Foundation, either version 2 of the License, or
+// (at your option) any later version.
+//
+// The Goby Binaries are distributed in the hope that they will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with Goby.  If not, see <http://www.gnu.org/licenses/>.
+
+
+#include <cassert>
+#include <chrono>
+#include <cstdint>
+#include <iostream>
+#include <string>
+
+#include "goby/middleware/application/multi_thread.h"
+#include "goby/middleware/io/udp_one_to_many.h"
+#include "goby/middleware/io/udp_point_to_point.h"
+#include "goby/time/steady_clock.h"
+#include "goby/time/system_clock.h"
+
+#include "goby/test/middleware/udp_batch/test.pb.h"
+
+// loopback test and benchmark of UDP{OneToMany,PointToPoint}Thread, run with the batch size (UDP*Config::batch_size) as the first argument, and optionally 1 as the second to use kernel receive time stamps (UDPOneToManyConfig::kernel_timestamp)
+
+using goby::glog;
+using namespace goby::util::logger;
+using goby::middleware::io::PubSubLayer;
+using goby::middleware::protobuf::IOData;
+using goby::middleware::protobuf::IOStatus;
+using goby::test::middleware::protobuf::TestConfig;
+
+extern constexpr goby::middleware::Group tx_in{"udp::tx_in"};
+extern constexpr goby::middleware::Group tx_out{"udp::tx_out"};
+extern constexpr goby::middleware::Group rx_in{"udp::rx_in"};
+extern constexpr goby::middleware::Group rx_out{"udp::rx_out"};
+
+using TxThread = goby::middleware::io::UDPPointToPointThread<
+    tx_in, tx_out, PubSubLayer::INTERTHREAD, PubSubLayer::INTERTHREAD>;
+using RxThread = goby::middleware::io::UDPOneToManyThread<rx_in, rx_out, PubSubLayer::INTERTHREAD,
+                                                          PubSubLayer::INTERTHREAD>;
+
+const int rx_port = 54871;
+const int num_datagrams = 20000;
+const int datagram_size = 512;
+// datagrams in flight at once (kept well below the socket receive buffer so none are dropped)
+const int window = 64;
+const std::chrono::seconds timeout(60);
+
+unsigned batch_size = 1;
+bool kernel_timestamp = false;
+
+class TestApp : public goby::middleware::MultiThreadStandaloneApplication<TestConfig>
+{
+  public:
+    TestApp() : goby::middleware::MultiThreadStandaloneApplication<TestConfig>(10)
+    {
+        rx_cfg_.set_bind_port(rx_port);
+        rx_cfg_.set_batch_size(batch_size);
+        rx_cfg_.set_kernel_timestamp(kernel_timestamp);
+        tx_cfg_.set_remote_address("127.0.0.1");
+        tx_cfg_.set_remote_port(rx_port);
+        tx_cfg_.set_batch_size(batch_size);
+
+        auto status_callback = [this](const IOStatus& status) {
+            if (status.state() == goby::middleware::protobuf::IO__LINK_OPEN && ++links_open_ == 2)
+            {
+                start_ = std::chrono::steady_clock::now();
+                for (int i = 0; i < window; ++i) send();
+            }
+        };
+        interthread().subscribe<tx_in, IOStatus>(status_callback);
+        interthread().subscribe<rx_in, IOStatus>(status_callback);
+
+        interthread().subscribe<rx_in, IOData>([this](const IOData& io_msg) {
+            assert(io_msg.data().size() == datagram_size);
+            assert(std::stoi(io_msg.data()) == received_);
+            assert(io_msg.udp_dest().port() == rx_port);
+
+            // received before now, and in order
+            assert(io_msg.has_receive_time() && io_msg.has_receive_steady_time());
+            auto system_now = goby::time::SystemClock::now().time_since_epoch().count();
+            auto steady_now = goby::time::SteadyClock::now().time_since_epoch().count();
+            assert(io_msg.receive_time() <= static_cast<std::uint64_t>(system_now));
+            assert(io_msg.receive_steady_time() <= static_cast<std::uint64_t>(steady_now));
+            // kernel time stamps are taken in order of arrival, but the steady time inferred from them can be off by the time taken to read both clocks
+            auto receive_time =
+                kernel_timestamp ? io_msg.receive_time() : io_msg.receive_steady_time();
+            assert(receive_time >= last_receive_time_);
+            last_receive_time_ = receive_time;
+            if (++received_ == num_datagrams)
+                end_ = std::chrono::steady_clock::now();
+            send();
+        });
+
+        launch_thread<RxThread>(rx_cfg_);
+        launch_thread<TxThread>(tx_cfg_);
+    }
+
+    void loop() override
+    {
+        assert(std::chrono::steady_clock::now() < start_time_ + timeout);
+
+        if (received_ == num_datagrams)
+        {
+            join_thread<TxThread>();
+            join_thread<RxThread>();
+            quit();
+        }
+    }
+
+    void post_finalize() override
+    {
+        goby::middleware::MultiThreadStandaloneApplication<TestConfig>::post_finalize();
+
+        double seconds = std::chrono::duration<double>(end_ - start_).count();
+        std::cout << "batch_size: " << batch_size
+                  << (kernel_timestamp ? " (kernel_timestamp), " : ", ") << num_datagrams
+                  << " datagrams of " << datagram_size << "B in " << seconds << " s ("
+                  << static_cast<int>(num_datagrams / seconds) << " datagrams/s)" << std::endl;
+        std::cout << "all tests passed" << std::endl;
+    }
+
+  private:
+    void send()
+    {
+        if (sent_ == num_datagrams)
+            return;
+
+        auto io_msg = std::make_shared<IOData>();
+        std::string data = std::to_string(sent_++);
+        data.resize(datagram_size, ' ');
+        io_msg->set_data(data);
+        interthread().publish<tx_out>(io_msg);
+    }
+
+  private:
+    goby::middleware::protobuf::UDPOneToManyConfig rx_cfg_;
+    goby::middleware::protobuf::UDPPointToPointConfig tx_cfg_;
+    int links_open_{0};
+    int sent_{0};
+    int received_{0};
+    std::uint64_t last_receive_time_{0};
+    std::chrono::steady_clock::time_point start_time_{std::chrono::steady_clock::now()};
+    std::chrono::steady_clock::time_point start_;
+    std::chrono::steady_clock::time_point end_;
+};
+
+class TestConfigurator : public goby::middleware::ConfiguratorInterface<TestConfig>
+{
+  public:
+    TestConfigurator(char* argv0)
+    {
+        auto& app_cfg = mutable_app_configuration();
+        app_cfg.set_name(argv0);
+    }
+
+  private:
+    std::string str() const override { return ""; }
+};
+
+int main(int argc, char* argv[])
+{
+    if (argc > 1)
+        batch_size = std::stoi(argv[1]);
+    if (argc > 2)
+        kernel_timestamp = std::stoi(argv[2]);
+    return goby::run<TestApp>(TestConfigurator(argv[0]));
+}
@@ -0,0 +1,136 @@
+// Copyright 2023:
+//   GobySoft, LLC (2013-)
+//   Community contributors (see AUTHORS file)
+// File authors:
+//   Toby Schneider <toby@gobysoft.org>
+//
+//
+// This file is part of the Goby Underwater Autonomy Project Binaries
+// ("The Goby Binaries").
+//
+// The Goby Binaries are free software: you can redistribute them and/or modify
+// them under the terms of the GNU General Public License as published by
+// the Free Software Foundation, either version 2 of the License, or
+// (at your option) any later version.
+//
+// The Goby Binaries are distributed in the hope that they will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with Goby.  If not, see <http://www.gnu.org/licenses/>.
+
+#include <cassert>  // for assert
+#include <chrono>   // for seconds
+#include <iostream> // for cout
+#include <thread>   // for thread
+
+#include "goby/time/discrete_event.h"
+#include "goby/time/system_clock.h"
+
+using goby::time::DiscreteEventScheduler;
+using goby::time::SteadyClock;
+using goby::time::SystemClock;
+
+// a minimal version of PollerInterface and SubscriptionStore::publish()
+struct Poller
+{
+    std::timed_mutex mutex;
+    std::condition_variable_any cv;
+    bool pending{false};
+
+    std::cv_status wait_until(SteadyClock::time_point deadline)
+    {
+        std::unique_lock<std::timed_mutex> lock(mutex);
+        while (!pending)
+        {
+            if (DiscreteEventScheduler::wait_until(cv, lock, deadline) == std::cv_status::timeout)
+                return std::cv_status::timeout;
+        }
+        pending = false;
+        return std::cv_status::no_timeout;
+    }
+
+    void notify()
+    {
+        {
+            std::lock_guard<std::timed_mutex> lock(mutex);
+            pending = true;
+        }
+        DiscreteEventScheduler::notify(cv);
+        cv.notify_all();
+    }
+};
+
+int main()
+{
+    goby::time::SimulatorSettings::using_sim_time = true;
+    DiscreteEventScheduler::enable();
+    assert(DiscreteEventScheduler::enabled());
+
+    DiscreteEventScheduler::Participant main_participant;
+
+    auto real_start = std::chrono::steady_clock::now();
+    auto steady_start = SteadyClock::now();
+    auto system_start = SystemClock::now();
+
+    // the only participant: time jumps straight to the deadline
+    Poller main_poller;
+    assert(main_poller.wait_until(steady_start + std::chrono::hours(1)) ==
+           std::cv_status::timeout);
+    assert(SteadyClock::now() == steady_start + std::chrono::hours(1));
+    assert(SystemClock::now() == system_start + std::chrono::hours(1));
+
+    // deadlines in the past time out immediately without advancing time
+    assert(main_poller.wait_until(steady_start) == std::cv_status::timeout);
+    assert(SteadyClock::now() == steady_start + std::chrono::hours(1));
+
+    // two participants: time advances to each deadline in turn
+    {
+        auto t0 = SteadyClock::now();
+        SteadyClock::time_point other_woken_at;
+        DiscreteEventScheduler::reserve_participant();
+        std::thread other([&]() {
+            DiscreteEventScheduler::Participant participant(true);
+            Poller other_poller;
+            auto status = other_poller.wait_until(t0 + std::chrono::seconds(10));
+            assert(status == std::cv_status::timeout);
+            other_woken_at = SteadyClock::now();
+        });
+
+        assert(main_poller.wait_until(t0 + std::chrono::seconds(20)) == std::cv_status::timeout);
+        assert(SteadyClock::now() == t0 + std::chrono::seconds(20));
+        other.join();
+        assert(other_woken_at == t0 + std::chrono::seconds(10));
+    }
+
+    // notify() wakes a participant without advancing time
+    {
+        auto t0 = SteadyClock::now();
+        Poller other_poller;
+        DiscreteEventScheduler::reserve_participant();
+        std::thread other([&]() {
+            DiscreteEventScheduler::Participant participant(true);
+            auto status = other_poller.wait_until(SteadyClock::time_point::max());
+            assert(status == std::cv_status::no_timeout);
+            // reply to main
+            main_poller.notify();
+        });
+
+        // other is blocked forever, but main's deadline is reached
+        assert(main_poller.wait_until(t0 + std::chrono::seconds(1)) == std::cv_status::timeout);
+        assert(SteadyClock::now() == t0 + std::chrono::seconds(1));
+
+        other_poller.notify();
+        assert(main_poller.wait_until(t0 + std::chrono::seconds(100)) ==
+               std::cv_status::no_timeout);
+        assert(SteadyClock::now() == t0 + std::chrono::seconds(1));
+        other.join();
+    }
+
+    // several hours of simulated time should take (much) less than a second of real time
+    assert(std::chrono::steady_clock::now() - real_start < std::chrono::seconds(1));
+
+    std::cout << "all tests passed" << std::endl;
+}
@@ -181,6 +181,43 @@ int main()
     glog << group("test1") << "test1 group ok" << std::endl;
     glog.is(WARN) && glog << group("test2") << "test2 group warning ok" << std::endl;
 
+    std::cout << "checking async ... " << std::endl;
+    {
+        std::stringstream ss2;
+        glog.add_stream(QUIET, &std::cout);
+        glog.add_stream(VERBOSE, &ss2);
+        glog.set_lock_action(goby::util::logger_lock::lock);
+        // small queue so that we also exercise dropping lines
+        glog.enable_async(8);
+        assert(glog.buf().is_async());
+
+        const int lines_per_thread = 2000;
+        auto async_spew = [](int m) {
+            for (int i = 0; i < lines_per_thread; i++)
+                glog.is(VERBOSE) && glog << "async " << m << " " << i << std::endl;
+        };
+        std::thread t1(async_spew, 1);
+        std::thread t2(async_spew, 2);
+        t1.join();
+        t2.join();
+
+        glog.disable_async();
+        assert(!glog.buf().is_async());
+
+        int async_lines = 0;
+        std::string line;
+        while (std::getline(ss2, line))
+        {
+            if (line.find("async ") != std::string::npos)
+                ++async_lines;
+        }
+        std::cout << "async: wrote " << async_lines << ", dropped " << glog.buf().async_dropped()
+                  << std::endl;
+        assert(async_lines + glog.buf().async_dropped() == 2 * lines_per_thread);
+
+        glog.set_lock_action(goby::util::logger_lock::none);
+    }
+
     std::cout << "All tests passed." << std::endl;
     return 0;
 }
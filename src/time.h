@@ -26,6 +26,7 @@
 #define GOBY_TIME_H
 
 #include "goby/time/convert.h"
+#include "goby/time/discrete_event.h"
 #include "goby/time/simulation.h"
 #include "goby/time/steady_clock.h"
 #include "goby/time/system_clock.h"
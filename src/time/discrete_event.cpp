@@ -0,0 +1,213 @@
+// Copyright 2023:
+//   GobySoft, LLC (2013-)
+//   Community contributors (see AUTHORS file)
+// File authors:
+//   Toby Schneider <toby@gobysoft.org>
+//
+//
+// This file is part of the Goby Underwater Autonomy Project Libraries
+// ("The Goby Libraries").
+//
+// The Goby Libraries are free software: you can redistribute them and/or modify
+// them under the terms of the GNU Lesser General Public License as published by
+// the Free Software Foundation, either version 2.1 of the License, or
+// (at your option) any later version.
+//
+// The Goby Libraries are distributed in the hope that they will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU Lesser General Public License for more details.
+//
+// You should have received a copy of the GNU Lesser General Public License
+// along with Goby.  If not, see <http://www.gnu.org/licenses/>.
+
+
+#include <cstdint>   // for int64_t
+#include <limits>    // for numeric_limits
+#include <list>      // for list
+#include <utility>   // for pair
+#include <vector>    // for vector
+
+#include "goby/time/system_clock.h" // for SystemClock
+
+#include "discrete_event.h"
+
+namespace
+{
+struct Waiter
+{
+    std::condition_variable_any* cv;
+    std::timed_mutex* poller_mutex;
+    std::int64_t deadline;
+    bool participant;
+    // no longer counted as idle
+    bool woken{false};
+    // woken by the virtual time reaching deadline
+    bool timed_out{false};
+};
+
+using Wakeup = std::pair<std::condition_variable_any*, std::timed_mutex*>;
+
+// protects all of the following
+std::mutex scheduler_mutex;
+int participants{0};
+// participants currently blocked in wait_until()
+int idle{0};
+std::list<Waiter*> waiters;
+
+thread_local bool is_participant{false};
+
+// if every participant is idle, advance the virtual time to the earliest deadline and wake the
+// waiters that are then due. Must be called with scheduler_mutex locked; returns the waiters
+// (other than self) that must be notified once it is unlocked
+std::vector<Wakeup> advance_if_idle(const Waiter* self)
+{
+    std::vector<Wakeup> wakeups;
+    if (participants == 0 || idle < participants)
+        return wakeups;
+
+    std::int64_t next = std::numeric_limits<std::int64_t>::max();
+    for (const auto* waiter : waiters)
+    {
+        if (!waiter->woken && waiter->deadline < next)
+            next = waiter->deadline;
+    }
+
+    // nothing scheduled: wait for an event from outside the simulation (e.g. I/O)
+    if (next == std::numeric_limits<std::int64_t>::max())
+        return wakeups;
+
+    auto& now = goby::time::detail::discrete_event_steady_time;
+    if (next > now)
+        now = next;
+
+    for (auto* waiter : waiters)
+    {
+        if (!waiter->woken && waiter->deadline <= now)
+        {
+            waiter->woken = true;
+            waiter->timed_out = true;
+            if (waiter->participant)
+                --idle;
+            if (waiter != self)
+                wakeups.emplace_back(waiter->cv, waiter->poller_mutex);
+        }
+    }
+    return wakeups;
+}
+
+void notify_wakeups(const std::vector<Wakeup>& wakeups)
+{
+    for (const auto& wakeup : wakeups)
+    {
+        {
+            // as in SubscriptionStore::publish(), ensures the waiter is not between
+            // checking its state and waiting on the condition variable
+            std::lock_guard<std::timed_mutex> lock(*wakeup.second);
+        }
+        wakeup.first->notify_all();
+    }
+}
+} // namespace
+
+void goby::time::DiscreteEventScheduler::enable()
+{
+    // start from the current warped times so that the clocks are continuous
+    auto steady_now = SteadyClock::now().time_since_epoch().count();
+    auto system_now = SystemClock::now().time_since_epoch().count();
+
+    detail::discrete_event_steady_time = steady_now;
+    detail::discrete_event_system_offset = system_now - steady_now;
+    SimulatorSettings::discrete_event = true;
+}
+
+goby::time::DiscreteEventScheduler::Participant::Participant(bool reserved) : active_(enabled())
+{
+    if (!active_)
+        return;
+
+    if (!reserved)
+        reserve_participant();
+    is_participant = true;
+}
+
+goby::time::DiscreteEventScheduler::Participant::~Participant()
+{
+    if (!active_)
+        return;
+
+    is_participant = false;
+    std::vector<Wakeup> wakeups;
+    {
+        std::lock_guard<std::mutex> lock(scheduler_mutex);
+        --participants;
+        // the remaining participants may all be waiting on this one
+        wakeups = advance_if_idle(nullptr);
+    }
+    notify_wakeups(wakeups);
+}
+
+void goby::time::DiscreteEventScheduler::reserve_participant()
+{
+    std::lock_guard<std::mutex> lock(scheduler_mutex);
+    ++participants;
+}
+
+std::cv_status goby::time::DiscreteEventScheduler::wait_until(
+    std::condition_variable_any& cv, std::unique_lock<std::timed_mutex>& lock,
+    SteadyClock::time_point deadline)
+{
+    std::unique_lock<std::mutex> scheduler_lock(scheduler_mutex);
+    if (deadline.time_since_epoch().count() <= detail::discrete_event_steady_time)
+        return std::cv_status::timeout;
+
+    Waiter waiter{&cv, lock.mutex(), deadline.time_since_epoch().count(), is_participant};
+    auto waiter_it = waiters.insert(waiters.end(), &waiter);
+    if (waiter.participant)
+        ++idle;
+
+    auto wakeups = advance_if_idle(&waiter);
+    if (!wakeups.empty())
+    {
+        scheduler_lock.unlock();
+        notify_wakeups(wakeups);
+        scheduler_lock.lock();
+    }
+
+    if (!waiter.woken)
+    {
+        // lock is held until wait() releases it, so a notify() followed by cv.notify_all()
+        // (with the notifying thread locking the mutex in between) cannot be missed
+        scheduler_lock.unlock();
+        cv.wait(lock);
+        scheduler_lock.lock();
+
+        // notified without notify() (or spurious wakeup)
+        if (!waiter.woken)
+        {
+            waiter.woken = true;
+            if (waiter.participant)
+                --idle;
+        }
+    }
+
+    waiters.erase(waiter_it);
+    return waiter.timed_out ? std::cv_status::timeout : std::cv_status::no_timeout;
+}
+
+void goby::time::DiscreteEventScheduler::notify(const std::condition_variable_any& cv)
+{
+    if (!enabled())
+        return;
+
+    std::lock_guard<std::mutex> lock(scheduler_mutex);
+    for (auto* waiter : waiters)
+    {
+        if (waiter->cv == &cv && !waiter->woken)
+        {
+            waiter->woken = true;
+            if (waiter->participant)
+                --idle;
+        }
+    }
+}
@@ -0,0 +1,98 @@
+// Copyright 2023:
+//   GobySoft, LLC (2013-)
+//   Community contributors (see AUTHORS file)
+// File authors:
+//   Toby Schneider <toby@gobysoft.org>
+//
+//
+// This file is part of the Goby Underwater Autonomy Project Libraries
+// ("The Goby Libraries").
+//
+// The Goby Libraries are free software: you can redistribute them and/or modify
+// them under the terms of the GNU Lesser General Public License as published by
+// the Free Software Foundation, either version 2.1 of the License, or
+// (at your option) any later version.
+//
+// The Goby Libraries are distributed in the hope that they will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU Lesser General Public License for more details.
+//
+// You should have received a copy of the GNU Lesser General Public License
+// along with Goby.  If not, see <http://www.gnu.org/licenses/>.
+
+
+#ifndef GOBY_TIME_DISCRETE_EVENT_H
+#define GOBY_TIME_DISCRETE_EVENT_H
+
+#include <chrono>             // for duration_cast
+#include <condition_variable> // for condition_variable_any, cv_status
+#include <mutex>              // for unique_lock, timed_mutex
+
+#include "goby/time/simulation.h"   // for SimulatorSettings
+#include "goby/time/steady_clock.h" // for SteadyClock
+
+namespace goby
+{
+namespace time
+{
+/// \brief Advances the simulated SteadyClock and SystemClock in discrete steps, from one scheduled deadline to the next, rather than with (warped) real time
+///
+/// Threads that take part in the simulation ("participants") register using Participant. Whenever every participant is blocked waiting (in wait_until(), called by goby::middleware::PollerInterface), the virtual time jumps to the earliest deadline of any waiter and those waiters time out. A participant that is woken by data (notify()) is no longer idle, so time does not advance until it (and any thread it publishes to) is waiting again.
+///
+/// Only deadlines that are waited on through wait_until() (Thread::loop() and poll() timeouts, and anything built on them) are scheduled events. Timers that wait on the operating system directly (e.g. boost::asio timers) still use real time, and each process keeps its own virtual time.
+class DiscreteEventScheduler
+{
+  public:
+    /// \brief Enables discrete event simulation (sets SimulatorSettings::discrete_event) with the virtual time starting at the current (warped) time. Call before any threads are launched
+    static void enable();
+
+    /// \brief True if discrete event simulation is enabled
+    static bool enabled() { return SimulatorSettings::discrete_event; }
+
+    /// \brief Registers the calling thread as a participant in the simulation while in scope (no effect if not enabled())
+    class Participant
+    {
+      public:
+        /// \param reserved true if reserve_participant() was called for this thread before it was started
+        explicit Participant(bool reserved = false);
+        ~Participant();
+
+        Participant(const Participant&) = delete;
+        Participant& operator=(const Participant&) = delete;
+
+      private:
+        bool active_;
+    };
+
+    /// \brief Counts a participant for a thread that has not yet started, so that the time cannot advance before it first waits. The thread must then create Participant(true)
+    static void reserve_participant();
+
+    /// \brief Blocks until cv is notified or the virtual time reaches deadline
+    ///
+    /// \param cv Condition variable that is notified (after notify()) when there is data for this thread
+    /// \param lock Lock on the mutex protecting the data, which must also be held by the notifying thread before calling cv.notify_all()
+    /// \param deadline Virtual time at which to time out (or SteadyClock::time_point::max() to only wait on cv)
+    static std::cv_status wait_until(std::condition_variable_any& cv,
+                                     std::unique_lock<std::timed_mutex>& lock,
+                                     SteadyClock::time_point deadline);
+
+    /// \brief Marks any thread waiting on cv as no longer idle. Call before notifying cv (no effect if not enabled())
+    static void notify(const std::condition_variable_any& cv);
+
+    /// \brief Converts a time point on any clock to the equivalent virtual SteadyClock deadline
+    template <typename Clock, typename Duration>
+    static SteadyClock::time_point to_steady_time(const std::chrono::time_point<Clock, Duration>& t)
+    {
+        if (t == std::chrono::time_point<Clock, Duration>::max())
+            return SteadyClock::time_point::max();
+        return SteadyClock::now() +
+               std::chrono::duration_cast<SteadyClock::duration>(t - Clock::now());
+    }
+
+    static SteadyClock::time_point to_steady_time(const SteadyClock::time_point& t) { return t; }
+};
+} // namespace time
+} // namespace goby
+
+#endif
@@ -35,6 +35,9 @@
 
 bool goby::time::SimulatorSettings::using_sim_time = false;
 int goby::time::SimulatorSettings::warp_factor = 1;
+bool goby::time::SimulatorSettings::discrete_event = false;
+std::atomic<std::int64_t> goby::time::detail::discrete_event_steady_time{0};
+std::int64_t goby::time::detail::discrete_event_system_offset = 0;
 
 // creates the default reference time, which is Jan 1 of the current year
 std::chrono::system_clock::time_point create_reference_time()
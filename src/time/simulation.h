@@ -25,7 +25,9 @@
 #ifndef GOBY_TIME_SIMULATION_H
 #define GOBY_TIME_SIMULATION_H
 
+#include <atomic>
 #include <chrono>
+#include <cstdint>
 
 namespace goby
 {
@@ -40,8 +42,18 @@ struct SimulatorSettings
     static int warp_factor;
     /// \brief Reference time when calculating SystemClock::now(). If this is unset, the default is 1 January of the current year.
     static std::chrono::system_clock::time_point reference_time;
+    /// \brief If true, SteadyClock::now() and SystemClock::now() return a virtual time that jumps to the next scheduled deadline whenever every participating thread is idle (see DiscreteEventScheduler), rather than a warped real time. Set using DiscreteEventScheduler::enable()
+    static bool discrete_event;
 };
 
+namespace detail
+{
+/// \brief Virtual SteadyClock time (microseconds since epoch) when SimulatorSettings::discrete_event is true. Only advanced by DiscreteEventScheduler
+extern std::atomic<std::int64_t> discrete_event_steady_time;
+/// \brief Difference between SystemClock and SteadyClock (microseconds) when SimulatorSettings::discrete_event is true
+extern std::int64_t discrete_event_system_offset;
+} // namespace detail
+
 } // namespace time
 } // namespace goby
 
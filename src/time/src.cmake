@@ -1,2 +1,3 @@
 set(TIME_SRC
+  time/discrete_event.cpp
   time/simulation.cpp)
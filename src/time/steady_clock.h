@@ -45,7 +45,7 @@ struct SteadyClock
     typedef std::chrono::time_point<SteadyClock> time_point;
     static const bool is_steady = true;
 
-    /// \brief Returns the current steady time unless `SimulatorSettings::using_sim_time == true` in which case a simulated time is returned that is sped up by (multiplied by) the `SimulatorSettings::warp_factor`
+    /// \brief Returns the current steady time unless `SimulatorSettings::using_sim_time == true` in which case a simulated time is returned that is sped up by (multiplied by) the `SimulatorSettings::warp_factor` (or, if `SimulatorSettings::discrete_event == true`, the virtual time kept by DiscreteEventScheduler)
     static time_point now() noexcept
     {
         using namespace std::chrono;
@@ -53,6 +53,8 @@ struct SteadyClock
 
         if (!SimulatorSettings::using_sim_time)
             return time_point(duration_cast<duration>(now.time_since_epoch()));
+        else if (SimulatorSettings::discrete_event)
+            return time_point(duration(detail::discrete_event_steady_time.load()));
         else
             return time_point(SimulatorSettings::warp_factor *
                               duration_cast<duration>(now.time_since_epoch()));
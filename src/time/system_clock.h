@@ -59,6 +59,7 @@ struct SystemClock
     ///
     /// When using simulated time, the returned time (t_sim) is computed relative to SimulatorSettings::reference_time (t_0) with an accelerated progression by a factor of the SimulatorSettings::warp_time (w) such that:
     /// t_sim = (t-t_0)*w + t_0
+    /// When SimulatorSettings::discrete_event is also set, the returned time instead advances with the virtual SteadyClock time (see DiscreteEventScheduler), starting from the warped time when DiscreteEventScheduler::enable() was called.
     /// A note when using MOOS middleware's MOOSTimeWarp: the value returned by this function is the same as MOOSTime() when \code SimulatorSettings::reference_time == 0 \endcode
     static time_point now() noexcept
     {
@@ -67,6 +68,9 @@ struct SystemClock
 
         if (!SimulatorSettings::using_sim_time)
             return time_point(duration_cast<duration>(now.time_since_epoch()));
+        else if (SimulatorSettings::discrete_event)
+            return time_point(duration(detail::discrete_event_steady_time.load() +
+                                       detail::discrete_event_system_offset));
         else
             return warp(now);
     }
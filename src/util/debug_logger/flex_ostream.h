@@ -100,6 +100,20 @@ class FlexOstream : public std::ostream
         sb_.add_stream(static_cast<logger::Verbosity>(verbosity), os);
     }
 
+    /// Write log lines to the attached streams from a background thread (see FlexOStreamBuf::enable_async)
+    void enable_async(std::size_t queue_size = 10000)
+    {
+        std::lock_guard<std::recursive_mutex> l(goby::util::logger::mutex);
+        sb_.enable_async(queue_size);
+    }
+
+    /// Write any queued log lines and return to writing from the logging thread. Call before destroying any attached streams
+    void disable_async()
+    {
+        std::lock_guard<std::recursive_mutex> l(goby::util::logger::mutex);
+        sb_.disable_async();
+    }
+
     const FlexOStreamBuf& buf() { return sb_; }
 
     //@}
@@ -84,6 +84,7 @@ goby::util::FlexOStreamBuf::FlexOStreamBuf(FlexOstream* parent)
 
 goby::util::FlexOStreamBuf::~FlexOStreamBuf()
 {
+    disable_async();
 #ifdef HAS_NCURSES
     if (curses_)
         delete curses_;
@@ -92,6 +93,8 @@ goby::util::FlexOStreamBuf::~FlexOStreamBuf()
 
 void goby::util::FlexOStreamBuf::add_stream(logger::Verbosity verbosity, std::ostream* os)
 {
+    std::lock_guard<std::mutex> config_lock(config_mutex_);
+
     //check that this stream doesn't exist
     // if so, update its verbosity and return
     bool stream_exists = false;
@@ -122,6 +125,7 @@ void goby::util::FlexOStreamBuf::enable_gui()
     is_gui_ = true;
     curses_ = new FlexNCurses;
 
+    std::lock_guard<std::mutex> config_lock(config_mutex_);
     std::lock_guard<std::mutex> lock(curses_mutex);
 
     curses_->startup();
@@ -143,6 +147,7 @@ void goby::util::FlexOStreamBuf::enable_gui()
 
 void goby::util::FlexOStreamBuf::add_group(const std::string& name, logger::Group g)
 {
+    std::lock_guard<std::mutex> config_lock(config_mutex_);
     bool group_existed = groups_.count(name);
 
     groups_[name] = std::move(g);
@@ -186,11 +191,31 @@ int goby::util::FlexOStreamBuf::sync()
         return 0;
     }
 
+    // write any queued lines before exiting
+    if (die_flag_)
+        disable_async();
+
     // all but last one
     while (buffer_.size() > 1)
     {
-        display(buffer_.front());
+        Line line;
+        line.text = std::move(buffer_.front());
+        line.verbosity = current_verbosity_;
+        line.group_name = group_name_;
+        line.time = SystemClock::now();
         buffer_.pop_front();
+
+        if (is_async())
+        {
+            if (async_push(line))
+                async_wait_cv_.notify_one();
+            else
+                ++async_dropped_;
+        }
+        else
+        {
+            display(line);
+        }
     }
 
     group_name_.erase();
@@ -208,39 +233,45 @@ int goby::util::FlexOStreamBuf::sync()
     return 0;
 }
 
-void goby::util::FlexOStreamBuf::display(std::string& s)
+void goby::util::FlexOStreamBuf::display(Line& line)
 {
+    std::lock_guard<std::mutex> config_lock(config_mutex_);
+
+    std::string& s = line.text;
+    const auto& group_name = line.group_name;
+    const auto verbosity = line.verbosity;
+    const auto time_str = goby::time::str(line.time);
+
     bool gui_displayed = false;
     for (const StreamConfig& cfg : streams_)
     {
         if ((cfg.os() == &std::cout || cfg.os() == &std::cerr || cfg.os() == &std::clog) &&
-            current_verbosity_ <= cfg.verbosity())
+            verbosity <= cfg.verbosity())
         {
 #ifdef HAS_NCURSES
-            if (is_gui_ && current_verbosity_ <= cfg.verbosity() && !gui_displayed)
+            if (is_gui_ && verbosity <= cfg.verbosity() && !gui_displayed)
             {
                 if (!die_flag_)
                 {
                     std::lock_guard<std::mutex> lock(curses_mutex);
-                    std::stringstream line;
-                    boost::posix_time::time_duration time_of_day =
-                        SystemClock::now<boost::posix_time::ptime>().time_of_day();
-                    line << "\n"
+                    auto line_ptime = goby::time::convert<boost::posix_time::ptime>(line.time);
+                    boost::posix_time::time_duration time_of_day = line_ptime.time_of_day();
+                    std::stringstream gui_line;
+                    gui_line << "\n"
                          << std::setfill('0') << std::setw(2) << time_of_day.hours() << ":"
                          << std::setw(2) << time_of_day.minutes() << ":" << std::setw(2)
                          << time_of_day.seconds()
-                         << TermColor::esc_code_from_col(groups_[group_name_].color()) << " | "
+                         << TermColor::esc_code_from_col(groups_[group_name].color()) << " | "
                          << esc_nocolor << s;
 
-                    curses_->insert(SystemClock::now<boost::posix_time::ptime>(), line.str(),
-                                    &groups_[group_name_]);
+                    curses_->insert(line_ptime, gui_line.str(), &groups_[group_name]);
                 }
                 else
                 {
                     curses_->alive(false);
                     input_thread_->join();
                     curses_->cleanup();
-                    std::cerr << TermColor::esc_code_from_col(groups_[group_name_].color()) << name_
+                    std::cerr << TermColor::esc_code_from_col(groups_[group_name].color()) << name_
                               << esc_nocolor << ": " << s << esc_nocolor << std::endl;
                 }
                 gui_displayed = true;
@@ -251,16 +282,16 @@ void goby::util::FlexOStreamBuf::display(std::string& s)
             (void)gui_displayed;
 #endif
 
-            *cfg.os() << TermColor::esc_code_from_col(groups_[group_name_].color()) << name_
-                      << esc_nocolor << " [" << goby::time::str() << "]";
-            if (!group_name_.empty())
+            *cfg.os() << TermColor::esc_code_from_col(groups_[group_name].color()) << name_
+                      << esc_nocolor << " [" << time_str << "]";
+            if (!group_name.empty())
                 *cfg.os() << " "
-                          << "{" << group_name_ << "}";
+                          << "{" << group_name << "}";
             *cfg.os() << ": " << s << std::endl;
         }
-        else if (cfg.os() && current_verbosity_ <= cfg.verbosity())
+        else if (cfg.os() && verbosity <= cfg.verbosity())
         {
-            goby::util::logger::basic_log_header(*cfg.os(), group_name_);
+            goby::util::logger::basic_log_header(*cfg.os(), group_name, time_str);
             strip_escapes(s);
             *cfg.os() << s << std::endl;
         }
@@ -289,3 +320,82 @@ void goby::util::FlexOStreamBuf::strip_escapes(std::string& s)
            (m_pos = s.find(m, esc_pos)) != std::string::npos)
         s.erase(esc_pos, m_pos - esc_pos + 1);
 }
+
+void goby::util::FlexOStreamBuf::enable_async(std::size_t queue_size)
+{
+    if (is_async() || queue_size == 0)
+        return;
+
+    async_queue_.clear();
+    async_queue_.resize(queue_size);
+    async_head_ = 0;
+    async_tail_ = 0;
+    async_stop_ = false;
+    async_writer_.reset(new std::thread([this]() { run_async_writer(); }));
+}
+
+void goby::util::FlexOStreamBuf::disable_async()
+{
+    if (!is_async())
+        return;
+
+    {
+        std::lock_guard<std::mutex> lock(async_wait_mutex_);
+        async_stop_ = true;
+    }
+    async_wait_cv_.notify_one();
+    // the writer empties the queue before exiting
+    async_writer_->join();
+    async_writer_.reset();
+}
+
+bool goby::util::FlexOStreamBuf::async_push(Line& line)
+{
+    auto tail = async_tail_.load(std::memory_order_relaxed);
+    if (tail - async_head_.load(std::memory_order_acquire) == async_queue_.size())
+        return false;
+
+    async_queue_[tail % async_queue_.size()] = std::move(line);
+    async_tail_.store(tail + 1, std::memory_order_release);
+    return true;
+}
+
+bool goby::util::FlexOStreamBuf::async_pop(Line& line)
+{
+    auto head = async_head_.load(std::memory_order_relaxed);
+    if (head == async_tail_.load(std::memory_order_acquire))
+        return false;
+
+    line = std::move(async_queue_[head % async_queue_.size()]);
+    async_head_.store(head + 1, std::memory_order_release);
+    return true;
+}
+
+void goby::util::FlexOStreamBuf::run_async_writer()
+{
+    std::uint64_t dropped_reported = 0;
+    Line line;
+    while (true)
+    {
+        while (async_pop(line)) display(line);
+
+        auto dropped = async_dropped_.load();
+        if (dropped != dropped_reported)
+        {
+            Line dropped_line;
+            dropped_line.text = "Dropped " + std::to_string(dropped - dropped_reported) +
+                                " log line(s): the asynchronous queue was full";
+            dropped_line.verbosity = logger::WARN;
+            dropped_line.time = SystemClock::now();
+            display(dropped_line);
+            dropped_reported = dropped;
+        }
+
+        std::unique_lock<std::mutex> lock(async_wait_mutex_);
+        if (async_stop_ && async_head_ == async_tail_)
+            break;
+        // the producer does not take the mutex to notify, so don't wait long in case it was missed
+        async_wait_cv_.wait_for(lock, std::chrono::milliseconds(10),
+                                [this]() { return async_stop_ || async_head_ != async_tail_; });
+    }
+}
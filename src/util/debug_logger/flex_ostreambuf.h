@@ -26,6 +26,8 @@
 #define GOBY_UTIL_DEBUG_LOGGER_FLEX_OSTREAMBUF_H
 
 #include <atomic>
+#include <condition_variable>
+#include <cstdint>
 #include <cstdio>
 #include <deque>
 #include <iostream>
@@ -38,6 +40,7 @@
 #include <boost/date_time.hpp>
 #include <memory>
 
+#include "goby/time/system_clock.h"
 #include "goby/util/protobuf/debug_logger.pb.h"
 
 #include "term_color.h"
@@ -132,13 +135,51 @@ class FlexOStreamBuf : public std::streambuf
 
     logger_lock::LockAction lock_action() { return lock_action_; }
 
+    /// write completed lines to the streams from a background thread, so that logging does not block on the streams. Lines are dropped (and counted) when more than queue_size are waiting
+    void enable_async(std::size_t queue_size);
+
+    /// write any queued lines and go back to writing from the logging thread
+    void disable_async();
+
+    bool is_async() const { return async_writer_ != nullptr; }
+
+    /// number of lines dropped because the async queue was full
+    std::uint64_t async_dropped() const { return async_dropped_; }
+
   private:
-    void display(std::string& s);
+    struct Line
+    {
+        std::string text;
+        logger::Verbosity verbosity{logger::UNKNOWN};
+        std::string group_name;
+        goby::time::SystemClock::time_point time;
+    };
+
+    void display(Line& line);
     void strip_escapes(std::string& s);
 
+    // bounded single producer (producers are serialized by logger::mutex), single consumer
+    // lock-free queue
+    bool async_push(Line& line);
+    bool async_pop(Line& line);
+    void run_async_writer();
+
   private:
     std::deque<std::string> buffer_;
 
+    std::vector<Line> async_queue_;
+    std::atomic<std::size_t> async_head_{0};
+    std::atomic<std::size_t> async_tail_{0};
+    std::atomic<std::uint64_t> async_dropped_{0};
+    std::atomic<bool> async_stop_{false};
+    std::unique_ptr<std::thread> async_writer_;
+    // only used to sleep the writer when the queue is empty
+    std::mutex async_wait_mutex_;
+    std::condition_variable async_wait_cv_;
+
+    // protects streams_ and groups_, which are read by the async writer
+    std::mutex config_mutex_;
+
     class StreamConfig
     {
       public:
@@ -115,6 +115,9 @@ class GroupSetter
 
 /// used for non tty ostreams (everything but std::cout / std::cerr) as the header for every line
 std::ostream& basic_log_header(std::ostream& os, const std::string& group_name);
+/// as above, for a line logged at a time already formatted by goby::time::str()
+std::ostream& basic_log_header(std::ostream& os, const std::string& group_name,
+                               const std::string& time_str);
 
 std::ostream& operator<<(std::ostream& os, const Group& g);
 inline std::ostream& operator<<(std::ostream& os, const GroupSetter& gs)
@@ -28,6 +28,8 @@
 #include <type_traits> // for __success_type<>::type
 #include <utility>     // for pair, move
 
+#include "goby/time/discrete_event.h" // for DiscreteEventScheduler
+
 #include "interprocess.h"
 
 #if GOOGLE_PROTOBUF_VERSION < 3001000
@@ -447,6 +449,7 @@ void goby::zeromq::InterProcessPortalReadThread::send_control_msg(
     zmq::message_t zmq_control_msg(control.ByteSizeLong());
     control.SerializeToArray((char*)zmq_control_msg.data(), zmq_control_msg.size());
     control_socket_.send(zmq_control_msg, zmq_send_flags_none);
+    goby::time::DiscreteEventScheduler::notify(*poller_cv_);
     poller_cv_->notify_all();
 }
 
@@ -53,6 +53,7 @@
 #include "goby/middleware/protobuf/transporter_config.pb.h"     // for Tran...
 #include "goby/middleware/transport/interface.h"                // for Poll...
 #include "goby/middleware/transport/interprocess.h"             // for Inte...
+#include "goby/middleware/transport/metrics.h"                  // for Regi...
 #include "goby/middleware/transport/null.h"                     // for Null...
 #include "goby/middleware/transport/serialization_handlers.h"   // for Seri...
 #include "goby/middleware/transport/subscriber.h"               // for Subs...
@@ -95,7 +96,7 @@ inline std::string identifier_part_to_string(int i)
 {
     return middleware::MarshallingScheme::to_string(i);
 }
-inline std::string identifier_part_to_string(std::thread::id i)
+inline std::string identifier_part_to_string(middleware::ThreadId i)
 {
     return goby::middleware::thread_id(i);
 }
@@ -117,14 +118,14 @@ inline std::string
 make_identifier(const std::string& type_name, int scheme, const std::string& group,
                 IdentifierWildcard wildcard, const std::string& process,
                 std::unordered_map<int, std::string>* schemes_buffer = nullptr,
-                std::unordered_map<std::thread::id, std::string>* threads_buffer = nullptr)
+                std::unordered_map<middleware::ThreadId, std::string>* threads_buffer = nullptr)
 {
     switch (wildcard)
     {
         default:
         case IdentifierWildcard::NO_WILDCARDS:
         {
-            auto thread = std::this_thread::get_id();
+            auto thread = middleware::this_thread_id();
             return ("/" + group + "/" +
                     (schemes_buffer ? id_component(scheme, *schemes_buffer)
                                     : std::string(identifier_part_to_string(scheme) + "/")) +
@@ -354,14 +355,22 @@ class InterProcessPortalImplementation
     void _publish(const Data& d, const goby::middleware::Group& group,
                   const middleware::Publisher<Data>& /*publisher*/, bool ignore_buffer = false)
     {
+        auto serialize_start = middleware::metrics::start_time();
         std::vector<char> bytes(middleware::SerializerParserHelper<Data, scheme>::serialize(d));
         std::string type_name = middleware::SerializerParserHelper<Data, scheme>::type_name(d);
-        _publish_serialized(type_name, scheme, bytes, group, ignore_buffer);
+        _publish_serialized(type_name, scheme, bytes, group, ignore_buffer, serialize_start);
     }
 
     void _publish_serialized(std::string type_name, int scheme, const std::vector<char>& bytes,
-                             const goby::middleware::Group& group, bool ignore_buffer = false)
+                             const goby::middleware::Group& group, bool ignore_buffer = false,
+                             middleware::metrics::Clock::time_point serialize_start =
+                                 middleware::metrics::Clock::time_point())
     {
+        if (middleware::metrics::Registry::enabled())
+            middleware::metrics::publish_counters<middleware::protobuf::LAYER_INTERPROCESS,
+                                                  std::vector<char>>(std::string(group), type_name)
+                .record_publish(bytes.size(), serialize_start);
+
         std::string identifier = _make_fully_qualified_identifier(type_name, scheme, group) + '\0';
         zmq_main_.publish(identifier, &bytes[0], bytes.size(), ignore_buffer);
     }
@@ -369,8 +378,19 @@ class InterProcessPortalImplementation
     template <typename Data, int scheme>
     void _subscribe(std::function<void(std::shared_ptr<const Data> d)> f,
                     const goby::middleware::Group& group,
-                    const middleware::Subscriber<Data>& /*subscriber*/)
+                    const middleware::Subscriber<Data>& subscriber)
     {
+        // bounded queues are applied to the data received in each _poll(), so these are handled as batches
+        if (subscriber.cfg().queue().max_size() > 0)
+        {
+            _subscribe_batch<Data, scheme>(
+                [f](const std::vector<std::shared_ptr<const Data>>& batch) {
+                    for (const auto& d : batch) f(d);
+                },
+                group, subscriber);
+            return;
+        }
+
         std::string identifier =
             _make_identifier<Data, scheme>(group, IdentifierWildcard::PROCESS_THREAD_WILDCARD);
 
@@ -385,6 +405,27 @@ class InterProcessPortalImplementation
         portal_subscriptions_.insert(std::make_pair(identifier, subscription));
     }
 
+    template <typename Data, int scheme>
+    void _subscribe_batch(
+        std::function<void(const std::vector<std::shared_ptr<const Data>>&)> f,
+        const goby::middleware::Group& group, const middleware::Subscriber<Data>& subscriber)
+    {
+        std::string identifier =
+            _make_identifier<Data, scheme>(group, IdentifierWildcard::PROCESS_THREAD_WILDCARD);
+
+        auto subscription =
+            std::make_shared<middleware::SerializationBatchSubscription<Data, scheme>>(
+                f, group,
+                middleware::Subscriber<Data>(subscriber.cfg(),
+                                             [=](const Data& /*d*/) { return group; }));
+
+        if (forwarder_subscriptions_.count(identifier) == 0 &&
+            portal_subscriptions_.count(identifier) == 0)
+            zmq_main_.subscribe(identifier);
+        portal_subscriptions_.insert(std::make_pair(identifier, subscription));
+        portal_batch_subscriptions_.insert(std::make_pair(identifier, subscription));
+    }
+
     std::shared_ptr<middleware::SerializationSubscriptionRegex> _subscribe_regex(
         std::function<void(const std::vector<unsigned char>&, int scheme, const std::string& type,
                            const goby::middleware::Group& group)>
@@ -406,6 +447,7 @@ class InterProcessPortalImplementation
             _make_identifier<Data, scheme>(group, IdentifierWildcard::PROCESS_THREAD_WILDCARD);
 
         portal_subscriptions_.erase(identifier);
+        portal_batch_subscriptions_.erase(identifier);
 
         // If no forwarded subscriptions, do the actual unsubscribe
         if (forwarder_subscriptions_.count(identifier) == 0)
@@ -413,10 +455,10 @@ class InterProcessPortalImplementation
     }
 
     void _unsubscribe_all(
-        const std::string& subscriber_id = identifier_part_to_string(std::this_thread::get_id()))
+        const std::string& subscriber_id = identifier_part_to_string(middleware::this_thread_id()))
     {
         // portal unsubscribe
-        if (subscriber_id == identifier_part_to_string(std::this_thread::get_id()))
+        if (subscriber_id == identifier_part_to_string(middleware::this_thread_id()))
         {
             for (const auto& p : portal_subscriptions_)
             {
@@ -425,6 +467,7 @@ class InterProcessPortalImplementation
                     zmq_main_.unsubscribe(identifier);
             }
             portal_subscriptions_.clear();
+            portal_batch_subscriptions_.clear();
         }
         else // forwarder unsubscribe
         {
@@ -506,7 +549,8 @@ class InterProcessPortalImplementation
                         {
                             // only post at most once for forwarders as the threads will filter
                             bool is_forwarded_sub =
-                                sub.first != identifier_part_to_string(std::this_thread::get_id());
+                                sub.first !=
+                                identifier_part_to_string(middleware::this_thread_id());
                             if (is_forwarded_sub && forwarder_subscription_posted)
                                 continue;
 
@@ -541,6 +585,19 @@ class InterProcessPortalImplementation
             }
             zmq_main_.control_buffer().pop_front();
         }
+
+        // pass the data posted above to the batch subscriptions, one call per subscription
+        if (items > 0 && !portal_batch_subscriptions_.empty())
+        {
+            // copy in case any of the handlers unsubscribes
+            std::vector<std::weak_ptr<middleware::SerializationBatchHandlerBase>> subs_to_flush;
+            for (const auto& p : portal_batch_subscriptions_) subs_to_flush.push_back(p.second);
+            for (auto& sub : subs_to_flush)
+            {
+                if (auto sub_sp = sub.lock())
+                    sub_sp->flush();
+            }
+        }
         return items;
     }
 
@@ -656,7 +713,7 @@ class InterProcessPortalImplementation
                                                  const std::string& group)
     {
         return _make_identifier(type_name, scheme, group, IdentifierWildcard::THREAD_WILDCARD) +
-               id_component(std::this_thread::get_id(), threads_);
+               id_component(middleware::this_thread_id(), threads_);
     }
 
     template <typename Data, int scheme>
@@ -703,6 +760,10 @@ class InterProcessPortalImplementation
     std::unordered_multimap<std::string,
                             std::shared_ptr<const middleware::SerializationHandlerBase<>>>
         portal_subscriptions_;
+    // subset of portal_subscriptions_ that were made with subscribe_batch(), and need to be flushed after each poll
+    std::unordered_multimap<std::string,
+                            std::shared_ptr<middleware::SerializationBatchHandlerBase>>
+        portal_batch_subscriptions_;
     // only one subscription for each forwarded identifier
     std::unordered_map<std::string, std::shared_ptr<const middleware::SerializationHandlerBase<>>>
         forwarder_subscriptions_;
@@ -716,7 +777,7 @@ class InterProcessPortalImplementation
         regex_subscriptions_;
     std::string process_{std::to_string(getpid())};
     std::unordered_map<int, std::string> schemes_;
-    std::unordered_map<std::thread::id, std::string> threads_;
+    std::unordered_map<middleware::ThreadId, std::string> threads_;
 
     bool ready_{false};
 };